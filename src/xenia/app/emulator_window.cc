@@ -9,6 +9,7 @@
 
 #include "xenia/app/emulator_window.h"
 
+#include <cfloat>
 #include <filesystem>
 #include <functional>
 #include <memory>
@@ -25,6 +26,7 @@
 #include "xenia/base/clock.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/debugging.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/profiling.h"
@@ -62,6 +64,8 @@ DECLARE_bool(clear_memory_page_state);
 
 DECLARE_bool(d3d12_readback_resolve);
 
+DECLARE_path(frame_telemetry_path);
+
 DEFINE_bool(fullscreen, false, "Whether to launch the emulator in fullscreen.",
             "Display");
 
@@ -567,6 +571,82 @@ void EmulatorWindow::DisplayConfigDialog::OnDraw(ImGuiIO& io) {
   }
 }
 
+void EmulatorWindow::MouseLatencyDialog::OnDraw(ImGuiIO& io) {
+  hid::InputSystem* input_system = emulator_window_.emulator_->input_system();
+  hid::InputLatencyHistogram* histogram =
+      input_system ? input_system->GetMouseLatencyHistogram() : nullptr;
+
+  ImGui::SetNextWindowPos(ImVec2(20, 20), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowBgAlpha(0.6f);
+  bool dialog_open = true;
+  if (!ImGui::Begin("Mouse input latency", &dialog_open,
+                    ImGuiWindowFlags_NoCollapse |
+                        ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::End();
+    return;
+  }
+
+  if (!histogram) {
+    ImGui::TextUnformatted("No input driver handling the mouse is available.");
+  } else {
+    ImGui::TextUnformatted(
+        "Time from raw mouse input arriving to MouseHook writing it to the "
+        "game's memory.");
+    ImGui::Spacing();
+
+    hid::InputLatencyHistogram::Counts counts = histogram->GetCounts();
+    uint64_t total_count = 0;
+    for (uint64_t count : counts) {
+      total_count += count;
+    }
+    if (!total_count) {
+      ImGui::TextUnformatted("No mouse input has been passed to a game yet.");
+    } else {
+      float bucket_values[hid::InputLatencyHistogram::kBucketCount];
+      for (uint32_t i = 0; i < hid::InputLatencyHistogram::kBucketCount; ++i) {
+        bucket_values[i] = float(counts[i]);
+      }
+      ImGui::PlotHistogram("##MouseLatencyHistogram", bucket_values,
+                           int(hid::InputLatencyHistogram::kBucketCount), 0,
+                           "Power-of-two microsecond buckets", 0.0f, FLT_MAX,
+                           ImVec2(0, 80));
+
+      // Upper bounds of the buckets the percentiles are in.
+      auto get_percentile_us = [&counts, total_count](uint64_t percent) {
+        uint64_t threshold = (total_count * percent + 99) / 100;
+        uint64_t count = 0;
+        for (uint32_t i = 0; i < hid::InputLatencyHistogram::kBucketCount;
+             ++i) {
+          count += counts[i];
+          if (count >= threshold) {
+            return hid::InputLatencyHistogram::GetBucketMinUs(i + 1);
+          }
+        }
+        return hid::InputLatencyHistogram::GetBucketMinUs(
+            hid::InputLatencyHistogram::kBucketCount);
+      };
+      ImGui::TextUnformatted(
+          fmt::format("Samples: {}\n50%: < {} us\n99%: < {} us",
+                      total_count, get_percentile_us(50),
+                      get_percentile_us(99))
+              .c_str());
+    }
+
+    ImGui::Spacing();
+    if (ImGui::Button("Reset")) {
+      histogram->Reset();
+    }
+  }
+
+  ImGui::End();
+
+  if (!dialog_open) {
+    emulator_window_.ToggleMouseLatencyDialog();
+    // `this` might have been destroyed by ToggleMouseLatencyDialog.
+    return;
+  }
+}
+
 bool EmulatorWindow::Initialize() {
   window_->AddListener(&window_listener_);
   window_->AddInputListener(&window_listener_, kZOrderEmulatorWindowInput);
@@ -641,6 +721,9 @@ bool EmulatorWindow::Initialize() {
     cpu_menu->AddChild(MenuItem::Create(MenuItem::Type::kString,
                                         "&Pause/Resume Profiler", "`",
                                         []() { Profiler::TogglePause(); }));
+    cpu_menu->AddChild(MenuItem::Create(
+        MenuItem::Type::kString, "Save &Frame Telemetry", "Shift+F3",
+        std::bind(&EmulatorWindow::SaveFrameTelemetry, this)));
   }
   cpu_menu->AddChild(MenuItem::Create(MenuItem::Type::kSeparator));
   {
@@ -696,6 +779,9 @@ bool EmulatorWindow::Initialize() {
     hid_menu->AddChild(MenuItem::Create(
         MenuItem::Type::kString, "&Display controller hotkeys", "",
         std::bind(&EmulatorWindow::DisplayHotKeysConfig, this)));
+    hid_menu->AddChild(MenuItem::Create(
+        MenuItem::Type::kString, "Show &mouse input latency", "",
+        std::bind(&EmulatorWindow::ToggleMouseLatencyDialog, this)));
   }
   main_menu->AddChild(std::move(hid_menu));
 
@@ -852,7 +938,11 @@ void EmulatorWindow::OnKeyDown(ui::KeyEvent& e) {
     } break;
 
     case ui::VirtualKey::kF3: {
-      Profiler::ToggleDisplay();
+      if (e.is_shift_pressed()) {
+        SaveFrameTelemetry();
+      } else {
+        Profiler::ToggleDisplay();
+      }
     } break;
 
     case ui::VirtualKey::kF4: {
@@ -1371,6 +1461,18 @@ void EmulatorWindow::CpuBreakIntoDebugger() {
 
 void EmulatorWindow::CpuBreakIntoHostDebugger() { xe::debugging::Break(); }
 
+void EmulatorWindow::SaveFrameTelemetry() {
+  if (!frame_telemetry::is_enabled()) {
+    XELOGW("Frame telemetry is not being recorded, enable --frame_telemetry");
+    return;
+  }
+  std::filesystem::path path = cvars::frame_telemetry_path;
+  if (path.empty()) {
+    path = emulator_->storage_root() / "frame_telemetry.csv";
+  }
+  frame_telemetry::WriteFrames(path);
+}
+
 void EmulatorWindow::GpuTraceFrame() {
   emulator()->graphics_system()->RequestFrameTrace();
 }
@@ -1428,6 +1530,15 @@ void EmulatorWindow::ToggleControllerVibration() {
   }
 }
 
+void EmulatorWindow::ToggleMouseLatencyDialog() {
+  if (!mouse_latency_dialog_) {
+    mouse_latency_dialog_ = std::unique_ptr<MouseLatencyDialog>(
+        new MouseLatencyDialog(imgui_drawer_.get(), *this));
+  } else {
+    mouse_latency_dialog_.reset();
+  }
+}
+
 void EmulatorWindow::ShowCompatibility() {
   const std::string_view base_url =
       "https://github.com/xenia-canary/game-compatibility/issues";
@@ -2017,6 +2128,10 @@ xe::X_STATUS EmulatorWindow::RunTitle(
     display_config_dialog_.reset();
   }
 
+  if (mouse_latency_dialog_) {
+    mouse_latency_dialog_.reset();
+  }
+
   imgui_drawer_.get()->ClearDialogs();
 
   if (result) {
@@ -186,6 +186,19 @@ class EmulatorWindow {
     EmulatorWindow& emulator_window_;
   };
 
+  class MouseLatencyDialog final : public ui::ImGuiDialog {
+   public:
+    MouseLatencyDialog(ui::ImGuiDrawer* imgui_drawer,
+                       EmulatorWindow& emulator_window)
+        : ui::ImGuiDialog(imgui_drawer), emulator_window_(emulator_window) {}
+
+   protected:
+    void OnDraw(ImGuiIO& io) override;
+
+   private:
+    EmulatorWindow& emulator_window_;
+  };
+
   explicit EmulatorWindow(Emulator* emulator,
                           ui::WindowedAppContext& app_context, uint32_t width,
                           uint32_t height);
@@ -224,10 +237,12 @@ class EmulatorWindow {
   void CpuTimeScalarSetDouble();
   void CpuBreakIntoDebugger();
   void CpuBreakIntoHostDebugger();
+  void SaveFrameTelemetry();
   void GpuTraceFrame();
   void GpuClearCaches();
   void ToggleDisplayConfigDialog();
   void ToggleControllerVibration();
+  void ToggleMouseLatencyDialog();
   void ShowCompatibility();
   void ShowFAQ();
   void ShowBuildCommit();
@@ -266,6 +281,7 @@ class EmulatorWindow {
   bool initializing_shader_storage_ = false;
 
   std::unique_ptr<DisplayConfigDialog> display_config_dialog_;
+  std::unique_ptr<MouseLatencyDialog> mouse_latency_dialog_;
 
   // Storing pointers and toggling dialog state is useful for broadcasting
   // messages back to guest.
@@ -12,6 +12,7 @@
 
 #include <algorithm>
 
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/profiling.h"
@@ -117,6 +118,8 @@ bool XmaContextNew::Work() {
   if (!is_enabled() || !is_allocated()) {
     return false;
   }
+  frame_telemetry::ScopedCounterTime decode_time(
+      frame_telemetry::Counter::kXmaDecodeTimeUs);
 
   std::lock_guard<xe_mutex> lock(lock_);
   set_is_enabled(false);
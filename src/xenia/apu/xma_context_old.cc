@@ -15,6 +15,7 @@
 #include "xenia/apu/xma_decoder.h"
 #include "xenia/apu/xma_helpers.h"
 #include "xenia/base/bit_stream.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/profiling.h"
@@ -96,6 +97,8 @@ bool XmaContextOld::Work() {
   if (!is_enabled() || !is_allocated()) {
     return false;
   }
+  frame_telemetry::ScopedCounterTime decode_time(
+      frame_telemetry::Counter::kXmaDecodeTimeUs);
   {
     std::lock_guard<xe_mutex> lock(lock_);
     set_is_enabled(false);
@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/boot_trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/mutex.h"
+#include "xenia/base/string.h"
+#include "xenia/base/threading.h"
+
+DEFINE_path(boot_trace_path, "",
+            "If set, the durations of the emulator setup and title launch "
+            "phases are written to this file in the Chrome trace event format "
+            "(chrome://tracing, Perfetto).",
+            "Logging");
+
+namespace xe {
+namespace boot_trace {
+
+namespace {
+
+struct Phase {
+  const char* name;
+  uint32_t thread_id;
+  uint64_t start_us;
+  uint64_t duration_us;
+};
+
+xe_mutex phases_lock;
+std::vector<Phase> phases;
+
+uint64_t GetTimeUs() {
+  // Relative to the first call so the trace starts at 0.
+  static const std::chrono::steady_clock::time_point epoch =
+      std::chrono::steady_clock::now();
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - epoch)
+                      .count());
+}
+
+}  // namespace
+
+bool is_enabled() { return !cvars::boot_trace_path.empty(); }
+
+ScopedPhase::ScopedPhase(const char* name)
+    : name_(name), recording_(is_enabled()) {
+  if (recording_) {
+    start_us_ = GetTimeUs();
+  }
+}
+
+ScopedPhase::~ScopedPhase() {
+  if (!recording_) {
+    return;
+  }
+  Phase phase;
+  phase.name = name_;
+  phase.thread_id = xe::threading::current_thread_system_id();
+  phase.start_us = start_us_;
+  phase.duration_us = GetTimeUs() - start_us_;
+  std::lock_guard<xe_mutex> lock(phases_lock);
+  phases.push_back(phase);
+}
+
+void Flush() {
+  if (!is_enabled()) {
+    return;
+  }
+  // Start the next launch with no phases, so relaunching a title doesn't
+  // write the phases of the previous launches again.
+  std::vector<Phase> phases_copy;
+  {
+    std::lock_guard<xe_mutex> lock(phases_lock);
+    phases_copy.swap(phases);
+  }
+
+  FILE* file = xe::filesystem::OpenFile(cvars::boot_trace_path, "wb");
+  if (!file) {
+    XELOGE("Failed to open the boot trace file {}",
+           xe::path_to_utf8(cvars::boot_trace_path));
+    return;
+  }
+  std::string json = "{\"traceEvents\":[";
+  for (size_t i = 0; i < phases_copy.size(); ++i) {
+    const Phase& phase = phases_copy[i];
+    json += fmt::format(
+        "{}\n{{\"name\":\"{}\",\"cat\":\"boot\",\"ph\":\"X\",\"ts\":{},"
+        "\"dur\":{},\"pid\":1,\"tid\":{}}}",
+        i ? "," : "", phase.name, phase.start_us, phase.duration_us,
+        phase.thread_id);
+  }
+  json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  fwrite(json.data(), 1, json.size(), file);
+  fclose(file);
+  XELOGI("Wrote {} boot phases to {}", phases_copy.size(),
+         xe::path_to_utf8(cvars::boot_trace_path));
+}
+
+}  // namespace boot_trace
+}  // namespace xe
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_BASE_BOOT_TRACE_H_
+#define XENIA_BASE_BOOT_TRACE_H_
+
+#include <cstdint>
+
+namespace xe {
+namespace boot_trace {
+
+// Whether boot phases are being recorded, which is the case if
+// --boot_trace_path is set.
+bool is_enabled();
+
+// Records the time spent by the calling thread in a phase of the emulator
+// setup or of a title launch, from the construction to the destruction.
+// Phases may be nested and may run on multiple threads at once.
+class ScopedPhase {
+ public:
+  // The name must be a string literal - it's not copied, and is written to
+  // the trace without escaping.
+  explicit ScopedPhase(const char* name);
+  ~ScopedPhase();
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+ private:
+  const char* name_;
+  bool recording_;
+  uint64_t start_us_ = 0;
+};
+
+// Writes all the phases recorded since the previous flush to the
+// --boot_trace_path file in the Chrome trace event format, viewable in
+// chrome://tracing or Perfetto, and drops them.
+void Flush();
+
+}  // namespace boot_trace
+}  // namespace xe
+
+#endif  // XENIA_BASE_BOOT_TRACE_H_
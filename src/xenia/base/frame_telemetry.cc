@@ -0,0 +1,245 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/frame_telemetry.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "third_party/fmt/include/fmt/format.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/math.h"
+#include "xenia/base/string.h"
+#include "xenia/base/utf8.h"
+
+DEFINE_bool(frame_telemetry, false,
+            "Record the guest frame time, host presentation time and the work "
+            "done by the emulator for each of the most recent frames. The "
+            "records can be saved with Shift+F3.",
+            "Logging");
+DEFINE_path(frame_telemetry_path, "",
+            "File to save the frame telemetry to on exit and with Shift+F3, "
+            "as JSON if the extension is .json, or as CSV otherwise.",
+            "Logging");
+
+namespace xe {
+namespace frame_telemetry {
+
+namespace {
+
+// Column names for the CSV and keys for the JSON, in the order of the fields
+// in FrameRecord.
+const char* const kFieldNames[] = {
+    "frame",
+    "guest_swap_time_us",
+    "guest_frame_time_us",
+    "vblanks",
+    "host_presents",
+    "host_present_time_us",
+    "pm4_packets",
+    "draws",
+    "texture_uploads",
+    "pipeline_creations",
+    "jit_compiles",
+    "xma_decode_time_us",
+    "command_processor_busy_time_us",
+    "draw_state_reuses",
+};
+constexpr size_t kFieldCount = 6 + size_t(Counter::kCount);
+static_assert(xe::countof(kFieldNames) == kFieldCount,
+              "Frame telemetry field names must match FrameRecord");
+
+std::array<uint64_t, kFieldCount> GetFieldValues(const FrameRecord& record) {
+  std::array<uint64_t, kFieldCount> values = {
+      record.frame_index,
+      record.guest_swap_time_us,
+      record.guest_frame_time_us,
+      record.vblank_count,
+      record.host_present_count,
+      record.host_present_time_us,
+  };
+  std::copy(std::begin(record.counters), std::end(record.counters),
+            values.begin() + 6);
+  return values;
+}
+
+// Accumulated for the current frame.
+std::array<std::atomic<uint64_t>, size_t(Counter::kCount)> counters = {};
+std::atomic<uint32_t> vblank_count = 0;
+std::atomic<uint32_t> host_present_count = 0;
+std::atomic<uint64_t> host_present_time_us = 0;
+
+// Only accessed by the thread doing the guest swaps.
+uint64_t first_swap_time_us = 0;
+uint64_t last_swap_time_us = 0;
+
+// The ring of the most recent frames. Written only by EndGuestFrame, readers
+// copy the records and use the sequence numbers to skip ones that have been
+// overwritten while being copied, so the writer never waits for them.
+struct Slot {
+  // 2 * frame index + 1 while being written, 2 * frame index + 2 after.
+  std::atomic<uint64_t> sequence = 0;
+  FrameRecord record;
+};
+std::array<Slot, kFrameCapacity> slots;
+std::atomic<uint64_t> frames_written = 0;
+// Frames before this were dropped by Clear.
+std::atomic<uint64_t> frames_cleared = 0;
+
+}  // namespace
+
+uint64_t GetTimeUs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count()) +
+         1;
+}
+
+void AddToCounterImpl(Counter counter, uint64_t value) {
+  counters[size_t(counter)].fetch_add(value, std::memory_order_relaxed);
+}
+
+void EndGuestFrame() {
+  if (!is_enabled()) {
+    return;
+  }
+  uint64_t time_us = GetTimeUs();
+
+  FrameRecord record;
+  uint64_t index = frames_written.load(std::memory_order_relaxed);
+  record.frame_index = index;
+  if (!first_swap_time_us) {
+    first_swap_time_us = time_us;
+  }
+  record.guest_swap_time_us = time_us - first_swap_time_us;
+  record.guest_frame_time_us =
+      last_swap_time_us ? time_us - last_swap_time_us : 0;
+  last_swap_time_us = time_us;
+  record.vblank_count = vblank_count.exchange(0, std::memory_order_relaxed);
+  record.host_present_count =
+      host_present_count.exchange(0, std::memory_order_relaxed);
+  record.host_present_time_us =
+      host_present_time_us.exchange(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < size_t(Counter::kCount); ++i) {
+    record.counters[i] = counters[i].exchange(0, std::memory_order_relaxed);
+  }
+
+  Slot& slot = slots[index % kFrameCapacity];
+  slot.sequence.store(index * 2 + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.record = record;
+  slot.sequence.store(index * 2 + 2, std::memory_order_release);
+  frames_written.store(index + 1, std::memory_order_release);
+}
+
+void MarkVblank() {
+  if (is_enabled()) {
+    vblank_count.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void AddHostPresent(uint64_t duration_us) {
+  if (is_enabled()) {
+    host_present_count.fetch_add(1, std::memory_order_relaxed);
+    host_present_time_us.fetch_add(duration_us, std::memory_order_relaxed);
+  }
+}
+
+std::vector<FrameRecord> GetFrames() {
+  uint64_t end = frames_written.load(std::memory_order_acquire);
+  uint64_t begin = std::max(end - std::min(end, uint64_t(kFrameCapacity)),
+                            frames_cleared.load(std::memory_order_relaxed));
+  std::vector<FrameRecord> frames;
+  frames.reserve(size_t(end - std::min(begin, end)));
+  for (uint64_t index = begin; index < end; ++index) {
+    const Slot& slot = slots[index % kFrameCapacity];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != index * 2 + 2) {
+      continue;
+    }
+    FrameRecord record = slot.record;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence) {
+      // Overwritten by a newer frame while copying.
+      continue;
+    }
+    frames.push_back(record);
+  }
+  return frames;
+}
+
+void Clear() {
+  frames_cleared.store(frames_written.load(std::memory_order_acquire),
+                       std::memory_order_relaxed);
+}
+
+bool WriteFrames(const std::filesystem::path& path) {
+  std::vector<FrameRecord> frames = GetFrames();
+
+  bool json = xe::utf8::lower_ascii(xe::path_to_utf8(path.extension())) ==
+              ".json";
+  std::string text;
+  if (json) {
+    text = "{\"frames\":[";
+    for (size_t i = 0; i < frames.size(); ++i) {
+      std::array<uint64_t, kFieldCount> values = GetFieldValues(frames[i]);
+      text += i ? ",\n{" : "\n{";
+      for (size_t j = 0; j < kFieldCount; ++j) {
+        text += fmt::format("{}\"{}\":{}", j ? "," : "", kFieldNames[j],
+                            values[j]);
+      }
+      text += '}';
+    }
+    text += "\n]}\n";
+  } else {
+    for (size_t j = 0; j < kFieldCount; ++j) {
+      text += j ? "," : "";
+      text += kFieldNames[j];
+    }
+    text += '\n';
+    for (const FrameRecord& frame : frames) {
+      std::array<uint64_t, kFieldCount> values = GetFieldValues(frame);
+      for (size_t j = 0; j < kFieldCount; ++j) {
+        text += fmt::format("{}{}", j ? "," : "", values[j]);
+      }
+      text += '\n';
+    }
+  }
+
+  FILE* file = xe::filesystem::OpenFile(path, "wb");
+  if (!file) {
+    XELOGE("Failed to open the frame telemetry file {}",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  bool written = fwrite(text.data(), 1, text.size(), file) == text.size();
+  fclose(file);
+  if (!written) {
+    XELOGE("Failed to write the frame telemetry file {}",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  XELOGI("Wrote telemetry of {} frames to {}", frames.size(),
+         xe::path_to_utf8(path));
+  return true;
+}
+
+void WriteFramesIfRequested() {
+  if (is_enabled() && !cvars::frame_telemetry_path.empty()) {
+    WriteFrames(cvars::frame_telemetry_path);
+  }
+}
+
+}  // namespace frame_telemetry
+}  // namespace xe
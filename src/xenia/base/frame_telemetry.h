@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_BASE_FRAME_TELEMETRY_H_
+#define XENIA_BASE_FRAME_TELEMETRY_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "xenia/base/cvar.h"
+
+DECLARE_bool(frame_telemetry);
+
+namespace xe {
+namespace frame_telemetry {
+
+// Work done by the emulator between two guest swaps, summed from any thread.
+enum class Counter : uint32_t {
+  kPm4Packets,
+  kDraws,
+  kTextureUploads,
+  kPipelineCreations,
+  kJitCompiles,
+  kXmaDecodeTimeUs,
+  kCommandProcessorBusyTimeUs,
+  // Draw state derived from the registers for a previous draw and reused
+  // because the registers haven't been written.
+  kDrawStateReuses,
+
+  kCount,
+};
+
+struct FrameRecord {
+  uint64_t frame_index;
+  // Since the first recorded frame.
+  uint64_t guest_swap_time_us;
+  // Since the previous guest swap.
+  uint64_t guest_frame_time_us;
+  uint32_t vblank_count;
+  uint32_t host_present_count;
+  uint64_t host_present_time_us;
+  uint64_t counters[size_t(Counter::kCount)];
+};
+
+// The number of the most recent frames kept.
+constexpr uint32_t kFrameCapacity = 8192;
+
+inline bool is_enabled() { return cvars::frame_telemetry; }
+
+// Microseconds on a monotonic clock, for measuring durations. Never 0.
+uint64_t GetTimeUs();
+
+void AddToCounterImpl(Counter counter, uint64_t value);
+inline void AddToCounter(Counter counter, uint64_t value = 1) {
+  if (is_enabled()) {
+    AddToCounterImpl(counter, value);
+  }
+}
+
+// Adds the time from the construction to the destruction to a counter.
+class ScopedCounterTime {
+ public:
+  explicit ScopedCounterTime(Counter counter)
+      : counter_(counter), start_us_(is_enabled() ? GetTimeUs() : 0) {}
+  ~ScopedCounterTime() {
+    if (start_us_) {
+      AddToCounterImpl(counter_, GetTimeUs() - start_us_);
+    }
+  }
+
+  ScopedCounterTime(const ScopedCounterTime&) = delete;
+  ScopedCounterTime& operator=(const ScopedCounterTime&) = delete;
+
+ private:
+  Counter counter_;
+  uint64_t start_us_;
+};
+
+// Called by the GPU command processor on a guest swap - closes the current
+// frame record. Must not be called from multiple threads at once.
+void EndGuestFrame();
+void MarkVblank();
+void AddHostPresent(uint64_t duration_us);
+
+// The recorded frames, oldest first.
+std::vector<FrameRecord> GetFrames();
+void Clear();
+
+// Writes the recorded frames to a JSON file if the extension is .json, or to
+// a CSV file otherwise.
+bool WriteFrames(const std::filesystem::path& path);
+// Writes the recorded frames to --frame_telemetry_path if it's set, for
+// saving them on exit.
+void WriteFramesIfRequested();
+
+}  // namespace frame_telemetry
+}  // namespace xe
+
+#endif  // XENIA_BASE_FRAME_TELEMETRY_H_
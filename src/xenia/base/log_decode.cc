@@ -0,0 +1,65 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/string.h"
+
+namespace xe {
+
+DEFINE_transient_path(source, "",
+                      "Specifies the binary log file written with "
+                      "--log_binary_file.",
+                      "General");
+
+DEFINE_transient_path(target, "",
+                      "Specifies the text file to write, or stdout if not "
+                      "specified.",
+                      "General");
+
+int log_decode_main(const std::vector<std::string>& args) {
+  if (cvars::source.empty()) {
+    XELOGE("Usage: {} [source] [target]", xe::path_to_utf8(args[0]));
+    return 1;
+  }
+
+  FILE* source_file = xe::filesystem::OpenFile(cvars::source, "rb");
+  if (!source_file) {
+    XELOGE("Failed to open {}", xe::path_to_utf8(cvars::source));
+    return 1;
+  }
+  FILE* target_file = stdout;
+  if (!cvars::target.empty()) {
+    target_file = xe::filesystem::OpenFile(cvars::target, "wt");
+    if (!target_file) {
+      XELOGE("Failed to open {}", xe::path_to_utf8(cvars::target));
+      fclose(source_file);
+      return 1;
+    }
+  }
+
+  bool decoded;
+  {
+    FileLogSink sink(target_file, target_file != stdout);
+    decoded = DecodeBinaryLog(source_file, sink);
+  }
+  fclose(source_file);
+  return decoded ? 0 : 1;
+}
+
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-log-decode", xe::log_decode_main,
+                      "[source] [target]", "source", "target");
@@ -11,8 +11,10 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <iterator>
 #include <mutex>
 #include <vector>
 
@@ -43,6 +45,7 @@
 #include "xenia/base/platform_win.h"
 #endif  // XE_PLATFORM
 
+#include "third_party/fmt/include/fmt/args.h"
 #include "third_party/fmt/include/fmt/format.h"
 
 #if XE_PLATFORM_ANDROID
@@ -52,9 +55,25 @@ DEFINE_bool(log_to_logcat, true, "Write log output to Android Logcat.",
 DEFINE_path(log_file, "", "Logs are written to the given file", "Logging");
 DEFINE_bool(log_to_stdout, true, "Write log output to stdout", "Logging");
 DEFINE_bool(log_to_debugprint, false, "Dump the log to DebugPrint.", "Logging");
+DEFINE_path(log_binary_file, "",
+            "Write the log to the given file in the binary format instead of "
+            "the text log file. Lines are stored with their format arguments "
+            "when --log_deferred_format is enabled. Use xenia-log-decode to "
+            "convert it to text.",
+            "Logging");
 #endif  // XE_PLATFORM_ANDROID
 DEFINE_bool(flush_log, true, "Flush log file after each log line batch.",
             "Logging");
+DEFINE_uint32(flush_log_interval_ms, 0,
+              "With --flush_log, the minimum time between flushes of the log "
+              "file, in milliseconds. Batches containing errors are always "
+              "flushed. 0 to flush after every batch.",
+              "Logging");
+DEFINE_bool(log_deferred_format, false,
+            "Format log lines on the logging writer thread instead of the "
+            "thread logging them, which is faster for the emulated threads "
+            "with verbose logging.",
+            "Logging");
 
 DEFINE_uint32(log_mask, 0,
               "Disables specific categorizes for more granular debug logging. "
@@ -78,13 +97,62 @@ Logger* logger_ = nullptr;
 struct LogLine {
   size_t buffer_length;
   uint32_t thread_id;
-  uint16_t _pad_0;  // (2b) padding
+  bool deferred;
+  uint8_t _pad_0;  // (1b) padding
   bool terminate;
   char prefix_char;
 };
 
 thread_local char thread_log_buffer_[64_KiB];
 
+// Binary log file layout: kBinaryLogMagic, then a BinaryLogRecord followed by
+// its data for each log line.
+const char kBinaryLogMagic[8] = {'X', 'E', 'L', 'O', 'G', 'B', 'N', '1'};
+
+struct BinaryLogRecord {
+  uint32_t data_length;
+  uint32_t thread_id;
+  char prefix_char;
+  // The data was encoded by logging::internal::EncodeDeferredLogLine rather
+  // than being the text.
+  bool deferred;
+  uint16_t _pad_0;  // (2b) padding
+};
+static_assert(sizeof(BinaryLogRecord) == 12);
+
+// Writes the line with the prefix and the thread ID to the sink, ensuring it
+// ends with a newline.
+void WriteLogLineText(LogSink& sink, char prefix_char, uint32_t thread_id,
+                      const std::string_view text) {
+  if (prefix_char) {
+    char prefix[] = {
+        prefix_char,
+        '>',
+        ' ',
+        '?',  // Thread ID gets placed here (8 chars).
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        '?',
+        ' ',
+        0,
+    };
+    fmt::format_to_n(prefix + 3, sizeof(prefix) - 3, "{:08X}", thread_id);
+    sink.Write(prefix, sizeof(prefix) - 1);
+  }
+  if (!text.empty()) {
+    sink.Write(text.data(), text.size());
+  }
+  // Always ensure there is a newline.
+  if (text.empty() || text.back() != '\n') {
+    const char suffix[1] = {'\n'};
+    sink.Write(suffix, 1);
+  }
+}
+
 FileLogSink::~FileLogSink() {
   if (file_) {
     fflush(file_);
@@ -110,6 +178,34 @@ void DebugPrintLogSink::Write(const char* buf, size_t size) {
   debugging::DebugPrint("{}", std::string_view(buf, size));
 }
 
+bool DecodeBinaryLog(FILE* file, LogSink& sink) {
+  char magic[sizeof(kBinaryLogMagic)];
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+      std::memcmp(magic, kBinaryLogMagic, sizeof(magic))) {
+    XELOGE("Not a binary log file");
+    return false;
+  }
+  std::string data;
+  std::string text;
+  BinaryLogRecord record;
+  while (fread(&record, sizeof(record), 1, file) == 1) {
+    data.resize(record.data_length);
+    if (fread(data.data(), 1, data.size(), file) != data.size()) {
+      XELOGE("Binary log file is truncated");
+      return false;
+    }
+    if (record.deferred) {
+      text.clear();
+      logging::FormatDeferredLogLine(data.data(), data.size(), text);
+      WriteLogLineText(sink, record.prefix_char, record.thread_id, text);
+    } else {
+      WriteLogLineText(sink, record.prefix_char, record.thread_id, data);
+    }
+  }
+  sink.Flush();
+  return true;
+}
+
 #if XE_PLATFORM_ANDROID
 class AndroidLogSink final : public LogSink {
  public:
@@ -237,12 +333,21 @@ class Logger {
   ~Logger() {
     AppendLine(0, '\0', nullptr, 0, true);  // append a terminator
     xe::threading::Wait(write_thread_.get(), true);
+    if (binary_file_) {
+      fclose(binary_file_);
+    }
   }
 
   void AddLogSink(std::unique_ptr<LogSink>&& sink) {
     sinks_.push_back(std::move(sink));
   }
 
+  // Must be called before logging anything.
+  void SetBinaryFile(FILE* file) {
+    binary_file_ = file;
+    fwrite(kBinaryLogMagic, 1, sizeof(kBinaryLogMagic), binary_file_);
+  }
+
  private:
   static const size_t kBufferSize = 8_MiB;
   uint8_t buffer_[kBufferSize];
@@ -267,6 +372,7 @@ class Logger {
   dp::sequence_barrier<dp::spin_wait_strategy> consumed_;
 
   std::vector<std::unique_ptr<LogSink>> sinks_;
+  FILE* binary_file_ = nullptr;
 
   std::unique_ptr<xe::threading::Thread> write_thread_;
 
@@ -276,11 +382,53 @@ class Logger {
     }
   }
 
+  void WriteLine(const LogLine& line, const std::string_view data,
+                 std::string& formatted) {
+    if (binary_file_ && line.prefix_char) {
+      BinaryLogRecord record = {};
+      record.data_length = uint32_t(data.size());
+      record.thread_id = line.thread_id;
+      record.prefix_char = line.prefix_char;
+      record.deferred = line.deferred;
+      fwrite(&record, sizeof(record), 1, binary_file_);
+      fwrite(data.data(), 1, data.size(), binary_file_);
+    }
+    if (sinks_.empty()) {
+      return;
+    }
+    std::string_view text = data;
+    if (line.deferred) {
+      formatted.clear();
+      logging::FormatDeferredLogLine(data.data(), data.size(), formatted);
+      text = formatted;
+    }
+    for (const auto& sink : sinks_) {
+      WriteLogLineText(*sink, line.prefix_char, line.thread_id, text);
+    }
+  }
+
+  void Flush() {
+    for (const auto& sink : sinks_) {
+      sink->Flush();
+    }
+    if (binary_file_) {
+      fflush(binary_file_);
+    }
+  }
+
   void WriteThread() {
     RingBuffer rb(buffer_, kBufferSize);
 
     size_t idle_loops = 0;
 
+    // Reused to avoid allocating for every line.
+    std::string line_data;
+    std::string line_formatted;
+
+    auto last_flush_time = std::chrono::steady_clock::now();
+    // Written lines not flushed yet due to --flush_log_interval_ms.
+    bool flush_pending = false;
+
     dp::sequence_t next_sequence = 0;
     dp::sequence_t last_sequence = -1;
 
@@ -299,6 +447,7 @@ class Logger {
       rb.set_write_offset(BlockOffset(available_range.end()));
 
       bool terminate = false;
+      bool flush_now = false;
       for (size_t i = available_range.first(); i != available_range.end();) {
         rb.set_read_offset(BlockOffset(i));
 
@@ -315,53 +464,13 @@ class Logger {
           read_count += needed_count;
           i += needed_count;
 
-          if (line.prefix_char) {
-            char prefix[] = {
-                line.prefix_char,
-                '>',
-                ' ',
-                '?',  // Thread ID gets placed here (8 chars).
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                '?',
-                ' ',
-                0,
-            };
-            fmt::format_to_n(prefix + 3, sizeof(prefix) - 3, "{:08X}",
-                             line.thread_id);
-            Write(prefix, sizeof(prefix) - 1);
-          }
-
+          line_data.resize(line.buffer_length);
           if (line.buffer_length) {
-            // Get access to the line data - which may be split in the ring
-            // buffer - and write it out in parts.
-            auto line_range = rb.BeginRead(line.buffer_length);
-            Write(reinterpret_cast<const char*>(line_range.first),
-                  line_range.first_length);
-            if (line_range.second_length) {
-              Write(reinterpret_cast<const char*>(line_range.second),
-                    line_range.second_length);
-            }
-
-            // Always ensure there is a newline.
-            char last_char =
-                line_range.second
-                    ? line_range.second[line_range.second_length - 1]
-                    : line_range.first[line_range.first_length - 1];
-            if (last_char != '\n') {
-              const char suffix[1] = {'\n'};
-              Write(suffix, 1);
-            }
-
-            rb.EndRead(std::move(line_range));
-          } else {
-            // Always ensure there is a newline.
-            const char suffix[1] = {'\n'};
-            Write(suffix, 1);
+            rb.Read(line_data.data(), line.buffer_length);
+          }
+          WriteLine(line, line_data, line_formatted);
+          if (line.prefix_char == '!' || line.prefix_char == 'x') {
+            flush_now = true;
           }
 
           if (line.terminate) {
@@ -385,13 +494,26 @@ class Logger {
         desired_count = 1;
 
         if (cvars::flush_log) {
-          for (const auto& sink : sinks_) {
-            sink->Flush();
+          auto now = std::chrono::steady_clock::now();
+          if (flush_now ||
+              now - last_flush_time >=
+                  std::chrono::milliseconds(cvars::flush_log_interval_ms)) {
+            Flush();
+            last_flush_time = now;
+            flush_pending = false;
+          } else {
+            flush_pending = true;
           }
         }
 
         idle_loops = 0;
       } else {
+        if (flush_pending) {
+          // Nothing more to write for now, don't keep the lines unflushed.
+          Flush();
+          last_flush_time = std::chrono::steady_clock::now();
+          flush_pending = false;
+        }
         if (idle_loops >= 1000) {
           // Introduce a waiting period.
           xe::threading::Sleep(std::chrono::milliseconds(50));
@@ -405,7 +527,7 @@ class Logger {
  public:
   void AppendLine(uint32_t thread_id, const char prefix_char,
                   const char* buffer_data, size_t buffer_length,
-                  bool terminate = false) {
+                  bool terminate = false, bool deferred = false) {
     size_t count = BlockCount(sizeof(LogLine) + buffer_length);
 
     auto range = claim_strategy_.claim(count);
@@ -420,6 +542,7 @@ class Logger {
     line.thread_id = thread_id;
     line.prefix_char = prefix_char;
     line.terminate = terminate;
+    line.deferred = deferred;
 
     rb.Write(&line, sizeof(LogLine));
     if (buffer_length) {
@@ -442,7 +565,13 @@ void InitializeLogging(const std::string_view app_name) {
   }
 #else
   FILE* log_file = nullptr;
-  if (cvars::log_file.empty()) {
+  if (!cvars::log_binary_file.empty()) {
+    xe::filesystem::CreateParentFolder(cvars::log_binary_file);
+    FILE* binary_file = xe::filesystem::OpenFile(cvars::log_binary_file, "wb");
+    if (binary_file) {
+      logger_->SetBinaryFile(binary_file);
+    }
+  } else if (cvars::log_file.empty()) {
     // Default to app name.
     auto file_name = fmt::format("{}.log", app_name);
     auto file_path = xe::filesystem::GetExecutableFolder() / file_name;
@@ -451,7 +580,9 @@ void InitializeLogging(const std::string_view app_name) {
     xe::filesystem::CreateParentFolder(cvars::log_file);
     log_file = xe::filesystem::OpenFile(cvars::log_file, "wt");
   }
-  logger_->AddLogSink(std::make_unique<FileLogSink>(log_file, true));
+  if (log_file) {
+    logger_->AddLogSink(std::make_unique<FileLogSink>(log_file, true));
+  }
 
   if (cvars::log_to_stdout) {
     logger_->AddLogSink(std::make_unique<FileLogSink>(stdout, false));
@@ -497,6 +628,146 @@ void logging::internal::AppendLogLine(LogLevel log_level,
                       thread_log_buffer_, written);
 }
 
+bool logging::internal::ShouldDeferFormatting() {
+  return cvars::log_deferred_format;
+}
+
+XE_NOALIAS
+void logging::internal::AppendDeferredLogLine(LogLevel log_level,
+                                              const char prefix_char,
+                                              size_t written) {
+  if (!logger_ || !ShouldLog(log_level) || !written) {
+    return;
+  }
+  logger_->AppendLine(xe::threading::current_thread_id(), prefix_char,
+                      thread_log_buffer_, written, false, true);
+}
+
+namespace {
+
+class DeferredLineDecoder {
+ public:
+  DeferredLineDecoder(const void* data, size_t size)
+      : data_(static_cast<const char*>(data)), size_(size) {}
+
+  bool Read(void* value, size_t size) {
+    if (size > size_ - offset_) {
+      return false;
+    }
+    std::memcpy(value, data_ + offset_, size);
+    offset_ += size;
+    return true;
+  }
+  template <typename T>
+  bool ReadValue(T& value) {
+    return Read(&value, sizeof(value));
+  }
+  bool ReadString(std::string_view& str) {
+    uint32_t length;
+    if (!ReadValue(length) || length > size_ - offset_) {
+      return false;
+    }
+    str = std::string_view(data_ + offset_, length);
+    offset_ += length;
+    return true;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+using DeferredArgStore = fmt::dynamic_format_arg_store<fmt::format_context>;
+
+template <typename T>
+bool PushDeferredArg(DeferredLineDecoder& decoder, DeferredArgStore& store) {
+  T value;
+  if (!decoder.ReadValue(value)) {
+    return false;
+  }
+  store.push_back(value);
+  return true;
+}
+
+}  // namespace
+
+bool logging::FormatDeferredLogLine(const void* data, size_t size,
+                                    std::string& out) {
+  using internal::DeferredArgType;
+  DeferredLineDecoder decoder(data, size);
+  std::string_view format;
+  uint8_t arg_count;
+  if (!decoder.ReadString(format) || !decoder.ReadValue(arg_count)) {
+    out.append("<malformed log line>");
+    return false;
+  }
+  DeferredArgStore store;
+  store.reserve(arg_count, 0);
+  bool args_valid = true;
+  for (uint8_t i = 0; args_valid && i < arg_count; ++i) {
+    DeferredArgType type;
+    if (!decoder.ReadValue(type)) {
+      args_valid = false;
+      break;
+    }
+    switch (type) {
+      case DeferredArgType::kBool:
+        args_valid = PushDeferredArg<bool>(decoder, store);
+        break;
+      case DeferredArgType::kChar:
+        args_valid = PushDeferredArg<char>(decoder, store);
+        break;
+      case DeferredArgType::kInt64:
+        args_valid = PushDeferredArg<int64_t>(decoder, store);
+        break;
+      case DeferredArgType::kUint64:
+        args_valid = PushDeferredArg<uint64_t>(decoder, store);
+        break;
+      case DeferredArgType::kFloat:
+        args_valid = PushDeferredArg<float>(decoder, store);
+        break;
+      case DeferredArgType::kDouble:
+        args_valid = PushDeferredArg<double>(decoder, store);
+        break;
+      case DeferredArgType::kString: {
+        std::string_view str;
+        args_valid = decoder.ReadString(str);
+        if (args_valid) {
+          // Points into the data, which outlives the store.
+          store.push_back(fmt::string_view(str.data(), str.size()));
+        }
+      } break;
+      case DeferredArgType::kPointer: {
+        uint64_t pointer;
+        args_valid = decoder.ReadValue(pointer);
+        if (args_valid) {
+          store.push_back(
+              reinterpret_cast<const void*>(uintptr_t(pointer)));
+        }
+      } break;
+      default:
+        args_valid = false;
+        break;
+    }
+  }
+  size_t out_start = out.size();
+  if (args_valid) {
+    try {
+      fmt::vformat_to(std::back_inserter(out),
+                      fmt::string_view(format.data(), format.size()), store);
+      return true;
+    } catch (const fmt::format_error&) {
+      // Drop the partially formatted line.
+      out.resize(out_start);
+    }
+  }
+  // Keep the format string at least.
+  out.append(format);
+  out.append(" <malformed log arguments>");
+  return false;
+}
+
 void logging::AppendLogLine(LogLevel log_level, const char prefix_char,
                             const std::string_view str, uint32_t log_mask) {
   if (!internal::ShouldLog(log_level, log_mask) || !str.size()) {
@@ -12,7 +12,10 @@
 
 #include <cstdarg>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/string.h"
@@ -74,6 +77,9 @@ class DebugPrintLogSink final : public LogSink {
   void Flush() override {}
 };
 
+// Formats a binary log written with --log_binary_file into the sink as text.
+bool DecodeBinaryLog(FILE* file, LogSink& sink);
+
 // Initializes the logging system and any outputs requested.
 // Must be called on startup.
 void InitializeLogging(const std::string_view app_name);
@@ -91,7 +97,145 @@ std::pair<char*, size_t> GetThreadBuffer();
 XE_NOALIAS
 void AppendLogLine(LogLevel log_level, const char prefix_char, size_t written);
 
+// Deferred formatting: instead of formatting on the logging thread, the format
+// string and the arguments are copied into the thread buffer, and the line is
+// formatted by the writer thread, or by xenia-log-decode for binary logs.
+bool ShouldDeferFormatting();
+XE_NOALIAS
+void AppendDeferredLogLine(LogLevel log_level, const char prefix_char,
+                           size_t written);
+
+enum class DeferredArgType : uint8_t {
+  kUnsupported,
+  kBool,
+  kChar,
+  kInt64,
+  kUint64,
+  kFloat,
+  kDouble,
+  kString,
+  kPointer,
+};
+
+// Types with custom formatters are not captured, lines using them are
+// formatted immediately.
+template <typename T>
+constexpr DeferredArgType GetDeferredArgType() {
+  using U = std::remove_cv_t<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    return DeferredArgType::kBool;
+  } else if constexpr (std::is_same_v<U, char>) {
+    return DeferredArgType::kChar;
+  } else if constexpr (std::is_integral_v<U>) {
+    return std::is_signed_v<U> ? DeferredArgType::kInt64
+                               : DeferredArgType::kUint64;
+  } else if constexpr (std::is_same_v<U, float>) {
+    return DeferredArgType::kFloat;
+  } else if constexpr (std::is_same_v<U, double>) {
+    return DeferredArgType::kDouble;
+  } else if constexpr (std::is_same_v<U, const char*> ||
+                       std::is_same_v<U, char*> ||
+                       std::is_same_v<U, std::string> ||
+                       std::is_same_v<U, std::string_view>) {
+    return DeferredArgType::kString;
+  } else if constexpr (std::is_array_v<U> &&
+                       std::is_same_v<std::remove_cv_t<std::remove_extent_t<U>>,
+                                      char>) {
+    return DeferredArgType::kString;
+  } else if constexpr (std::is_same_v<U, const void*> ||
+                       std::is_same_v<U, void*>) {
+    return DeferredArgType::kPointer;
+  } else {
+    return DeferredArgType::kUnsupported;
+  }
+}
+
+template <typename... Args>
+constexpr bool CanDeferFormatting() {
+  return ((GetDeferredArgType<Args>() != DeferredArgType::kUnsupported) &&
+          ...);
+}
+
+// Layout: uint32 format length, format, uint8 argument count, and for each
+// argument a DeferredArgType byte and the value - 1 byte for bool and char, 4
+// for float, 8 for the other scalars, and uint32 length and the characters
+// for strings. Values are in the host byte order and unaligned.
+class DeferredLineEncoder {
+ public:
+  DeferredLineEncoder(char* buffer, size_t capacity)
+      : buffer_(buffer), capacity_(capacity) {}
+
+  // 0 if the line doesn't fit in the buffer or can't be captured.
+  size_t size() const { return failed_ ? 0 : size_; }
+
+  void Write(const void* data, size_t size) {
+    if (failed_ || size > capacity_ - size_) {
+      failed_ = true;
+      return;
+    }
+    std::memcpy(buffer_ + size_, data, size);
+    size_ += size;
+  }
+  template <typename T>
+  void WriteValue(T value) {
+    Write(&value, sizeof(value));
+  }
+  void WriteString(const std::string_view str) {
+    WriteValue(uint32_t(str.size()));
+    Write(str.data(), str.size());
+  }
+
+  template <typename T>
+  void WriteArg(const T& arg) {
+    constexpr DeferredArgType type = GetDeferredArgType<T>();
+    WriteValue(type);
+    if constexpr (type == DeferredArgType::kBool ||
+                  type == DeferredArgType::kChar ||
+                  type == DeferredArgType::kFloat ||
+                  type == DeferredArgType::kDouble) {
+      WriteValue(arg);
+    } else if constexpr (type == DeferredArgType::kInt64) {
+      WriteValue(int64_t(arg));
+    } else if constexpr (type == DeferredArgType::kUint64) {
+      WriteValue(uint64_t(arg));
+    } else if constexpr (type == DeferredArgType::kPointer) {
+      WriteValue(uint64_t(reinterpret_cast<uintptr_t>(arg)));
+    } else if constexpr (std::is_pointer_v<T>) {
+      // {fmt} rejects null strings, leave it to the immediate formatting.
+      if (!arg) {
+        failed_ = true;
+        return;
+      }
+      WriteString(arg);
+    } else {
+      WriteString(std::string_view(arg));
+    }
+  }
+
+ private:
+  char* buffer_;
+  size_t capacity_;
+  size_t size_ = 0;
+  bool failed_ = false;
+};
+
+template <typename... Args>
+size_t EncodeDeferredLogLine(char* buffer, size_t capacity, const char* format,
+                             const Args&... args) {
+  static_assert(sizeof...(Args) <= UINT8_MAX);
+  DeferredLineEncoder encoder(buffer, capacity);
+  encoder.WriteString(format);
+  encoder.WriteValue(uint8_t(sizeof...(Args)));
+  (encoder.WriteArg(args), ...);
+  return encoder.size();
+}
+
 }  // namespace internal
+
+// Formats a line captured by internal::EncodeDeferredLogLine. If the data is
+// malformed or doesn't match the format, writes what could be recovered and
+// returns false.
+bool FormatDeferredLogLine(const void* data, size_t size, std::string& out);
 // technically, noalias is incorrect here, these functions do in fact alias
 // global memory, but msvc will not optimize the calls away, and the global
 // memory modified by the calls is limited to internal logging variables, so it
@@ -101,6 +245,16 @@ XE_NOALIAS XE_NOINLINE XE_COLD static void AppendLogLineFormat_Impl(
     LogLevel log_level, const char prefix_char, const char* format,
     const Args&... args) {
   auto target = internal::GetThreadBuffer();
+  if constexpr (internal::CanDeferFormatting<Args...>()) {
+    if (internal::ShouldDeferFormatting()) {
+      size_t size = internal::EncodeDeferredLogLine(
+          target.first, target.second, format, args...);
+      if (size) {
+        internal::AppendDeferredLogLine(log_level, prefix_char, size);
+        return;
+      }
+    }
+  }
   auto result = fmt::format_to_n(target.first, target.second, format, args...);
   internal::AppendLogLine(log_level, prefix_char, result.size);
 }
@@ -23,6 +23,18 @@ DEFINE_bool(
     "Allow mapping memory with both write and execute access, for simulating "
     "behavior on platforms where that's not supported",
     "Memory");
+DEFINE_bool(
+    large_pages, false,
+    "Back the guest memory and the generated code with large pages where "
+    "supported by the host (transparent huge pages on Linux) to reduce TLB "
+    "misses. May increase the host memory usage.",
+    "Memory");
+DEFINE_bool(
+    copy_and_swap_non_temporal_stores, false,
+    "Write the results of large (1 MB or more) byte-swapping copies, such as "
+    "texture and buffer uploads, bypassing the CPU caches. May be faster on "
+    "hosts with high memory bandwidth, but slower on others.",
+    "Memory");
 
 namespace xe {
 namespace memory {
@@ -32,6 +44,8 @@ bool IsWritableExecutableMemoryPreferred() {
          cvars::writable_executable_memory;
 }
 
+bool IsLargePageMemoryPreferred() { return cvars::large_pages; }
+
 using xe::swcache::CacheLine;
 
 static constexpr unsigned NUM_CACHELINES_IN_PAGE = 4096 / sizeof(CacheLine);
@@ -220,15 +234,6 @@ void vastcpy(uint8_t* XE_RESTRICT physaddr, uint8_t* XE_RESTRICT rdmapping,
 }
 }  // namespace memory
 
-// TODO(benvanik): fancy AVX versions.
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_16u_byteswap.h
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_32u_byteswap.h
-// https://github.com/gnuradio/volk/blob/master/kernels/volk/volk_64u_byteswap.h
-// Original links:
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/cb32b70b79f430456208a2cd521d028e0ece5d5b/entry/volk/kernels/volk/volk_16u_byteswap.h
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/f2bc76cc65ffba51a141950f98e75364e49df874/entry/volk/kernels/volk/volk_32u_byteswap.h
-// https://gnuradio.org/redmine/projects/gnuradio/repository/revisions/2c4c371885c31222362f70a1cd714415d1398021/entry/volk/kernels/volk/volk_64u_byteswap.h
-
 void copy_128_aligned(void* dest, const void* src, size_t count) {
   std::memcpy(dest, src, count * 16);
 }
@@ -244,216 +249,240 @@ void copy_128_aligned(void* dest, const void* src, size_t count) {
 #else
 #define XE_WORKAROUND_CONSTANT_RETURN_IF(x)
 #endif
-void copy_and_swap_16_aligned(void* dest_ptr, const void* src_ptr,
-                              size_t count) {
-  assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
-  assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
 
-  auto dest = reinterpret_cast<uint16_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint16_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0E, 0x0F, 0x0C, 0x0D, 0x0A, 0x0B, 0x08, 0x09, 0x06, 0x07,
-                   0x04, 0x05, 0x02, 0x03, 0x00, 0x01);
-
-  size_t i = 0;
-  for (i = 0; i + 8 <= count; i += 8) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
+// The wider kernels are chosen at runtime, while the rest of the code is
+// compiled for the minimum requirements (AVX) - Clang and GCC only allow using
+// the intrinsics in functions explicitly targeting the extensions.
+#if XE_COMPILER_HAS_GNU_EXTENSIONS
+#define XE_BASE_MEMORY_TARGET_AVX2 __attribute__((target("avx2")))
+#define XE_BASE_MEMORY_TARGET_AVX512 \
+  __attribute__((target("avx2,avx512f,avx512vl,avx512bw")))
+#else
+#define XE_BASE_MEMORY_TARGET_AVX2
+#define XE_BASE_MEMORY_TARGET_AVX512
+#endif  // XE_COMPILER_HAS_GNU_EXTENSIONS
+
+namespace {
+
+// Copies of at least this many bytes (large textures, shared memory uploads)
+// may be written with non-temporal stores - the destination is usually
+// consumed by the GPU, and such copies would evict most of the CPU caches
+// anyway.
+constexpr size_t kCopyAndSwapNonTemporalMinSize = 1024 * 1024;
+// How far ahead of the current position the source is prefetched when using
+// non-temporal stores - the hardware prefetchers don't cross page boundaries.
+constexpr size_t kCopyAndSwapPrefetchDistance = 512;
+
+// Every swap is a byte permutation within each 16-byte lane, so the same
+// vpshufb works for all vector widths - no need for VBMI cross-lane permutes.
+// The permutation is the index of the byte XORed with kByteIndexXor.
+template <typename T, uint8_t kByteIndexXor>
+struct ByteSwapTraits {
+  using Element = T;
+  static T Swap(T value) { return byte_swap(value); }
+  static __m128i LaneShuffle() {
+    return _mm_xor_si128(
+        _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+        _mm_set1_epi8(kByteIndexXor));
+  }
+};
+using Swap16Traits = ByteSwapTraits<uint16_t, 0b001>;
+using Swap32Traits = ByteSwapTraits<uint32_t, 0b011>;
+using Swap64Traits = ByteSwapTraits<uint64_t, 0b111>;
+struct Swap16In32Traits : ByteSwapTraits<uint32_t, 0b010> {
+  static uint32_t Swap(uint32_t value) {
+    return (value >> 16) | (value << 16);
+  }
+};
+
+template <typename Traits>
+void CopyAndSwapSSSE3(void* dest_ptr, const void* src_ptr, size_t count) {
+  using Element = typename Traits::Element;
+  constexpr size_t kVectorElements = sizeof(__m128i) / sizeof(Element);
+  auto dest = reinterpret_cast<Element*>(dest_ptr);
+  auto src = reinterpret_cast<const Element*>(src_ptr);
+  __m128i shufmask = Traits::LaneShuffle();
+  size_t i;
+  for (i = 0; i + kVectorElements <= count; i += kVectorElements) {
+    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
     __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 8 == 0);
+  XE_WORKAROUND_CONSTANT_RETURN_IF(count % kVectorElements == 0);
   for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+    dest[i] = Traits::Swap(src[i]);
   }
 }
 
-void copy_and_swap_16_unaligned(void* dest_ptr, const void* src_ptr,
-                                size_t count) {
-  auto dest = reinterpret_cast<uint16_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint16_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0E, 0x0F, 0x0C, 0x0D, 0x0A, 0x0B, 0x08, 0x09, 0x06, 0x07,
-                   0x04, 0x05, 0x02, 0x03, 0x00, 0x01);
-
-  size_t i;
-  for (i = 0; i + 8 <= count; i += 8) {
+template <typename Traits>
+XE_BASE_MEMORY_TARGET_AVX2 void CopyAndSwapAVX2(void* dest_ptr,
+                                                const void* src_ptr,
+                                                size_t count,
+                                                bool non_temporal) {
+  using Element = typename Traits::Element;
+  constexpr size_t kVectorElements = sizeof(__m256i) / sizeof(Element);
+  auto dest = reinterpret_cast<Element*>(dest_ptr);
+  auto src = reinterpret_cast<const Element*>(src_ptr);
+  __m256i shufmask = _mm256_broadcastsi128_si256(Traits::LaneShuffle());
+  size_t i = 0;
+  if (non_temporal &&
+      !(reinterpret_cast<uintptr_t>(dest) & (sizeof(Element) - 1))) {
+    // Align the destination for the streaming stores.
+    for (; reinterpret_cast<uintptr_t>(&dest[i]) & (sizeof(__m256i) - 1);
+         ++i) {
+      dest[i] = Traits::Swap(src[i]);
+    }
+    // One cache line per iteration.
+    for (; i + 2 * kVectorElements <= count; i += 2 * kVectorElements) {
+      swcache::PrefetchNTA(reinterpret_cast<const uint8_t*>(&src[i]) +
+                           kCopyAndSwapPrefetchDistance);
+      __m256i input1 =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+      __m256i input2 = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(&src[i + kVectorElements]));
+      _mm256_stream_si256(reinterpret_cast<__m256i*>(&dest[i]),
+                          _mm256_shuffle_epi8(input1, shufmask));
+      _mm256_stream_si256(
+          reinterpret_cast<__m256i*>(&dest[i + kVectorElements]),
+          _mm256_shuffle_epi8(input2, shufmask));
+    }
+    _mm_sfence();
+  }
+  // With vpshufb having a throughput of 2 per cycle on most hosts, doubling up
+  // on the iterations.
+  for (; i + 2 * kVectorElements <= count; i += 2 * kVectorElements) {
+    __m256i input1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+    __m256i input2 = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(&src[i + kVectorElements]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]),
+                        _mm256_shuffle_epi8(input1, shufmask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i + kVectorElements]),
+                        _mm256_shuffle_epi8(input2, shufmask));
+  }
+  if (i + kVectorElements <= count) {
+    __m256i input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]),
+                        _mm256_shuffle_epi8(input, shufmask));
+    i += kVectorElements;
+  }
+  if (i + kVectorElements / 2 <= count) {
     __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(&dest[i]),
+        _mm_shuffle_epi8(input, _mm256_castsi256_si128(shufmask)));
+    i += kVectorElements / 2;
   }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 8 == 0);
   for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
+    dest[i] = Traits::Swap(src[i]);
   }
 }
 
-void copy_and_swap_32_aligned(void* dest_ptr, const void* src_ptr,
+template <typename Traits>
+XE_BASE_MEMORY_TARGET_AVX512 void CopyAndSwapAVX512(void* dest_ptr,
+                                                    const void* src_ptr,
+                                                    size_t count,
+                                                    bool non_temporal) {
+  using Element = typename Traits::Element;
+  constexpr size_t kVectorElements = sizeof(__m512i) / sizeof(Element);
+  auto dest = reinterpret_cast<Element*>(dest_ptr);
+  auto src = reinterpret_cast<const Element*>(src_ptr);
+  __m512i shufmask = _mm512_broadcast_i32x4(Traits::LaneShuffle());
+  size_t i = 0;
+  if (non_temporal &&
+      !(reinterpret_cast<uintptr_t>(dest) & (sizeof(Element) - 1))) {
+    // Align the destination for the streaming stores.
+    for (; reinterpret_cast<uintptr_t>(&dest[i]) & (sizeof(__m512i) - 1);
+         ++i) {
+      dest[i] = Traits::Swap(src[i]);
+    }
+    for (; i + kVectorElements <= count; i += kVectorElements) {
+      swcache::PrefetchNTA(reinterpret_cast<const uint8_t*>(&src[i]) +
+                           kCopyAndSwapPrefetchDistance);
+      __m512i input = _mm512_loadu_si512(&src[i]);
+      _mm512_stream_si512(reinterpret_cast<__m512i*>(&dest[i]),
+                          _mm512_shuffle_epi8(input, shufmask));
+    }
+    _mm_sfence();
+  }
+  for (; i + kVectorElements <= count; i += kVectorElements) {
+    __m512i input = _mm512_loadu_si512(&src[i]);
+    _mm512_storeu_si512(&dest[i], _mm512_shuffle_epi8(input, shufmask));
+  }
+  if (i < count) {
+    // Masked access doesn't fault on the bytes outside the mask.
+    __mmask64 tail_mask =
+        (uint64_t(1) << ((count - i) * sizeof(Element))) - 1;
+    __m512i input = _mm512_maskz_loadu_epi8(tail_mask, &src[i]);
+    _mm512_mask_storeu_epi8(&dest[i], tail_mask,
+                            _mm512_shuffle_epi8(input, shufmask));
+  }
+}
+
+template <typename Traits>
+void CopyAndSwap(void* dest, const void* src, size_t count) {
+  constexpr uint64_t kAVX512FeatureFlags =
+      amd64::kX64EmitAVX512Ortho | amd64::kX64EmitAVX512BW;
+  uint64_t feature_flags = amd64::GetFeatureFlags();
+  bool non_temporal = cvars::copy_and_swap_non_temporal_stores &&
+                      count * sizeof(typename Traits::Element) >=
+                          kCopyAndSwapNonTemporalMinSize;
+  if ((feature_flags & kAVX512FeatureFlags) == kAVX512FeatureFlags) {
+    CopyAndSwapAVX512<Traits>(dest, src, count, non_temporal);
+  } else if (feature_flags & amd64::kX64EmitAVX2) {
+    CopyAndSwapAVX2<Traits>(dest, src, count, non_temporal);
+  } else {
+    CopyAndSwapSSSE3<Traits>(dest, src, count);
+  }
+}
+
+}  // namespace
+
+void copy_and_swap_16_aligned(void* dest_ptr, const void* src_ptr,
                               size_t count) {
   assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
   assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
+  CopyAndSwap<Swap16Traits>(dest_ptr, src_ptr, count);
+}
 
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05,
-                   0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
+void copy_and_swap_16_unaligned(void* dest_ptr, const void* src_ptr,
+                                size_t count) {
+  CopyAndSwap<Swap16Traits>(dest_ptr, src_ptr, count);
+}
 
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
-  }
+void copy_and_swap_32_aligned(void* dest_ptr, const void* src_ptr,
+                              size_t count) {
+  assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
+  assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
+  CopyAndSwap<Swap32Traits>(dest_ptr, src_ptr, count);
 }
 
 void copy_and_swap_32_unaligned(void* dest_ptr, const void* src_ptr,
                                 size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  // chrispy: this optimization mightt backfire if our unaligned load spans two
-  // cachelines... which it probably will
-  if (amd64::GetFeatureFlags() & amd64::kX64EmitAVX2) {
-    __m256i shufmask = _mm256_set_epi8(
-        0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05, 0x06, 0x07,
-        0x00, 0x01, 0x02, 0x03, 0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B,
-        0x04, 0x05, 0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
-    // with vpshufb being a 0.5 through instruction, it makes the most sense to
-    // double up on our iters
-    for (i = 0; i + 16 <= count; i += 16) {
-      __m256i input1 =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
-      __m256i input2 =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i + 8]));
-
-      __m256i output1 = _mm256_shuffle_epi8(input1, shufmask);
-      __m256i output2 = _mm256_shuffle_epi8(input2, shufmask);
-// chrispy: todo, benchmark this w/ and w/out these prefetches here on multiple
-// machines finding a good distance for prefetchw in particular is probably
-// important for when we're writing across 2 cachelines
-#if 0
-      if (i + 48 <= count) {
-        swcache::PrefetchNTA(&src[i + 32]);
-        if (amd64::GetFeatureFlags() & amd64::kX64EmitPrefetchW) {
-          swcache::PrefetchW(&dest[i + 32]);
-        }
-      }
-#endif
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output1);
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i + 8]), output2);
-    }
-    if (i + 8 <= count) {
-      __m256i input =
-          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&src[i]));
-      __m256i output = _mm256_shuffle_epi8(input, shufmask);
-      _mm256_storeu_si256(reinterpret_cast<__m256i*>(&dest[i]), output);
-      i += 8;
-    }
-    if (i + 4 <= count) {
-      __m128i input =
-          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-      __m128i output =
-          _mm_shuffle_epi8(input, _mm256_castsi256_si128(shufmask));
-      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-      i += 4;
-    }
-  } else {
-    __m128i shufmask =
-        _mm_set_epi8(0x0C, 0x0D, 0x0E, 0x0F, 0x08, 0x09, 0x0A, 0x0B, 0x04, 0x05,
-                     0x06, 0x07, 0x00, 0x01, 0x02, 0x03);
-
-    for (i = 0; i + 4 <= count; i += 4) {
-      __m128i input =
-          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-      __m128i output = _mm_shuffle_epi8(input, shufmask);
-      _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-    }
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
-  }
+  CopyAndSwap<Swap32Traits>(dest_ptr, src_ptr, count);
 }
 
 void copy_and_swap_64_aligned(void* dest_ptr, const void* src_ptr,
                               size_t count) {
   assert_zero(reinterpret_cast<uintptr_t>(dest_ptr) & 0xF);
   assert_zero(reinterpret_cast<uintptr_t>(src_ptr) & 0xF);
-
-  auto dest = reinterpret_cast<uint64_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint64_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x01,
-                   0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
-
-  size_t i;
-  for (i = 0; i + 2 <= count; i += 2) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 2 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
-  }
+  CopyAndSwap<Swap64Traits>(dest_ptr, src_ptr, count);
 }
 
 void copy_and_swap_64_unaligned(void* dest_ptr, const void* src_ptr,
                                 size_t count) {
-  auto dest = reinterpret_cast<uint64_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint64_t*>(src_ptr);
-  __m128i shufmask =
-      _mm_set_epi8(0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x00, 0x01,
-                   0x02, 0x03, 0x04, 0x05, 0x06, 0x07);
-
-  size_t i;
-  for (i = 0; i + 2 <= count; i += 2) {
-    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output = _mm_shuffle_epi8(input, shufmask);
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 2 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = byte_swap(src[i]);
-  }
+  CopyAndSwap<Swap64Traits>(dest_ptr, src_ptr, count);
 }
 
 void copy_and_swap_16_in_32_aligned(void* dest_ptr, const void* src_ptr,
                                     size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_load_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output =
-        _mm_or_si128(_mm_slli_epi32(input, 16), _mm_srli_epi32(input, 16));
-    _mm_store_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = (src[i] >> 16) | (src[i] << 16);
-  }
+  CopyAndSwap<Swap16In32Traits>(dest_ptr, src_ptr, count);
 }
 
 void copy_and_swap_16_in_32_unaligned(void* dest_ptr, const void* src_ptr,
                                       size_t count) {
-  auto dest = reinterpret_cast<uint32_t*>(dest_ptr);
-  auto src = reinterpret_cast<const uint32_t*>(src_ptr);
-  size_t i;
-  for (i = 0; i + 4 <= count; i += 4) {
-    __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&src[i]));
-    __m128i output =
-        _mm_or_si128(_mm_slli_epi32(input, 16), _mm_srli_epi32(input, 16));
-    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dest[i]), output);
-  }
-  XE_WORKAROUND_CONSTANT_RETURN_IF(count % 4 == 0);
-  for (; i < count; ++i) {  // handle residual elements
-    dest[i] = (src[i] >> 16) | (src[i] << 16);
-  }
+  CopyAndSwap<Swap16In32Traits>(dest_ptr, src_ptr, count);
 }
 
 #elif XE_ARCH_ARM64
@@ -89,6 +89,17 @@ bool IsWritableExecutableMemorySupported();
 // writable executable memory on a system with it.
 bool IsWritableExecutableMemoryPreferred();
 
+// Whether large blocks of memory accessed all the time, like the guest memory
+// and the generated code, should be backed by large pages to reduce TLB misses.
+bool IsLargePageMemoryPreferred();
+
+// Asks the host to back the block of memory with large pages where possible
+// (transparent huge pages on Linux). The pages are still protected with
+// page_size() granularity, the host splits the large pages for that. Returns
+// false if not supported by the host, in which case the memory remains usable
+// with the normal pages.
+bool AdviseLargePages(void* base_address, size_t length);
+
 // Allocates a block of memory at the given page-aligned base address.
 // Fails if the memory is not available.
 // Specify nullptr for base_address to leave it up to the system.
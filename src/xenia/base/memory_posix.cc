@@ -95,9 +95,15 @@ void* AllocFixed(void* base_address, size_t length,
                       MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0);
   if (result == MAP_FAILED) {
     return nullptr;
-  } else {
-    return result;
   }
+  // A new mapping replaces the advice given for the range previously, and
+  // mappings of neighboring commits can only be merged if the advice is the
+  // same for them.
+  if ((uint32_t(allocation_type) & uint32_t(AllocationType::kCommit)) &&
+      IsLargePageMemoryPreferred()) {
+    AdviseLargePages(result, length);
+  }
+  return result;
 }
 
 bool DeallocFixed(void* base_address, size_t length,
@@ -118,6 +124,15 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return false;
 }
 
+bool AdviseLargePages(void* base_address, size_t length) {
+#ifdef MADV_HUGEPAGE
+  // Fails with EINVAL if the kernel is built without transparent huge pages.
+  return madvise(base_address, length, MADV_HUGEPAGE) == 0;
+#else
+  return false;
+#endif  // MADV_HUGEPAGE
+}
+
 FileMappingHandle CreateFileMappingHandle(const std::filesystem::path& path,
                                           size_t length, PageAccess access,
                                           bool commit) {
@@ -210,6 +210,12 @@ bool QueryProtect(void* base_address, size_t& length, PageAccess& access_out) {
   return true;
 }
 
+bool AdviseLargePages(void* base_address, size_t length) {
+  // MEM_LARGE_PAGES requires SeLockMemoryPrivilege, must be specified when
+  // allocating, and the protection of large pages can't be changed partially.
+  return false;
+}
+
 FileMappingHandle CreateFileMappingHandle(const std::filesystem::path& path,
                                           size_t length, PageAccess access,
                                           bool commit) {
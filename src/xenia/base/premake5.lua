@@ -13,8 +13,27 @@ project("xenia-base")
   local_platform_files()
   removefiles({"console_app_main_*.cc"})
   removefiles({"main_init_*.cc"})
+  removefiles({"log_decode.cc"})
   files({
     "debug_visualizers.natvis",
   })
 
+project("xenia-log-decode")
+  uuid("5b0d3c1e-8f47-4a2b-9e61-3d7a90c4f2b8")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "fmt",
+    "xenia-base",
+  })
+  defines({})
+
+  files({
+    "log_decode.cc",
+    "console_app_main_"..platform_suffix..".cc",
+  })
+  resincludedirs({
+    project_root,
+  })
+
 include("testing")
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/boot_trace.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "xenia/base/cvar.h"
+#include "xenia/base/threading.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+DECLARE_path(boot_trace_path);
+
+namespace xe::base::test {
+
+TEST_CASE("Boot phases are written as Chrome trace events", "[boot_trace]") {
+  std::filesystem::path trace_path =
+      std::filesystem::temp_directory_path() / "xenia-boot-trace-test.json";
+  std::filesystem::remove(trace_path);
+
+  cvars::boot_trace_path = trace_path;
+  REQUIRE(boot_trace::is_enabled());
+  {
+    boot_trace::ScopedPhase outer_phase("Outer phase");
+    { boot_trace::ScopedPhase inner_phase("Inner phase"); }
+    auto thread = xe::threading::Thread::Create(
+        {}, []() { boot_trace::ScopedPhase phase("Worker phase"); });
+    REQUIRE(thread);
+    xe::threading::Wait(thread.get(), false);
+  }
+  boot_trace::Flush();
+  cvars::boot_trace_path.clear();
+  REQUIRE_FALSE(boot_trace::is_enabled());
+
+  std::ifstream trace_file(trace_path);
+  REQUIRE(trace_file.is_open());
+  std::string trace((std::istreambuf_iterator<char>(trace_file)),
+                    std::istreambuf_iterator<char>());
+  trace_file.close();
+  REQUIRE(trace.rfind("{\"traceEvents\":[", 0) == 0);
+  REQUIRE(trace.find("\"name\":\"Outer phase\"") != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"Inner phase\"") != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"Worker phase\"") != std::string::npos);
+  REQUIRE(trace.find("\"ph\":\"X\"") != std::string::npos);
+
+  // The next flush only writes the phases recorded after the previous one.
+  cvars::boot_trace_path = trace_path;
+  { boot_trace::ScopedPhase phase("Next launch phase"); }
+  boot_trace::Flush();
+  cvars::boot_trace_path.clear();
+  trace_file.open(trace_path);
+  REQUIRE(trace_file.is_open());
+  trace.assign(std::istreambuf_iterator<char>(trace_file),
+               std::istreambuf_iterator<char>());
+  trace_file.close();
+  REQUIRE(trace.find("\"name\":\"Next launch phase\"") != std::string::npos);
+  REQUIRE(trace.find("\"name\":\"Outer phase\"") == std::string::npos);
+
+  // Nothing is recorded or written while disabled.
+  std::filesystem::remove(trace_path);
+  { boot_trace::ScopedPhase phase("Disabled phase"); }
+  boot_trace::Flush();
+  REQUIRE_FALSE(std::filesystem::exists(trace_path));
+}
+
+}  // namespace xe::base::test
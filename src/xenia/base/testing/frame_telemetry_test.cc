@@ -0,0 +1,73 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/frame_telemetry.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::base::test {
+
+TEST_CASE("Frame telemetry keeps the most recent frames", "[frame_telemetry]") {
+  using namespace xe::frame_telemetry;
+
+  cvars::frame_telemetry = false;
+  Clear();
+  AddToCounter(Counter::kDraws);
+  EndGuestFrame();
+  REQUIRE(GetFrames().empty());
+
+  cvars::frame_telemetry = true;
+  const uint32_t frame_count = kFrameCapacity + 100;
+  for (uint32_t i = 0; i < frame_count; ++i) {
+    AddToCounter(Counter::kDraws, i);
+    AddToCounter(Counter::kPm4Packets);
+    MarkVblank();
+    EndGuestFrame();
+  }
+  std::vector<FrameRecord> frames = GetFrames();
+  REQUIRE(frames.size() == kFrameCapacity);
+  for (size_t i = 1; i < frames.size(); ++i) {
+    REQUIRE(frames[i].frame_index == frames[i - 1].frame_index + 1);
+    REQUIRE(frames[i].guest_swap_time_us >= frames[i - 1].guest_swap_time_us);
+  }
+  const FrameRecord& last_frame = frames.back();
+  REQUIRE(last_frame.counters[size_t(Counter::kDraws)] == frame_count - 1);
+  REQUIRE(last_frame.counters[size_t(Counter::kPm4Packets)] == 1);
+  REQUIRE(last_frame.counters[size_t(Counter::kJitCompiles)] == 0);
+  REQUIRE(last_frame.vblank_count == 1);
+
+  std::filesystem::path csv_path =
+      std::filesystem::temp_directory_path() / "xenia-frame-telemetry.csv";
+  REQUIRE(WriteFrames(csv_path));
+  {
+    std::ifstream csv_file(csv_path);
+    std::string line;
+    size_t line_count = 0;
+    REQUIRE(std::getline(csv_file, line));
+    REQUIRE(line.rfind("frame,guest_swap_time_us,", 0) == 0);
+    while (std::getline(csv_file, line)) {
+      ++line_count;
+    }
+    REQUIRE(line_count == kFrameCapacity);
+  }
+  std::filesystem::remove(csv_path);
+
+  Clear();
+  REQUIRE(GetFrames().empty());
+  EndGuestFrame();
+  REQUIRE(GetFrames().size() == 1);
+
+  cvars::frame_telemetry = false;
+}
+
+}  // namespace xe::base::test
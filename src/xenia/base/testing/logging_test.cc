@@ -0,0 +1,74 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/base/logging.h"
+
+#include <string>
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::base::test {
+
+using namespace xe::logging;
+
+template <typename... Args>
+std::string FormatDeferred(const char* format, const Args&... args) {
+  char buffer[1024];
+  size_t size = internal::EncodeDeferredLogLine(buffer, sizeof(buffer), format,
+                                                args...);
+  REQUIRE(size);
+  std::string text;
+  REQUIRE(FormatDeferredLogLine(buffer, size, text));
+  return text;
+}
+
+TEST_CASE("Deferred log lines match immediate formatting", "[logging]") {
+  const char* c_string = "c string";
+  std::string string = "string";
+  std::string_view string_view = "string view";
+  const void* pointer = reinterpret_cast<const void*>(uintptr_t(0x1234));
+  REQUIRE(FormatDeferred("No arguments {{}}") == "No arguments {}");
+  REQUIRE(FormatDeferred("{} {} {} {}", c_string, string, string_view,
+                         "literal") ==
+          "c string string string view literal");
+  REQUIRE(FormatDeferred("{:08X} {} {}", uint32_t(0xBADF00D), int8_t(-5),
+                         uint16_t(65535)) == "0BADF00D -5 65535");
+  REQUIRE(FormatDeferred("{:X} {}", int32_t(-1), int64_t(-1)) ==
+          fmt::format("{:X} {}", int32_t(-1), int64_t(-1)));
+  REQUIRE(FormatDeferred("{} {:.3f} {}", 0.1f, 2.5, 1e300) ==
+          fmt::format("{} {:.3f} {}", 0.1f, 2.5, 1e300));
+  REQUIRE(FormatDeferred("{} {} {}", true, 'c', pointer) ==
+          fmt::format("{} {} {}", true, 'c', pointer));
+}
+
+TEST_CASE("Deferred log lines fall back when they can't be captured",
+          "[logging]") {
+  enum class Enum { kValue };
+  REQUIRE(internal::CanDeferFormatting<int, const char*, std::string>());
+  REQUIRE_FALSE(internal::CanDeferFormatting<int, Enum>());
+
+  char buffer[16];
+  REQUIRE_FALSE(internal::EncodeDeferredLogLine(buffer, sizeof(buffer),
+                                                "Too long for the buffer"));
+  const char* null_string = nullptr;
+  REQUIRE_FALSE(internal::EncodeDeferredLogLine(buffer, sizeof(buffer), "{}",
+                                                null_string));
+
+  // Arguments not matching the format.
+  size_t size =
+      internal::EncodeDeferredLogLine(buffer, sizeof(buffer), "{} {}", true);
+  REQUIRE(size);
+  std::string text;
+  REQUIRE_FALSE(FormatDeferredLogLine(buffer, size, text));
+  REQUIRE(text.rfind("{} {}", 0) == 0);
+  text.clear();
+  REQUIRE_FALSE(FormatDeferredLogLine(buffer, size - 1, text));
+}
+
+}  // namespace xe::base::test
@@ -13,8 +13,20 @@
 #include "third_party/fmt/include/fmt/format.h"
 
 #include "xenia/base/clock.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/math.h"
+#include "xenia/base/platform.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+DECLARE_bool(copy_and_swap_non_temporal_stores);
+#if XE_ARCH_AMD64
+DECLARE_int64(x64_extension_mask);
+#endif  // XE_ARCH_AMD64
 
 namespace xe {
 namespace base {
@@ -506,6 +518,192 @@ TEST_CASE("copy_and_swap_16_in_32_unaligned", "[copy_and_swap]") {
   }
 }
 
+#if XE_ARCH_AMD64
+// The kernels are selected from the host features, which are limited with this
+// mask to test and measure the narrower ones too.
+static const uint64_t kCopyAndSwapInstructionSetMasks[] = {
+    // All available (AVX-512 if supported).
+    UINT64_MAX,
+    // AVX2.
+    ~uint64_t(amd64::kX64EmitAVX512F | amd64::kX64EmitAVX512BW),
+    // SSSE3.
+    ~uint64_t(amd64::kX64EmitAVX2 | amd64::kX64EmitAVX512F |
+              amd64::kX64EmitAVX512BW),
+};
+static const char* const kCopyAndSwapInstructionSetNames[] = {
+    "AVX-512",
+    "AVX2",
+    "SSSE3",
+};
+
+static void LimitCopyAndSwapInstructionSet(uint64_t mask) {
+  cvars::x64_extension_mask = int64_t(mask);
+  amd64::InitFeatureFlags();
+}
+#endif  // XE_ARCH_AMD64
+
+struct CopyAndSwapFunction {
+  const char* name;
+  const char* short_name;
+  void (*function)(void* dest, const void* src, size_t count);
+  size_t element_size;
+  // Byte i of each element is taken from byte (i ^ byte_index_xor) of the
+  // source element.
+  size_t byte_index_xor;
+};
+static const CopyAndSwapFunction kCopyAndSwapFunctions[] = {
+    {"copy_and_swap_16", "16", copy_and_swap_16_unaligned, 2, 0b001},
+    {"copy_and_swap_32", "32", copy_and_swap_32_unaligned, 4, 0b011},
+    {"copy_and_swap_64", "64", copy_and_swap_64_unaligned, 8, 0b111},
+    {"copy_and_swap_16_in_32", "16in32", copy_and_swap_16_in_32_unaligned, 4,
+     0b010},
+};
+
+static void TestCopyAndSwapFunction(const CopyAndSwapFunction& function) {
+  // Around the vector widths, and above the non-temporal store threshold.
+  static const size_t kCounts[] = {0,  1,  3,   7,   8,   15,  16,
+                                   17, 31, 33,  63,  64,  65,  127,
+                                   129, 255, 1000, (size_t(1) << 20) + 37};
+  static const size_t kOffsets[] = {0, 1, 4, 8, 12, 33, 60};
+  // Space after the destination to check for writes out of bounds.
+  constexpr size_t kGuardSize = 64;
+  for (size_t count : kCounts) {
+    size_t size = count * function.element_size;
+    std::vector<uint8_t> src(size + 64);
+    for (size_t i = 0; i < src.size(); ++i) {
+      src[i] = uint8_t(i * 7 + (i >> 8));
+    }
+    std::vector<uint8_t> dest(size + 64 + kGuardSize);
+    bool large = size > 4096;
+    for (size_t dest_offset : kOffsets) {
+      for (size_t src_offset : kOffsets) {
+        if (large && dest_offset != src_offset) {
+          continue;
+        }
+        std::memset(dest.data(), 0xCC, dest.size());
+        function.function(dest.data() + dest_offset, src.data() + src_offset,
+                          count);
+        size_t mismatch = SIZE_MAX;
+        for (size_t i = 0; i < size; ++i) {
+          if (dest[dest_offset + i] !=
+              src[src_offset + (i ^ function.byte_index_xor)]) {
+            mismatch = i;
+            break;
+          }
+        }
+        for (size_t i = 0; i < dest_offset; ++i) {
+          if (dest[i] != 0xCC) {
+            mismatch = i;
+            break;
+          }
+        }
+        for (size_t i = dest_offset + size; i < dest.size(); ++i) {
+          if (dest[i] != 0xCC) {
+            mismatch = i;
+            break;
+          }
+        }
+        INFO(function.name << " count " << count << " dest offset "
+                           << dest_offset << " src offset " << src_offset);
+        REQUIRE(mismatch == SIZE_MAX);
+      }
+    }
+  }
+}
+
+TEST_CASE("copy_and_swap kernels", "[copy_and_swap]") {
+  bool non_temporal_stores = cvars::copy_and_swap_non_temporal_stores;
+  auto test_functions = [] {
+    for (bool non_temporal : {false, true}) {
+      INFO("Non-temporal stores " << non_temporal);
+      cvars::copy_and_swap_non_temporal_stores = non_temporal;
+      for (const CopyAndSwapFunction& function : kCopyAndSwapFunctions) {
+        TestCopyAndSwapFunction(function);
+      }
+    }
+  };
+#if XE_ARCH_AMD64
+  int64_t extension_mask = cvars::x64_extension_mask;
+  for (size_t i = 0; i < xe::countof(kCopyAndSwapInstructionSetMasks); ++i) {
+    INFO(kCopyAndSwapInstructionSetNames[i]);
+    LimitCopyAndSwapInstructionSet(kCopyAndSwapInstructionSetMasks[i]);
+    test_functions();
+  }
+  LimitCopyAndSwapInstructionSet(uint64_t(extension_mask));
+#else
+  test_functions();
+#endif  // XE_ARCH_AMD64
+  cvars::copy_and_swap_non_temporal_stores = non_temporal_stores;
+}
+
+TEST_CASE("copy_and_swap throughput", "[.benchmark][copy_and_swap]") {
+  // From single registers and GPU constants to large textures exceeding the
+  // caches.
+  static const size_t kSizes[] = {256, 4096, 65536, 1 << 20, 16 << 20};
+  std::vector<uint8_t> src((16 << 20) + 64);
+  std::vector<uint8_t> dest((16 << 20) + 64);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = uint8_t(i);
+  }
+  auto measure = [&](size_t size, size_t offset, auto function) {
+    // Roughly the same amount of data for all sizes, at least 4 passes.
+    size_t iterations = std::max((size_t(256) << 20) / size, size_t(4));
+    function(dest.data() + offset, src.data() + offset, size);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      function(dest.data() + offset, src.data() + offset, size);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return double(size) * iterations /
+           std::chrono::duration<double, std::nano>(end - start).count();
+  };
+  auto run = [&](const char* instruction_set) {
+    for (size_t size : kSizes) {
+      // Aligned, and misaligned by an element of all the swap sizes.
+      for (size_t offset : {size_t(0), size_t(8)}) {
+        fmt::print("{:<8} {:<2} {:>8} B +{} memcpy {:6.2f} GB/s",
+                   instruction_set,
+                   cvars::copy_and_swap_non_temporal_stores ? "NT" : "",
+                   size, offset,
+                   measure(size, offset,
+                           [](void* dest, const void* src, size_t size) {
+                             std::memcpy(dest, src, size);
+                           }));
+        for (const CopyAndSwapFunction& function : kCopyAndSwapFunctions) {
+          fmt::print(
+              " | {} {:6.2f}", function.short_name,
+              measure(size, offset,
+                      [&function](void* dest, const void* src, size_t size) {
+                        function.function(dest, src,
+                                          size / function.element_size);
+                      }));
+        }
+        fmt::print("\n");
+      }
+    }
+  };
+  bool non_temporal_stores = cvars::copy_and_swap_non_temporal_stores;
+  for (bool non_temporal : {false, true}) {
+    cvars::copy_and_swap_non_temporal_stores = non_temporal;
+#if XE_ARCH_AMD64
+    int64_t extension_mask = cvars::x64_extension_mask;
+    for (size_t i = 0; i < xe::countof(kCopyAndSwapInstructionSetMasks); ++i) {
+      // Only the AVX2 and AVX-512 kernels have a non-temporal path.
+      if (non_temporal &&
+          !(kCopyAndSwapInstructionSetMasks[i] & amd64::kX64EmitAVX2)) {
+        continue;
+      }
+      LimitCopyAndSwapInstructionSet(kCopyAndSwapInstructionSetMasks[i]);
+      run(kCopyAndSwapInstructionSetNames[i]);
+    }
+    LimitCopyAndSwapInstructionSet(uint64_t(extension_mask));
+#else
+    run("Generic");
+#endif  // XE_ARCH_AMD64
+  }
+  cvars::copy_and_swap_non_temporal_stores = non_temporal_stores;
+}
+
 TEST_CASE("create_and_close_file_mapping", "Virtual Memory Mapping") {
   auto path = fmt::format("xenia_test_{}", Clock::QueryHostTickCount());
   auto memory = xe::memory::CreateFileMappingHandle(
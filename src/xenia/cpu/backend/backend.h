@@ -51,6 +51,9 @@ class Backend {
   CodeCache* code_cache() const { return code_cache_; }
 
   virtual bool Initialize(Processor* processor);
+  // Stops background work done by the backend, called before the modules and
+  // their functions are destroyed.
+  virtual void Shutdown() {}
 
   virtual void* AllocThreadData();
   virtual void FreeThreadData(void* thread_data);
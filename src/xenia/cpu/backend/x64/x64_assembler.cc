@@ -91,9 +91,8 @@ bool X64Assembler::Assemble(GuestFunction* function, HIRBuilder* builder,
     string_buffer_.Reset();
   }
 
+  // The code cache has already set up the function with the machine code.
   function->set_debug_info(std::move(debug_info));
-  static_cast<X64Function*>(function)->Setup(
-      reinterpret_cast<uint8_t*>(machine_code), code_size);
 
   // Install into indirection table.
   uint64_t host_address = reinterpret_cast<uint64_t>(machine_code);
@@ -11,6 +11,10 @@
 
 #include <stddef.h>
 #include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
 #include "third_party/capstone/include/capstone/capstone.h"
 #include "third_party/capstone/include/capstone/x86.h"
 
@@ -41,6 +45,31 @@ DEFINE_bool(enable_host_guest_stack_synchronization, true,
             "and checks for reentry at return sites. Has slight performance "
             "impact, but fixes crashes in games that use setjmp/longjmp.",
             "x64");
+DEFINE_bool(lazy_host_guest_stack_synchronization, false,
+            "With --enable_host_guest_stack_synchronization, only store the "
+            "guest stack pointer in each host stack frame instead of "
+            "recording a stackpoint on every call, and find the frame to "
+            "return to after a longjmp by walking the host frames. Makes "
+            "calls cheaper, but the walk stops at host code between guest "
+            "frames.",
+            "x64");
+
+DEFINE_bool(x64_leaf_export_thunks, true,
+            "Call kernel exports tagged as leaf functions through a "
+            "lightweight guest-to-host thunk that skips saving volatile "
+            "registers.",
+            "x64");
+DEFINE_int32(code_cache_relayout_delay, 0,
+             "Count guest function calls, and after this many seconds copy "
+             "the machine code of the most called functions next to each "
+             "other in the code cache to reduce instruction cache and TLB "
+             "misses. 0 to disable.",
+             "x64");
+DEFINE_uint32(code_cache_hot_function_count, 2048,
+              "Number of the most called guest functions to place together "
+              "with --code_cache_relayout_delay.",
+              "x64");
+
 #if XE_X64_PROFILER_AVAILABLE == 1
 DECLARE_bool(instrument_call_times);
 #endif
@@ -63,8 +92,10 @@ class X64HelperEmitter : public X64Emitter {
   ~X64HelperEmitter() override;
   HostToGuestThunk EmitHostToGuestThunk();
   GuestToHostThunk EmitGuestToHostThunk();
+  GuestToHostThunk EmitGuestToHostLeafThunk();
   ResolveFunctionThunk EmitResolveFunctionThunk();
   void* EmitGuestAndHostSynchronizeStackHelper();
+  void* EmitGuestAndHostSynchronizeStackLazyHelper();
   // 1 for loading byte, 2 for halfword and 4 for word.
   // these specialized versions save space in the caller
   void* EmitGuestAndHostSynchronizeStackSizeLoadThunk(
@@ -136,6 +167,8 @@ X64Backend::X64Backend() : Backend(), code_cache_(nullptr) {
 }
 
 X64Backend::~X64Backend() {
+  StopRelayoutThread();
+
   if (capstone_handle_) {
     cs_close(&capstone_handle_);
   }
@@ -266,11 +299,14 @@ bool X64Backend::Initialize(Processor* processor) {
   X64HelperEmitter thunk_emitter(this, &allocator);
   host_to_guest_thunk_ = thunk_emitter.EmitHostToGuestThunk();
   guest_to_host_thunk_ = thunk_emitter.EmitGuestToHostThunk();
+  guest_to_host_leaf_thunk_ = thunk_emitter.EmitGuestToHostLeafThunk();
   resolve_function_thunk_ = thunk_emitter.EmitResolveFunctionThunk();
 
   if (cvars::enable_host_guest_stack_synchronization) {
     synchronize_guest_and_host_stack_helper_ =
-        thunk_emitter.EmitGuestAndHostSynchronizeStackHelper();
+        cvars::lazy_host_guest_stack_synchronization
+            ? thunk_emitter.EmitGuestAndHostSynchronizeStackLazyHelper()
+            : thunk_emitter.EmitGuestAndHostSynchronizeStackHelper();
 
     synchronize_guest_and_host_stack_helper_size8_ =
         thunk_emitter.EmitGuestAndHostSynchronizeStackSizeLoadThunk(
@@ -320,9 +356,114 @@ bool X64Backend::Initialize(Processor* processor) {
   }
 #endif
 
+  if (cvars::code_cache_relayout_delay > 0) {
+    relayout_shutdown_event_ =
+        xe::threading::Event::CreateManualResetEvent(false);
+    relayout_thread_ = xe::threading::Thread::Create({}, [this]() {
+      if (xe::threading::Wait(
+              relayout_shutdown_event_.get(), false,
+              std::chrono::seconds(cvars::code_cache_relayout_delay)) ==
+          xe::threading::WaitResult::kTimeout) {
+        RelayoutHotFunctions();
+      }
+    });
+    if (relayout_thread_) {
+      relayout_thread_->set_name("Code Cache Relayout");
+    } else {
+      XELOGW("Failed to create the code cache relayout thread");
+    }
+  }
+
   return true;
 }
 
+void X64Backend::Shutdown() { StopRelayoutThread(); }
+
+void X64Backend::StopRelayoutThread() {
+  if (!relayout_thread_) {
+    return;
+  }
+  relayout_shutdown_event_->Set();
+  xe::threading::Wait(relayout_thread_.get(), false);
+  relayout_thread_.reset();
+  relayout_shutdown_event_.reset();
+}
+
+void X64Backend::RelayoutHotFunctions() {
+  // Prevents new code from being placed in between, and modules from being
+  // unloaded.
+  auto global_lock = global_critical_region::AcquireDirect();
+
+  std::vector<X64Function*> functions;
+  for (GuestFunction* function : code_cache_->GetGuestFunctions()) {
+    auto x64_function = static_cast<X64Function*>(function);
+    if (x64_function->is_relocatable() && x64_function->call_count()) {
+      functions.push_back(x64_function);
+    }
+  }
+  size_t hot_count = std::min(size_t(cvars::code_cache_hot_function_count),
+                              functions.size());
+  if (!hot_count) {
+    return;
+  }
+  std::partial_sort(functions.begin(), functions.begin() + hot_count,
+                    functions.end(), [](X64Function* a, X64Function* b) {
+                      return a->call_count() > b->call_count();
+                    });
+  functions.resize(hot_count);
+
+  struct Copy {
+    void* execute_address;
+    void* write_address;
+  };
+  std::vector<Copy> copies(hot_count);
+  std::unordered_map<uintptr_t, uintptr_t> new_addresses;
+  size_t copied_size = 0;
+  for (size_t i = 0; i < hot_count; ++i) {
+    X64Function* function = functions[i];
+    Copy& copy = copies[i];
+    code_cache_->RelocateGuestCode(
+        function, function->machine_code(), function->emit_info(),
+        function->external_branch_offsets(), copy.execute_address,
+        copy.write_address);
+    new_addresses.emplace(uintptr_t(function->machine_code()),
+                          uintptr_t(copy.execute_address));
+    copied_size += function->emit_info().code_size.total;
+  }
+
+  // Direct calls between the hot functions go to the new copies. Nothing
+  // executes the copies yet, so they can be modified.
+  for (size_t i = 0; i < hot_count; ++i) {
+    auto execute_address = static_cast<uint8_t*>(copies[i].execute_address);
+    auto write_address = static_cast<uint8_t*>(copies[i].write_address);
+    for (uint32_t offset : functions[i]->external_branch_offsets()) {
+      int32_t displacement;
+      std::memcpy(&displacement, write_address + offset,
+                  sizeof(displacement));
+      uintptr_t target =
+          uintptr_t(execute_address + offset + 4) + displacement;
+      auto new_address = new_addresses.find(target);
+      if (new_address == new_addresses.end()) {
+        continue;
+      }
+      displacement += int32_t(new_address->second - target);
+      std::memcpy(write_address + offset, &displacement,
+                  sizeof(displacement));
+    }
+  }
+
+  for (size_t i = 0; i < hot_count; ++i) {
+    X64Function* function = functions[i];
+    code_cache_->AddIndirection(
+        function->address(),
+        uint32_t(reinterpret_cast<uintptr_t>(copies[i].execute_address)));
+    function->Relocate(static_cast<uint8_t*>(copies[i].execute_address));
+  }
+
+  XELOGI("Placed {} most called guest functions together ({} KiB of code)",
+         hot_count, copied_size / 1024);
+}
+
 void X64Backend::CommitExecutableRange(uint32_t guest_low,
                                        uint32_t guest_high) {
   code_cache_->CommitExecutableRange(guest_low, guest_high);
@@ -734,8 +875,58 @@ GuestToHostThunk X64HelperEmitter::EmitGuestToHostThunk() {
   return (GuestToHostThunk)fn;
 }
 
+GuestToHostThunk X64HelperEmitter::EmitGuestToHostLeafThunk() {
+  // rcx = target function
+  // rdx = arg0
+  // r8  = arg1
+  // r9  = arg2
+  //
+  // Only used for extern calls to exports tagged kLeaf. Those are emitted as
+  // the sole instruction of an "sc; blr" stub, so no register-allocated
+  // values are live across the call and the target never re-enters guest
+  // code. All that must survive is the context and membase, which are only
+  // volatile under the SysV ABI.
+
+  _code_offsets code_offsets = {};
+
+  const size_t stack_size = StackLayout::THUNK_STACK_SIZE;
+
+  code_offsets.prolog = getSize();
+
+  // rsp + 0 = return address
+  sub(rsp, stack_size);
+
+  code_offsets.prolog_stack_alloc = getSize();
+  code_offsets.body = getSize();
+  vzeroupper();
+#if XE_PLATFORM_LINUX
+  mov(qword[rsp + offsetof(StackLayout::Thunk, r[3])], rsi);
+  mov(qword[rsp + offsetof(StackLayout::Thunk, r[4])], rdi);
+#endif
+
+  mov(rax, rcx);              // function
+  mov(rcx, GetContextReg());  // context
+  call(rax);
+
+#if XE_PLATFORM_LINUX
+  mov(rsi, qword[rsp + offsetof(StackLayout::Thunk, r[3])]);
+  mov(rdi, qword[rsp + offsetof(StackLayout::Thunk, r[4])]);
+#endif
+
+  code_offsets.epilog = getSize();
+
+  add(rsp, stack_size);
+  ret();
+
+  code_offsets.tail = getSize();
+
+  assert_zero(code_offsets.prolog);
+  return (GuestToHostThunk)EmitCurrentForOffsets(code_offsets, stack_size);
+}
+
 // X64Emitter handles actually resolving functions.
-uint64_t ResolveFunction(void* raw_context, uint64_t target_address);
+uint64_t ResolveFunctionAtHostStack(void* raw_context, uint64_t target_address,
+                                    uint64_t host_stack);
 
 ResolveFunctionThunk X64HelperEmitter::EmitResolveFunctionThunk() {
   // ebx = target PPC address
@@ -758,7 +949,8 @@ ResolveFunctionThunk X64HelperEmitter::EmitResolveFunctionThunk() {
 
   mov(rcx, rsi);  // context
   mov(rdx, rbx);
-  mov(rax, reinterpret_cast<uint64_t>(&ResolveFunction));
+  lea(r8, ptr[rsp + stack_size]);
+  mov(rax, reinterpret_cast<uint64_t>(&ResolveFunctionAtHostStack));
   call(rax);
 
   EmitLoadVolatileRegs();
@@ -892,6 +1084,65 @@ void* X64HelperEmitter::EmitGuestAndHostSynchronizeStackHelper() {
   return EmitCurrentForOffsets(code_offsets);
 }
 
+static uint64_t SynchronizeGuestAndHostStackLazily(void* raw_context,
+                                                   uint64_t host_stack,
+                                                   uint64_t return_address) {
+  auto guest_context = reinterpret_cast<ppc::PPCContext*>(raw_context);
+  auto backend = static_cast<X64Backend*>(
+      guest_context->thread_state->processor()->backend());
+  GuestFunction* function =
+      backend->code_cache()->LookupFunction(return_address);
+  if (!function) {
+    return 0;
+  }
+  return backend->FindGuestFrameAboveStack(
+      host_stack, function, static_cast<uint32_t>(guest_context->r[1]));
+}
+
+// r11 = size of callers stack, r8 = return address w/ adjustment
+// Same as EmitGuestAndHostSynchronizeStackHelper, but finds the frame of the
+// caller by walking the host frames rather than the stackpoints.
+void* X64HelperEmitter::EmitGuestAndHostSynchronizeStackLazyHelper() {
+  _code_offsets code_offsets = {};
+
+  const size_t stack_size = StackLayout::THUNK_STACK_SIZE;
+
+  code_offsets.prolog = getSize();
+
+  // rsp + 0 = return address into the innermost guest frame still on the host
+  // stack
+  sub(rsp, stack_size);
+
+  code_offsets.prolog_stack_alloc = getSize();
+  code_offsets.body = getSize();
+
+  EmitSaveVolatileRegs();
+
+  mov(rcx, rsi);  // context
+  lea(rdx, ptr[rsp + stack_size]);
+  // r8 = return address
+  mov(rax, reinterpret_cast<uint64_t>(&SynchronizeGuestAndHostStackLazily));
+  call(rax);
+
+  EmitLoadVolatileRegs();
+
+  code_offsets.epilog = getSize();
+
+  add(rsp, stack_size);
+  Xbyak::Label skip_adjust;
+  test(rax, rax);
+  jz(skip_adjust);
+  // The host stack pointer in the body of the caller, r11 is already accounted
+  // for.
+  mov(rsp, rax);
+  L(skip_adjust);
+  jmp(r8);
+
+  code_offsets.tail = getSize();
+
+  return EmitCurrentForOffsets(code_offsets);
+}
+
 void* X64HelperEmitter::EmitGuestAndHostSynchronizeStackSizeLoadThunk(
     void* sync_func, unsigned stack_element_size) {
   _code_offsets code_offsets = {};
@@ -1574,7 +1825,8 @@ void X64Backend::InitializeBackendContext(void* ctx) {
 
   */
 
-  bctx->stackpoints = cvars::enable_host_guest_stack_synchronization
+  bctx->stackpoints = cvars::enable_host_guest_stack_synchronization &&
+                              !cvars::lazy_host_guest_stack_synchronization
                           ? new X64BackendStackpoint[cvars::max_stackpoints]
                           : nullptr;
   bctx->current_stackpoint_depth = 0;
@@ -1615,8 +1867,61 @@ void X64Backend::SetGuestRoundingMode(void* ctx, unsigned int mode) {
   ppc_context->fpscr.bits.ni = control >> 2;
 }
 
+// Walks the host frames of the guest functions with
+// --lazy_host_guest_stack_synchronization, from a host stack pointer at a
+// return address into guest code, until the visitor returns true for a frame or
+// host code is reached. The visitor receives the function and the guest stack
+// pointer it was entered with. Returns the host stack pointer in the body of
+// the last visited frame, or 0.
+template <typename Visitor>
+static uint64_t WalkGuestFrames(X64CodeCache* code_cache, uint64_t host_stack,
+                                Visitor visitor) {
+  for (;;) {
+    auto function = static_cast<X64Function*>(code_cache->LookupFunction(
+        *reinterpret_cast<const uint64_t*>(host_stack)));
+    if (!function) {
+      return 0;
+    }
+    uint64_t frame = host_stack + sizeof(uint64_t);
+    uint32_t guest_stack_pointer = *reinterpret_cast<const uint32_t*>(
+        frame + StackLayout::GUEST_STACK_POINTER);
+    if (visitor(function, guest_stack_pointer)) {
+      return frame;
+    }
+    host_stack = frame + function->stack_size();
+  }
+}
+
+uint32_t X64Backend::CountGuestFramesBelowStack(uint64_t host_stack,
+                                                uint32_t guest_stack_pointer) {
+  uint32_t frame_count = 0;
+  WalkGuestFrames(code_cache(), host_stack,
+                  [&](X64Function*, uint32_t frame_stack_pointer) {
+                    if (frame_stack_pointer >= guest_stack_pointer) {
+                      return true;
+                    }
+                    ++frame_count;
+                    return false;
+                  });
+  return frame_count;
+}
+
+uint64_t X64Backend::FindGuestFrameAboveStack(uint64_t host_stack,
+                                              const GuestFunction* function,
+                                              uint32_t guest_stack_pointer) {
+  // Functions called by the one being returned to were entered with its stack
+  // pointer, so a frame with the same one is not the destination.
+  return WalkGuestFrames(
+      code_cache(), host_stack,
+      [&](X64Function* frame_function, uint32_t frame_stack_pointer) {
+        return frame_function == function &&
+               frame_stack_pointer > guest_stack_pointer;
+      });
+}
+
 bool X64Backend::PopulatePseudoStacktrace(GuestPseudoStackTrace* st) {
-  if (!cvars::enable_host_guest_stack_synchronization) {
+  if (!cvars::enable_host_guest_stack_synchronization ||
+      cvars::lazy_host_guest_stack_synchronization) {
     return false;
   }
 
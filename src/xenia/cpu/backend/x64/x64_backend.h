@@ -14,6 +14,7 @@
 
 #include "xenia/base/bit_map.h"
 #include "xenia/base/cvar.h"
+#include "xenia/base/threading.h"
 #include "xenia/cpu/backend/backend.h"
 
 #if XE_PLATFORM_WIN32 == 1
@@ -27,6 +28,8 @@
 DECLARE_int64(x64_extension_mask);
 DECLARE_int64(max_stackpoints);
 DECLARE_bool(enable_host_guest_stack_synchronization);
+DECLARE_bool(lazy_host_guest_stack_synchronization);
+DECLARE_bool(x64_leaf_export_thunks);
 namespace xe {
 class Exception;
 }  // namespace xe
@@ -132,6 +135,11 @@ class X64Backend : public Backend {
   HostToGuestThunk host_to_guest_thunk() const { return host_to_guest_thunk_; }
   // Function that guest code can call to transition into host code.
   GuestToHostThunk guest_to_host_thunk() const { return guest_to_host_thunk_; }
+  // Cheaper variant of guest_to_host_thunk for exports tagged kLeaf. Does not
+  // preserve volatile registers beyond the context and membase.
+  GuestToHostThunk guest_to_host_leaf_thunk() const {
+    return guest_to_host_leaf_thunk_;
+  }
   // Function that thunks to the ResolveFunction in X64Emitter.
   ResolveFunctionThunk resolve_function_thunk() const {
     return resolve_function_thunk_;
@@ -151,6 +159,7 @@ class X64Backend : public Backend {
     }
   }
   bool Initialize(Processor* processor) override;
+  void Shutdown() override;
 
   void CommitExecutableRange(uint32_t guest_low, uint32_t guest_high) override;
 
@@ -179,8 +188,26 @@ class X64Backend : public Backend {
   virtual void FreeGuestTrampoline(uint32_t trampoline_addr) override;
   virtual void SetGuestRoundingMode(void* ctx, unsigned int mode) override;
   virtual bool PopulatePseudoStacktrace(GuestPseudoStackTrace* st) override;
+
+  // For --lazy_host_guest_stack_synchronization, host_stack is a host stack
+  // pointer at a return address into guest code.
+  // Returns the number of the innermost guest frames entered with a guest stack
+  // pointer below guest_stack_pointer.
+  uint32_t CountGuestFramesBelowStack(uint64_t host_stack,
+                                      uint32_t guest_stack_pointer);
+  // Returns the host stack pointer in the body of the innermost frame of the
+  // function entered with a guest stack pointer above guest_stack_pointer, or 0
+  // if it's not found before reaching host code.
+  uint64_t FindGuestFrameAboveStack(uint64_t host_stack,
+                                    const GuestFunction* function,
+                                    uint32_t guest_stack_pointer);
   void RecordMMIOExceptionForGuestInstruction(void* host_address);
 
+  // Copies the machine code of the most frequently called guest functions
+  // next to each other at the end of the code cache, and switches to the
+  // copies. Requires --code_cache_relayout_delay to count the calls.
+  void RelayoutHotFunctions();
+
   uint32_t LookupXMMConstantAddress32(unsigned index) {
     return static_cast<uint32_t>(emitter_data() + sizeof(vec128_t) * index);
   }
@@ -194,6 +221,8 @@ class X64Backend : public Backend {
   static bool ExceptionCallbackThunk(Exception* ex, void* data);
   bool ExceptionCallback(Exception* ex);
 
+  void StopRelayoutThread();
+
   uintptr_t capstone_handle_ = 0;
 
   std::unique_ptr<X64CodeCache> code_cache_;
@@ -201,6 +230,7 @@ class X64Backend : public Backend {
 
   HostToGuestThunk host_to_guest_thunk_;
   GuestToHostThunk guest_to_host_thunk_;
+  GuestToHostThunk guest_to_host_leaf_thunk_;
   ResolveFunctionThunk resolve_function_thunk_;
   void* synchronize_guest_and_host_stack_helper_ = nullptr;
 
@@ -228,6 +258,9 @@ class X64Backend : public Backend {
   // range that will be used to dispatch to host code
   BitMap guest_trampoline_address_bitmap_;
   uint8_t* guest_trampoline_memory_;
+
+  std::unique_ptr<xe::threading::Event> relayout_shutdown_event_;
+  std::unique_ptr<xe::threading::Thread> relayout_thread_;
 };
 
 }  // namespace x64
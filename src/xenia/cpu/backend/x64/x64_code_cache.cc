@@ -24,6 +24,7 @@
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/cpu/backend/x64/x64_function.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/module.h"
 
@@ -120,6 +121,18 @@ bool X64CodeCache::Initialize() {
     }
   }
 
+  if (xe::memory::IsLargePageMemoryPreferred()) {
+    bool large_pages_advised = xe::memory::AdviseLargePages(
+        generated_code_execute_base_, kGeneratedCodeSize);
+    if (generated_code_write_base_ != generated_code_execute_base_) {
+      large_pages_advised &= xe::memory::AdviseLargePages(
+          generated_code_write_base_, kGeneratedCodeSize);
+    }
+    if (!large_pages_advised) {
+      XELOGW("Large pages are not available for the code cache");
+    }
+  }
+
   // Preallocate the function map to a large, reasonable size.
   generated_code_map_.reserve(kMaximumFunctionCount);
 
@@ -170,11 +183,11 @@ void X64CodeCache::PlaceHostCode(uint32_t guest_address, void* machine_code,
                  code_execute_address_out, code_write_address_out);
 }
 
-void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
-                                  const EmitFunctionInfo& func_info,
-                                  GuestFunction* function_info,
-                                  void*& code_execute_address_out,
-                                  void*& code_write_address_out) {
+void X64CodeCache::PlaceGuestCode(
+    uint32_t guest_address, void* machine_code,
+    const EmitFunctionInfo& func_info, GuestFunction* function_info,
+    void*& code_execute_address_out, void*& code_write_address_out,
+    const std::vector<uint32_t>* external_branch_offsets) {
   // Hold a lock while we bump the pointers up. This is important as the
   // unwind table requires entries AND code to be sorted in order.
   size_t low_mark;
@@ -211,6 +224,13 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
 
     high_mark = generated_code_offset_;
 
+    // A newly emitted function must be fully set up before the relayout
+    // thread, which holds the lock, can find it in the map.
+    if (function_info && !external_branch_offsets) {
+      static_cast<X64Function*>(function_info)
+          ->Setup(code_execute_address, func_info.code_size.total);
+    }
+
     // Store in map. It is maintained in sorted order of host PC dependent on
     // us also being append-only.
     generated_code_map_.emplace_back(
@@ -249,6 +269,20 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
     // Copy code.
     std::memcpy(code_write_address, machine_code, func_info.code_size.total);
 
+    if (external_branch_offsets) {
+      // Moved within the cache, so the distance fits in rel32.
+      auto distance = int32_t(code_write_address -
+                              reinterpret_cast<uint8_t*>(machine_code));
+      for (uint32_t offset : *external_branch_offsets) {
+        int32_t displacement;
+        std::memcpy(&displacement, code_write_address + offset,
+                    sizeof(displacement));
+        displacement -= distance;
+        std::memcpy(code_write_address + offset, &displacement,
+                    sizeof(displacement));
+      }
+    }
+
     // Fill unused slots with 0xCC
     std::memset(tail_write_address, 0xCC,
                 static_cast<size_t>(end_write_address - tail_write_address));
@@ -290,6 +324,33 @@ void X64CodeCache::PlaceGuestCode(uint32_t guest_address, void* machine_code,
   }
 }
 
+void X64CodeCache::RelocateGuestCode(
+    GuestFunction* function_info, const void* code_execute_address,
+    const EmitFunctionInfo& func_info,
+    const std::vector<uint32_t>& external_branch_offsets,
+    void*& code_execute_address_out, void*& code_write_address_out) {
+  uint8_t* code_write_address =
+      generated_code_write_base_ +
+      (static_cast<const uint8_t*>(code_execute_address) -
+       generated_code_execute_base_);
+  // No guest address to leave the indirection table pointing to the previous
+  // copy until the caller is ready to switch to the new one.
+  PlaceGuestCode(0, code_write_address, func_info, function_info,
+                 code_execute_address_out, code_write_address_out,
+                 &external_branch_offsets);
+}
+
+std::vector<GuestFunction*> X64CodeCache::GetGuestFunctions() const {
+  std::vector<GuestFunction*> functions;
+  functions.reserve(generated_code_map_.size());
+  for (const auto& entry : generated_code_map_) {
+    if (entry.second) {
+      functions.push_back(entry.second);
+    }
+  }
+  return functions;
+}
+
 uint32_t X64CodeCache::PlaceData(const void* data, size_t length) {
   // Hold a lock while we bump the pointers up.
   size_t high_mark;
@@ -67,13 +67,32 @@ class X64CodeCache : public CodeCache {
                      const EmitFunctionInfo& func_info,
                      void*& code_execute_address_out,
                      void*& code_write_address_out);
-  void PlaceGuestCode(uint32_t guest_address, void* machine_code,
-                      const EmitFunctionInfo& func_info,
-                      GuestFunction* function_info,
-                      void*& code_execute_address_out,
-                      void*& code_write_address_out);
+  // If external_branch_offsets is provided, machine_code is code placed
+  // before in the cache, and the rel32 displacements at those offsets are
+  // adjusted to keep branching to the same targets from the new location.
+  // Otherwise, function_info is set up to use the placed code before it's
+  // visible to other threads, and any relocation info must already be set.
+  void PlaceGuestCode(
+      uint32_t guest_address, void* machine_code,
+      const EmitFunctionInfo& func_info, GuestFunction* function_info,
+      void*& code_execute_address_out, void*& code_write_address_out,
+      const std::vector<uint32_t>* external_branch_offsets = nullptr);
   uint32_t PlaceData(const void* data, size_t length);
 
+  // Copies the code of a function placed before to the end of the cache, for
+  // placing frequently executed code together. The previous copy stays valid,
+  // and the new one isn't installed into the indirection table.
+  void RelocateGuestCode(GuestFunction* function_info,
+                         const void* code_execute_address,
+                         const EmitFunctionInfo& func_info,
+                         const std::vector<uint32_t>& external_branch_offsets,
+                         void*& code_execute_address_out,
+                         void*& code_write_address_out);
+
+  // The guest functions in the order their code was placed. Must be called
+  // with the global lock held for them to stay valid.
+  std::vector<GuestFunction*> GetGuestFunctions() const;
+
   GuestFunction* LookupFunction(uint64_t host_pc) override;
 
  protected:
@@ -30,6 +30,7 @@
 #include "xenia/cpu/backend/x64/x64_sequences.h"
 #include "xenia/cpu/backend/x64/x64_stack_layout.h"
 #include "xenia/cpu/cpu_flags.h"
+#include "xenia/cpu/export_resolver.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/function_debug_info.h"
 #include "xenia/cpu/hir/instr.h"
@@ -58,6 +59,8 @@ DEFINE_uint32(align_all_basic_blocks, 0,
               "power of 2, 16 is the recommended value. Results in larger "
               "icache usage, but potentially faster loops",
               "x64");
+DECLARE_int32(code_cache_relayout_delay);
+
 #if XE_X64_PROFILER_AVAILABLE == 1
 DEFINE_bool(instrument_call_times, false,
             "Compute time taken for functions, for profiling guest code",
@@ -120,6 +123,11 @@ bool X64Emitter::Emit(GuestFunction* function, HIRBuilder* builder,
   debug_info_flags_ = debug_info_flags;
   trace_data_ = &function->trace_data();
   source_map_arena_.Reset();
+  external_branch_offsets_.clear();
+  call_counter_ = nullptr;
+  if (cvars::code_cache_relayout_delay > 0) {
+    call_counter_ = static_cast<X64Function*>(function)->call_count_address();
+  }
 
   // Fill the generator with code.
   EmitFunctionInfo func_info = {};
@@ -151,6 +159,12 @@ void* X64Emitter::Emplace(const EmitFunctionInfo& func_info,
   void* new_write_address;
   assert_true(func_info.code_size.total == size_);
   if (function) {
+    auto x64_function = static_cast<X64Function*>(function);
+    x64_function->set_stack_size(func_info.stack_size);
+    // Set before the function is published by the code cache.
+    if (call_counter_) {
+      x64_function->SetRelocationInfo(func_info, external_branch_offsets_);
+    }
     code_cache_->PlaceGuestCode(function->address(), top_, func_info, function,
                                 new_execute_address, new_write_address);
   } else {
@@ -162,6 +176,8 @@ void* X64Emitter::Emplace(const EmitFunctionInfo& func_info,
   top_ = old_address;
   reset();
   tail_code_.clear();
+  external_branch_offsets_.clear();
+  call_counter_ = nullptr;
   for (auto&& cached_label : label_cache_) {
     delete cached_label;
   }
@@ -173,10 +189,19 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
   Xbyak::Label epilog_label;
   epilog_label_ = &epilog_label;
 
+  // The guest stack pointer slot is only needed for lazy synchronization.
+  bool store_guest_stack_pointer =
+      cvars::enable_host_guest_stack_synchronization &&
+      cvars::lazy_host_guest_stack_synchronization;
+  size_t guest_stack_size =
+      store_guest_stack_pointer
+          ? StackLayout::GUEST_STACK_SIZE_WITH_STACK_POINTER
+          : StackLayout::GUEST_STACK_SIZE;
+
   // Calculate stack size. We need to align things to their natural sizes.
   // This could be much better (sort by type/etc).
   auto locals = builder->locals();
-  size_t stack_offset = StackLayout::GUEST_STACK_SIZE;
+  size_t stack_offset = guest_stack_size;
   for (auto it = locals.begin(); it != locals.end(); ++it) {
     auto slot = *it;
     size_t type_size = GetTypeSize(slot->type);
@@ -188,7 +213,7 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
   }
 
   // Ensure 16b alignment.
-  stack_offset -= StackLayout::GUEST_STACK_SIZE;
+  stack_offset -= guest_stack_size;
   stack_offset = xe::align(stack_offset, static_cast<size_t>(16));
 
   struct _code_offsets {
@@ -214,7 +239,7 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
     that contains most backend fields the sizes that are checked are chosen
     based on PTE coalescing sizes. zen does 16k or 32k
   */
-  size_t stack_size = StackLayout::GUEST_STACK_SIZE;
+  size_t stack_size = guest_stack_size;
   if (stack_offset < (4096 - sizeof(X64BackendContext))) {
     locals_page_delta_ = 4096;
   } else if (stack_offset <
@@ -226,8 +251,7 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
     locals_page_delta_ = 65536;
   } else {
     // extremely unlikely, fall back to stack
-    stack_size =
-        xe::align<size_t>(StackLayout::GUEST_STACK_SIZE + stack_offset, 16);
+    stack_size = xe::align<size_t>(guest_stack_size + stack_offset, 16);
     locals_page_delta_ = 0;
   }
 
@@ -240,6 +264,17 @@ bool X64Emitter::Emit(HIRBuilder* builder, EmitFunctionInfo& func_info) {
 
   code_offsets.prolog_stack_alloc = getSize();
   code_offsets.body = getSize();
+  if (store_guest_stack_pointer) {
+    // Instead of a stackpoint, only the guest stack pointer is recorded in the
+    // frame - the frames are walked using the host return addresses if the
+    // stack needs to be synchronized.
+    mov(eax, dword[GetContextReg() + offsetof(ppc::PPCContext, r[1])]);
+    mov(dword[rsp + StackLayout::GUEST_STACK_POINTER], eax);
+  }
+  if (call_counter_) {
+    mov(rax, reinterpret_cast<uint64_t>(call_counter_));
+    inc(dword[rax]);
+  }
   xor_(eax, eax);
   /*
   * chrispy: removed this, it serves no purpose
@@ -482,8 +517,11 @@ void X64Emitter::UnimplementedInstr(const hir::Instr* i) {
   assert_always();
 }
 
-// This is used by the X64ThunkEmitter's ResolveFunctionThunk.
-uint64_t ResolveFunction(void* raw_context, uint64_t target_address) {
+// This is used by the X64ThunkEmitter's ResolveFunctionThunk. host_stack is
+// the host stack pointer at the entry of the thunk, pointing to a return
+// address into guest code, or 0 if not called through the thunk.
+uint64_t ResolveFunctionAtHostStack(void* raw_context, uint64_t target_address,
+                                    uint64_t host_stack) {
   auto guest_context = reinterpret_cast<ppc::PPCContext_s*>(raw_context);
 
   auto thread_state = guest_context->thread_state;
@@ -577,6 +615,16 @@ uint64_t ResolveFunction(void* raw_context, uint64_t target_address) {
                     static_cast<uint32_t>(guest_context->r[1]);
                 uint32_t num_frames_bigger = 0;
 
+                // Without stackpoints, walk the host frames instead (not
+                // possible if not called through the thunk).
+                if (cvars::lazy_host_guest_stack_synchronization) {
+                  current_stackpoint_index = 0xFFFFFFFF;
+                  if (host_stack) {
+                    num_frames_bigger = backend->CountGuestFramesBelowStack(
+                        host_stack, current_guest_stackpointer);
+                  }
+                }
+
                 /*
                         if the current guest stack pointer is bigger than the
                    recorded pointer for this stack thats fine, plenty of
@@ -696,6 +744,21 @@ uint64_t ResolveFunction(void* raw_context, uint64_t target_address) {
   return addr;
 }
 
+uint64_t ResolveFunction(void* raw_context, uint64_t target_address) {
+  return ResolveFunctionAtHostStack(raw_context, target_address, 0);
+}
+
+void X64Emitter::call(const void* addr) {
+  Xbyak::CodeGenerator::call(addr);
+  external_branch_offsets_.push_back(uint32_t(getSize() - 4));
+}
+
+void X64Emitter::jmp(const void* addr, LabelType type) {
+  // Only near jumps to absolute addresses are possible in the AutoGrow mode.
+  Xbyak::CodeGenerator::jmp(addr, type);
+  external_branch_offsets_.push_back(uint32_t(getSize() - 4));
+}
+
 void X64Emitter::Call(const hir::Instr* instr, GuestFunction* function) {
   assert_not_null(function);
   ForgetMxcsrMode();
@@ -839,7 +902,13 @@ void X64Emitter::CallExtern(const hir::Instr* instr, const Function* function) {
       mov(rcx, reinterpret_cast<uint64_t>(extern_function->extern_handler()));
       mov(rdx,
           qword[GetContextReg() + offsetof(ppc::PPCContext, kernel_state)]);
-      call(backend()->guest_to_host_thunk());
+      auto export_data = extern_function->export_data();
+      if (cvars::x64_leaf_export_thunks && export_data &&
+          export_data->is_leaf()) {
+        call(backend()->guest_to_host_leaf_thunk());
+      } else {
+        call(backend()->guest_to_host_thunk());
+      }
       // rax = host return
     }
   }
@@ -1744,7 +1813,8 @@ void X64Emitter::HandleStackpointOverflowError(ppc::PPCContext* context) {
 }
 
 void X64Emitter::PushStackpoint() {
-  if (!cvars::enable_host_guest_stack_synchronization) {
+  if (!cvars::enable_host_guest_stack_synchronization ||
+      cvars::lazy_host_guest_stack_synchronization) {
     return;
   }
   // push the current host and guest stack pointers
@@ -1788,7 +1858,8 @@ void X64Emitter::PushStackpoint() {
   jge(overflowed_stackpoints, T_NEAR);
 }
 void X64Emitter::PopStackpoint() {
-  if (!cvars::enable_host_guest_stack_synchronization) {
+  if (!cvars::enable_host_guest_stack_synchronization ||
+      cvars::lazy_host_guest_stack_synchronization) {
     return;
   }
   // todo: maybe verify that rsp and r1 == the stackpoint?
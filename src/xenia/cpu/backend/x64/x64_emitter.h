@@ -253,6 +253,17 @@ class X64Emitter : public Xbyak::CodeGenerator {
 
   Xbyak::Label& epilog_label() { return *epilog_label_; }
 
+  // Branches to absolute addresses are rel32, recorded so the code can be
+  // moved within the code cache later.
+  using Xbyak::CodeGenerator::call;
+  using Xbyak::CodeGenerator::jmp;
+  void call(const void* addr);
+  template <class Ret, class... Params>
+  void call(Ret (*func)(Params...)) {
+    call(reinterpret_cast<const void*>(func));
+  }
+  void jmp(const void* addr, LabelType type = T_AUTO);
+
   void MarkSourceOffset(const hir::Instr* i);
 
   void DebugBreak();
@@ -425,6 +436,11 @@ class X64Emitter : public Xbyak::CodeGenerator {
   */
   bool may_use_membase32_as_zero_reg_;
   std::vector<TailEmitter> tail_code_;
+  // Offsets of the rel32 displacements of branches out of the function.
+  std::vector<uint32_t> external_branch_offsets_;
+  // Incremented on every entry to the function when the code cache relayout
+  // is enabled.
+  uint32_t* call_counter_ = nullptr;
   std::vector<Xbyak::Label*>
       label_cache_;  // for creating labels that need to be referenced much
                      // later by tail emitters
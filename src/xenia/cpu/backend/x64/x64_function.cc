@@ -9,6 +9,7 @@
 
 #include "xenia/cpu/backend/x64/x64_function.h"
 
+#include "xenia/base/assert.h"
 #include "xenia/cpu/backend/x64/x64_backend.h"
 #include "xenia/cpu/processor.h"
 #include "xenia/cpu/thread_state.h"
@@ -25,16 +26,44 @@ X64Function::~X64Function() {
   // machine_code_ is freed by code cache.
 }
 
+uintptr_t X64Function::MachineCodeBaseFor(uintptr_t host_address) const {
+  // Relocate stores the previous machine code before the new one.
+  uintptr_t machine_code = reinterpret_cast<uintptr_t>(this->machine_code());
+  uint8_t* previous_machine_code =
+      previous_machine_code_.load(std::memory_order_relaxed);
+  if (previous_machine_code &&
+      (host_address < machine_code ||
+       host_address >= machine_code + machine_code_length_)) {
+    return reinterpret_cast<uintptr_t>(previous_machine_code);
+  }
+  return machine_code;
+}
+
 void X64Function::Setup(uint8_t* machine_code, size_t machine_code_length) {
-  machine_code_ = machine_code;
   machine_code_length_ = machine_code_length;
+  machine_code_.store(machine_code, std::memory_order_release);
+}
+
+void X64Function::SetRelocationInfo(
+    const EmitFunctionInfo& emit_info,
+    std::vector<uint32_t> external_branch_offsets) {
+  emit_info_ = emit_info;
+  external_branch_offsets_ = std::move(external_branch_offsets);
+  is_relocatable_.store(true, std::memory_order_release);
+}
+
+void X64Function::Relocate(uint8_t* machine_code) {
+  assert_null(previous_machine_code_.load(std::memory_order_relaxed));
+  previous_machine_code_.store(this->machine_code(),
+                               std::memory_order_relaxed);
+  machine_code_.store(machine_code, std::memory_order_release);
 }
 
 bool X64Function::CallImpl(ThreadState* thread_state, uint32_t return_address) {
   auto backend =
       reinterpret_cast<X64Backend*>(thread_state->processor()->backend());
   auto thunk = backend->host_to_guest_thunk();
-  thunk(machine_code_, thread_state->context(),
+  thunk(machine_code(), thread_state->context(),
         reinterpret_cast<void*>(uintptr_t(return_address)));
   return true;
 }
@@ -10,6 +10,10 @@
 #ifndef XENIA_CPU_BACKEND_X64_X64_FUNCTION_H_
 #define XENIA_CPU_BACKEND_X64_X64_FUNCTION_H_
 
+#include <atomic>
+#include <vector>
+
+#include "xenia/cpu/backend/x64/x64_code_cache.h"
 #include "xenia/cpu/function.h"
 #include "xenia/cpu/thread_state.h"
 
@@ -23,17 +27,59 @@ class X64Function : public GuestFunction {
   X64Function(Module* module, uint32_t address);
   ~X64Function() override;
 
-  uint8_t* machine_code() const override { return machine_code_; }
+  uint8_t* machine_code() const override {
+    return machine_code_.load(std::memory_order_acquire);
+  }
   size_t machine_code_length() const override { return machine_code_length_; }
 
+  uintptr_t MachineCodeBaseFor(uintptr_t host_address) const override;
+
+  // Called by the code cache with its lock held, before the code is published.
   void Setup(uint8_t* machine_code, size_t machine_code_length);
 
+  // Incremented by the generated code if --code_cache_relayout_delay is set.
+  uint32_t* call_count_address() { return &call_count_; }
+  uint32_t call_count() const { return call_count_; }
+
+  // Host stack frame size of the function body, not including the return
+  // address.
+  size_t stack_size() const { return stack_size_; }
+  void set_stack_size(size_t stack_size) { stack_size_ = stack_size; }
+
+  // What's needed to copy the machine code elsewhere, recorded only if
+  // --code_cache_relayout_delay is set. Must be set before the code is placed,
+  // emit_info and external_branch_offsets may be accessed only if
+  // is_relocatable is true.
+  bool is_relocatable() const {
+    return is_relocatable_.load(std::memory_order_acquire);
+  }
+  const EmitFunctionInfo& emit_info() const { return emit_info_; }
+  // Offsets of the rel32 displacements of the branches out of the code.
+  const std::vector<uint32_t>& external_branch_offsets() const {
+    return external_branch_offsets_;
+  }
+  void SetRelocationInfo(const EmitFunctionInfo& emit_info,
+                         std::vector<uint32_t> external_branch_offsets);
+  // Switches to a copy of the machine code, keeping the current one known as
+  // threads may still be executing it. Can be done only once.
+  void Relocate(uint8_t* machine_code);
+
  protected:
   bool CallImpl(ThreadState* thread_state, uint32_t return_address) override;
 
  private:
-  uint8_t* machine_code_ = nullptr;
+  // Replaced while other threads may be executing or looking up the function.
+  std::atomic<uint8_t*> machine_code_ = nullptr;
   size_t machine_code_length_ = 0;
+  // The original machine code if relocated.
+  std::atomic<uint8_t*> previous_machine_code_ = nullptr;
+  size_t stack_size_ = 0;
+
+  uint32_t call_count_ = 0;
+
+  std::atomic<bool> is_relocatable_ = false;
+  EmitFunctionInfo emit_info_ = {};
+  std::vector<uint32_t> external_branch_offsets_;
 };
 
 }  // namespace x64
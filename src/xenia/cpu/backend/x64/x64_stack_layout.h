@@ -115,6 +115,10 @@ class StackLayout {
    *  +------------------+
    *  | call ret addr    | rsp + 96
    *  +------------------+
+   *  | guest r1 at entry| rsp + 104 (lazy stack synchronization only)
+   *  +------------------+
+   *  | (unused)         | rsp + 112 (lazy stack synchronization only)
+   *  +------------------+
    *    ... locals ...
    *  +------------------+
    *  | (return address) |
@@ -122,6 +126,10 @@ class StackLayout {
    *
    */
   static const size_t GUEST_STACK_SIZE = 104;
+  // Frames are only extended to hold GUEST_STACK_POINTER when emitting with
+  // --lazy_host_guest_stack_synchronization. The frame walk uses the stack
+  // size stored for each function, not this constant.
+  static const size_t GUEST_STACK_SIZE_WITH_STACK_POINTER = 120;
   // was GUEST_CTX_HOME, can't remove because that'd throw stack alignment off.
   // instead, can be used as a temporary in sequences
   static const size_t GUEST_SCRATCH = 0;
@@ -131,6 +139,11 @@ class StackLayout {
   static const size_t GUEST_PROFILER_START = 80;
   static const size_t GUEST_RET_ADDR = 88;
   static const size_t GUEST_CALL_RET_ADDR = 96;
+  // The guest stack pointer when the function was entered, stored if
+  // --lazy_host_guest_stack_synchronization is set to find the host frame to
+  // return to after a longjmp. Only present in frames of
+  // GUEST_STACK_SIZE_WITH_STACK_POINTER.
+  static const size_t GUEST_STACK_POINTER = 104;
 };
 
 }  // namespace x64
@@ -64,14 +64,25 @@ bool DeadCodeEliminationPass::Run(HIRBuilder* builder) {
   // all removed ops with NOP and then do a single pass that removes them
   // all.
 
+  // The instructions are walked through the table built before any changes.
+  // Instructions are only replaced with NOPs or unlinked here, and not
+  // deallocated for real, so the pointers stay valid. Opcodes from the table
+  // are only used to find local stores, which aren't modified by the reverse
+  // walk.
+  if (!instr_table_.Build(builder)) {
+    return false;
+  }
+
   bool any_instr_removed = false;
   bool any_locals_removed = false;
-  auto block = builder->first_block();
-  while (block) {
+  for (uint32_t block_index = 0; block_index < instr_table_.block_count();
+       ++block_index) {
+    uint32_t block_begin = instr_table_.block_begin(block_index);
+    uint32_t block_end = instr_table_.block_end(block_index);
+
     // Walk instructions in reverse.
-    Instr* i = block->instr_tail;
-    while (i) {
-      auto prev = i->prev;
+    for (uint32_t instr_index = block_end; instr_index-- > block_begin;) {
+      Instr* i = instr_table_.instr(instr_index);
 
       auto opcode = i->opcode;
       if (!(opcode->flags & OPCODE_FLAG_VOLATILE) && i->dest &&
@@ -84,36 +95,27 @@ bool DeadCodeEliminationPass::Run(HIRBuilder* builder) {
         // replacing the value.
         ReplaceAssignment(i);
       }
-
-      i = prev;
     }
 
     // Walk instructions forward.
-    i = block->instr_head;
-    while (i) {
-      auto next = i->next;
-
-      auto opcode = i->opcode;
-      if (opcode == &OPCODE_STORE_LOCAL_info) {
+    for (uint32_t instr_index = block_begin; instr_index < block_end;
+         ++instr_index) {
+      if (instr_table_.opcode(instr_index) == OPCODE_STORE_LOCAL) {
         // Check to see if the store has any interceeding uses after the load.
         // If not, it can be removed (as the local is just passing through the
         // function).
         // We do this after the previous pass so that removed code doesn't keep
         // the local alive.
-        if (!CheckLocalUse(i)) {
+        if (!CheckLocalUse(instr_table_.instr(instr_index))) {
           any_locals_removed = true;
         }
       }
-
-      i = next;
     }
-
-    block = block->next;
   }
 
   // Remove all nops.
   if (any_instr_removed) {
-    block = builder->first_block();
+    auto block = builder->first_block();
     while (block) {
       Instr* i = block->instr_head;
       while (i) {
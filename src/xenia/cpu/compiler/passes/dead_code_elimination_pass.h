@@ -11,6 +11,7 @@
 #define XENIA_CPU_COMPILER_PASSES_DEAD_CODE_ELIMINATION_PASS_H_
 
 #include "xenia/cpu/compiler/compiler_pass.h"
+#include "xenia/cpu/hir/instr_table.h"
 
 namespace xe {
 namespace cpu {
@@ -28,6 +29,8 @@ class DeadCodeEliminationPass : public CompilerPass {
   void MakeNopRecursive(hir::Instr* i);
   void ReplaceAssignment(hir::Instr* i);
   bool CheckLocalUse(hir::Instr* i);
+
+  hir::InstrTable instr_table_;
 };
 
 }  // namespace passes
@@ -26,8 +26,7 @@ using namespace xe::cpu::hir;
 using xe::cpu::hir::Block;
 using xe::cpu::hir::HIRBuilder;
 using xe::cpu::hir::Instr;
-using xe::cpu::hir::OpcodeSignatureType;
-using xe::cpu::hir::Value;
+using xe::cpu::hir::InstrTable;
 
 ValidationPass::ValidationPass() : CompilerPass() {}
 
@@ -42,8 +41,12 @@ bool ValidationPass::Run(HIRBuilder* builder) {
   str.Reset();
 #endif  // 0
 
-  auto block = builder->first_block();
-  while (block) {
+  if (!instr_table_.Build(builder)) {
+    return false;
+  }
+  for (uint32_t block_index = 0; block_index < instr_table_.block_count();
+       ++block_index) {
+    Block* block = instr_table_.block(block_index);
     auto label = block->label_head;
     while (label) {
       assert_true(label->block == block);
@@ -53,48 +56,33 @@ bool ValidationPass::Run(HIRBuilder* builder) {
       label = label->next;
     }
 
-    auto instr = block->instr_head;
-    while (instr) {
-      if (!ValidateInstruction(block, instr)) {
+    for (uint32_t instr_index = instr_table_.block_begin(block_index);
+         instr_index < instr_table_.block_end(block_index); ++instr_index) {
+      if (!ValidateInstruction(block_index, instr_index)) {
         return false;
       }
-      instr = instr->next;
     }
-
-    block = block->next;
   }
 
   return true;
 }
 
-bool ValidationPass::ValidateInstruction(Block* block, Instr* instr) {
-  assert_true(instr->block == block);
-  if (instr->block != block) {
+bool ValidationPass::ValidateInstruction(uint32_t block_index,
+                                         uint32_t instr_index) {
+  Instr* instr = instr_table_.instr(instr_index);
+  assert_true(instr->block == instr_table_.block(block_index));
+  if (instr->block != instr_table_.block(block_index)) {
     return false;
   }
 
   if (instr->dest) {
     assert_true(instr->dest->def == instr);
-    auto use = instr->dest->use_head;
-    while (use) {
-      assert_true(use->instr->block == block);
-      use = use->next;
-    }
   }
 
-  uint32_t signature = instr->opcode->signature;
-  if (GET_OPCODE_SIG_TYPE_SRC1(signature) == OPCODE_SIG_TYPE_V) {
-    if (!ValidateValue(block, instr, instr->src1.value)) {
-      return false;
-    }
-  }
-  if (GET_OPCODE_SIG_TYPE_SRC2(signature) == OPCODE_SIG_TYPE_V) {
-    if (!ValidateValue(block, instr, instr->src2.value)) {
-      return false;
-    }
-  }
-  if (GET_OPCODE_SIG_TYPE_SRC3(signature) == OPCODE_SIG_TYPE_V) {
-    if (!ValidateValue(block, instr, instr->src3.value)) {
+  for (uint32_t i = 0; i < 3; ++i) {
+    uint32_t value_ordinal = instr_table_.src(instr_index, i);
+    if (value_ordinal != InstrTable::kNoValue &&
+        !ValidateValue(block_index, value_ordinal)) {
       return false;
     }
   }
@@ -102,14 +90,11 @@ bool ValidationPass::ValidateInstruction(Block* block, Instr* instr) {
   return true;
 }
 
-bool ValidationPass::ValidateValue(Block* block, Instr* instr, Value* value) {
-  // if (value->def) {
-  //  auto def = value->def;
-  //  assert_true(def->block == block);
-  //  if (def->block != block) {
-  //    return false;
-  //  }
-  //}
+bool ValidationPass::ValidateValue(uint32_t block_index,
+                                   uint32_t value_ordinal) {
+  // Values must be used only in the block defining them.
+  uint16_t def_block = instr_table_.value_def_block(value_ordinal);
+  assert_true(def_block == InstrTable::kNoBlock || def_block == block_index);
   return true;
 }
 
@@ -11,6 +11,7 @@
 #define XENIA_CPU_COMPILER_PASSES_VALIDATION_PASS_H_
 
 #include "xenia/cpu/compiler/compiler_pass.h"
+#include "xenia/cpu/hir/instr_table.h"
 
 namespace xe {
 namespace cpu {
@@ -25,8 +26,10 @@ class ValidationPass : public CompilerPass {
   bool Run(hir::HIRBuilder* builder) override;
 
  private:
-  bool ValidateInstruction(hir::Block* block, hir::Instr* instr);
-  bool ValidateValue(hir::Block* block, hir::Instr* instr, hir::Value* value);
+  bool ValidateInstruction(uint32_t block_index, uint32_t instr_index);
+  bool ValidateValue(uint32_t block_index, uint32_t value_ordinal);
+
+  hir::InstrTable instr_table_;
 };
 
 }  // namespace passes
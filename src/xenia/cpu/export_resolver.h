@@ -42,7 +42,7 @@ struct ExportTag {
   using type = uint32_t;
 
   // packed like so:
-  // ll...... cccccccc ........ ..bihssi
+  // ll...... cccccccc ........ lvbihssi
 
   static constexpr int CategoryShift = 16;
 
@@ -59,6 +59,9 @@ struct ExportTag {
   // Export blocks the calling thread
   static constexpr type kBlocking = 1u << 5;
   static constexpr type kIsVariable = 1u << 6;
+  // Export is a host leaf: it never re-enters guest code, blocks or delivers
+  // APCs, so it can be called through the lightweight guest-to-host thunk.
+  static constexpr type kLeaf = 1u << 7;
   // Export will be logged on each call.
   static constexpr type kLog = 1u << 30;
   // Export's result will be logged on each call.
@@ -108,6 +111,9 @@ class Export {
   constexpr bool is_implemented() const {
     return (tags & ExportTag::kImplemented) == ExportTag::kImplemented;
   }
+  constexpr bool is_leaf() const {
+    return (tags & ExportTag::kLeaf) == ExportTag::kLeaf;
+  }
   constexpr Type get_type() const {
     return (this->tags & ExportTag::kIsVariable) ? Type::kVariable
                                                  : Type::kFunction;
@@ -120,8 +120,8 @@ uintptr_t GuestFunction::MapGuestAddressToMachineCode(
 
 uint32_t GuestFunction::MapMachineCodeToGuestAddress(
     uintptr_t host_address) const {
-  auto entry = LookupMachineCodeOffset(static_cast<uint32_t>(
-      host_address - reinterpret_cast<uintptr_t>(machine_code())));
+  auto entry = LookupMachineCodeOffset(
+      static_cast<uint32_t>(host_address - MachineCodeBaseFor(host_address)));
   return entry ? entry->guest_address : address();
 }
 
@@ -149,6 +149,12 @@ class GuestFunction : public Function {
   uintptr_t MapGuestAddressToMachineCode(uint32_t guest_address) const;
   uint32_t MapMachineCodeToGuestAddress(uintptr_t host_address) const;
 
+  // Start of the copy of the machine code containing the host address. The
+  // code may be copied elsewhere while the previous copy is still executed.
+  virtual uintptr_t MachineCodeBaseFor(uintptr_t host_address) const {
+    return reinterpret_cast<uintptr_t>(machine_code());
+  }
+
   bool Call(ThreadState* thread_state, uint32_t return_address) override;
 
  protected:
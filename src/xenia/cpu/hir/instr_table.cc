@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/hir/instr_table.h"
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+#include "xenia/cpu/hir/block.h"
+#include "xenia/cpu/hir/hir_builder.h"
+#include "xenia/cpu/hir/instr.h"
+#include "xenia/cpu/hir/value.h"
+
+namespace xe {
+namespace cpu {
+namespace hir {
+
+bool InstrTable::Build(HIRBuilder* builder) {
+  Reset();
+
+  uint32_t value_count = builder->max_value_ordinal();
+  values_.resize(value_count, nullptr);
+  value_def_blocks_.resize(value_count, kNoBlock);
+
+  for (Block* block = builder->first_block(); block; block = block->next) {
+    assert_true(blocks_.size() < kNoBlock);
+    auto block_index = uint16_t(blocks_.size());
+    blocks_.push_back(block);
+    block_starts_.push_back(instr_count());
+    for (Instr* instr = block->instr_head; instr; instr = instr->next) {
+      instrs_.push_back(instr);
+      opcodes_.push_back(instr->opcode->num);
+      uint32_t signature = instr->opcode->signature;
+      uint32_t dest = AddValue(instr->dest);
+      uint32_t src1 = GET_OPCODE_SIG_TYPE_SRC1(signature) == OPCODE_SIG_TYPE_V
+                          ? AddValue(instr->src1.value)
+                          : kNoValue;
+      uint32_t src2 = GET_OPCODE_SIG_TYPE_SRC2(signature) == OPCODE_SIG_TYPE_V
+                          ? AddValue(instr->src2.value)
+                          : kNoValue;
+      uint32_t src3 = GET_OPCODE_SIG_TYPE_SRC3(signature) == OPCODE_SIG_TYPE_V
+                          ? AddValue(instr->src3.value)
+                          : kNoValue;
+      if (dest == kInvalidOrdinal || src1 == kInvalidOrdinal ||
+          src2 == kInvalidOrdinal || src3 == kInvalidOrdinal) {
+        // The ordinals have been compacted or reassigned.
+        XELOGE("HIR instruction table: non-unique value ordinals in block {}",
+               block_index);
+        Reset();
+        return false;
+      }
+      if (dest != kNoValue) {
+        value_def_blocks_[dest] = block_index;
+      }
+      dests_.push_back(dest);
+      srcs_.push_back(src1);
+      srcs_.push_back(src2);
+      srcs_.push_back(src3);
+    }
+  }
+  block_starts_.push_back(instr_count());
+  return true;
+}
+
+void InstrTable::Reset() {
+  blocks_.clear();
+  block_starts_.clear();
+  instrs_.clear();
+  opcodes_.clear();
+  dests_.clear();
+  srcs_.clear();
+  values_.clear();
+  value_def_blocks_.clear();
+}
+
+uint32_t InstrTable::AddValue(Value* value) {
+  if (!value) {
+    return kNoValue;
+  }
+  if (value->ordinal >= values_.size()) {
+    return kInvalidOrdinal;
+  }
+  Value*& value_entry = values_[value->ordinal];
+  if (value_entry && value_entry != value) {
+    return kInvalidOrdinal;
+  }
+  value_entry = value;
+  return value->ordinal;
+}
+
+}  // namespace hir
+}  // namespace cpu
+}  // namespace xe
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_CPU_HIR_INSTR_TABLE_H_
+#define XENIA_CPU_HIR_INSTR_TABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "xenia/cpu/hir/opcodes.h"
+
+namespace xe {
+namespace cpu {
+namespace hir {
+
+class Block;
+class HIRBuilder;
+class Instr;
+class Value;
+
+// Dense snapshot of the instructions of a function in program order, for
+// passes that only need to scan the HIR. The opcodes and the value operands
+// are stored in contiguous arrays, with the values referenced by their
+// ordinals, so scanning doesn't need to chase the Instr, Value and Value::Use
+// nodes scattered across the arena of the builder.
+//
+// Requires the value ordinals to be unique (not compacted by
+// ValueReductionPass). Not updated when the HIR is modified - must be built
+// again after instructions or their operands are changed. Building again
+// reuses the memory of the previous snapshot.
+class InstrTable {
+ public:
+  static constexpr uint32_t kNoValue = UINT32_MAX;
+  static constexpr uint16_t kNoBlock = UINT16_MAX;
+
+  // Returns false, leaving the table empty, if multiple values have the same
+  // ordinal.
+  bool Build(HIRBuilder* builder);
+  void Reset();
+
+  uint32_t block_count() const { return uint32_t(blocks_.size()); }
+  Block* block(uint32_t block_index) const { return blocks_[block_index]; }
+  // Range of the indices of the instructions of a block.
+  uint32_t block_begin(uint32_t block_index) const {
+    return block_starts_[block_index];
+  }
+  uint32_t block_end(uint32_t block_index) const {
+    return block_starts_[block_index + 1];
+  }
+
+  uint32_t instr_count() const { return uint32_t(instrs_.size()); }
+  Instr* instr(uint32_t index) const { return instrs_[index]; }
+  Opcode opcode(uint32_t index) const { return opcodes_[index]; }
+  // Ordinal of the destination value, or kNoValue.
+  uint32_t dest(uint32_t index) const { return dests_[index]; }
+  // Ordinal of the value in the source operand 0 to 2, or kNoValue if it's not
+  // a value.
+  uint32_t src(uint32_t index, uint32_t src_index) const {
+    return srcs_[index * 3 + src_index];
+  }
+
+  // Indexed by the value ordinal, null for values not referenced by any
+  // instruction.
+  Value* value(uint32_t ordinal) const { return values_[ordinal]; }
+  // Index of the block of the instruction defining the value, or kNoBlock for
+  // constants, locals and values not defined by any instruction.
+  uint16_t value_def_block(uint32_t ordinal) const {
+    return value_def_blocks_[ordinal];
+  }
+
+ private:
+  static constexpr uint32_t kInvalidOrdinal = kNoValue - 1;
+
+  // Returns the ordinal, kNoValue for no value, or kInvalidOrdinal if it's out
+  // of range or taken by a different value.
+  uint32_t AddValue(Value* value);
+
+  std::vector<Block*> blocks_;
+  // Instruction index of each block, and the instruction count in the end.
+  std::vector<uint32_t> block_starts_;
+
+  std::vector<Instr*> instrs_;
+  std::vector<Opcode> opcodes_;
+  std::vector<uint32_t> dests_;
+  // 3 per instruction.
+  std::vector<uint32_t> srcs_;
+
+  std::vector<Value*> values_;
+  std::vector<uint16_t> value_def_blocks_;
+};
+
+}  // namespace hir
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XENIA_CPU_HIR_INSTR_TABLE_H_
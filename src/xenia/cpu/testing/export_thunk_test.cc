@@ -0,0 +1,138 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+
+#include "xenia/cpu/export_resolver.h"
+#include "xenia/cpu/testing/util.h"
+#include "xenia/kernel/xam/xam_module.h"
+#include "xenia/kernel/xboxkrnl/xboxkrnl_module.h"
+
+#include "third_party/fmt/include/fmt/format.h"
+
+#if XE_ARCH_AMD64
+#include "xenia/cpu/backend/x64/x64_emitter.h"
+
+namespace xe {
+namespace cpu {
+namespace testing {
+
+// Calls a guest-to-host thunk in a loop with the context register set up the
+// same way generated code does.
+// void Drive(void* context, void* thunk, void* target, uint64_t count)
+class ThunkDriver : public Xbyak::CodeGenerator {
+ public:
+  using Fn = void (*)(void* context, void* thunk, void* target,
+                      uint64_t count);
+
+  ThunkDriver() {
+    push(rbx);
+    push(rsi);
+    push(rdi);
+    push(r12);
+    push(r13);
+    sub(rsp, 32);
+#if XE_PLATFORM_WIN32
+    mov(rsi, rcx);
+    mov(r12, rdx);
+    mov(r13, r8);
+    mov(rbx, r9);
+#else
+    mov(r12, rsi);
+    mov(rsi, rdi);
+    mov(r13, rdx);
+    mov(rbx, rcx);
+#endif
+    Xbyak::Label loop;
+    L(loop);
+    mov(rcx, r13);
+    call(r12);
+    dec(rbx);
+    jnz(loop);
+    add(rsp, 32);
+    pop(r13);
+    pop(r12);
+    pop(rdi);
+    pop(rsi);
+    pop(rbx);
+    ret();
+    ready();
+  }
+
+  Fn fn() const { return getCode<Fn>(); }
+};
+
+static void NopExportTrampoline(ppc::PPCContext* ppc_context) {}
+
+static double MeasureThunkNanoseconds(const ThunkDriver& driver, void* thunk,
+                                      void* context, uint64_t count) {
+  // Warm up.
+  driver.fn()(context, thunk, reinterpret_cast<void*>(&NopExportTrampoline),
+              1024);
+  auto start = std::chrono::steady_clock::now();
+  driver.fn()(context, thunk, reinterpret_cast<void*>(&NopExportTrampoline),
+              count);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         double(count);
+}
+
+TEST_CASE("Guest-to-host thunk overhead", "[.benchmark][thunk]") {
+  constexpr uint64_t kIterations = 10000000;
+
+  auto memory = std::make_unique<Memory>();
+  REQUIRE(memory->Initialize());
+  auto processor = std::make_unique<Processor>(memory.get(), nullptr);
+  REQUIRE(processor->Setup(std::make_unique<backend::x64::X64Backend>()));
+  auto backend =
+      static_cast<backend::x64::X64Backend*>(processor->backend());
+
+  auto context = std::make_unique<ppc::PPCContext>();
+  ThunkDriver driver;
+
+  double full_ns = MeasureThunkNanoseconds(
+      driver, reinterpret_cast<void*>(backend->guest_to_host_thunk()),
+      context.get(), kIterations);
+  double leaf_ns = MeasureThunkNanoseconds(
+      driver, reinterpret_cast<void*>(backend->guest_to_host_leaf_thunk()),
+      context.get(), kIterations);
+  fmt::print("full thunk: {:.2f} ns/call, leaf thunk: {:.2f} ns/call\n",
+             full_ns, leaf_ns);
+
+  ExportResolver export_resolver;
+  kernel::xam::XamModule::RegisterExportTable(&export_resolver);
+  kernel::xboxkrnl::XboxkrnlModule::RegisterExportTable(&export_resolver);
+
+  size_t high_frequency_count = 0;
+  size_t leaf_count = 0;
+  for (auto export_entry : export_resolver.all_exports_by_name()) {
+    if (!(export_entry->tags & ExportTag::kHighFrequency) ||
+        export_entry->get_type() != Export::Type::kFunction) {
+      continue;
+    }
+    ++high_frequency_count;
+    if (export_entry->is_leaf()) {
+      ++leaf_count;
+    }
+  }
+  // The thunk overhead doesn't depend on the export, so it's measured once
+  // rather than per export.
+  fmt::print(
+      "{} of {} kHighFrequency exports use the leaf thunk "
+      "({:.2f} -> {:.2f} ns/call)\n",
+      leaf_count, high_frequency_count, full_ns, leaf_ns);
+
+  REQUIRE(leaf_ns > 0.0);
+}
+
+}  // namespace testing
+}  // namespace cpu
+}  // namespace xe
+
+#endif  // XE_ARCH_AMD64
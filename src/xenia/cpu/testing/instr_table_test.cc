@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/cpu/hir/hir_builder.h"
+#include "xenia/cpu/hir/instr_table.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace cpu {
+namespace hir {
+namespace test {
+
+TEST_CASE("Instruction table mirrors the HIR", "[instr_table]") {
+  HIRBuilder builder;
+  builder.MakeCurrent();
+
+  Value* loaded = builder.LoadContext(0, INT32_TYPE);
+  Value* sum = builder.Add(loaded, builder.LoadConstantInt32(1));
+  builder.StoreContext(4, sum);
+  Label* label = builder.NewLabel();
+  builder.Branch(label);
+  builder.MarkLabel(label);
+  builder.StoreContext(8, loaded);
+  builder.Return();
+
+  InstrTable table;
+  REQUIRE(table.Build(&builder));
+  REQUIRE(table.block_count() == 2);
+  REQUIRE(table.instr_count() == 6);
+  REQUIRE(table.block_begin(0) == 0);
+  REQUIRE(table.block_end(0) == 4);
+  REQUIRE(table.block_begin(1) == 4);
+  REQUIRE(table.block_end(1) == 6);
+  REQUIRE(table.block(1) == builder.last_block());
+
+  // loaded = load_context +0
+  REQUIRE(table.opcode(0) == OPCODE_LOAD_CONTEXT);
+  REQUIRE(table.dest(0) == loaded->ordinal);
+  REQUIRE(table.src(0, 0) == InstrTable::kNoValue);
+  // sum = add loaded, 1
+  REQUIRE(table.opcode(1) == OPCODE_ADD);
+  REQUIRE(table.instr(1) == sum->def);
+  REQUIRE(table.src(1, 0) == loaded->ordinal);
+  uint32_t constant = table.src(1, 1);
+  REQUIRE(table.value(constant)->IsConstant());
+  REQUIRE(table.value_def_block(constant) == InstrTable::kNoBlock);
+  REQUIRE(table.src(1, 2) == InstrTable::kNoValue);
+  // store_context +8, loaded - in the second block.
+  REQUIRE(table.opcode(4) == OPCODE_STORE_CONTEXT);
+  REQUIRE(table.dest(4) == InstrTable::kNoValue);
+  REQUIRE(table.src(4, 1) == loaded->ordinal);
+  REQUIRE(table.value(loaded->ordinal) == loaded);
+  REQUIRE(table.value_def_block(loaded->ordinal) == 0);
+  REQUIRE(table.value_def_block(sum->ordinal) == 0);
+
+  // Rebuilt after modifying the HIR.
+  builder.last_block()->instr_head->UnlinkAndNOP();
+  REQUIRE(table.Build(&builder));
+  REQUIRE(table.instr_count() == 5);
+  REQUIRE(table.block_end(1) == 5);
+  REQUIRE(table.opcode(4) == OPCODE_RETURN);
+
+  // Values with the same ordinal, like after ValueReductionPass, are rejected.
+  uint32_t sum_ordinal = sum->ordinal;
+  sum->ordinal = loaded->ordinal;
+  REQUIRE_FALSE(table.Build(&builder));
+  REQUIRE(table.instr_count() == 0);
+  sum->ordinal = sum_ordinal;
+  REQUIRE(table.Build(&builder));
+
+  builder.RemoveCurrent();
+}
+
+}  // namespace test
+}  // namespace hir
+}  // namespace cpu
+}  // namespace xe
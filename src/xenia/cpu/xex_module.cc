@@ -13,11 +13,13 @@
 
 #include "third_party/fmt/include/fmt/format.h"
 
+#include "xenia/base/boot_trace.h"
 #include "xenia/base/byte_order.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/memory.h"
+#include "xenia/base/threading.h"
 
 #include "xenia/cpu/cpu_flags.h"
 #include "xenia/cpu/export_resolver.h"
@@ -224,6 +226,8 @@ int XexModule::ApplyPatch(XexModule* module) {
     return 1;
   }
 
+  boot_trace::ScopedPhase phase("Apply XEX delta patch");
+
   const uint32_t original_base_address = module->base_address();
 
   // Grab the delta descriptor and get to work.
@@ -722,8 +726,11 @@ int XexModule::ReadImageCompressed(const void* xex_addr, size_t xex_length) {
       // TODO: a way to do without a copy/alloc?
       free_input = true;
       input_buffer = (const uint8_t*)calloc(1, exe_length);
-      aes_decrypt_buffer(session_key_, exe_buffer, exe_length,
-                         (uint8_t*)input_buffer, exe_length);
+      {
+        boot_trace::ScopedPhase phase("Decrypt XEX image");
+        aes_decrypt_buffer(session_key_, exe_buffer, exe_length,
+                           (uint8_t*)input_buffer, exe_length);
+      }
       break;
     default:
       assert_always();
@@ -793,6 +800,7 @@ int XexModule::ReadImageCompressed(const void* xex_addr, size_t xex_length) {
       std::memset(buffer, 0, uncompressed_size);
 
       // Decompress into XEX base
+      boot_trace::ScopedPhase phase("Decompress XEX image");
       result_code = lzx_decompress(
           compress_buffer, d - compress_buffer, buffer, uncompressed_size,
           compression_info->normal.window_size, nullptr, 0);
@@ -971,18 +979,22 @@ bool XexModule::Load(const std::string_view name, const std::string_view path,
 
   // Load in the XEX basefile
   // We'll try using both XEX2 keys to see if any give a valid PE
-  int result_code = ReadImage(xex_addr, xex_length, false);
-  if (result_code) {
-    XELOGW("XEX load failed with code {}, trying with devkit encryption key...",
-           result_code);
-
-    result_code = ReadImage(xex_addr, xex_length, true);
+  int result_code;
+  {
+    boot_trace::ScopedPhase read_image_phase("Read XEX image");
+    result_code = ReadImage(xex_addr, xex_length, false);
     if (result_code) {
-      XELOGE("XEX load failed with code {}, tried both encryption keys",
-             result_code);
-      return false;
+      XELOGW(
+          "XEX load failed with code {}, trying with devkit encryption key...",
+          result_code);
+      result_code = ReadImage(xex_addr, xex_length, true);
     }
   }
+  if (result_code) {
+    XELOGE("XEX load failed with code {}, tried both encryption keys",
+           result_code);
+    return false;
+  }
 
   // Note: caller will have to call LoadContinue once it's determined whether a
   // patch file exists or not!
@@ -1126,15 +1138,41 @@ bool XexModule::LoadContinue() {
 }
 
 void XexModule::Precompile() {
-  sha1::SHA1 final_image_sha_;
+  boot_trace::ScopedPhase precompile_phase("Precompile XEX");
 
-  final_image_sha_.reset();
+  // The hash is only needed by the info cache, so compute it while searching
+  // for the save/restore functions, which only reads the image too.
+  auto hash_image = [this]() {
+    boot_trace::ScopedPhase phase("Hash XEX image");
+    sha1::SHA1 final_image_sha_;
 
-  unsigned high_code = this->high_address_ - this->low_address_;
+    final_image_sha_.reset();
 
-  final_image_sha_.processBytes(memory()->TranslateVirtual(this->low_address_),
-                                high_code);
-  final_image_sha_.finalize(image_sha_bytes_);
+    unsigned high_code = this->high_address_ - this->low_address_;
+
+    final_image_sha_.processBytes(
+        memory()->TranslateVirtual(this->low_address_), high_code);
+    final_image_sha_.finalize(image_sha_bytes_);
+  };
+  std::unique_ptr<xe::threading::Thread> hash_thread =
+      xe::threading::Thread::Create({}, hash_image);
+  if (hash_thread) {
+    hash_thread->set_name("XEX Image Hash");
+  } else {
+    hash_image();
+  }
+
+  // Find __savegprlr_* and __restgprlr_* and the others.
+  // We can flag these for special handling (inlining/etc).
+  bool found_save_rest;
+  {
+    boot_trace::ScopedPhase phase("Find save/restore functions");
+    found_save_rest = FindSaveRest();
+  }
+
+  if (hash_thread) {
+    xe::threading::Wait(hash_thread.get(), false);
+  }
 
   char fmtbuf[16];
 
@@ -1143,13 +1181,12 @@ void XexModule::Precompile() {
     image_sha_str_ += &fmtbuf[0];
   }
 
-  // Find __savegprlr_* and __restgprlr_* and the others.
-  // We can flag these for special handling (inlining/etc).
-  if (!FindSaveRest()) {
+  if (!found_save_rest) {
     return;
   }
 
   info_cache_.Init(this);
+  boot_trace::ScopedPhase discovery_phase("Precompile discovered functions");
   PrecompileDiscoveredFunctions();
 }
 bool XexModule::Unload() {
@@ -20,8 +20,10 @@
 #include "third_party/zarchive/src/sha_256.h"
 #include "xenia/apu/audio_system.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/boot_trace.h"
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/clock.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/debugging.h"
 #include "xenia/base/exception_handler.h"
@@ -31,6 +33,7 @@
 #include "xenia/base/platform.h"
 #include "xenia/base/string.h"
 #include "xenia/base/system.h"
+#include "xenia/base/threading.h"
 #include "xenia/cpu/backend/code_cache.h"
 #include "xenia/cpu/backend/null_backend.h"
 #include "xenia/cpu/cpu_flags.h"
@@ -167,6 +170,8 @@ Emulator::Emulator(const std::filesystem::path& command_line,
 }
 
 Emulator::~Emulator() {
+  frame_telemetry::WriteFramesIfRequested();
+
   // Note that we delete things in the reverse order they were initialized.
 
   // Give the systems time to shutdown before we delete them.
@@ -200,6 +205,7 @@ X_STATUS Emulator::Setup(
         graphics_system_factory,
     std::function<std::vector<std::unique_ptr<hid::InputDriver>>(ui::Window*)>
         input_driver_factory) {
+  boot_trace::ScopedPhase setup_phase("Emulator setup");
   X_STATUS result = X_STATUS_UNSUCCESSFUL;
 
   display_window_ = display_window;
@@ -246,12 +252,16 @@ X_STATUS Emulator::Setup(
   // Initialize the CPU.
   processor_ = std::make_unique<xe::cpu::Processor>(memory_.get(),
                                                     export_resolver_.get());
-  if (!processor_->Setup(std::move(backend))) {
-    return X_STATUS_UNSUCCESSFUL;
+  {
+    boot_trace::ScopedPhase processor_phase("Processor setup");
+    if (!processor_->Setup(std::move(backend))) {
+      return X_STATUS_UNSUCCESSFUL;
+    }
   }
 
   // Initialize the APU.
   if (audio_system_factory) {
+    boot_trace::ScopedPhase audio_phase("Audio system creation");
     audio_system_ = audio_system_factory(processor_.get());
     if (!audio_system_) {
       return X_STATUS_NOT_IMPLEMENTED;
@@ -259,9 +269,12 @@ X_STATUS Emulator::Setup(
   }
 
   // Initialize the GPU.
-  graphics_system_ = graphics_system_factory();
-  if (!graphics_system_) {
-    return X_STATUS_NOT_IMPLEMENTED;
+  {
+    boot_trace::ScopedPhase graphics_phase("Graphics system creation");
+    graphics_system_ = graphics_system_factory();
+    if (!graphics_system_) {
+      return X_STATUS_NOT_IMPLEMENTED;
+    }
   }
 
   // Initialize the HID.
@@ -279,15 +292,19 @@ X_STATUS Emulator::Setup(
     }
   }
 
-  result = input_system_->Setup();
-  if (result) {
-    return result;
+  {
+    boot_trace::ScopedPhase input_phase("Input system setup");
+    result = input_system_->Setup();
+    if (result) {
+      return result;
+    }
   }
 
   // Bring up the virtual filesystem used by the kernel.
   file_system_ = std::make_unique<xe::vfs::VirtualFileSystem>();
 
-  patcher_ = std::make_unique<xe::patcher::Patcher>(storage_root_);
+  patcher_ =
+      std::make_unique<xe::patcher::Patcher>(storage_root_, cache_root_);
 
   // Shared kernel state.
   kernel_state_ = std::make_unique<xe::kernel::KernelState>(this);
@@ -302,15 +319,19 @@ X_STATUS Emulator::Setup(
       kernel_state_.get(), storage_root() / "plugins");
 
   // Setup the core components.
-  result = graphics_system_->Setup(
-      processor_.get(), kernel_state_.get(),
-      display_window_ ? &display_window_->app_context() : nullptr,
-      display_window_ != nullptr);
-  if (result) {
-    return result;
+  {
+    boot_trace::ScopedPhase graphics_phase("Graphics system setup");
+    result = graphics_system_->Setup(
+        processor_.get(), kernel_state_.get(),
+        display_window_ ? &display_window_->app_context() : nullptr,
+        display_window_ != nullptr);
+    if (result) {
+      return result;
+    }
   }
 
   if (audio_system_) {
+    boot_trace::ScopedPhase audio_phase("Audio system setup");
     result = audio_system_->Setup(kernel_state_.get());
     if (result) {
       return result;
@@ -509,35 +530,44 @@ Emulator::FileSignatureType Emulator::GetFileSignature(
 }
 
 X_STATUS Emulator::LaunchPath(const std::filesystem::path& path) {
-  X_STATUS mount_result = X_STATUS_SUCCESS;
+  X_STATUS result = X_STATUS_SUCCESS;
+  {
+    boot_trace::ScopedPhase launch_phase("Title launch");
+    auto mount = [this, &path](const std::string_view mount_path) {
+      boot_trace::ScopedPhase mount_phase("Mount");
+      return MountPath(path, mount_path);
+    };
 
-  switch (GetFileSignature(path)) {
-    case FileSignatureType::XEX1:
-    case FileSignatureType::XEX2:
-    case FileSignatureType::ELF: {
-      mount_result = MountPath(path, "\\Device\\Harddisk0\\Partition1");
-      return mount_result ? mount_result : LaunchXexFile(path);
-    } break;
-    case FileSignatureType::LIVE:
-    case FileSignatureType::CON:
-    case FileSignatureType::PIRS: {
-      mount_result = MountPath(path, "\\Device\\Cdrom0");
-      return mount_result ? mount_result : LaunchStfsContainer(path);
-    } break;
-    case FileSignatureType::XISO: {
-      mount_result = MountPath(path, "\\Device\\Cdrom0");
-      return mount_result ? mount_result : LaunchDiscImage(path);
-    } break;
-    case FileSignatureType::ZAR: {
-      mount_result = MountPath(path, "\\Device\\Cdrom0");
-      return mount_result ? mount_result : LaunchDiscArchive(path);
-    } break;
-    case FileSignatureType::EXE:
-    case FileSignatureType::Unknown:
-    default:
-      return X_STATUS_NOT_SUPPORTED;
-      break;
+    switch (GetFileSignature(path)) {
+      case FileSignatureType::XEX1:
+      case FileSignatureType::XEX2:
+      case FileSignatureType::ELF: {
+        result = mount("\\Device\\Harddisk0\\Partition1");
+        result = result ? result : LaunchXexFile(path);
+      } break;
+      case FileSignatureType::LIVE:
+      case FileSignatureType::CON:
+      case FileSignatureType::PIRS: {
+        result = mount("\\Device\\Cdrom0");
+        result = result ? result : LaunchStfsContainer(path);
+      } break;
+      case FileSignatureType::XISO: {
+        result = mount("\\Device\\Cdrom0");
+        result = result ? result : LaunchDiscImage(path);
+      } break;
+      case FileSignatureType::ZAR: {
+        result = mount("\\Device\\Cdrom0");
+        result = result ? result : LaunchDiscArchive(path);
+      } break;
+      case FileSignatureType::EXE:
+      case FileSignatureType::Unknown:
+      default:
+        result = X_STATUS_NOT_SUPPORTED;
+        break;
+    }
   }
+  boot_trace::Flush();
+  return result;
 }
 
 X_STATUS Emulator::LaunchXexFile(const std::filesystem::path& path) {
@@ -822,6 +852,7 @@ X_STATUS Emulator::InstallContentPackage(
 
   X_STATUS error_code = vfs::VirtualFileSystem::ExtractContentFiles(
       device.get(), installation_path);
+  kernel_state()->content_manager()->InvalidateContentLists();
   if (error_code != X_ERROR_SUCCESS) {
     return error_code;
   }
@@ -1386,20 +1417,31 @@ X_STATUS Emulator::CompleteLaunch(const std::filesystem::path& path,
   auto xam = kernel_state()->GetKernelModule<kernel::xam::XamModule>("xam.xex");
 
   XELOGI("Loading module {}", module_path);
-  auto module = kernel_state_->LoadUserModule(module_path);
+  kernel::object_ref<kernel::UserModule> module;
+  {
+    boot_trace::ScopedPhase load_phase("Load user module");
+    module = kernel_state_->LoadUserModule(module_path);
+  }
   if (!module) {
     XELOGE("Failed to load user module {}", xe::path_to_utf8(path));
     return X_STATUS_NOT_FOUND;
   }
 
-  X_RESULT result = kernel_state_->ApplyTitleUpdate(module);
+  X_RESULT result;
+  {
+    boot_trace::ScopedPhase title_update_phase("Apply title update");
+    result = kernel_state_->ApplyTitleUpdate(module);
+  }
   if (XFAILED(result)) {
     XELOGE("Failed to apply title update! Cannot run module {}",
            xe::path_to_utf8(path));
     return result;
   }
 
-  result = kernel_state_->FinishLoadingUserModule(module);
+  {
+    boot_trace::ScopedPhase finish_load_phase("Finish loading user module");
+    result = kernel_state_->FinishLoadingUserModule(module);
+  }
   if (XFAILED(result)) {
     XELOGE("Failed to initialize user module {}", xe::path_to_utf8(path));
     return result;
@@ -1426,8 +1468,8 @@ X_STATUS Emulator::CompleteLaunch(const std::filesystem::path& path,
     }
   }
 
-  // Try and load the resource database (xex only).
   if (module->title_id()) {
+    boot_trace::ScopedPhase game_config_phase("Load game config");
     auto title_id = fmt::format("{:08X}", module->title_id());
 
     // Load the per-game configuration file and make sure updates are handled
@@ -1441,7 +1483,32 @@ X_STATUS Emulator::CompleteLaunch(const std::filesystem::path& path,
           ->PostGameConfigLoad();
     }
     game_config_load_callback_loop_next_index_ = SIZE_MAX;
+  }
+
+  // Initializing the shader storage in a blocking way so the user doesn't
+  // miss the initial seconds - for instance, sound from an intro video may
+  // start playing before the video can be seen if doing this in parallel with
+  // the main thread. It only depends on the title ID and the game config
+  // though, so load the resource database and patch the title meanwhile, and
+  // wait for it before launching the module.
+  on_shader_storage_initialization(true);
+  auto initialize_shader_storage = [this]() {
+    boot_trace::ScopedPhase shader_storage_phase(
+        "Shader storage initialization");
+    graphics_system_->InitializeShaderStorage(cache_root_, title_id_.value(),
+                                              true);
+  };
+  std::unique_ptr<xe::threading::Thread> shader_storage_thread =
+      xe::threading::Thread::Create({}, initialize_shader_storage);
+  if (shader_storage_thread) {
+    shader_storage_thread->set_name("Shader Storage Initialization");
+  } else {
+    initialize_shader_storage();
+  }
 
+  // Try and load the resource database (xex only).
+  if (module->title_id()) {
+    boot_trace::ScopedPhase resource_database_phase("Load resource database");
     const kernel::util::XdbfGameData db = kernel_state_->module_xdbf(module);
 
     game_info_database_ = std::make_unique<kernel::util::GameInfoDatabase>(&db);
@@ -1952,13 +2019,10 @@ X_STATUS Emulator::CompleteLaunch(const std::filesystem::path& path,
     }
   }
 
-  // Initializing the shader storage in a blocking way so the user doesn't
-  // miss the initial seconds - for instance, sound from an intro video may
-  // start playing before the video can be seen if doing this in parallel with
-  // the main thread.
-  on_shader_storage_initialization(true);
-  graphics_system_->InitializeShaderStorage(cache_root_, title_id_.value(),
-                                            true);
+  if (shader_storage_thread) {
+    boot_trace::ScopedPhase wait_phase("Wait for shader storage");
+    xe::threading::Wait(shader_storage_thread.get(), false);
+  }
   on_shader_storage_initialization(false);
 
   auto main_thread = kernel_state_->LaunchModule(module);
@@ -1974,6 +2038,7 @@ X_STATUS Emulator::CompleteLaunch(const std::filesystem::path& path,
   // FinishLoadingUserModule() which will apply TUs and patching to the main
   // xex.
   if (cvars::allow_plugins) {
+    boot_trace::ScopedPhase plugins_phase("Load plugins");
     if (plugin_loader_->IsAnyPluginForTitleAvailable(title_id_.value(),
                                                      module->hash().value())) {
       plugin_loader_->LoadTitlePlugins(title_id_.value());
@@ -188,6 +188,7 @@ void CommandProcessor::RestoreRegisters(uint32_t first_register,
   } else {
     std::memcpy(register_file_->values + first_register, register_values,
                 sizeof(uint32_t) * register_count);
+    register_file_->MarkRangeDirty(first_register, register_count);
   }
 }
 
@@ -269,7 +270,11 @@ void CommandProcessor::WorkerThreadMain() {
     assert_true(read_ptr_index_ != write_ptr_index);
 
     // Execute. Note that we handle wraparound transparently.
-    read_ptr_index_ = ExecutePrimaryBuffer(read_ptr_index_, write_ptr_index);
+    {
+      frame_telemetry::ScopedCounterTime busy_time(
+          frame_telemetry::Counter::kCommandProcessorBusyTimeUs);
+      read_ptr_index_ = ExecutePrimaryBuffer(read_ptr_index_, write_ptr_index);
+    }
 
     // TODO(benvanik): use reader->Read_update_freq_ and only issue after moving
     //     that many indices.
@@ -597,6 +602,7 @@ void CommandProcessor::WriteRegister(uint32_t index, uint32_t value) {
 
   if (XE_LIKELY(index < RegisterFile::kRegisterCount)) {
     register_file_->values[index] = value;
+    register_file_->MarkDirty(index);
 
     // quick pre-test
     // todo: figure out just how unlikely this is. if very (it ought to be,
@@ -19,7 +19,9 @@
 #include <string>
 #include <vector>
 
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/ring_buffer.h"
+#include "xenia/gpu/draw_util.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/trace_writer.h"
 #include "xenia/gpu/xenos.h"
@@ -255,6 +257,8 @@ class CommandProcessor {
   kernel::KernelState* kernel_state_ = nullptr;
   GraphicsSystem* graphics_system_ = nullptr;
   RegisterFile* XE_RESTRICT register_file_ = nullptr;
+  // State derived from the registers, reused between draws by the backends.
+  draw_util::DrawStateCache draw_state_cache_;
 
   TraceWriter trace_writer_;
   enum class TraceState {
@@ -1769,6 +1769,7 @@ void D3D12CommandProcessor::WriteRegisterForceinline(uint32_t index,
   __m128i is_below_upper = _mm_cmplt_epi16(to_rangecheck, upper_bounds);
   __m128i is_within_range = _mm_and_si128(is_above_lower, is_below_upper);
   register_file_->values[index] = value;
+  register_file_->MarkDirty(index);
 
   uint32_t movmask = static_cast<uint32_t>(_mm_movemask_epi8(is_within_range));
 
@@ -2048,6 +2049,7 @@ void D3D12CommandProcessor::WritePossiblySpecialRegistersFromMem(
     uint32_t value = xe::load_and_swap<uint32_t>(base);
 
     register_file_->values[index] = value;
+    register_file_->MarkDirty(index);
 
     unsigned expr = 0;
 
@@ -2075,8 +2077,9 @@ D3D12CommandProcessor::WriteRegisterRangeFromMem_WithKnownBound(
   auto get_end_before_qty = [&end, current_index](uint32_t regnum) {
     return std::min<uint32_t>(regnum, end) - current_index;
   };
-#define REGULAR_WRITE_CALLBACK(s, e, i, b, n) \
-  copy_and_swap_32_unaligned(&register_file_->values[i], b, n)
+#define REGULAR_WRITE_CALLBACK(s, e, i, b, n)                    \
+  copy_and_swap_32_unaligned(&register_file_->values[i], b, n); \
+  register_file_->MarkRangeDirty(i, n)
 #define WRITE_FETCH_CONSTANTS_CALLBACK(str, er, ind, b, n) \
   WriteFetchFromMem(ind, b, n)
 #define SPECIAL_REG_RANGE_CALLBACK(str, edr, ind, bs, n) \
@@ -2553,6 +2556,7 @@ bool D3D12CommandProcessor::IssueDraw(xenos::PrimitiveType primitive_type,
 #endif  // XE_UI_D3D12_FINE_GRAINED_DRAW_SCOPES
 
   ID3D12Device* device = GetD3D12Provider().GetDevice();
+  draw_state_cache_.BeginDraw(*register_file_);
   const RegisterFile& regs = *register_file_;
 
   xenos::ModeControl edram_mode = regs.Get<reg::RB_MODECONTROL>().edram_mode;
@@ -2624,7 +2628,7 @@ bool D3D12CommandProcessor::IssueDraw(xenos::PrimitiveType primitive_type,
   }
 
   reg::RB_DEPTHCONTROL normalized_depth_control =
-      draw_util::GetNormalizedDepthControl(regs);
+      draw_state_cache_.GetNormalizedDepthControl(regs);
 
   // Shader modifications.
   uint32_t ps_param_gen_pos = UINT32_MAX;
@@ -2646,7 +2650,7 @@ bool D3D12CommandProcessor::IssueDraw(xenos::PrimitiveType primitive_type,
 
   // Set up the render targets - this may perform dispatches and draws.
   uint32_t normalized_color_mask =
-      pixel_shader ? draw_util::GetNormalizedColorMask(
+      pixel_shader ? draw_state_cache_.GetNormalizedColorMask(
                          regs, pixel_shader->writes_color_targets())
                    : 0;
   if (!render_target_cache_->Update(is_rasterization_done,
@@ -2723,18 +2727,10 @@ bool D3D12CommandProcessor::IssueDraw(xenos::PrimitiveType primitive_type,
       host_render_targets_used &&
           render_target_cache_->depth_float24_convert_in_pixel_shader(),
       host_render_targets_used, pixel_shader && pixel_shader->writes_depth());
-  gviargs.SetupRegisterValues(regs);
-
-  if (gviargs == previous_viewport_info_args_) {
-    viewport_info = previous_viewport_info_;
-  } else {
-    draw_util::GetHostViewportInfo(&gviargs, viewport_info);
-    previous_viewport_info_args_ = gviargs;
-    previous_viewport_info_ = viewport_info;
-  }
+  draw_state_cache_.GetHostViewportInfo(regs, gviargs, viewport_info);
   // todo: use SIMD for getscissor + scaling here, should reduce code size more
   draw_util::Scissor scissor;
-  draw_util::GetScissor(regs, scissor);
+  draw_state_cache_.GetScissor(regs, scissor);
 #if XE_ARCH_AMD64 == 1
   __m128i* scisp = (__m128i*)&scissor;
   *scisp = _mm_mullo_epi32(
@@ -792,9 +792,6 @@ class D3D12CommandProcessor final : public CommandProcessor {
   // Current primitive topology.
   D3D_PRIMITIVE_TOPOLOGY primitive_topology_;
 
-  draw_util::GetViewportInfoArgs previous_viewport_info_args_;
-  draw_util::ViewportInfo previous_viewport_info_;
-
   std::atomic<bool> pix_capture_requested_ = false;
   bool pix_capturing_;
 
@@ -27,6 +27,7 @@
 #include "xenia/base/clock.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
@@ -84,6 +85,80 @@ namespace shaders {
 #include "xenia/gpu/shaders/bytecode/d3d12_5_1/tessellation_indexed_vs.h"
 }  // namespace shaders
 
+class PipelineCache::TranslationWorker : public ShaderTranslationPool::Worker {
+ public:
+  explicit TranslationWorker(PipelineCache& pipeline_cache)
+      : pipeline_cache_(pipeline_cache) {
+    const ui::d3d12::D3D12Provider& provider =
+        pipeline_cache.command_processor_.GetD3D12Provider();
+    const D3D12RenderTargetCache& render_target_cache =
+        pipeline_cache.render_target_cache_;
+    translator_ = std::make_unique<DxbcShaderTranslator>(
+        provider.GetAdapterVendorID(), pipeline_cache.bindless_resources_used_,
+        render_target_cache.GetPath() ==
+            RenderTargetCache::Path::kPixelShaderInterlock,
+        render_target_cache.gamma_render_target_as_srgb(),
+        render_target_cache.msaa_2x_supported(),
+        render_target_cache.draw_resolution_scale_x(),
+        render_target_cache.draw_resolution_scale_y(),
+        provider.GetGraphicsAnalysis() != nullptr);
+    // If needed and possible, create objects needed for DXIL conversion and
+    // disassembly on this thread.
+    if (cvars::d3d12_dxbc_disasm_dxilconv && pipeline_cache.dxbc_converter_ &&
+        pipeline_cache.dxc_utils_ && pipeline_cache.dxc_compiler_) {
+      provider.DxbcConverterCreateInstance(CLSID_DxbcConverter,
+                                           IID_PPV_ARGS(&dxbc_converter_));
+      provider.DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxc_utils_));
+      provider.DxcCreateInstance(CLSID_DxcCompiler,
+                                 IID_PPV_ARGS(&dxc_compiler_));
+    }
+  }
+
+  ~TranslationWorker() override {
+    ui::d3d12::util::ReleaseAndNull(dxc_compiler_);
+    ui::d3d12::util::ReleaseAndNull(dxc_utils_);
+    ui::d3d12::util::ReleaseAndNull(dxbc_converter_);
+  }
+
+  bool Translate(Shader::Translation& translation) override {
+    return pipeline_cache_.TranslateAnalyzedShader(
+        *translator_, static_cast<D3D12Shader::D3D12Translation&>(translation),
+        dxbc_converter_, dxc_utils_, dxc_compiler_);
+  }
+
+  uint64_t PredictModification(const Shader& shader,
+                               uint64_t last_modification,
+                               uint32_t program_cntl_num_reg) override {
+    // Keep the state-dependent parts, but take what depends on the shader
+    // itself from the new shader.
+    DxbcShaderTranslator::Modification modification(last_modification);
+    uint32_t dynamic_addressable_register_count =
+        shader.GetDynamicAddressableRegisterCount(program_cntl_num_reg);
+    if (shader.type() == xenos::ShaderType::kVertex) {
+      modification.vertex.dynamic_addressable_register_count =
+          dynamic_addressable_register_count;
+      modification.vertex.interpolator_mask &= shader.writes_interpolators();
+      if (!(shader.writes_point_size_edge_flag_kill_vertex() & 0b100)) {
+        modification.vertex.vertex_kill_and = 0;
+      }
+      if (!(shader.writes_point_size_edge_flag_kill_vertex() & 0b001)) {
+        modification.vertex.output_point_size = 0;
+      }
+    } else {
+      modification.pixel.dynamic_addressable_register_count =
+          dynamic_addressable_register_count;
+    }
+    return modification.value;
+  }
+
+ private:
+  PipelineCache& pipeline_cache_;
+  std::unique_ptr<DxbcShaderTranslator> translator_;
+  IDxbcConverter* dxbc_converter_ = nullptr;
+  IDxcUtils* dxc_utils_ = nullptr;
+  IDxcCompiler* dxc_compiler_ = nullptr;
+};
+
 PipelineCache::PipelineCache(D3D12CommandProcessor& command_processor,
                              const RegisterFile& register_file,
                              const D3D12RenderTargetCache& render_target_cache,
@@ -175,10 +250,18 @@ bool PipelineCache::Initialize() {
       creation_threads_.push_back(std::move(creation_thread));
     }
   }
+
+  last_vertex_shader_modification_.reset();
+  last_pixel_shader_modification_.reset();
+  translation_pool_.Initialize(
+      [this]() { return std::make_unique<TranslationWorker>(*this); });
   return true;
 }
 
 void PipelineCache::Shutdown() {
+  // Stop background shader translation before destroying the shaders.
+  translation_pool_.Shutdown();
+
   // Shut down all threads, before destroying the pipelines since they may be
   // creating them.
   if (!creation_threads_.empty()) {
@@ -229,6 +312,10 @@ void PipelineCache::InitializeShaderStorage(
     const std::filesystem::path& cache_root, uint32_t title_id, bool blocking) {
   ShutdownShaderStorage();
 
+  // The storage is loaded on its own threads, which may access the shaders
+  // being translated in the background.
+  translation_pool_.WaitForIdle();
+
   auto shader_storage_root = cache_root / "shaders";
   // For files that can be moved between different hosts.
   // Host PSO blobs - if ever added - should be stored in shaders/local/ (they
@@ -269,11 +356,10 @@ void PipelineCache::InitializeShaderStorage(
     return;
   }
   pipeline_storage_file_flush_needed_ = false;
-  // 'XEPS'.
-  const uint32_t pipeline_storage_magic = 0x53504558;
-  // 'DXRO' or 'DXRT'.
+  const uint32_t pipeline_storage_magic = kPipelineStorageMagic;
   const uint32_t pipeline_storage_magic_api =
-      edram_rov_used ? 0x4F525844 : 0x54525844;
+      edram_rov_used ? kPipelineStorageMagicApiD3D12Rov
+                     : kPipelineStorageMagicApiD3D12Rtv;
   const uint32_t pipeline_storage_version_swapped =
       xe::byte_swap(std::max(PipelineDescription::kVersion,
                              DxbcShaderTranslator::Modification::kVersion));
@@ -364,8 +450,7 @@ void PipelineCache::InitializeShaderStorage(
     uint32_t magic;
     uint32_t version_swapped;
   } shader_storage_file_header;
-  // 'XESH'.
-  const uint32_t shader_storage_magic = 0x48534558;
+  const uint32_t shader_storage_magic = kShaderStorageMagic;
   if (fread(&shader_storage_file_header, sizeof(shader_storage_file_header), 1,
             shader_storage_file_) &&
       shader_storage_file_header.magic == shader_storage_magic &&
@@ -842,8 +927,19 @@ D3D12Shader* PipelineCache::LoadShader(xenos::ShaderType shader_type,
                                        const uint32_t* host_address,
                                        uint32_t dword_count) {
   // Hash the input memory and lookup the shader.
-  return LoadShader(shader_type, host_address, dword_count,
-                    XXH3_64bits(host_address, dword_count * sizeof(uint32_t)));
+  D3D12Shader* shader =
+      LoadShader(shader_type, host_address, dword_count,
+                 XXH3_64bits(host_address, dword_count * sizeof(uint32_t)));
+  // Start analyzing and translating it ahead of the draws if it's new.
+  auto sq_program_cntl = register_file_.Get<reg::SQ_PROGRAM_CNTL>();
+  if (shader_type == xenos::ShaderType::kVertex) {
+    translation_pool_.Prefetch(*shader, last_vertex_shader_modification_,
+                               sq_program_cntl.vs_num_reg);
+  } else {
+    translation_pool_.Prefetch(*shader, last_pixel_shader_modification_,
+                               sq_program_cntl.ps_num_reg);
+  }
+  return shader;
 }
 
 D3D12Shader* PipelineCache::LoadShader(xenos::ShaderType shader_type,
@@ -981,6 +1077,12 @@ bool PipelineCache::ConfigurePipeline(
               register_file_.Get<reg::SQ_PROGRAM_CNTL>().vs_export_mode !=
                   xenos::VertexShaderExportMode::kPosition2VectorsEdgeKill);
   assert_false(register_file_.Get<reg::SQ_PROGRAM_CNTL>().gen_index_vtx);
+  // If both shaders are new, translate the pixel shader in the background
+  // while translating the vertex shader.
+  if (pixel_shader != nullptr && !pixel_shader->is_translated() &&
+      !vertex_shader->is_translated() && translation_pool_.is_active()) {
+    translation_pool_.Translate(*pixel_shader);
+  }
   if (!vertex_shader->is_translated()) {
     if (!vertex_shader->shader().is_ucode_analyzed()) {
       vertex_shader->shader().AnalyzeUcode(ucode_disasm_buffer_);
@@ -990,23 +1092,13 @@ bool PipelineCache::ConfigurePipeline(
       XELOGE("Failed to translate the vertex shader!");
       return false;
     }
-    if (shader_storage_file_ && vertex_shader->shader().ucode_storage_index() !=
-                                    shader_storage_index_) {
-      vertex_shader->shader().set_ucode_storage_index(shader_storage_index_);
-      assert_not_null(storage_write_thread_);
-      shader_storage_file_flush_needed_ = true;
-      {
-        std::lock_guard<std::mutex> lock(storage_write_request_lock_);
-        storage_write_shader_queue_.push_back(&vertex_shader->shader());
-      }
-      storage_write_request_cond_.notify_all();
-    }
   }
   if (!vertex_shader->is_valid()) {
     // Translation attempted previously, but not valid.
     return false;
   }
   if (pixel_shader != nullptr) {
+    translation_pool_.WaitForShader(pixel_shader->shader());
     if (!pixel_shader->is_translated()) {
       if (!pixel_shader->shader().is_ucode_analyzed()) {
         pixel_shader->shader().AnalyzeUcode(ucode_disasm_buffer_);
@@ -1017,24 +1109,34 @@ bool PipelineCache::ConfigurePipeline(
         XELOGE("Failed to translate the pixel shader!");
         return false;
       }
-      if (shader_storage_file_ &&
-          pixel_shader->shader().ucode_storage_index() !=
-              shader_storage_index_) {
-        pixel_shader->shader().set_ucode_storage_index(shader_storage_index_);
-        assert_not_null(storage_write_thread_);
-        shader_storage_file_flush_needed_ = true;
-        {
-          std::lock_guard<std::mutex> lock(storage_write_request_lock_);
-          storage_write_shader_queue_.push_back(&pixel_shader->shader());
-        }
-        storage_write_request_cond_.notify_all();
-      }
     }
     if (!pixel_shader->is_valid()) {
       // Translation attempted previously, but not valid.
       return false;
     }
   }
+  // Write the shaders to the storage - checking for all draws as they may have
+  // been translated in the background.
+  for (Shader::Translation* translation :
+       {static_cast<Shader::Translation*>(vertex_shader),
+        static_cast<Shader::Translation*>(pixel_shader)}) {
+    if (translation == nullptr || !shader_storage_file_ ||
+        translation->shader().ucode_storage_index() == shader_storage_index_) {
+      continue;
+    }
+    translation->shader().set_ucode_storage_index(shader_storage_index_);
+    assert_not_null(storage_write_thread_);
+    shader_storage_file_flush_needed_ = true;
+    {
+      std::lock_guard<std::mutex> lock(storage_write_request_lock_);
+      storage_write_shader_queue_.push_back(&translation->shader());
+    }
+    storage_write_request_cond_.notify_all();
+  }
+  last_vertex_shader_modification_ = vertex_shader->modification();
+  if (pixel_shader != nullptr) {
+    last_pixel_shader_modification_ = pixel_shader->modification();
+  }
 
   PipelineRuntimeDescription runtime_description;
   if (!GetCurrentStateDescription(
@@ -2805,6 +2907,7 @@ const std::vector<uint32_t>& PipelineCache::GetGeometryShader(
 ID3D12PipelineState* PipelineCache::CreateD3D12Pipeline(
     const PipelineRuntimeDescription& runtime_description) {
   const PipelineDescription& description = runtime_description.description;
+  frame_telemetry::AddToCounter(frame_telemetry::Counter::kPipelineCreations);
 
   if (runtime_description.pixel_shader != nullptr) {
     XELOGGPU("Creating graphics pipeline with VS {:016X}, PS {:016X}",
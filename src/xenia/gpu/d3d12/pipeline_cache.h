@@ -16,6 +16,7 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -34,6 +35,8 @@
 #include "xenia/gpu/primitive_processor.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/registers.h"
+#include "xenia/gpu/shader_storage.h"
+#include "xenia/gpu/shader_translation_pool.h"
 #include "xenia/gpu/xenos.h"
 #include "xenia/ui/d3d12/d3d12_api.h"
 
@@ -67,10 +70,14 @@ class PipelineCache {
   void EndSubmission();
   bool IsCreatingPipelines();
 
+  // Loads a shader from the guest, and starts its translation in the
+  // background if it's new.
   D3D12Shader* LoadShader(xenos::ShaderType shader_type,
                           const uint32_t* host_address, uint32_t dword_count);
-  // Analyze shader microcode on the translator thread.
+  // Analyze shader microcode on the translator thread, or wait for the
+  // background analysis.
   void AnalyzeShaderUcode(Shader& shader) {
+    translation_pool_.WaitForShader(shader);
     if (!shader.is_ucode_analyzed()) {
       shader.AnalyzeUcode(ucode_disasm_buffer_);
     }
@@ -105,15 +112,6 @@ class PipelineCache {
   }
 
  private:
-  XEPACKEDSTRUCT(ShaderStoredHeader, {
-    uint64_t ucode_data_hash;
-
-    uint32_t ucode_dword_count : 31;
-    xenos::ShaderType type : 1;
-
-    static constexpr uint32_t kVersion = 0x20201219;
-  });
-
   // Update PipelineDescription::kVersion if any of the Pipeline* enums are
   // changed!
 
@@ -227,13 +225,19 @@ class PipelineCache {
     PipelineRenderTarget render_targets[xenos::kMaxColorRenderTargets];
 
     inline bool operator==(const PipelineDescription& other) const;
-    static constexpr uint32_t kVersion = 0x20210425;
+    static constexpr uint32_t kVersion = kD3D12PipelineDescriptionVersion;
   });
 
+  // Begins with PipelineStoredShaders for the offline tools.
   XEPACKEDSTRUCT(PipelineStoredDescription, {
     uint64_t description_hash;
     PipelineDescription description;
   });
+  static_assert(sizeof(PipelineStoredDescription) ==
+                    kD3D12PipelineStoredDescriptionSize,
+                "Update kD3D12PipelineStoredDescriptionSize and "
+                "kD3D12PipelineDescriptionVersion when changing "
+                "PipelineDescription");
 
   struct PipelineRuntimeDescription {
     ID3D12RootSignature* root_signature;
@@ -274,6 +278,9 @@ class PipelineCache {
                           const uint32_t* host_address, uint32_t dword_count,
                           uint64_t data_hash);
 
+  // Translates shaders on the background translation threads.
+  class TranslationWorker;
+
   // Can be called from multiple threads.
   bool TranslateAnalyzedShader(DxbcShaderTranslator& translator,
                                D3D12Shader::D3D12Translation& translation,
@@ -322,6 +329,12 @@ class PipelineCache {
   IDxcUtils* dxc_utils_ = nullptr;
   IDxcCompiler* dxc_compiler_ = nullptr;
 
+  ShaderTranslationPool translation_pool_;
+  // Modifications of the shaders used by the last draw, for guessing the
+  // modifications of new shaders to translate them before they're drawn.
+  std::optional<uint64_t> last_vertex_shader_modification_;
+  std::optional<uint64_t> last_pixel_shader_modification_;
+
   // Ucode hash -> shader.
   std::unordered_map<uint64_t, D3D12Shader*, xe::hash::IdentityHasher<uint64_t>>
       shaders_;
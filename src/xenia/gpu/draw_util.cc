@@ -12,6 +12,7 @@
 #include "xenia/base/cvar.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/memory.h"
 #include "xenia/gpu/gpu_flags.h"
 #include "xenia/gpu/texture_cache.h"
@@ -757,6 +758,96 @@ uint32_t GetNormalizedColorMask(const RegisterFile& regs,
   return normalized_color_mask;
 }
 
+void DrawStateCache::BeginDraw(RegisterFile& regs) {
+  uint32_t dirty_groups = regs.ConsumeDirtyGroups();
+  depth_control_stale_groups_ |= dirty_groups;
+  color_mask_stale_groups_ |= dirty_groups;
+  viewport_stale_groups_ |= dirty_groups;
+  scissor_stale_groups_ |= dirty_groups;
+}
+
+void DrawStateCache::Invalidate() {
+  depth_control_stale_groups_ = RegisterFile::kAllGroupsMask;
+  color_mask_stale_groups_ = RegisterFile::kAllGroupsMask;
+  viewport_stale_groups_ = RegisterFile::kAllGroupsMask;
+  scissor_stale_groups_ = RegisterFile::kAllGroupsMask;
+}
+
+bool DrawStateCache::NeedsDerivation(uint32_t& stale_groups,
+                                     uint32_t group_mask,
+                                     bool inputs_changed) {
+  if (!(stale_groups & group_mask) && !inputs_changed) {
+    ++reuse_count_;
+    frame_telemetry::AddToCounter(frame_telemetry::Counter::kDrawStateReuses);
+    return false;
+  }
+  stale_groups = 0;
+  ++derivation_count_;
+  return true;
+}
+
+reg::RB_DEPTHCONTROL DrawStateCache::GetNormalizedDepthControl(
+    const RegisterFile& regs) {
+  if (NeedsDerivation(
+          depth_control_stale_groups_,
+          RegisterFile::GetGroupMask(RegisterGroup::kDepthStencil))) {
+    depth_control_ = draw_util::GetNormalizedDepthControl(regs);
+  }
+  return depth_control_;
+}
+
+uint32_t DrawStateCache::GetNormalizedColorMask(
+    const RegisterFile& regs, uint32_t pixel_shader_writes_color_targets) {
+  if (NeedsDerivation(
+          color_mask_stale_groups_,
+          RegisterFile::GetGroupMask(RegisterGroup::kBlend) |
+              RegisterFile::GetGroupMask(RegisterGroup::kSurfaceInfo),
+          pixel_shader_writes_color_targets != color_mask_shader_targets_)) {
+    color_mask_shader_targets_ = pixel_shader_writes_color_targets;
+    color_mask_ = draw_util::GetNormalizedColorMask(
+        regs, pixel_shader_writes_color_targets);
+  }
+  return color_mask_;
+}
+
+void DrawStateCache::GetHostViewportInfo(const RegisterFile& regs,
+                                         GetViewportInfoArgs& args,
+                                         ViewportInfo& viewport_info_out) {
+  constexpr uint32_t kGroupMask =
+      RegisterFile::GetGroupMask(RegisterGroup::kViewport) |
+      RegisterFile::GetGroupMask(RegisterGroup::kSurfaceInfo);
+  if (viewport_stale_groups_ & kGroupMask) {
+    args.SetupRegisterValues(regs);
+  } else {
+    args.CopyRegisterValues(viewport_args_);
+  }
+  // The register values are up to date now, but the depth control and the
+  // host inputs set up by the caller may be different.
+  viewport_stale_groups_ = 0;
+  bool inputs_changed =
+      !(args == viewport_args_) ||
+      args.draw_resolution_scale_x != viewport_args_.draw_resolution_scale_x ||
+      args.draw_resolution_scale_y != viewport_args_.draw_resolution_scale_y;
+  if (NeedsDerivation(viewport_stale_groups_, 0, inputs_changed)) {
+    draw_util::GetHostViewportInfo(&args, viewport_info_);
+    viewport_args_ = args;
+  }
+  viewport_info_out = viewport_info_;
+}
+
+void DrawStateCache::GetScissor(const RegisterFile& regs, Scissor& scissor_out,
+                                bool clamp_to_surface_pitch) {
+  if (NeedsDerivation(
+          scissor_stale_groups_,
+          RegisterFile::GetGroupMask(RegisterGroup::kViewport) |
+              RegisterFile::GetGroupMask(RegisterGroup::kSurfaceInfo),
+          clamp_to_surface_pitch != scissor_clamp_to_surface_pitch_)) {
+    scissor_clamp_to_surface_pitch_ = clamp_to_surface_pitch;
+    draw_util::GetScissor(regs, scissor_, clamp_to_surface_pitch);
+  }
+  scissor_out = scissor_;
+}
+
 void AddMemExportRanges(const RegisterFile& regs, const Shader& shader,
                         std::vector<MemExportRange>& ranges_out) {
   if (!shader.memexport_eM_written()) {
@@ -382,6 +382,22 @@ struct GetViewportInfoArgs {
     pa_sc_window_offset = regs.Get<reg::PA_SC_WINDOW_OFFSET>();
     depth_format = regs.Get<reg::RB_DEPTH_INFO>().depth_format;
   }
+  // Takes the values SetupRegisterValues would take from the registers from
+  // arguments set up earlier.
+  void CopyRegisterValues(const GetViewportInfoArgs& other) {
+    pa_cl_clip_cntl = other.pa_cl_clip_cntl;
+    pa_cl_vte_cntl = other.pa_cl_vte_cntl;
+    pa_su_sc_mode_cntl = other.pa_su_sc_mode_cntl;
+    pa_su_vtx_cntl = other.pa_su_vtx_cntl;
+    PA_CL_VPORT_XSCALE = other.PA_CL_VPORT_XSCALE;
+    PA_CL_VPORT_YSCALE = other.PA_CL_VPORT_YSCALE;
+    PA_CL_VPORT_ZSCALE = other.PA_CL_VPORT_ZSCALE;
+    PA_CL_VPORT_XOFFSET = other.PA_CL_VPORT_XOFFSET;
+    PA_CL_VPORT_YOFFSET = other.PA_CL_VPORT_YOFFSET;
+    PA_CL_VPORT_ZOFFSET = other.PA_CL_VPORT_ZOFFSET;
+    pa_sc_window_offset = other.pa_sc_window_offset;
+    depth_format = other.depth_format;
+  }
   XE_FORCEINLINE
   bool operator==(const GetViewportInfoArgs& prev) {
 #if XE_ARCH_AMD64 == 0
@@ -456,6 +472,59 @@ void GetScissor(const RegisterFile& XE_RESTRICT regs,
 uint32_t GetNormalizedColorMask(const RegisterFile& regs,
                                 uint32_t pixel_shader_writes_color_targets);
 
+// Keeps the state derived from the registers for the previous draws, and
+// derives it again only if the registers it depends on have been written
+// since then, or if the inputs not coming from the registers are different.
+// Owned by the command processor, which must be the only consumer of the
+// dirty register groups in the register file.
+class DrawStateCache {
+ public:
+  // Takes the register groups written since the previous draw. Must be called
+  // before getting the state for each draw.
+  void BeginDraw(RegisterFile& regs);
+  // Forces everything to be derived again, such as when the host settings the
+  // state depends on have been changed.
+  void Invalidate();
+
+  reg::RB_DEPTHCONTROL GetNormalizedDepthControl(const RegisterFile& regs);
+  uint32_t GetNormalizedColorMask(const RegisterFile& regs,
+                                  uint32_t pixel_shader_writes_color_targets);
+  // The arguments must be initialized with Setup - the register values are
+  // set up by the cache.
+  void GetHostViewportInfo(const RegisterFile& regs, GetViewportInfoArgs& args,
+                           ViewportInfo& viewport_info_out);
+  void GetScissor(const RegisterFile& regs, Scissor& scissor_out,
+                  bool clamp_to_surface_pitch = true);
+
+  // Numbers of the derivations skipped and done since the creation.
+  uint64_t reuse_count() const { return reuse_count_; }
+  uint64_t derivation_count() const { return derivation_count_; }
+
+ private:
+  // Returns whether the state must be derived again, and if it must, marks it
+  // as up to date with the registers.
+  bool NeedsDerivation(uint32_t& stale_groups, uint32_t group_mask,
+                       bool inputs_changed = false);
+
+  uint32_t depth_control_stale_groups_ = RegisterFile::kAllGroupsMask;
+  reg::RB_DEPTHCONTROL depth_control_;
+
+  uint32_t color_mask_stale_groups_ = RegisterFile::kAllGroupsMask;
+  uint32_t color_mask_shader_targets_ = 0;
+  uint32_t color_mask_ = 0;
+
+  uint32_t viewport_stale_groups_ = RegisterFile::kAllGroupsMask;
+  GetViewportInfoArgs viewport_args_ = {};
+  ViewportInfo viewport_info_;
+
+  uint32_t scissor_stale_groups_ = RegisterFile::kAllGroupsMask;
+  bool scissor_clamp_to_surface_pitch_ = false;
+  Scissor scissor_;
+
+  uint64_t reuse_count_ = 0;
+  uint64_t derivation_count_ = 0;
+};
+
 // Never an identity conversion - can always write conditional move instructions
 // to shaders that will be no-ops for conversion from guest to host samples.
 // While we don't know the exact guest sample pattern, due to the way
@@ -15,10 +15,12 @@
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <utility>
 
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/clock.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
@@ -74,9 +76,9 @@ __declspec(dllexport) uint32_t AmdPowerXpressRequestHighPerformance = 1;
 #endif  // XE_PLATFORM_WIN32
 
 GraphicsSystem::GraphicsSystem() : frame_limiter_worker_running_(false) {
-  register_file_ = reinterpret_cast<RegisterFile*>(memory::AllocFixed(
+  register_file_ = new (memory::AllocFixed(
       nullptr, sizeof(RegisterFile), memory::AllocationType::kReserveCommit,
-      memory::PageAccess::kReadWrite));
+      memory::PageAccess::kReadWrite)) RegisterFile();
 }
 
 GraphicsSystem::~GraphicsSystem() = default;
@@ -304,6 +306,7 @@ void GraphicsSystem::WriteRegister(uint32_t addr, uint32_t value) {
 
   assert_true(r < RegisterFile::kRegisterCount);
   this->register_file()->values[r] = value;
+  this->register_file()->MarkDirty(r);
 }
 
 void GraphicsSystem::InitializeRingBuffer(uint32_t ptr, uint32_t size_log2) {
@@ -332,6 +335,7 @@ void GraphicsSystem::MarkVblank() {
 
   // Increment vblank counter (so the game sees us making progress).
   command_processor_->increment_counter();
+  frame_telemetry::MarkVblank();
 
   // TODO(benvanik): we shouldn't need to do the dispatch here, but there's
   //     something wrong and the CP will block waiting for code that
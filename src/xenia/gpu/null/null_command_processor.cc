@@ -9,6 +9,13 @@
 
 #include "xenia/gpu/null/null_command_processor.h"
 
+#include <algorithm>
+
+#include "xenia/base/logging.h"
+#include "xenia/base/xxhash.h"
+#include "xenia/gpu/gpu_flags.h"
+#include "xenia/gpu/registers.h"
+
 namespace xe {
 namespace gpu {
 namespace null {
@@ -19,40 +26,202 @@ NullCommandProcessor::NullCommandProcessor(NullGraphicsSystem* graphics_system,
 NullCommandProcessor::~NullCommandProcessor() = default;
 
 void NullCommandProcessor::TracePlaybackWroteMemory(uint32_t base_ptr,
-                                                    uint32_t length) {}
+                                                    uint32_t length) {
+  shared_memory_->MemoryInvalidationCallback(base_ptr, length, true);
+  primitive_processor_->MemoryInvalidationCallback(base_ptr, length, true);
+}
 
 void NullCommandProcessor::RestoreEdramSnapshot(const void* snapshot) {}
 
 bool NullCommandProcessor::SetupContext() {
-  return CommandProcessor::SetupContext();
+  if (!CommandProcessor::SetupContext()) {
+    return false;
+  }
+
+  shared_memory_ = std::make_unique<NullSharedMemory>(*memory_, trace_writer_);
+  if (!shared_memory_->Initialize()) {
+    XELOGE("Failed to initialize the null shared memory");
+    return false;
+  }
+
+  primitive_processor_ = std::make_unique<NullPrimitiveProcessor>(
+      *register_file_, *memory_, trace_writer_, *shared_memory_);
+  if (!primitive_processor_->Initialize()) {
+    XELOGE("Failed to initialize the null primitive processor");
+    return false;
+  }
+
+  draw_extent_estimator_ = std::make_unique<DrawExtentEstimator>(
+      *register_file_, *memory_, &trace_writer_);
+
+  stats_ = Stats();
+  return true;
 }
 
 void NullCommandProcessor::ShutdownContext() {
-  return CommandProcessor::ShutdownContext();
+  shaders_.clear();
+  draw_extent_estimator_.reset();
+  primitive_processor_.reset();
+  shared_memory_.reset();
+
+  CommandProcessor::ShutdownContext();
 }
 
 void NullCommandProcessor::IssueSwap(uint32_t frontbuffer_ptr,
                                      uint32_t frontbuffer_width,
-                                     uint32_t frontbuffer_height) {}
+                                     uint32_t frontbuffer_height) {
+  ++stats_.swaps;
+  primitive_processor_->EndFrame();
+}
 
 Shader* NullCommandProcessor::LoadShader(xenos::ShaderType shader_type,
                                          uint32_t guest_address,
                                          const uint32_t* host_address,
                                          uint32_t dword_count) {
-  return nullptr;
+  uint64_t data_hash =
+      XXH3_64bits(host_address, dword_count * sizeof(uint32_t));
+  auto it = shaders_.find(data_hash);
+  if (it != shaders_.end()) {
+    return it->second.get();
+  }
+  auto shader =
+      std::make_unique<Shader>(shader_type, data_hash, host_address,
+                               dword_count);
+  Shader* shader_ptr = shader.get();
+  shaders_.emplace(data_hash, std::move(shader));
+  ++stats_.shaders_loaded;
+  return shader_ptr;
+}
+
+bool NullCommandProcessor::RequestSharedMemoryRange(uint32_t start,
+                                                    uint32_t length) {
+  ++stats_.shared_memory_requests;
+  return shared_memory_->RequestRange(start, length);
 }
 
 bool NullCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
                                      uint32_t index_count,
                                      IndexBufferInfo* index_buffer_info,
                                      bool major_mode_explicit) {
+  const RegisterFile& regs = *register_file_;
+
+  xenos::ModeControl edram_mode = regs.Get<reg::RB_MODECONTROL>().edram_mode;
+  if (edram_mode == xenos::ModeControl::kCopy) {
+    // Special copy handling.
+    return IssueCopy();
+  }
+
+  memexport_ranges_.clear();
+
+  // Vertex shader analysis.
+  Shader* vertex_shader = active_vertex_shader();
+  if (!vertex_shader) {
+    // Always need a vertex shader.
+    return false;
+  }
+  vertex_shader->AnalyzeUcode(ucode_disasm_buffer_);
+  if (vertex_shader->memexport_eM_written() != 0) {
+    draw_util::AddMemExportRanges(regs, *vertex_shader, memexport_ranges_);
+  }
+
+  // Pixel shader analysis.
+  bool primitive_polygonal = draw_util::IsPrimitivePolygonal(regs);
+  bool is_rasterization_done =
+      draw_util::IsRasterizationPotentiallyDone(regs, primitive_polygonal);
+  Shader* pixel_shader = nullptr;
+  if (is_rasterization_done) {
+    if (edram_mode == xenos::ModeControl::kColorDepth) {
+      pixel_shader = active_pixel_shader();
+      if (pixel_shader) {
+        pixel_shader->AnalyzeUcode(ucode_disasm_buffer_);
+        if (!draw_util::IsPixelShaderNeededWithRasterization(*pixel_shader,
+                                                             regs)) {
+          pixel_shader = nullptr;
+        }
+      }
+    }
+  } else if (memexport_ranges_.empty()) {
+    // This draw has no effect.
+    ++stats_.draws_skipped;
+    return true;
+  }
+  if (pixel_shader && pixel_shader->memexport_eM_written() != 0) {
+    draw_util::AddMemExportRanges(regs, *pixel_shader, memexport_ranges_);
+  }
+
+  // Process primitives.
+  PrimitiveProcessor::ProcessingResult primitive_processing_result;
+  if (!primitive_processor_->Process(primitive_processing_result)) {
+    return false;
+  }
+  if (!primitive_processing_result.host_draw_vertex_count) {
+    // Nothing to draw.
+    ++stats_.draws_skipped;
+    return true;
+  }
+
+  // Estimate the render target extent the same way the render target cache
+  // does for real backends.
+  if (is_rasterization_done) {
+    draw_extent_estimator_->EstimateMaxY(true, *vertex_shader);
+  }
+
+  // Ensure vertex buffers are resident.
+  uint64_t vertex_buffers_resident[2] = {};
+  for (const Shader::VertexBinding& vertex_binding :
+       vertex_shader->vertex_bindings()) {
+    uint32_t vfetch_index = vertex_binding.fetch_constant;
+    if (vertex_buffers_resident[vfetch_index >> 6] &
+        (uint64_t(1) << (vfetch_index & 63))) {
+      continue;
+    }
+    xenos::xe_gpu_vertex_fetch_t vfetch_constant =
+        regs.GetVertexFetch(vfetch_index);
+    switch (vfetch_constant.type) {
+      case xenos::FetchConstantType::kVertex:
+        break;
+      case xenos::FetchConstantType::kInvalidVertex:
+        if (cvars::gpu_allow_invalid_fetch_constants) {
+          break;
+        }
+        return false;
+      default:
+        return false;
+    }
+    if (!RequestSharedMemoryRange(vfetch_constant.address << 2,
+                                  vfetch_constant.size << 2)) {
+      return false;
+    }
+    vertex_buffers_resident[vfetch_index >> 6] |= uint64_t(1)
+                                                  << (vfetch_index & 63);
+  }
+
+  // Synchronize the memory pages backing memory scatter export streams.
+  for (const draw_util::MemExportRange& memexport_range : memexport_ranges_) {
+    if (!RequestSharedMemoryRange(memexport_range.base_address_dwords << 2,
+                                  memexport_range.size_bytes)) {
+      return false;
+    }
+  }
+
+  ++stats_.draws;
+
+  // Invalidate textures in memexported memory and watch for changes.
+  for (const draw_util::MemExportRange& memexport_range : memexport_ranges_) {
+    shared_memory_->RangeWrittenByGpu(memexport_range.base_address_dwords << 2,
+                                      memexport_range.size_bytes, false);
+  }
+
   return true;
 }
 
-bool NullCommandProcessor::IssueCopy() { return true; }
+bool NullCommandProcessor::IssueCopy() {
+  ++stats_.copies;
+  return true;
+}
 
 void NullCommandProcessor::InitializeTrace() {}
 
 }  // namespace null
 }  // namespace gpu
-}  // namespace xe
\ No newline at end of file
+}  // namespace xe
@@ -10,8 +10,20 @@
 #ifndef XENIA_GPU_NULL_NULL_COMMAND_PROCESSOR_H_
 #define XENIA_GPU_NULL_NULL_COMMAND_PROCESSOR_H_
 
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/base/hash.h"
+#include "xenia/base/string_buffer.h"
 #include "xenia/gpu/command_processor.h"
+#include "xenia/gpu/draw_extent_estimator.h"
+#include "xenia/gpu/draw_util.h"
 #include "xenia/gpu/null/null_graphics_system.h"
+#include "xenia/gpu/null/null_primitive_processor.h"
+#include "xenia/gpu/null/null_shared_memory.h"
+#include "xenia/gpu/shader.h"
 #include "xenia/gpu/xenos.h"
 #include "xenia/kernel/kernel_state.h"
 
@@ -19,12 +31,32 @@ namespace xe {
 namespace gpu {
 namespace null {
 
+// Command processor that performs all the guest-facing CPU work of a real
+// backend (shader analysis, primitive processing, shared memory validation and
+// uploads, draw extent estimation) without submitting anything to a host GPU,
+// so the cost of the common PM4 path can be measured in isolation.
 class NullCommandProcessor : public CommandProcessor {
  public:
+  struct Stats {
+    uint64_t draws = 0;
+    uint64_t draws_skipped = 0;
+    uint64_t copies = 0;
+    uint64_t swaps = 0;
+    uint64_t shaders_loaded = 0;
+    uint64_t shared_memory_requests = 0;
+  };
+
   NullCommandProcessor(NullGraphicsSystem* graphics_system,
                        kernel::KernelState* kernel_state);
   ~NullCommandProcessor();
 
+  // Only valid to read on the command processor thread.
+  const Stats& stats() const { return stats_; }
+  const NullSharedMemory* shared_memory() const { return shared_memory_.get(); }
+  const NullPrimitiveProcessor* primitive_processor() const {
+    return primitive_processor_.get();
+  }
+
   void TracePlaybackWroteMemory(uint32_t base_ptr, uint32_t length) override;
 
   void RestoreEdramSnapshot(const void* snapshot) override;
@@ -46,6 +78,22 @@ class NullCommandProcessor : public CommandProcessor {
   bool IssueCopy() override;
 
   void InitializeTrace() override;
+
+  bool RequestSharedMemoryRange(uint32_t start, uint32_t length);
+
+  std::unique_ptr<NullSharedMemory> shared_memory_;
+  std::unique_ptr<NullPrimitiveProcessor> primitive_processor_;
+  std::unique_ptr<DrawExtentEstimator> draw_extent_estimator_;
+
+  // Ucode hash -> shader.
+  std::unordered_map<uint64_t, std::unique_ptr<Shader>,
+                     xe::hash::IdentityHasher<uint64_t>>
+      shaders_;
+  StringBuffer ucode_disasm_buffer_;
+
+  std::vector<draw_util::MemExportRange> memexport_ranges_;
+
+  Stats stats_;
 };
 
 }  // namespace null
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/gpu/null/null_primitive_processor.h"
+
+#include <algorithm>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/math.h"
+
+namespace xe {
+namespace gpu {
+namespace null {
+
+NullPrimitiveProcessor::~NullPrimitiveProcessor() { Shutdown(true); }
+
+bool NullPrimitiveProcessor::Initialize() {
+  if (!InitializeCommon(true, false, false, true, true, true)) {
+    Shutdown();
+    return false;
+  }
+  return true;
+}
+
+void NullPrimitiveProcessor::Shutdown(bool from_destructor) {
+  frame_pages_.clear();
+  frame_page_current_ = 0;
+  frame_page_offset_ = 0;
+  frame_index_buffer_count_ = 0;
+  builtin_index_buffer_.reset();
+  if (!from_destructor) {
+    ShutdownCommon();
+  }
+}
+
+void NullPrimitiveProcessor::EndFrame() {
+  ClearPerFrameCache();
+  frame_page_current_ = 0;
+  frame_page_offset_ = 0;
+  frame_index_buffer_count_ = 0;
+}
+
+bool NullPrimitiveProcessor::InitializeBuiltinIndexBuffer(
+    size_t size_bytes, std::function<void(void*)> fill_callback) {
+  assert_not_zero(size_bytes);
+  assert_null(builtin_index_buffer_);
+  builtin_index_buffer_ = std::make_unique<uint8_t[]>(size_bytes);
+  fill_callback(builtin_index_buffer_.get());
+  return true;
+}
+
+void* NullPrimitiveProcessor::RequestHostConvertedIndexBufferForCurrentFrame(
+    xenos::IndexFormat format, uint32_t index_count, bool coalign_for_simd,
+    uint32_t coalignment_original_address, size_t& backend_handle_out) {
+  size_t index_size = format == xenos::IndexFormat::kInt16 ? sizeof(uint16_t)
+                                                           : sizeof(uint32_t);
+  size_t size = index_size * index_count +
+                (coalign_for_simd ? XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE : 0);
+  if (size > kFramePageSize) {
+    return nullptr;
+  }
+  frame_page_offset_ = xe::align(frame_page_offset_, index_size);
+  if (frame_page_current_ >= frame_pages_.size() ||
+      kFramePageSize - frame_page_offset_ < size) {
+    if (frame_page_current_ < frame_pages_.size()) {
+      ++frame_page_current_;
+    }
+    if (frame_page_current_ >= frame_pages_.size()) {
+      frame_pages_.push_back(std::make_unique<uint8_t[]>(kFramePageSize));
+    }
+    frame_page_offset_ = 0;
+  }
+  uint8_t* mapping =
+      frame_pages_[frame_page_current_].get() + frame_page_offset_;
+  frame_page_offset_ += size;
+  if (coalign_for_simd) {
+    mapping += GetSimdCoalignmentOffset(mapping, coalignment_original_address);
+  }
+  converted_index_bytes_ += index_size * index_count;
+  backend_handle_out = frame_index_buffer_count_++;
+  return mapping;
+}
+
+}  // namespace null
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_NULL_NULL_PRIMITIVE_PROCESSOR_H_
+#define XENIA_GPU_NULL_NULL_PRIMITIVE_PROCESSOR_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "xenia/gpu/primitive_processor.h"
+
+namespace xe {
+namespace gpu {
+namespace null {
+
+// Primitive processor converting indices into reusable host memory pages that
+// are recycled at the end of every frame, with no GPU resources involved.
+class NullPrimitiveProcessor final : public PrimitiveProcessor {
+ public:
+  NullPrimitiveProcessor(const RegisterFile& register_file, Memory& memory,
+                         TraceWriter& trace_writer, SharedMemory& shared_memory)
+      : PrimitiveProcessor(register_file, memory, trace_writer,
+                           shared_memory) {}
+  ~NullPrimitiveProcessor();
+
+  bool Initialize();
+  void Shutdown(bool from_destructor = false);
+
+  void EndFrame();
+
+  uint64_t converted_index_bytes() const { return converted_index_bytes_; }
+
+ protected:
+  bool InitializeBuiltinIndexBuffer(
+      size_t size_bytes, std::function<void(void*)> fill_callback) override;
+
+  void* RequestHostConvertedIndexBufferForCurrentFrame(
+      xenos::IndexFormat format, uint32_t index_count, bool coalign_for_simd,
+      uint32_t coalignment_original_address,
+      size_t& backend_handle_out) override;
+
+ private:
+  static constexpr size_t kFramePageSize =
+      std::max(size_t(kMinRequiredConvertedIndexBufferSize),
+               size_t(4 * 1024 * 1024));
+
+  std::unique_ptr<uint8_t[]> builtin_index_buffer_;
+
+  // Pages are kept across frames, only the bump allocation position is reset.
+  std::vector<std::unique_ptr<uint8_t[]>> frame_pages_;
+  size_t frame_page_current_ = 0;
+  size_t frame_page_offset_ = 0;
+  // Number of allocations in the current frame, used as the backend handle.
+  size_t frame_index_buffer_count_ = 0;
+
+  uint64_t converted_index_bytes_ = 0;
+};
+
+}  // namespace null
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_NULL_NULL_PRIMITIVE_PROCESSOR_H_
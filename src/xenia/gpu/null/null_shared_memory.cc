@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/gpu/null/null_shared_memory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace xe {
+namespace gpu {
+namespace null {
+
+NullSharedMemory::~NullSharedMemory() { Shutdown(true); }
+
+bool NullSharedMemory::Initialize() {
+  InitializeCommon();
+  staging_buffer_ = std::make_unique<uint8_t[]>(kStagingBufferSize);
+  return true;
+}
+
+void NullSharedMemory::Shutdown(bool from_destructor) {
+  staging_buffer_.reset();
+  // If calling from the destructor, the SharedMemory destructor will call
+  // ShutdownCommon.
+  if (!from_destructor) {
+    ShutdownCommon();
+  }
+}
+
+bool NullSharedMemory::UploadRanges(
+    const std::pair<uint32_t, uint32_t>* upload_page_ranges,
+    uint32_t num_upload_ranges) {
+  for (uint32_t i = 0; i < num_upload_ranges; ++i) {
+    uint32_t upload_range_start = upload_page_ranges[i].first
+                                  << page_size_log2();
+    uint32_t upload_range_length = upload_page_ranges[i].second
+                                   << page_size_log2();
+    trace_writer_.WriteMemoryRead(upload_range_start, upload_range_length);
+    MakeRangeValid(upload_range_start, upload_range_length, false, false);
+    ++upload_count_;
+    upload_bytes_ += upload_range_length;
+    // Copy like a real backend would to an upload buffer, but keep reusing the
+    // same staging memory.
+    while (upload_range_length) {
+      uint32_t copy_length =
+          std::min(upload_range_length, uint32_t(kStagingBufferSize));
+      std::memcpy(staging_buffer_.get(),
+                  memory().TranslatePhysical(upload_range_start), copy_length);
+      upload_range_start += copy_length;
+      upload_range_length -= copy_length;
+    }
+  }
+  return true;
+}
+
+}  // namespace null
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_NULL_NULL_SHARED_MEMORY_H_
+#define XENIA_GPU_NULL_NULL_SHARED_MEMORY_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "xenia/gpu/shared_memory.h"
+#include "xenia/gpu/trace_writer.h"
+#include "xenia/memory.h"
+
+namespace xe {
+namespace gpu {
+namespace null {
+
+// Shared memory that performs all the validity tracking and upload copies of a
+// real backend, but into a reusable host staging buffer that is never
+// submitted anywhere.
+class NullSharedMemory : public SharedMemory {
+ public:
+  NullSharedMemory(Memory& memory, TraceWriter& trace_writer)
+      : SharedMemory(memory), trace_writer_(trace_writer) {}
+  ~NullSharedMemory() override;
+
+  bool Initialize();
+  void Shutdown(bool from_destructor = false);
+
+  uint64_t upload_count() const { return upload_count_; }
+  uint64_t upload_bytes() const { return upload_bytes_; }
+
+ protected:
+  bool UploadRanges(const std::pair<uint32_t, uint32_t>* upload_page_ranges,
+                    uint32_t num_upload_ranges) override;
+
+ private:
+  static constexpr size_t kStagingBufferSize = 4 * 1024 * 1024;
+
+  TraceWriter& trace_writer_;
+  std::unique_ptr<uint8_t[]> staging_buffer_;
+
+  uint64_t upload_count_ = 0;
+  uint64_t upload_bytes_ = 0;
+};
+
+}  // namespace null
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_NULL_NULL_SHARED_MEMORY_H_
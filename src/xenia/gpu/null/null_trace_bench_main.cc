@@ -0,0 +1,403 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "xenia/base/byte_order.h"
+#include "xenia/base/console_app_main.h"
+#include "xenia/base/cvar.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/threading.h"
+#include "xenia/emulator.h"
+#include "xenia/gpu/command_processor.h"
+#include "xenia/gpu/null/null_command_processor.h"
+#include "xenia/gpu/null/null_graphics_system.h"
+#include "xenia/gpu/packet_disassembler.h"
+#include "xenia/gpu/trace_protocol.h"
+#include "xenia/gpu/trace_reader.h"
+#include "xenia/gpu/xenos.h"
+#include "xenia/memory.h"
+
+DEFINE_path(trace_bench_file, "", "Specifies the trace file to replay.",
+            "GPU");
+DEFINE_int32(trace_bench_iterations, 5,
+             "Number of times to replay the whole trace. The first replay is "
+             "reported separately as it includes shader analysis and other "
+             "first-use costs.",
+             "GPU");
+
+// Heap allocation counting for the replay window, to catch per-packet
+// allocations in the common command processor path.
+static std::atomic<uint64_t> trace_bench_allocation_count{0};
+static std::atomic<uint64_t> trace_bench_allocation_bytes{0};
+
+void* operator new(size_t size) {
+  trace_bench_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  trace_bench_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  trace_bench_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  trace_bench_allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept {
+  return operator new(size, tag);
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t size) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t size) noexcept { std::free(ptr); }
+
+namespace xe {
+namespace gpu {
+namespace null {
+
+class NullTraceBench : public TraceReader {
+ public:
+  int Main(const std::vector<std::string>& args);
+
+ private:
+  struct PacketStats {
+    std::string name;
+    uint64_t count = 0;
+    uint64_t dwords = 0;
+    std::chrono::nanoseconds time{0};
+  };
+
+  struct ReplayStats {
+    std::chrono::nanoseconds time{0};
+    uint64_t packets = 0;
+    uint64_t draw_packets = 0;
+    uint64_t swaps = 0;
+    uint64_t allocations = 0;
+    uint64_t allocated_bytes = 0;
+  };
+
+  bool Setup();
+  void Replay(ReplayStats& stats);
+  void ReplayOnThread(ReplayStats& stats);
+  PacketStats& GetPacketStats(const uint8_t* packet_ptr);
+  void Report(const ReplayStats& cold, const ReplayStats& warm,
+              uint32_t warm_iterations) const;
+
+  std::unique_ptr<Emulator> emulator_;
+  GraphicsSystem* graphics_system_ = nullptr;
+  NullCommandProcessor* command_processor_ = nullptr;
+  std::unique_ptr<xe::threading::Event> replay_event_;
+
+  // Keyed by packet type in the upper bits and type 3 opcode in the lower.
+  std::map<uint32_t, PacketStats> packet_stats_;
+};
+
+int NullTraceBench::Main(const std::vector<std::string>& args) {
+  std::filesystem::path path;
+  if (!cvars::trace_bench_file.empty()) {
+    path = cvars::trace_bench_file;
+  } else if (args.size() >= 2) {
+    path = xe::to_path(args[1]);
+  }
+  if (path.empty()) {
+    XELOGE("No trace file specified");
+    return 5;
+  }
+
+  auto abs_path = std::filesystem::absolute(path);
+  XELOGI("Loading trace file {}...", xe::path_to_utf8(abs_path));
+
+  if (!Setup()) {
+    XELOGE("Unable to setup trace bench tool");
+    return 4;
+  }
+  if (!Open(xe::path_to_utf8(abs_path)) || !frame_count()) {
+    XELOGE("Unable to load trace file; not found?");
+    return 5;
+  }
+
+  uint32_t iterations =
+      uint32_t(std::max(cvars::trace_bench_iterations, int32_t(1)));
+  ReplayStats cold, warm;
+  Replay(cold);
+  for (uint32_t i = 1; i < iterations; ++i) {
+    Replay(warm);
+  }
+  Report(cold, warm, iterations - 1);
+
+  const NullCommandProcessor::Stats& cp_stats = command_processor_->stats();
+  XELOGI(
+      "Command processor: {} draws ({} skipped), {} copies, {} swaps, {} "
+      "unique shaders",
+      cp_stats.draws, cp_stats.draws_skipped, cp_stats.copies, cp_stats.swaps,
+      cp_stats.shaders_loaded);
+  XELOGI(
+      "Shared memory: {} range requests, {} uploads, {} bytes uploaded; "
+      "primitive processor: {} bytes of converted indices",
+      cp_stats.shared_memory_requests,
+      command_processor_->shared_memory()->upload_count(),
+      command_processor_->shared_memory()->upload_bytes(),
+      command_processor_->primitive_processor()->converted_index_bytes());
+
+  Close();
+  emulator_.reset();
+  return 0;
+}
+
+bool NullTraceBench::Setup() {
+  emulator_ = std::make_unique<Emulator>("", "", "", "");
+  X_STATUS result = emulator_->Setup(
+      nullptr, nullptr, false, nullptr,
+      []() { return std::unique_ptr<GraphicsSystem>(new NullGraphicsSystem()); },
+      nullptr);
+  if (XFAILED(result)) {
+    XELOGE("Failed to setup emulator: {:08X}", result);
+    return false;
+  }
+  graphics_system_ = emulator_->graphics_system();
+  command_processor_ =
+      static_cast<NullCommandProcessor*>(graphics_system_->command_processor());
+
+  // Like the trace player, make all of physical memory writable for playback.
+  auto heap = graphics_system_->memory()->LookupHeapByType(true, 64 * 1024);
+  heap->AllocFixed(heap->heap_base(), heap->heap_size(), heap->page_size(),
+                   kMemoryAllocationReserve | kMemoryAllocationCommit,
+                   kMemoryProtectRead | kMemoryProtectWrite);
+
+  replay_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  return replay_event_ != nullptr;
+}
+
+void NullTraceBench::Replay(ReplayStats& stats) {
+  command_processor_->CallInThread([this, &stats]() {
+    ReplayOnThread(stats);
+    replay_event_->Set();
+  });
+  xe::threading::Wait(replay_event_.get(), false);
+}
+
+NullTraceBench::PacketStats& NullTraceBench::GetPacketStats(
+    const uint8_t* packet_ptr) {
+  uint32_t packet = xe::load_and_swap<uint32_t>(packet_ptr);
+  uint32_t packet_type = packet >> 30;
+  uint32_t key = packet_type << 8;
+  if (packet_type == 3) {
+    key |= (packet >> 8) & 0x7F;
+  }
+  auto it = packet_stats_.find(key);
+  if (it != packet_stats_.end()) {
+    return it->second;
+  }
+  PacketStats& packet_stats = packet_stats_[key];
+  PacketInfo packet_info;
+  if (PacketDisassembler::DisasmPacket(packet_ptr, &packet_info) &&
+      packet_info.type_info && packet_info.type_info->name) {
+    packet_stats.name = packet_info.type_info->name;
+  } else {
+    packet_stats.name = fmt::format("type {} opcode 0x{:02X}", packet_type,
+                                    key & 0xFF);
+  }
+  return packet_stats;
+}
+
+void NullTraceBench::ReplayOnThread(ReplayStats& stats) {
+  Memory* memory = graphics_system_->memory();
+
+  const uint8_t* trace_begin = frame(0)->start_ptr;
+  const uint8_t* trace_end = frame(frame_count() - 1)->end_ptr;
+  const uint8_t* trace_ptr = trace_begin;
+  const PacketStartCommand* pending_packet = nullptr;
+
+  uint64_t allocation_count_start = trace_bench_allocation_count.load();
+  uint64_t allocation_bytes_start = trace_bench_allocation_bytes.load();
+  auto replay_start = std::chrono::steady_clock::now();
+
+  while (trace_ptr < trace_end) {
+    auto type = static_cast<TraceCommandType>(xe::load<uint32_t>(trace_ptr));
+    switch (type) {
+      case TraceCommandType::kPrimaryBufferStart: {
+        auto cmd =
+            reinterpret_cast<const PrimaryBufferStartCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd) + cmd->count * 4;
+        break;
+      }
+      case TraceCommandType::kPrimaryBufferEnd: {
+        trace_ptr += sizeof(PrimaryBufferEndCommand);
+        break;
+      }
+      case TraceCommandType::kIndirectBufferStart: {
+        auto cmd =
+            reinterpret_cast<const IndirectBufferStartCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd) + cmd->count * 4;
+        break;
+      }
+      case TraceCommandType::kIndirectBufferEnd: {
+        trace_ptr += sizeof(IndirectBufferEndCommand);
+        break;
+      }
+      case TraceCommandType::kPacketStart: {
+        auto cmd = reinterpret_cast<const PacketStartCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd);
+        std::memcpy(memory->TranslatePhysical(cmd->base_ptr), trace_ptr,
+                    cmd->count * 4);
+        trace_ptr += cmd->count * 4;
+        pending_packet = cmd;
+        break;
+      }
+      case TraceCommandType::kPacketEnd: {
+        trace_ptr += sizeof(PacketEndCommand);
+        if (!pending_packet) {
+          break;
+        }
+        const uint8_t* packet_ptr =
+            memory->TranslatePhysical(pending_packet->base_ptr);
+        PacketStats& packet_stats = GetPacketStats(packet_ptr);
+        bool is_draw = PacketDisassembler::GetPacketCategory(packet_ptr) ==
+                       PacketCategory::kDraw;
+        auto packet_start = std::chrono::steady_clock::now();
+        command_processor_->ExecutePacket(pending_packet->base_ptr,
+                                          pending_packet->count);
+        auto packet_end = std::chrono::steady_clock::now();
+        packet_stats.time += packet_end - packet_start;
+        ++packet_stats.count;
+        packet_stats.dwords += pending_packet->count;
+        ++stats.packets;
+        if (is_draw) {
+          ++stats.draw_packets;
+        }
+        pending_packet = nullptr;
+        break;
+      }
+      case TraceCommandType::kMemoryRead: {
+        auto cmd = reinterpret_cast<const MemoryCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd);
+        DecompressMemory(cmd->encoding_format, trace_ptr, cmd->encoded_length,
+                         memory->TranslatePhysical(cmd->base_ptr),
+                         cmd->decoded_length);
+        trace_ptr += cmd->encoded_length;
+        command_processor_->TracePlaybackWroteMemory(cmd->base_ptr,
+                                                     cmd->decoded_length);
+        break;
+      }
+      case TraceCommandType::kMemoryWrite: {
+        auto cmd = reinterpret_cast<const MemoryCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd) + cmd->encoded_length;
+        break;
+      }
+      case TraceCommandType::kEdramSnapshot: {
+        auto cmd = reinterpret_cast<const EdramSnapshotCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd) + cmd->encoded_length;
+        break;
+      }
+      case TraceCommandType::kEvent: {
+        auto cmd = reinterpret_cast<const EventCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd);
+        if (cmd->event_type == EventCommand::Type::kSwap) {
+          ++stats.swaps;
+        }
+        break;
+      }
+      case TraceCommandType::kRegisters: {
+        auto cmd = reinterpret_cast<const RegistersCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd);
+        std::unique_ptr<uint32_t[]> register_values(
+            new uint32_t[cmd->register_count]);
+        DecompressMemory(cmd->encoding_format, trace_ptr, cmd->encoded_length,
+                         register_values.get(),
+                         sizeof(uint32_t) * cmd->register_count);
+        trace_ptr += cmd->encoded_length;
+        command_processor_->RestoreRegisters(
+            cmd->first_register, register_values.get(), cmd->register_count,
+            cmd->execute_callbacks);
+        break;
+      }
+      case TraceCommandType::kGammaRamp: {
+        auto cmd = reinterpret_cast<const GammaRampCommand*>(trace_ptr);
+        trace_ptr += sizeof(*cmd) + cmd->encoded_length;
+        break;
+      }
+      default:
+        XELOGE("Unknown trace command type {}; stopping the replay",
+               uint32_t(type));
+        trace_ptr = trace_end;
+        break;
+    }
+  }
+
+  stats.time += std::chrono::steady_clock::now() - replay_start;
+  stats.allocations +=
+      trace_bench_allocation_count.load() - allocation_count_start;
+  stats.allocated_bytes +=
+      trace_bench_allocation_bytes.load() - allocation_bytes_start;
+}
+
+void NullTraceBench::Report(const ReplayStats& cold, const ReplayStats& warm,
+                            uint32_t warm_iterations) const {
+  auto report_replay = [](const char* label, const ReplayStats& stats,
+                          uint32_t iterations) {
+    if (!iterations) {
+      return;
+    }
+    double seconds = std::chrono::duration<double>(stats.time).count();
+    XELOGI(
+        "{}: {:.3f} ms per replay, {} packets, {} draws, {} swaps, "
+        "{:.0f} draws/s, {:.1f} allocations ({} bytes) per replay",
+        label, seconds * 1000.0 / iterations, stats.packets / iterations,
+        stats.draw_packets / iterations, stats.swaps / iterations,
+        seconds > 0.0 ? double(stats.draw_packets) / seconds : 0.0,
+        double(stats.allocations) / iterations,
+        stats.allocated_bytes / iterations);
+  };
+  report_replay("First replay", cold, 1);
+  report_replay("Next replays", warm, warm_iterations);
+
+  std::vector<const PacketStats*> sorted_packet_stats;
+  sorted_packet_stats.reserve(packet_stats_.size());
+  for (const auto& packet_stats : packet_stats_) {
+    sorted_packet_stats.push_back(&packet_stats.second);
+  }
+  std::sort(sorted_packet_stats.begin(), sorted_packet_stats.end(),
+            [](const PacketStats* a, const PacketStats* b) {
+              return a->time > b->time;
+            });
+  XELOGI("{:<28} {:>10} {:>12} {:>12} {:>10}", "Packet", "Count", "Dwords",
+         "Total ms", "ns/packet");
+  for (const PacketStats* packet_stats : sorted_packet_stats) {
+    double total_ns =
+        std::chrono::duration<double, std::nano>(packet_stats->time).count();
+    XELOGI("{:<28} {:>10} {:>12} {:>12.3f} {:>10.1f}", packet_stats->name,
+           packet_stats->count, packet_stats->dwords, total_ns / 1000000.0,
+           packet_stats->count ? total_ns / double(packet_stats->count) : 0.0);
+  }
+}
+
+int trace_bench_main(const std::vector<std::string>& args) {
+  NullTraceBench trace_bench;
+  return trace_bench.Main(args);
+}
+
+}  // namespace null
+}  // namespace gpu
+}  // namespace xe
+
+XE_DEFINE_CONSOLE_APP("xenia-gpu-null-trace-bench",
+                      xe::gpu::null::trace_bench_main, "some.trace",
+                      "trace_bench_file");
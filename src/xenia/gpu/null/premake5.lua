@@ -17,3 +17,56 @@ project("xenia-gpu-null")
     project_root.."/third_party/Vulkan-Headers/include",
   })
   local_platform_files()
+
+group("src")
+project("xenia-gpu-null-trace-bench")
+  uuid("5b1a9e2c-7d43-4f0e-9c61-2e8f4a3d7b15")
+  kind("ConsoleApp")
+  language("C++")
+  links({
+    "xenia-apu",
+    "xenia-apu-nop",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-gpu",
+    "xenia-gpu-null",
+    "xenia-hid",
+    "xenia-hid-nop",
+    "xenia-kernel",
+    "xenia-ui",
+    "xenia-ui-vulkan",
+    "xenia-vfs",
+    "xenia-patcher",
+  })
+  links({
+    "aes_128",
+    "capstone",
+    "fmt",
+    "glslang-spirv",
+    "imgui",
+    "libavcodec",
+    "libavutil",
+    "mspack",
+    "snappy",
+    "xxhash",
+  })
+  includedirs({
+    project_root.."/third_party/Vulkan-Headers/include",
+  })
+  files({
+    "null_trace_bench_main.cc",
+    "../../base/console_app_main_"..platform_suffix..".cc",
+  })
+
+  filter("architecture:x86_64")
+    links({
+      "xenia-cpu-backend-x64",
+    })
+
+  filter("platforms:Linux")
+    links({
+      "X11",
+      "xcb",
+      "X11-xcb",
+    })
@@ -273,6 +273,7 @@ bool COMMAND_PROCESSOR::ExecutePacket() {
 #endif
   const uint32_t packet = reader_.ReadAndSwap<uint32_t>();
   const uint32_t packet_type = packet >> 30;
+  frame_telemetry::AddToCounter(frame_telemetry::Counter::kPm4Packets);
 
   XE_LIKELY_IF(packet && packet != 0x0BADF00D) {
     XE_LIKELY_IF((packet != 0xCDCDCDCD)) {
@@ -662,6 +663,7 @@ bool COMMAND_PROCESSOR::ExecutePacketType3_XE_SWAP(uint32_t packet,
 
   COMMAND_PROCESSOR::IssueSwap(frontbuffer_ptr, frontbuffer_width,
                                frontbuffer_height);
+  frame_telemetry::EndGuestFrame();
 
   ++counter_;
   return true;
@@ -1087,6 +1089,7 @@ bool COMMAND_PROCESSOR::ExecutePacketType3Draw(
           is_indexed ? &index_buffer_info : nullptr,
           xenos::IsMajorModeExplicit(vgt_draw_initiator.major_mode,
                                      vgt_draw_initiator.prim_type));
+      frame_telemetry::AddToCounter(frame_telemetry::Counter::kDraws);
       if (!draw_succeeded) {
         XELOGE("{}({}, {}, {}): Failed in backend", opcode_name,
                vgt_draw_initiator.num_indices,
@@ -26,6 +26,12 @@
 #include "xenia/gpu/trace_writer.h"
 #include "xenia/gpu/xenos.h"
 
+#include "third_party/fmt/include/fmt/format.h"
+
+#if XE_ARCH_AMD64
+#include <immintrin.h>
+#endif  // XE_ARCH_AMD64
+
 // All these overrides are always safe to use as all backends are expected to
 // support triangle lists and line strips.
 DEFINE_bool(
@@ -68,6 +74,37 @@ DEFINE_int32(
     "while a very low value may result in excessive locking and lookups.\n"
     "Negative values disable caching.",
     "GPU");
+DEFINE_int32(
+    primitive_processor_threads, 0,
+    "Number of worker threads to split processing (such as primitive type "
+    "conversion or reset index replacement) of large index buffers between, "
+    "in addition to the GPU command processor thread. May be faster with "
+    "games drawing very large converted index buffers on hosts with many "
+    "cores, but the worker threads compete with the emulated CPU threads.\n"
+    "0 disables multi-threaded processing.",
+    "GPU");
+DEFINE_int32(
+    primitive_processor_parallel_min_indices, 32768,
+    "Smallest number of guest indices to split processing of between multiple "
+    "threads if primitive_processor_threads is not 0.\n"
+    "Waking up the worker threads has a cost comparable to processing of a few "
+    "thousand indices, so a very low value may make processing slower.\n"
+    "Negative values disable multi-threaded processing.",
+    "GPU");
+
+#if XE_ARCH_AMD64
+// The wider kernels are chosen at runtime, while the rest of the code is
+// compiled for the minimum requirements (AVX) - Clang and GCC only allow using
+// the intrinsics in functions explicitly targeting the extensions.
+#if XE_COMPILER_HAS_GNU_EXTENSIONS
+#define XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 __attribute__((target("avx2")))
+#define XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX512 \
+  __attribute__((target("avx2,avx512f,avx512vl,avx512bw")))
+#else
+#define XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2
+#define XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX512
+#endif  // XE_COMPILER_HAS_GNU_EXTENSIONS
+#endif  // XE_ARCH_AMD64
 
 namespace xe {
 namespace gpu {
@@ -237,10 +274,50 @@ bool PrimitiveProcessor::InitializeCommon(
     }
   }
 
+  // Worker threads for processing of large index buffers. Not critical - if
+  // failed to create any, processing will just be done on fewer threads.
+  if (cvars::primitive_processor_threads > 0 &&
+      cvars::primitive_processor_parallel_min_indices >= 0) {
+    chunk_workers_done_event_ =
+        xe::threading::Event::CreateAutoResetEvent(false);
+    if (chunk_workers_done_event_) {
+      chunk_workers_shutting_down_.store(false, std::memory_order_relaxed);
+      for (int32_t i = 0; i < cvars::primitive_processor_threads; ++i) {
+        std::unique_ptr<xe::threading::Event> chunk_worker_event =
+            xe::threading::Event::CreateAutoResetEvent(false);
+        if (!chunk_worker_event) {
+          break;
+        }
+        size_t worker_index = chunk_worker_threads_.size();
+        chunk_worker_events_.push_back(std::move(chunk_worker_event));
+        std::unique_ptr<xe::threading::Thread> chunk_worker_thread =
+            xe::threading::Thread::Create({}, [this, worker_index]() {
+              ChunkWorkerThread(worker_index);
+            });
+        if (!chunk_worker_thread) {
+          chunk_worker_events_.pop_back();
+          break;
+        }
+        chunk_worker_thread->set_name(
+            fmt::format("GPU Primitive Processor {}", worker_index));
+        chunk_worker_threads_.push_back(std::move(chunk_worker_thread));
+      }
+    }
+    if (chunk_worker_threads_.size() <
+        size_t(cvars::primitive_processor_threads)) {
+      XELOGW(
+          "Primitive processor: Created {} of {} worker threads for "
+          "processing large index buffers",
+          chunk_worker_threads_.size(), cvars::primitive_processor_threads);
+    }
+  }
+
   return true;
 }
 
 void PrimitiveProcessor::ShutdownCommon() {
+  ShutdownChunkWorkers();
+
   if (memory_invalidation_callback_handle_) {
     // Clear the cache if it has ever been used and unregister the invalidation
     // callback.
@@ -278,6 +355,96 @@ void PrimitiveProcessor::ClearPerFrameCache() {
               sizeof(cache_buckets_non_empty_l2_));
 }
 
+bool PrimitiveProcessor::ShouldProcessInChunks(uint32_t count) const {
+  return !chunk_worker_threads_.empty() &&
+         cvars::primitive_processor_parallel_min_indices >= 0 &&
+         count >= uint32_t(cvars::primitive_processor_parallel_min_indices) &&
+         count >= kChunkMinElements * 2;
+}
+
+uint32_t PrimitiveProcessor::GetChunkSize(uint32_t count,
+                                          uint32_t max_chunk_count) {
+  uint32_t chunk_count =
+      std::max(std::min(max_chunk_count, count / kChunkMinElements),
+               uint32_t(1));
+  return xe::align((count + (chunk_count - 1)) / chunk_count,
+                   kChunkAlignmentElements);
+}
+
+void PrimitiveProcessor::ProcessInChunksOnWorkers(
+    uint32_t count, const std::function<void(uint32_t, uint32_t)>& function) {
+  SCOPE_profile_cpu_f("gpu");
+
+  uint32_t chunk_size =
+      GetChunkSize(count, uint32_t(chunk_worker_threads_.size()) + 1);
+  uint32_t chunk_count = (count + (chunk_size - 1)) / chunk_size;
+
+  chunk_function_ = &function;
+  chunk_total_count_ = count;
+  chunk_size_ = chunk_size;
+  chunk_count_ = chunk_count;
+  chunk_next_.store(0, std::memory_order_relaxed);
+  // The calling thread processes chunks too.
+  uint32_t workers_to_wake = chunk_count - 1;
+  chunk_workers_running_.store(workers_to_wake, std::memory_order_release);
+  for (uint32_t i = 0; i < workers_to_wake; ++i) {
+    chunk_worker_events_[i]->Set();
+  }
+  ProcessAvailableChunks();
+  // The workers must not be accessing the current job anymore when this
+  // returns, not just have all the chunks completed.
+  while (chunk_workers_running_.load(std::memory_order_acquire)) {
+    xe::threading::Wait(chunk_workers_done_event_.get(), false);
+  }
+  chunk_function_ = nullptr;
+}
+
+void PrimitiveProcessor::ProcessAvailableChunks() {
+  const std::function<void(uint32_t, uint32_t)>& function = *chunk_function_;
+  while (true) {
+    uint32_t chunk_index = chunk_next_.fetch_add(1, std::memory_order_relaxed);
+    if (chunk_index >= chunk_count_) {
+      break;
+    }
+    uint32_t chunk_offset = chunk_index * chunk_size_;
+    function(chunk_offset,
+             std::min(chunk_size_, chunk_total_count_ - chunk_offset));
+  }
+}
+
+void PrimitiveProcessor::ChunkWorkerThread(size_t worker_index) {
+  xe::threading::Event& event = *chunk_worker_events_[worker_index];
+  while (true) {
+    xe::threading::Wait(&event, false);
+    if (chunk_workers_shutting_down_.load(std::memory_order_acquire)) {
+      break;
+    }
+    {
+      SCOPE_profile_cpu_f("gpu");
+      ProcessAvailableChunks();
+    }
+    if (chunk_workers_running_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      chunk_workers_done_event_->Set();
+    }
+  }
+}
+
+void PrimitiveProcessor::ShutdownChunkWorkers() {
+  if (!chunk_worker_threads_.empty()) {
+    chunk_workers_shutting_down_.store(true, std::memory_order_release);
+    for (size_t i = 0; i < chunk_worker_threads_.size(); ++i) {
+      chunk_worker_events_[i]->Set();
+    }
+    for (const std::unique_ptr<xe::threading::Thread>& chunk_worker_thread :
+         chunk_worker_threads_) {
+      xe::threading::Wait(chunk_worker_thread.get(), false);
+    }
+    chunk_worker_threads_.clear();
+  }
+  chunk_worker_events_.clear();
+  chunk_workers_done_event_.reset();
+}
+
 bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
   SCOPE_profile_cpu_f("gpu");
 
@@ -741,10 +908,18 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
           if (!host_indices) {
             return false;
           }
-          ConvertSinglePrimitiveRanges(
-              host_indices, guest_indices, guest_primitive_type,
-              PassthroughIndexTransform(), single_primitive_ranges_.cbegin(),
-              single_primitive_ranges_.cend());
+          if (single_primitive_ranges_.size() == 1) {
+            const SinglePrimitiveRange& range =
+                single_primitive_ranges_.front();
+            ConvertSinglePrimitivePassthrough(
+                host_indices, guest_indices + range.guest_offset,
+                guest_primitive_type, range.guest_index_count);
+          } else {
+            ConvertSinglePrimitiveRanges(
+                host_indices, guest_indices, guest_primitive_type,
+                PassthroughIndexTransform(), single_primitive_ranges_.cbegin(),
+                single_primitive_ranges_.cend());
+          }
         } else {
           // 32-bit indices - may need to pre-swap and pre-mask also if the host
           // doesn't support full 32-bit vertex indices.
@@ -779,10 +954,19 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
               single_primitive_ranges_.cbegin();
           auto single_primitive_ranges_end = single_primitive_ranges_.cend();
           if (full_32bit_vertex_indices_used_) {
-            ConvertSinglePrimitiveRanges(
-                host_indices, guest_indices, guest_primitive_type,
-                PassthroughIndexTransform(), single_primitive_ranges_beginning,
-                single_primitive_ranges_end);
+            if (single_primitive_ranges_.size() == 1) {
+              const SinglePrimitiveRange& range =
+                  single_primitive_ranges_.front();
+              ConvertSinglePrimitivePassthrough(
+                  host_indices, guest_indices + range.guest_offset,
+                  guest_primitive_type, range.guest_index_count);
+            } else {
+              ConvertSinglePrimitiveRanges(
+                  host_indices, guest_indices, guest_primitive_type,
+                  PassthroughIndexTransform(),
+                  single_primitive_ranges_beginning,
+                  single_primitive_ranges_end);
+            }
           } else {
             switch (guest_index_endian) {
               case xenos::Endian::kNone:
@@ -875,16 +1059,30 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
                 if (!host_indices_ptr) {
                   return false;
                 }
+                auto reset_index_guest_endian =
+                    uint16_t(guest_primitive_reset_index_guest_endian);
                 if (is_ffff_used_as_vertex_index) {
-                  ReplaceResetIndex16To24(
-                      reinterpret_cast<uint32_t*>(host_indices_ptr),
-                      guest_indices, guest_draw_vertex_count,
-                      guest_primitive_reset_index_guest_endian);
+                  auto host_indices =
+                      reinterpret_cast<uint32_t*>(host_indices_ptr);
+                  ProcessInChunks(
+                      guest_draw_vertex_count,
+                      [host_indices, guest_indices, reset_index_guest_endian](
+                          uint32_t offset, uint32_t count) {
+                        ReplaceResetIndex16To24(host_indices + offset,
+                                                guest_indices + offset, count,
+                                                reset_index_guest_endian);
+                      });
                 } else {
-                  ReplaceResetIndex16To16(
-                      reinterpret_cast<uint16_t*>(host_indices_ptr),
-                      guest_indices, guest_draw_vertex_count,
-                      guest_primitive_reset_index_guest_endian);
+                  auto host_indices =
+                      reinterpret_cast<uint16_t*>(host_indices_ptr);
+                  ProcessInChunks(
+                      guest_draw_vertex_count,
+                      [host_indices, guest_indices, reset_index_guest_endian](
+                          uint32_t offset, uint32_t count) {
+                        ReplaceResetIndex16To16(host_indices + offset,
+                                                guest_indices + offset, count,
+                                                reset_index_guest_endian);
+                      });
                 }
               }
               cache_transaction.SetNewResult(cacheable);
@@ -926,31 +1124,39 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
               if (!host_indices) {
                 return false;
               }
+              void (*replace_reset_index)(uint32_t* dest,
+                                          const uint32_t* source,
+                                          uint32_t count,
+                                          uint32_t reset_index_guest_endian,
+                                          uint32_t low_bits_mask_guest_endian);
               if (full_32bit_vertex_indices_used_ ||
                   guest_index_endian == xenos::Endian::kNone) {
-                ReplaceResetIndex32To24<xenos::Endian::kNone>(
-                    host_indices, guest_indices, guest_draw_vertex_count,
-                    guest_primitive_reset_index_guest_endian,
-                    guest_index_mask_guest_endian);
+                replace_reset_index =
+                    ReplaceResetIndex32To24<xenos::Endian::kNone>;
               } else if (guest_index_endian == xenos::Endian::k8in16) {
-                ReplaceResetIndex32To24<xenos::Endian::k8in16>(
-                    host_indices, guest_indices, guest_draw_vertex_count,
-                    guest_primitive_reset_index_guest_endian,
-                    guest_index_mask_guest_endian);
+                replace_reset_index =
+                    ReplaceResetIndex32To24<xenos::Endian::k8in16>;
               } else if (guest_index_endian == xenos::Endian::k8in32) {
-                ReplaceResetIndex32To24<xenos::Endian::k8in32>(
-                    host_indices, guest_indices, guest_draw_vertex_count,
-                    guest_primitive_reset_index_guest_endian,
-                    guest_index_mask_guest_endian);
+                replace_reset_index =
+                    ReplaceResetIndex32To24<xenos::Endian::k8in32>;
               } else if (guest_index_endian == xenos::Endian::k16in32) {
-                ReplaceResetIndex32To24<xenos::Endian::k16in32>(
-                    host_indices, guest_indices, guest_draw_vertex_count,
-                    guest_primitive_reset_index_guest_endian,
-                    guest_index_mask_guest_endian);
+                replace_reset_index =
+                    ReplaceResetIndex32To24<xenos::Endian::k16in32>;
               } else {
                 assert_unhandled_case(guest_index_endian);
                 return false;
               }
+              ProcessInChunks(
+                  guest_draw_vertex_count,
+                  [replace_reset_index, host_indices, guest_indices,
+                   guest_primitive_reset_index_guest_endian,
+                   guest_index_mask_guest_endian](uint32_t offset,
+                                                  uint32_t count) {
+                    replace_reset_index(
+                        host_indices + offset, guest_indices + offset, count,
+                        guest_primitive_reset_index_guest_endian,
+                        guest_index_mask_guest_endian);
+                  });
               cacheable.host_shader_index_endian =
                   full_32bit_vertex_indices_used_ ? guest_index_endian
                                                   : xenos::Endian::kNone;
@@ -997,6 +1203,11 @@ bool PrimitiveProcessor::Process(ProcessingResult& result_out) {
 
 bool PrimitiveProcessor::IsResetUsed(const uint16_t* source, uint32_t count,
                                      uint16_t reset_index_guest_endian) {
+#if XE_ARCH_AMD64
+  if (AreAVX2KernelsSupported()) {
+    return IsResetUsedAVX2(source, count, reset_index_guest_endian);
+  }
+#endif  // XE_ARCH_AMD64
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
   while (count && (reinterpret_cast<uintptr_t>(source) &
                    (XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE - 1))) {
@@ -1051,6 +1262,14 @@ void PrimitiveProcessor::Get16BitResetIndexUsage(
         IsResetUsed(source, count, reset_index_guest_endian);
     return;
   }
+#if XE_ARCH_AMD64
+  if (AreAVX2KernelsSupported()) {
+    Get16BitResetIndexUsageAVX2(source, count, reset_index_guest_endian,
+                                is_reset_index_used_out,
+                                is_ffff_used_as_vertex_index_out);
+    return;
+  }
+#endif  // XE_ARCH_AMD64
   is_reset_index_used_out = false;
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
   while (count && (reinterpret_cast<uintptr_t>(source) &
@@ -1125,6 +1344,12 @@ void PrimitiveProcessor::Get16BitResetIndexUsage(
 bool PrimitiveProcessor::IsResetUsed(const uint32_t* source, uint32_t count,
                                      uint32_t reset_index_guest_endian,
                                      uint32_t low_bits_mask_guest_endian) {
+#if XE_ARCH_AMD64
+  if (AreAVX2KernelsSupported()) {
+    return IsResetUsedAVX2(source, count, reset_index_guest_endian,
+                           low_bits_mask_guest_endian);
+  }
+#endif  // XE_ARCH_AMD64
   // The Xbox 360's GPU only uses the low 24 bits of the index - masking before
   // comparing.
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
@@ -1176,6 +1401,17 @@ bool PrimitiveProcessor::IsResetUsed(const uint32_t* source, uint32_t count,
 void PrimitiveProcessor::ReplaceResetIndex16To16(
     uint16_t* dest, const uint16_t* source, uint32_t count,
     uint16_t reset_index_guest_endian) {
+#if XE_ARCH_AMD64
+  if (AreAVX512KernelsSupported()) {
+    ReplaceResetIndex16To16AVX512(dest, source, count,
+                                  reset_index_guest_endian);
+    return;
+  }
+  if (AreAVX2KernelsSupported()) {
+    ReplaceResetIndex16To16AVX2(dest, source, count, reset_index_guest_endian);
+    return;
+  }
+#endif  // XE_ARCH_AMD64
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
   while (count && (reinterpret_cast<uintptr_t>(source) &
                    (XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE - 1))) {
@@ -1218,6 +1454,17 @@ void PrimitiveProcessor::ReplaceResetIndex16To16(
 void PrimitiveProcessor::ReplaceResetIndex16To24(
     uint32_t* dest, const uint16_t* source, uint32_t count,
     uint16_t reset_index_guest_endian) {
+#if XE_ARCH_AMD64
+  if (AreAVX512KernelsSupported()) {
+    ReplaceResetIndex16To24AVX512(dest, source, count,
+                                  reset_index_guest_endian);
+    return;
+  }
+  if (AreAVX2KernelsSupported()) {
+    ReplaceResetIndex16To24AVX2(dest, source, count, reset_index_guest_endian);
+    return;
+  }
+#endif  // XE_ARCH_AMD64
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
   while (count && (reinterpret_cast<uintptr_t>(source) &
                    (XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE - 1))) {
@@ -1269,6 +1516,407 @@ void PrimitiveProcessor::ReplaceResetIndex16To24(
   }
 }
 
+#if XE_ARCH_AMD64
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 bool PrimitiveProcessor::IsResetUsedAVX2(
+    const uint16_t* source, uint32_t count, uint16_t reset_index_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    if (*(source++) == reset_index_guest_endian) {
+      return true;
+    }
+  }
+  __m256i reset_index_guest_endian_simd =
+      _mm256_set1_epi16(int16_t(reset_index_guest_endian));
+  // Two vectors per iteration for fewer branches.
+  while (count >= 32) {
+    count -= 32;
+    __m256i source_0 =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source));
+    __m256i source_1 =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source + 16));
+    source += 32;
+    __m256i are_reset = _mm256_or_si256(
+        _mm256_cmpeq_epi16(source_0, reset_index_guest_endian_simd),
+        _mm256_cmpeq_epi16(source_1, reset_index_guest_endian_simd));
+    if (!_mm256_testz_si256(are_reset, are_reset)) {
+      return true;
+    }
+  }
+  if (count >= 16) {
+    count -= 16;
+    __m256i are_reset = _mm256_cmpeq_epi16(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source)),
+        reset_index_guest_endian_simd);
+    source += 16;
+    if (!_mm256_testz_si256(are_reset, are_reset)) {
+      return true;
+    }
+  }
+  while (count--) {
+    if (*(source++) == reset_index_guest_endian) {
+      return true;
+    }
+  }
+  return false;
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 void
+PrimitiveProcessor::Get16BitResetIndexUsageAVX2(
+    const uint16_t* source, uint32_t count, uint16_t reset_index_guest_endian,
+    bool& is_reset_index_used_out, bool& is_ffff_used_as_vertex_index_out) {
+  is_ffff_used_as_vertex_index_out = false;
+  if (reset_index_guest_endian == UINT16_MAX) {
+    is_reset_index_used_out =
+        IsResetUsedAVX2(source, count, reset_index_guest_endian);
+    return;
+  }
+  is_reset_index_used_out = false;
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    uint16_t index = *(source++);
+    if (index == reset_index_guest_endian) {
+      is_reset_index_used_out = true;
+    }
+    if (index == UINT16_MAX) {
+      is_ffff_used_as_vertex_index_out = true;
+    }
+  }
+  if (count >= 16) {
+    __m256i reset_index_guest_endian_simd =
+        _mm256_set1_epi16(int16_t(reset_index_guest_endian));
+    __m256i ffff_simd = _mm256_set1_epi16(-1);
+    __m256i is_reset_simd = _mm256_setzero_si256();
+    __m256i is_ffff_simd = _mm256_setzero_si256();
+    while (count >= 16) {
+      count -= 16;
+      __m256i source_simd =
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(source));
+      source += 16;
+      is_reset_simd = _mm256_or_si256(
+          is_reset_simd,
+          _mm256_cmpeq_epi16(source_simd, reset_index_guest_endian_simd));
+      is_ffff_simd = _mm256_or_si256(
+          is_ffff_simd, _mm256_cmpeq_epi16(source_simd, ffff_simd));
+    }
+    if (!_mm256_testz_si256(is_reset_simd, is_reset_simd)) {
+      is_reset_index_used_out = true;
+    }
+    if (!_mm256_testz_si256(is_ffff_simd, is_ffff_simd)) {
+      is_ffff_used_as_vertex_index_out = true;
+    }
+  }
+  while (count--) {
+    uint16_t index = *(source++);
+    if (index == reset_index_guest_endian) {
+      is_reset_index_used_out = true;
+    }
+    if (index == UINT16_MAX) {
+      is_ffff_used_as_vertex_index_out = true;
+    }
+  }
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 bool PrimitiveProcessor::IsResetUsedAVX2(
+    const uint32_t* source, uint32_t count, uint32_t reset_index_guest_endian,
+    uint32_t low_bits_mask_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    if ((*(source++) & low_bits_mask_guest_endian) ==
+        reset_index_guest_endian) {
+      return true;
+    }
+  }
+  __m256i reset_index_guest_endian_simd =
+      _mm256_set1_epi32(int32_t(reset_index_guest_endian));
+  __m256i low_bits_mask_guest_endian_simd =
+      _mm256_set1_epi32(int32_t(low_bits_mask_guest_endian));
+  while (count >= 16) {
+    count -= 16;
+    __m256i source_0 = _mm256_and_si256(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source)),
+        low_bits_mask_guest_endian_simd);
+    __m256i source_1 = _mm256_and_si256(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source + 8)),
+        low_bits_mask_guest_endian_simd);
+    source += 16;
+    __m256i are_reset = _mm256_or_si256(
+        _mm256_cmpeq_epi32(source_0, reset_index_guest_endian_simd),
+        _mm256_cmpeq_epi32(source_1, reset_index_guest_endian_simd));
+    if (!_mm256_testz_si256(are_reset, are_reset)) {
+      return true;
+    }
+  }
+  if (count >= 8) {
+    count -= 8;
+    __m256i are_reset = _mm256_cmpeq_epi32(
+        _mm256_and_si256(
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(source)),
+            low_bits_mask_guest_endian_simd),
+        reset_index_guest_endian_simd);
+    source += 8;
+    if (!_mm256_testz_si256(are_reset, are_reset)) {
+      return true;
+    }
+  }
+  while (count--) {
+    if ((*(source++) & low_bits_mask_guest_endian) ==
+        reset_index_guest_endian) {
+      return true;
+    }
+  }
+  return false;
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 void
+PrimitiveProcessor::ReplaceResetIndex16To16AVX2(
+    uint16_t* dest, const uint16_t* source, uint32_t count,
+    uint16_t reset_index_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT16_MAX;
+  }
+  __m256i reset_index_guest_endian_simd =
+      _mm256_set1_epi16(int16_t(reset_index_guest_endian));
+  while (count >= 16) {
+    count -= 16;
+    // `index | (index == reset_index)`, like in the 128-bit version.
+    __m256i source_simd =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source));
+    source += 16;
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dest),
+        _mm256_or_si256(source_simd, _mm256_cmpeq_epi16(
+                                         source_simd,
+                                         reset_index_guest_endian_simd)));
+    dest += 16;
+  }
+  while (count--) {
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT16_MAX;
+  }
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX512 void
+PrimitiveProcessor::ReplaceResetIndex16To16AVX512(
+    uint16_t* dest, const uint16_t* source, uint32_t count,
+    uint16_t reset_index_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m512i) - 1))) {
+    --count;
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT16_MAX;
+  }
+  __m512i reset_index_guest_endian_simd =
+      _mm512_set1_epi16(int16_t(reset_index_guest_endian));
+  __m512i ffff_simd = _mm512_set1_epi16(-1);
+  while (count >= 32) {
+    count -= 32;
+    __m512i source_simd = _mm512_load_si512(source);
+    source += 32;
+    _mm512_storeu_si512(
+        dest, _mm512_mask_mov_epi16(
+                  source_simd,
+                  _mm512_cmpeq_epi16_mask(source_simd,
+                                          reset_index_guest_endian_simd),
+                  ffff_simd));
+    dest += 32;
+  }
+  if (count) {
+    // The tail with masked loads and stores instead of scalar processing.
+    __mmask32 tail_mask = _cvtu32_mask32((uint32_t(1) << count) - 1);
+    __m512i source_simd = _mm512_maskz_loadu_epi16(tail_mask, source);
+    _mm512_mask_storeu_epi16(
+        dest, tail_mask,
+        _mm512_mask_mov_epi16(
+            source_simd,
+            _mm512_cmpeq_epi16_mask(source_simd, reset_index_guest_endian_simd),
+            ffff_simd));
+  }
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 void
+PrimitiveProcessor::ReplaceResetIndex16To24AVX2(
+    uint32_t* dest, const uint16_t* source, uint32_t count,
+    uint16_t reset_index_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT32_MAX;
+  }
+  // Zero-extending, and then comparing the 32-bit indices to the zero-extended
+  // reset index, so the comparison result can be used directly as 0xFFFFFFFF.
+  __m256i reset_index_guest_endian_simd =
+      _mm256_set1_epi32(int32_t(reset_index_guest_endian));
+  while (count >= 16) {
+    count -= 16;
+    __m256i source_simd =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source));
+    source += 16;
+    __m256i source_low =
+        _mm256_cvtepu16_epi32(_mm256_castsi256_si128(source_simd));
+    __m256i source_high =
+        _mm256_cvtepu16_epi32(_mm256_extracti128_si256(source_simd, 1));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dest),
+        _mm256_or_si256(source_low, _mm256_cmpeq_epi32(
+                                        source_low,
+                                        reset_index_guest_endian_simd)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dest + 8),
+        _mm256_or_si256(source_high, _mm256_cmpeq_epi32(
+                                         source_high,
+                                         reset_index_guest_endian_simd)));
+    dest += 16;
+  }
+  while (count--) {
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT32_MAX;
+  }
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX512 void
+PrimitiveProcessor::ReplaceResetIndex16To24AVX512(
+    uint32_t* dest, const uint16_t* source, uint32_t count,
+    uint16_t reset_index_guest_endian) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    uint16_t index = *(source++);
+    *(dest++) = index != reset_index_guest_endian ? index : UINT32_MAX;
+  }
+  __m512i reset_index_guest_endian_simd =
+      _mm512_set1_epi32(int32_t(reset_index_guest_endian));
+  __m512i ffffffff_simd = _mm512_set1_epi32(-1);
+  while (count >= 16) {
+    count -= 16;
+    __m512i source_simd = _mm512_cvtepu16_epi32(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source)));
+    source += 16;
+    _mm512_storeu_si512(
+        dest, _mm512_mask_mov_epi32(
+                  source_simd,
+                  _mm512_cmpeq_epi32_mask(source_simd,
+                                          reset_index_guest_endian_simd),
+                  ffffffff_simd));
+    dest += 16;
+  }
+  if (count) {
+    __mmask16 tail_mask = _cvtu32_mask16((uint32_t(1) << count) - 1);
+    __m512i source_simd =
+        _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(tail_mask, source));
+    _mm512_mask_storeu_epi32(
+        dest, tail_mask,
+        _mm512_mask_mov_epi32(
+            source_simd,
+            _mm512_cmpeq_epi32_mask(source_simd, reset_index_guest_endian_simd),
+            ffffffff_simd));
+  }
+}
+
+// pshufb indices for swapping 32-bit elements within a 128-bit lane.
+static __m128i GetHostSwapShuffle32(xenos::Endian host_swap) {
+  return _mm_setr_epi32(
+      int32_t(xenos::GpuSwapInline(uint32_t(0x03020100), host_swap)),
+      int32_t(xenos::GpuSwapInline(uint32_t(0x07060504), host_swap)),
+      int32_t(xenos::GpuSwapInline(uint32_t(0x0B0A0908), host_swap)),
+      int32_t(xenos::GpuSwapInline(uint32_t(0x0F0E0D0C), host_swap)));
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX2 void
+PrimitiveProcessor::ReplaceResetIndex32To24AVX2(
+    uint32_t* dest, const uint32_t* source, uint32_t count,
+    uint32_t reset_index_guest_endian, uint32_t low_bits_mask_guest_endian,
+    xenos::Endian host_swap) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m256i) - 1))) {
+    --count;
+    uint32_t index = *(source++) & low_bits_mask_guest_endian;
+    *(dest++) = index != reset_index_guest_endian
+                    ? xenos::GpuSwapInline(index, host_swap)
+                    : UINT32_MAX;
+  }
+  __m256i reset_index_guest_endian_simd =
+      _mm256_set1_epi32(int32_t(reset_index_guest_endian));
+  __m256i low_bits_mask_guest_endian_simd =
+      _mm256_set1_epi32(int32_t(low_bits_mask_guest_endian));
+  // The identity shuffle for kNone is cheaper than a branch in the loop.
+  __m256i host_swap_shuffle =
+      _mm256_broadcastsi128_si256(GetHostSwapShuffle32(host_swap));
+  while (count >= 8) {
+    count -= 8;
+    __m256i source_simd = _mm256_and_si256(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(source)),
+        low_bits_mask_guest_endian_simd);
+    source += 8;
+    __m256i result_simd = _mm256_or_si256(
+        source_simd,
+        _mm256_cmpeq_epi32(source_simd, reset_index_guest_endian_simd));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest),
+                        _mm256_shuffle_epi8(result_simd, host_swap_shuffle));
+    dest += 8;
+  }
+  while (count--) {
+    uint32_t index = *(source++) & low_bits_mask_guest_endian;
+    *(dest++) = index != reset_index_guest_endian
+                    ? xenos::GpuSwapInline(index, host_swap)
+                    : UINT32_MAX;
+  }
+}
+
+XE_GPU_PRIMITIVE_PROCESSOR_TARGET_AVX512 void
+PrimitiveProcessor::ReplaceResetIndex32To24AVX512(
+    uint32_t* dest, const uint32_t* source, uint32_t count,
+    uint32_t reset_index_guest_endian, uint32_t low_bits_mask_guest_endian,
+    xenos::Endian host_swap) {
+  while (count &&
+         (reinterpret_cast<uintptr_t>(source) & (sizeof(__m512i) - 1))) {
+    --count;
+    uint32_t index = *(source++) & low_bits_mask_guest_endian;
+    *(dest++) = index != reset_index_guest_endian
+                    ? xenos::GpuSwapInline(index, host_swap)
+                    : UINT32_MAX;
+  }
+  __m512i reset_index_guest_endian_simd =
+      _mm512_set1_epi32(int32_t(reset_index_guest_endian));
+  __m512i low_bits_mask_guest_endian_simd =
+      _mm512_set1_epi32(int32_t(low_bits_mask_guest_endian));
+  __m512i ffffffff_simd = _mm512_set1_epi32(-1);
+  __m512i host_swap_shuffle =
+      _mm512_broadcast_i32x4(GetHostSwapShuffle32(host_swap));
+  while (count >= 16) {
+    count -= 16;
+    __m512i source_simd = _mm512_and_si512(_mm512_load_si512(source),
+                                           low_bits_mask_guest_endian_simd);
+    source += 16;
+    __m512i result_simd = _mm512_mask_mov_epi32(
+        source_simd,
+        _mm512_cmpeq_epi32_mask(source_simd, reset_index_guest_endian_simd),
+        ffffffff_simd);
+    _mm512_storeu_si512(dest,
+                        _mm512_shuffle_epi8(result_simd, host_swap_shuffle));
+    dest += 16;
+  }
+  if (count) {
+    __mmask16 tail_mask = _cvtu32_mask16((uint32_t(1) << count) - 1);
+    __m512i source_simd =
+        _mm512_and_si512(_mm512_maskz_loadu_epi32(tail_mask, source),
+                         low_bits_mask_guest_endian_simd);
+    __m512i result_simd = _mm512_mask_mov_epi32(
+        source_simd,
+        _mm512_cmpeq_epi32_mask(source_simd, reset_index_guest_endian_simd),
+        ffffffff_simd);
+    _mm512_mask_storeu_epi32(
+        dest, tail_mask, _mm512_shuffle_epi8(result_simd, host_swap_shuffle));
+  }
+}
+#endif  // XE_ARCH_AMD64
+
 template void PrimitiveProcessor::ReplaceResetIndex32To24<xenos::Endian::kNone>(
     uint32_t* dest, const uint32_t* source, uint32_t count,
     uint32_t reset_index_guest_endian, uint32_t low_bits_mask_guest_endian);
@@ -1299,23 +1947,13 @@ PrimitiveProcessor::ReplaceResetIndex32To24<xenos::Endian::k16in32>(
   template void PrimitiveProcessor::ConverterName(                         \
       uint32_t* dest, const uint32_t* source, uint32_t source_index_count, \
       const To24Swapping16In32IndexTransform& index_transform);
-#define XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION(ConverterName)   \
-  template void PrimitiveProcessor::ConverterName(                         \
-      uint16_t* dest, const uint16_t* source, uint32_t source_index_count, \
-      const PassthroughIndexTransform& index_transform);                   \
-  template void PrimitiveProcessor::ConverterName(                         \
-      uint32_t* dest, const uint32_t* source, uint32_t source_index_count, \
-      const PassthroughIndexTransform& index_transform);                   \
-  XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION_NO_PASSTHROUGH(        \
-      ConverterName)
-XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION(TriangleFanToList)
+XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION_NO_PASSTHROUGH(
+    TriangleFanToList)
 XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION_NO_PASSTHROUGH(
     LineLoopToStrip)
-// TODO(Triang3l): SIMD quad conversion maybe - 2 vectors to 3 vectors (though
-// multiple quads are rarely drawn anyway).
-XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION(QuadListToTriangleList)
+XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION_NO_PASSTHROUGH(
+    QuadListToTriangleList)
 #undef XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION_NO_PASSTHROUGH
-#undef XE_GPU_PRIMITIVE_PROCESSOR_INSTANTIATE_CONVERSION
 
 void PrimitiveProcessor::LineLoopToStrip(
     uint16_t* dest, const uint16_t* source, uint32_t source_index_count,
@@ -1338,6 +1976,217 @@ void PrimitiveProcessor::LineLoopToStrip(
   dest[source_index_count] = source[0];
 }
 
+void PrimitiveProcessor::TriangleFanToList(
+    uint16_t* dest, const uint16_t* source, uint32_t source_index_count,
+    const PassthroughIndexTransform& index_transform) {
+  if (source_index_count <= 2) {
+    // To match GetTriangleFanListIndexCount.
+    return;
+  }
+  TriangleFanToListTriangles(dest, source[0], source + 1,
+                             source_index_count - 2);
+}
+void PrimitiveProcessor::TriangleFanToList(
+    uint32_t* dest, const uint32_t* source, uint32_t source_index_count,
+    const PassthroughIndexTransform& index_transform) {
+  if (source_index_count <= 2) {
+    // To match GetTriangleFanListIndexCount.
+    return;
+  }
+  TriangleFanToListTriangles(dest, source[0], source + 1,
+                             source_index_count - 2);
+}
+
+void PrimitiveProcessor::TriangleFanToListTriangles(uint16_t* dest,
+                                                    uint16_t index_first,
+                                                    const uint16_t* source,
+                                                    uint32_t triangle_count) {
+#if XE_ARCH_AMD64
+  if (triangle_count >= 8) {
+    // 8 triangles (24 indices, 3 vectors) from source[0...8] per iteration.
+    // The first two vectors are gathered from source[0...7], the third from
+    // source[1...8], and index_first is blended in.
+    __m128i index_first_simd = _mm_set1_epi16(int16_t(index_first));
+    // (s0, s1, f, s1, s2, f, s2, s3).
+    __m128i shuffle_0 = _mm_setr_epi8(0, 1, 2, 3, -1, -1, 2, 3, 4, 5, -1, -1,
+                                      4, 5, 6, 7);
+    // (f, s3, s4, f, s4, s5, f, s5).
+    __m128i shuffle_1 = _mm_setr_epi8(-1, -1, 6, 7, 8, 9, -1, -1, 8, 9, 10, 11,
+                                      -1, -1, 10, 11);
+    // (s6, f, s6, s7, f, s7, s8, f) from source[1...8].
+    __m128i shuffle_2 = _mm_setr_epi8(10, 11, -1, -1, 10, 11, 12, 13, -1, -1,
+                                      12, 13, 14, 15, -1, -1);
+    while (triangle_count >= 8) {
+      triangle_count -= 8;
+      __m128i source_0 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+      __m128i source_1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 1));
+      source += 8;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+                       _mm_blend_epi16(_mm_shuffle_epi8(source_0, shuffle_0),
+                                       index_first_simd, 0b00100100));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 8),
+                       _mm_blend_epi16(_mm_shuffle_epi8(source_0, shuffle_1),
+                                       index_first_simd, 0b01001001));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 16),
+                       _mm_blend_epi16(_mm_shuffle_epi8(source_1, shuffle_2),
+                                       index_first_simd, 0b10010010));
+      dest += 24;
+    }
+  }
+#endif  // XE_ARCH_AMD64
+  for (uint32_t i = 0; i < triangle_count; ++i) {
+    *(dest++) = source[i];
+    *(dest++) = source[i + 1];
+    *(dest++) = index_first;
+  }
+}
+void PrimitiveProcessor::TriangleFanToListTriangles(uint32_t* dest,
+                                                    uint32_t index_first,
+                                                    const uint32_t* source,
+                                                    uint32_t triangle_count) {
+#if XE_ARCH_AMD64
+  if (triangle_count >= 4) {
+    // 4 triangles (12 indices, 3 vectors) from source[0...4] per iteration.
+    __m128i index_first_simd = _mm_set1_epi32(int32_t(index_first));
+    while (triangle_count >= 4) {
+      triangle_count -= 4;
+      __m128i source_0 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+      __m128i source_1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 1));
+      source += 4;
+      // (s0, s1, f, s1).
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dest),
+          _mm_blend_epi16(_mm_shuffle_epi32(source_0, _MM_SHUFFLE(1, 0, 1, 0)),
+                          index_first_simd, 0b00110000));
+      // (s2, f, s2, s3).
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dest + 4),
+          _mm_blend_epi16(_mm_shuffle_epi32(source_0, _MM_SHUFFLE(3, 2, 2, 2)),
+                          index_first_simd, 0b00001100));
+      // (f, s3, s4, f) from source[1...4].
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dest + 8),
+          _mm_blend_epi16(_mm_shuffle_epi32(source_1, _MM_SHUFFLE(3, 3, 2, 2)),
+                          index_first_simd, 0b11000011));
+      dest += 12;
+    }
+  }
+#endif  // XE_ARCH_AMD64
+  for (uint32_t i = 0; i < triangle_count; ++i) {
+    *(dest++) = source[i];
+    *(dest++) = source[i + 1];
+    *(dest++) = index_first;
+  }
+}
+
+void PrimitiveProcessor::QuadListToTriangleList(
+    uint16_t* dest, const uint16_t* source, uint32_t source_index_count,
+    const PassthroughIndexTransform& index_transform) {
+  uint32_t quad_count = source_index_count / 4;
+#if XE_ARCH_AMD64
+  if (quad_count >= 4) {
+    // 4 quads (2 vectors) to 8 triangles (3 vectors) per iteration.
+    // (v0, v1, v2, v0, v2, v3) for the first quad, then the first two indices
+    // of the second quad.
+    __m128i shuffle_quad_0 =
+        _mm_setr_epi8(0, 1, 2, 3, 4, 5, 0, 1, 4, 5, 6, 7, 8, 9, 10, 11);
+    // The last 4 indices of the first quad, then all 6 of the second.
+    __m128i shuffle_quad_1 =
+        _mm_setr_epi8(4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 8, 9, 12, 13, 14, 15);
+    while (quad_count >= 4) {
+      quad_count -= 4;
+      __m128i source_0 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+      __m128i source_1 =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 8));
+      source += 16;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+                       _mm_shuffle_epi8(source_0, shuffle_quad_0));
+      // The end of the second quad and the beginning of the third.
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(dest + 8),
+          _mm_alignr_epi8(_mm_shuffle_epi8(source_1, shuffle_quad_0),
+                          _mm_shuffle_epi8(source_0, shuffle_quad_1), 8));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 16),
+                       _mm_shuffle_epi8(source_1, shuffle_quad_1));
+      dest += 24;
+    }
+  }
+#endif  // XE_ARCH_AMD64
+  QuadListToTriangleList<uint16_t, PassthroughIndexTransform>(
+      dest, source, quad_count * 4, index_transform);
+}
+void PrimitiveProcessor::QuadListToTriangleList(
+    uint32_t* dest, const uint32_t* source, uint32_t source_index_count,
+    const PassthroughIndexTransform& index_transform) {
+  uint32_t quad_count = source_index_count / 4;
+#if XE_ARCH_AMD64
+  // 2 quads (2 vectors) to 4 triangles (3 vectors) per iteration.
+  while (quad_count >= 2) {
+    quad_count -= 2;
+    __m128i source_0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+    __m128i source_1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 4));
+    source += 8;
+    // (q0v0, q0v1, q0v2, q0v0).
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+                     _mm_shuffle_epi32(source_0, _MM_SHUFFLE(0, 2, 1, 0)));
+    // (q0v2, q0v3, q1v0, q1v1).
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4),
+                     _mm_alignr_epi8(source_1, source_0, 8));
+    // (q1v2, q1v0, q1v2, q1v3).
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 8),
+                     _mm_shuffle_epi32(source_1, _MM_SHUFFLE(3, 2, 0, 2)));
+    dest += 12;
+  }
+#endif  // XE_ARCH_AMD64
+  QuadListToTriangleList<uint32_t, PassthroughIndexTransform>(
+      dest, source, quad_count * 4, index_transform);
+}
+
+template <typename Index>
+void PrimitiveProcessor::ConvertSinglePrimitivePassthrough(
+    Index* dest, const Index* source,
+    xenos::PrimitiveType source_primitive_type, uint32_t source_index_count) {
+  switch (source_primitive_type) {
+    case xenos::PrimitiveType::kTriangleFan: {
+      if (source_index_count <= 2) {
+        // To match GetTriangleFanListIndexCount.
+        return;
+      }
+      Index index_first = source[0];
+      ProcessInChunks(source_index_count - 2,
+                      [dest, index_first, source](uint32_t offset,
+                                                  uint32_t count) {
+                        TriangleFanToListTriangles(dest + offset * 3,
+                                                   index_first,
+                                                   source + 1 + offset, count);
+                      });
+    } break;
+    case xenos::PrimitiveType::kLineLoop:
+      // Just a copy.
+      LineLoopToStrip(dest, source, source_index_count,
+                      PassthroughIndexTransform());
+      break;
+    case xenos::PrimitiveType::kQuadList:
+      // Chunks are aligned to whole quads.
+      ProcessInChunks(source_index_count,
+                      [dest, source](uint32_t offset, uint32_t count) {
+                        QuadListToTriangleList(dest + offset / 4 * 6,
+                                               source + offset, count,
+                                               PassthroughIndexTransform());
+                      });
+      break;
+    default:
+      assert_unhandled_case(source_primitive_type);
+  }
+}
+
 uint32_t PrimitiveProcessor::GetMultiPrimitiveHostIndexCountAndRanges(
     std::function<uint32_t(uint32_t)> single_primitive_guest_to_host_count,
     const uint16_t* source, uint32_t source_index_count,
@@ -11,21 +11,25 @@
 #define XENIA_GPU_PRIMITIVE_PROCESSOR_H_
 
 #include <algorithm>
+#include <atomic>
 #include <climits>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "xenia/base/assert.h"
 #include "xenia/base/cvar.h"
 #include "xenia/base/math.h"
 #include "xenia/base/mutex.h"
 #include "xenia/base/platform.h"
+#include "xenia/base/threading.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/shader.h"
 #include "xenia/gpu/shared_memory.h"
@@ -36,7 +40,8 @@
 #if XE_ARCH_AMD64
 // 128-bit SSSE3-level (SSE2+ for integer comparison, SSSE3 for pshufb) or AVX
 // (256-bit AVX only got integer operations such as comparison in AVX2, which is
-// above the minimum requirements of Xenia).
+// above the minimum requirements of Xenia - 256-bit AVX2 and 512-bit AVX-512
+// versions of the most bandwidth-heavy functions are chosen at runtime).
 #include <tmmintrin.h>
 #define XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE 16
 #elif XE_ARCH_ARM64
@@ -389,6 +394,20 @@ class PrimitiveProcessor {
       sizeof(SimdVectorU32) / sizeof(uint32_t);
 #endif  // XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
 
+  // Index processing functions are accessible to subclasses primarily for
+  // testing of them against the non-SIMD reference.
+ protected:
+  // Large index buffers are processed in chunks, on the calling thread and on
+  // the chunk worker threads, which is done for element-wise operations (reset
+  // index replacement and conversion of a single primitive without reset).
+  // Aligned to a multiple of the cache line size for both 16-bit and 32-bit
+  // elements so threads don't write to the same cache lines.
+  static constexpr uint32_t kChunkAlignmentElements = 64;
+  static constexpr uint32_t kChunkMinElements = 8192;
+  // Size of all chunks except for possibly the last one when splitting count
+  // elements into at most max_chunk_count chunks.
+  static uint32_t GetChunkSize(uint32_t count, uint32_t max_chunk_count);
+
   static bool IsResetUsed(const uint16_t* source, uint32_t count,
                           uint16_t reset_index_guest_endian);
   static void Get16BitResetIndexUsage(const uint16_t* source, uint32_t count,
@@ -423,6 +442,19 @@ class PrimitiveProcessor {
                                       uint32_t count,
                                       uint32_t reset_index_guest_endian,
                                       uint32_t low_bits_mask_guest_endian) {
+#if XE_ARCH_AMD64
+    if (AreAVX512KernelsSupported()) {
+      ReplaceResetIndex32To24AVX512(dest, source, count,
+                                    reset_index_guest_endian,
+                                    low_bits_mask_guest_endian, HostSwap);
+      return;
+    }
+    if (AreAVX2KernelsSupported()) {
+      ReplaceResetIndex32To24AVX2(dest, source, count, reset_index_guest_endian,
+                                  low_bits_mask_guest_endian, HostSwap);
+      return;
+    }
+#endif  // XE_ARCH_AMD64
     // The Xbox 360's GPU only uses the low 24 bits of the index - masking.
 #if XE_GPU_PRIMITIVE_PROCESSOR_SIMD_SIZE
     while (count && (reinterpret_cast<uintptr_t>(source) &
@@ -495,6 +527,58 @@ class PrimitiveProcessor {
     }
   }
 
+#if XE_ARCH_AMD64
+  // 256-bit and 512-bit versions of the functions above, chosen by them at
+  // runtime if the CPU supports the needed instruction set extensions. The
+  // 512-bit ones require AVX-512BW in addition to the foundation for 16-bit
+  // comparisons and byte shuffles.
+  static bool AreAVX2KernelsSupported() {
+    return (amd64::GetFeatureFlags() & amd64::kX64EmitAVX2) != 0;
+  }
+  static bool AreAVX512KernelsSupported() {
+    constexpr uint64_t kAVX512FeatureFlags =
+        amd64::kX64EmitAVX512Ortho | amd64::kX64EmitAVX512BW;
+    return (amd64::GetFeatureFlags() & kAVX512FeatureFlags) ==
+           kAVX512FeatureFlags;
+  }
+  static bool IsResetUsedAVX2(const uint16_t* source, uint32_t count,
+                              uint16_t reset_index_guest_endian);
+  static void Get16BitResetIndexUsageAVX2(
+      const uint16_t* source, uint32_t count, uint16_t reset_index_guest_endian,
+      bool& is_reset_index_used_out, bool& is_ffff_used_as_vertex_index_out);
+  static bool IsResetUsedAVX2(const uint32_t* source, uint32_t count,
+                              uint32_t reset_index_guest_endian,
+                              uint32_t low_bits_mask_guest_endian);
+  static void ReplaceResetIndex16To16AVX2(uint16_t* dest,
+                                          const uint16_t* source,
+                                          uint32_t count,
+                                          uint16_t reset_index_guest_endian);
+  static void ReplaceResetIndex16To16AVX512(uint16_t* dest,
+                                            const uint16_t* source,
+                                            uint32_t count,
+                                            uint16_t reset_index_guest_endian);
+  static void ReplaceResetIndex16To24AVX2(uint32_t* dest,
+                                          const uint16_t* source,
+                                          uint32_t count,
+                                          uint16_t reset_index_guest_endian);
+  static void ReplaceResetIndex16To24AVX512(uint32_t* dest,
+                                            const uint16_t* source,
+                                            uint32_t count,
+                                            uint16_t reset_index_guest_endian);
+  static void ReplaceResetIndex32To24AVX2(uint32_t* dest,
+                                          const uint32_t* source,
+                                          uint32_t count,
+                                          uint32_t reset_index_guest_endian,
+                                          uint32_t low_bits_mask_guest_endian,
+                                          xenos::Endian host_swap);
+  static void ReplaceResetIndex32To24AVX512(uint32_t* dest,
+                                            const uint32_t* source,
+                                            uint32_t count,
+                                            uint32_t reset_index_guest_endian,
+                                            uint32_t low_bits_mask_guest_endian,
+                                            xenos::Endian host_swap);
+#endif  // XE_ARCH_AMD64
+
   // TODO(Triang3l): 16-bit > 32-bit primitive type conversion for Metal, where
   // primitive reset is always enabled, if UINT16_MAX is used as a real vertex
   // index.
@@ -566,6 +650,21 @@ class PrimitiveProcessor {
       index_previous = index_current;
     }
   }
+  static void TriangleFanToList(
+      uint16_t* dest, const uint16_t* source, uint32_t source_index_count,
+      const PassthroughIndexTransform& index_transform);
+  static void TriangleFanToList(
+      uint32_t* dest, const uint32_t* source, uint32_t source_index_count,
+      const PassthroughIndexTransform& index_transform);
+  // Writes the triangles (source[i], source[i + 1], index_first) for i in
+  // [0, triangle_count) - a part of the triangle fan to triangle list
+  // conversion, for splitting it between threads.
+  static void TriangleFanToListTriangles(uint16_t* dest, uint16_t index_first,
+                                         const uint16_t* source,
+                                         uint32_t triangle_count);
+  static void TriangleFanToListTriangles(uint32_t* dest, uint32_t index_first,
+                                         const uint32_t* source,
+                                         uint32_t triangle_count);
 
   static constexpr uint32_t GetLineLoopStripIndexCount(
       uint32_t loop_index_count) {
@@ -622,6 +721,12 @@ class PrimitiveProcessor {
       *(dest++) = index_transform(*(source++));
     }
   }
+  static void QuadListToTriangleList(
+      uint16_t* dest, const uint16_t* source, uint32_t source_index_count,
+      const PassthroughIndexTransform& index_transform);
+  static void QuadListToTriangleList(
+      uint32_t* dest, const uint32_t* source, uint32_t source_index_count,
+      const PassthroughIndexTransform& index_transform);
 
   // Pre-gathering the ranges allows for usage of the same functions for
   // conversion with and without reset. In addition, this increases safety in
@@ -690,6 +795,32 @@ class PrimitiveProcessor {
     }
   }
 
+ private:
+  bool ShouldProcessInChunks(uint32_t count) const;
+  // Calls function(offset, count) for the whole range [0, count), splitting it
+  // between threads if it's large enough.
+  template <typename Function>
+  void ProcessInChunks(uint32_t count, Function&& function) {
+    if (!ShouldProcessInChunks(count)) {
+      function(uint32_t(0), count);
+      return;
+    }
+    ProcessInChunksOnWorkers(count, std::function<void(uint32_t, uint32_t)>(
+                                        std::forward<Function>(function)));
+  }
+  void ProcessInChunksOnWorkers(
+      uint32_t count, const std::function<void(uint32_t, uint32_t)>& function);
+  void ProcessAvailableChunks();
+  void ChunkWorkerThread(size_t worker_index);
+  void ShutdownChunkWorkers();
+  // Converts a single primitive (with no primitive reset in the middle) using
+  // the passthrough index transform, splitting the conversion between threads
+  // for large primitives.
+  template <typename Index>
+  void ConvertSinglePrimitivePassthrough(
+      Index* dest, const Index* source,
+      xenos::PrimitiveType source_primitive_type, uint32_t source_index_count);
+
   const RegisterFile& register_file_;
   Memory& memory_;
   TraceWriter& trace_writer_;
@@ -709,6 +840,20 @@ class PrimitiveProcessor {
 
   std::deque<SinglePrimitiveRange> single_primitive_ranges_;
 
+  std::vector<std::unique_ptr<xe::threading::Thread>> chunk_worker_threads_;
+  // One per worker so a wake-up can't be consumed by a different worker.
+  std::vector<std::unique_ptr<xe::threading::Event>> chunk_worker_events_;
+  std::unique_ptr<xe::threading::Event> chunk_workers_done_event_;
+  std::atomic<bool> chunk_workers_shutting_down_{false};
+  // The job currently being processed in chunks, written before waking up the
+  // workers, and not modified until all of them are done with it.
+  const std::function<void(uint32_t, uint32_t)>* chunk_function_ = nullptr;
+  uint32_t chunk_total_count_ = 0;
+  uint32_t chunk_size_ = 0;
+  uint32_t chunk_count_ = 0;
+  std::atomic<uint32_t> chunk_next_{0};
+  std::atomic<uint32_t> chunk_workers_running_{0};
+
   // Caching for reuse of converted indices within a frame.
 
   // 256 KB as the largest possible guest index buffer - 0xFFFF 32-bit indices -
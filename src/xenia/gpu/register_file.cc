@@ -64,6 +64,55 @@ static constexpr ValidRegisterBitset BuildValidRegisterBitset() {
 static constexpr ValidRegisterBitset valid_register_bitset =
     BuildValidRegisterBitset();
 
+static constexpr std::array<uint8_t, RegisterFile::kRegisterCount>
+BuildRegisterGroupMasks() {
+  std::array<uint8_t, RegisterFile::kRegisterCount> result{};
+  auto add_range = [&result](uint32_t first, uint32_t last,
+                             RegisterGroup group) {
+    for (uint32_t i = first; i <= last; ++i) {
+      result[i] |= uint8_t(RegisterFile::GetGroupMask(group));
+    }
+  };
+  auto add = [&add_range](uint32_t index, RegisterGroup group) {
+    add_range(index, index, group);
+  };
+
+  add(XE_GPU_REG_RB_BLENDCONTROL0, RegisterGroup::kBlend);
+  add_range(XE_GPU_REG_RB_BLENDCONTROL1, XE_GPU_REG_RB_BLENDCONTROL3,
+            RegisterGroup::kBlend);
+  add_range(XE_GPU_REG_RB_BLEND_RED, XE_GPU_REG_RB_BLEND_ALPHA,
+            RegisterGroup::kBlend);
+  add(XE_GPU_REG_RB_COLOR_MASK, RegisterGroup::kBlend);
+  add(XE_GPU_REG_RB_COLORCONTROL, RegisterGroup::kBlend);
+
+  add(XE_GPU_REG_RB_DEPTHCONTROL, RegisterGroup::kDepthStencil);
+  add(XE_GPU_REG_RB_STENCILREFMASK, RegisterGroup::kDepthStencil);
+  add(XE_GPU_REG_RB_STENCILREFMASK_BF, RegisterGroup::kDepthStencil);
+
+  add_range(XE_GPU_REG_RB_SURFACE_INFO, XE_GPU_REG_RB_COLOR3_INFO,
+            RegisterGroup::kSurfaceInfo);
+
+  // Enables or disables color and depth altogether.
+  add(XE_GPU_REG_RB_MODECONTROL, RegisterGroup::kBlend);
+  add(XE_GPU_REG_RB_MODECONTROL, RegisterGroup::kDepthStencil);
+  add(XE_GPU_REG_RB_MODECONTROL, RegisterGroup::kSurfaceInfo);
+
+  add_range(XE_GPU_REG_PA_SC_SCREEN_SCISSOR_TL,
+            XE_GPU_REG_PA_SC_SCREEN_SCISSOR_BR, RegisterGroup::kViewport);
+  add_range(XE_GPU_REG_PA_SC_WINDOW_OFFSET, XE_GPU_REG_PA_SC_WINDOW_SCISSOR_BR,
+            RegisterGroup::kViewport);
+  add_range(XE_GPU_REG_PA_CL_VPORT_XSCALE, XE_GPU_REG_PA_CL_VPORT_ZOFFSET,
+            RegisterGroup::kViewport);
+  add_range(XE_GPU_REG_PA_CL_CLIP_CNTL, XE_GPU_REG_PA_CL_VTE_CNTL,
+            RegisterGroup::kViewport);
+  add_range(XE_GPU_REG_PA_SU_VTX_CNTL, XE_GPU_REG_PA_CL_GB_HORZ_DISC_ADJ,
+            RegisterGroup::kViewport);
+
+  return result;
+}
+const std::array<uint8_t, RegisterFile::kRegisterCount>
+    RegisterFile::register_group_masks_ = BuildRegisterGroupMasks();
+
 const RegisterInfo* RegisterFile::GetRegisterInfo(uint32_t index) {
   switch (index) {
 #define XE_GPU_REGISTER(index, type, name) \
@@ -10,6 +10,8 @@
 #ifndef XENIA_GPU_REGISTER_FILE_H_
 #define XENIA_GPU_REGISTER_FILE_H_
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -31,6 +33,23 @@ struct RegisterInfo {
   const char* name;
 };
 
+// Registers that state used for drawing is derived from, tracked for skipping
+// the derivation if none of the registers it depends on have been written.
+enum class RegisterGroup : uint32_t {
+  // RB_BLENDCONTROL0-3, RB_BLEND_RED-ALPHA, RB_COLOR_MASK, RB_COLORCONTROL.
+  kBlend,
+  // RB_DEPTHCONTROL, RB_STENCILREFMASK, RB_STENCILREFMASK_BF.
+  kDepthStencil,
+  // RB_SURFACE_INFO, RB_COLOR_INFO, RB_COLOR1-3_INFO, RB_DEPTH_INFO.
+  kSurfaceInfo,
+  // Viewport, clipping and scissor registers of the PA.
+  kViewport,
+  // Shader constants are not tracked as nothing derived from them is cached
+  // yet, and they're the most frequently written registers.
+
+  kCount,
+};
+
 class RegisterFile {
  public:
   RegisterFile();
@@ -40,6 +59,43 @@ class RegisterFile {
   static constexpr size_t kRegisterCount = 0x5003;
   uint32_t values[kRegisterCount];
 
+  static constexpr uint32_t GetGroupMask(RegisterGroup group) {
+    return UINT32_C(1) << uint32_t(group);
+  }
+  static constexpr uint32_t kAllGroupsMask =
+      (UINT32_C(1) << uint32_t(RegisterGroup::kCount)) - 1;
+  // Groups containing the register (RB_MODECONTROL is in multiple).
+  static uint32_t GetRegisterGroupMask(uint32_t index) {
+    return register_group_masks_[index];
+  }
+
+  // Must be called by everything writing the registers, except for writes
+  // that shouldn't invalidate state derived from them. May be called on any
+  // thread, as registers are also written via MMIO by the CPU.
+  void MarkDirty(uint32_t index) {
+    MarkGroupsDirty(register_group_masks_[index]);
+  }
+  void MarkRangeDirty(uint32_t first_index, uint32_t count) {
+    uint32_t dirty_groups = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+      dirty_groups |= register_group_masks_[first_index + i];
+    }
+    MarkGroupsDirty(dirty_groups);
+  }
+  void MarkGroupsDirty(uint32_t group_mask) {
+    // Most registers aren't in any group - skip the locked operation for them.
+    if (group_mask) {
+      dirty_groups_.fetch_or(group_mask, std::memory_order_release);
+    }
+  }
+  uint32_t dirty_groups() const {
+    return dirty_groups_.load(std::memory_order_acquire);
+  }
+  // Returns the groups written since the previous call, and clears them.
+  uint32_t ConsumeDirtyGroups() {
+    return dirty_groups_.exchange(0, std::memory_order_acq_rel);
+  }
+
   const uint32_t& operator[](uint32_t reg) const { return values[reg]; }
   uint32_t& operator[](uint32_t reg) { return values[reg]; }
 
@@ -86,6 +142,13 @@ class RegisterFile {
         sizeof(stream));
     return stream;
   }
+
+ private:
+  static const std::array<uint8_t, kRegisterCount> register_group_masks_;
+  static_assert(uint32_t(RegisterGroup::kCount) <= 8,
+                "Register group masks are stored as bytes");
+
+  std::atomic<uint32_t> dirty_groups_ = kAllGroupsMask;
 };
 
 }  // namespace gpu
@@ -506,19 +506,16 @@ RenderTargetCache::~RenderTargetCache() { ShutdownCommon(); }
 
 void RenderTargetCache::InitializeCommon() {
   assert_true(ownership_ranges_.empty());
-  ownership_ranges_.emplace(
-      std::piecewise_construct, std::forward_as_tuple(uint32_t(0)),
-      std::forward_as_tuple(xenos::kEdramTileCount, RenderTargetKey(),
-                            RenderTargetKey(), RenderTargetKey()));
+  // Enough for a lot of render targets of different formats and
+  // configurations, the array grows if there's more.
+  ownership_ranges_.reserve(256);
+  ResetOwnershipRanges(RenderTargetKey());
 }
 
 void RenderTargetCache::DestroyAllRenderTargets(bool shutting_down) {
   ownership_ranges_.clear();
   if (!shutting_down) {
-    ownership_ranges_.emplace(
-        std::piecewise_construct, std::forward_as_tuple(uint32_t(0)),
-        std::forward_as_tuple(xenos::kEdramTileCount, RenderTargetKey(),
-                              RenderTargetKey(), RenderTargetKey()));
+    ResetOwnershipRanges(RenderTargetKey());
   }
 
   for (const auto& render_target_pair : render_targets_) {
@@ -823,9 +820,7 @@ bool RenderTargetCache::Update(bool is_rasterization_done,
   RenderTarget* rts[1 + xenos::kMaxColorRenderTargets];
   uint32_t rt_lengths_tiles[1 + xenos::kMaxColorRenderTargets];
   uint32_t length_used_tiles_at_32bpp =
-      ((height_used << uint32_t(msaa_samples >= xenos::MsaaSamples::k2X)) +
-       (xenos::kEdramTileHeightSamples - 1)) /
-      xenos::kEdramTileHeightSamples * pitch_tiles_at_32bpp;
+      GetLengthTilesAt32bpp(pitch_tiles_at_32bpp, height_used, msaa_samples);
   for (uint32_t i = 0; i < edram_bases_sorted_count; ++i) {
     const std::pair<uint32_t, uint32_t>& rt_base_index = edram_bases_sorted[i];
     uint32_t rt_base = rt_base_index.first;
@@ -1086,7 +1081,8 @@ void RenderTargetCache::GetResolveCopyRectanglesToDump(
     // Collect render targets owning ranges within the specified rectangle. The
     // first render target in the range may be before the lower_bound, only
     // being in the range with its tail.
-    auto it = ownership_ranges_.lower_bound(extent_start);
+    auto it = ownership_ranges_.cbegin() +
+              GetOwnershipRangeLowerBound(extent_start);
     if (it != ownership_ranges_.cbegin()) {
       auto it_pre = std::prev(it);
       if (it_pre->second.end_tiles > extent_start) {
@@ -1408,32 +1404,32 @@ RenderTargetCache::PrepareFullEdram1280xRenderTargetForSnapshotRestoration(
   }
   // Change ownership, but don't transfer the contents - they will be replaced
   // anyway.
-  ownership_ranges_.clear();
-  ownership_ranges_.emplace(
-      std::piecewise_construct, std::forward_as_tuple(uint32_t(0)),
-      std::forward_as_tuple(xenos::kEdramTileCount, render_target_key,
-                            RenderTargetKey(), RenderTargetKey()));
+  ResetOwnershipRanges(render_target_key);
   return render_target;
 }
 
 void RenderTargetCache::PixelShaderInterlockFullEdramBarrierPlaced() {
   assert_true(GetPath() == Path::kPixelShaderInterlock);
   // Clear ownership - any overlap of data written before the barrier is safe.
-  OwnershipRange empty_range(xenos::kEdramTileCount, RenderTargetKey(),
-                             RenderTargetKey(), RenderTargetKey());
-  if (ownership_ranges_.size() == 1) {
-    // Do not reallocate map elements if not needed (either nothing drawn since
-    // the last barrier, or all of the EDRAM is owned by one render target).
-    // The ownership map contains no gaps - the first element should always be
-    // at 0.
-    assert_true(!ownership_ranges_.begin()->first);
-    OwnershipRange& all_edram_range = ownership_ranges_.begin()->second;
-    assert_true(all_edram_range.end_tiles == xenos::kEdramTileCount);
-    all_edram_range = empty_range;
-    return;
-  }
+  ResetOwnershipRanges(RenderTargetKey());
+}
+
+size_t RenderTargetCache::GetOwnershipRangeLowerBound(uint32_t tiles) const {
+  return size_t(std::lower_bound(
+                    ownership_ranges_.cbegin(), ownership_ranges_.cend(),
+                    tiles,
+                    [](const std::pair<uint32_t, OwnershipRange>& range,
+                       uint32_t tiles) { return range.first < tiles; }) -
+                ownership_ranges_.cbegin());
+}
+
+void RenderTargetCache::ResetOwnershipRanges(RenderTargetKey render_target) {
+  // Keeps the capacity of the array.
   ownership_ranges_.clear();
-  ownership_ranges_.emplace(0, empty_range);
+  ownership_ranges_.emplace_back(
+      std::piecewise_construct, std::forward_as_tuple(uint32_t(0)),
+      std::forward_as_tuple(xenos::kEdramTileCount, render_target,
+                            RenderTargetKey(), RenderTargetKey()));
 }
 
 RenderTargetCache::RenderTarget* RenderTargetCache::GetOrCreateRenderTarget(
@@ -1489,14 +1485,15 @@ bool RenderTargetCache::WouldOwnershipChangeRequireTransfers(
     // same. Find the range starting at >= the start. A portion of the range
     // preceding it may be intersecting the render target's range (or even fully
     // contain it).
-    auto it = ownership_ranges_.lower_bound(extent_start);
-    if (it != ownership_ranges_.begin()) {
+    auto it = ownership_ranges_.cbegin() +
+              GetOwnershipRangeLowerBound(extent_start);
+    if (it != ownership_ranges_.cbegin()) {
       auto it_pre = std::prev(it);
       if (it_pre->second.end_tiles > extent_start) {
         it = it_pre;
       }
     }
-    for (; it != ownership_ranges_.end(); ++it) {
+    for (; it != ownership_ranges_.cend(); ++it) {
       if (it->first >= extent_end) {
         // Outside the touched extent already.
         break;
@@ -1555,25 +1552,29 @@ void RenderTargetCache::ChangeOwnership(
       IsHostDepthEncodingDifferent(dest.GetDepthFormat());
   auto change_ownership_in_extent = [&](uint32_t extent_start,
                                         uint32_t extent_end) {
-    // The map contains consecutive ranges, merged if the adjacent ones are the
-    // same. Find the range starting at >= the start. A portion of the range
+    // The array contains consecutive ranges, merged if the adjacent ones are
+    // the same. Find the range starting at >= the start. A portion of the range
     // preceding it may be intersecting the render target's range (or even fully
     // contain it) - split it into the untouched head and the claimed tail if
     // needed.
-    auto it = ownership_ranges_.lower_bound(extent_start);
-    if (it != ownership_ranges_.begin()) {
-      auto it_pre = std::prev(it);
-      if (it_pre->second.end_tiles > extent_start &&
-          !it_pre->second.IsOwnedBy(dest, host_depth_encoding_different)) {
+    // Indices rather than iterators are used as ranges are inserted and
+    // erased while iterating.
+    size_t index = GetOwnershipRangeLowerBound(extent_start);
+    if (index) {
+      size_t index_pre = index - 1;
+      OwnershipRange range_pre = ownership_ranges_[index_pre].second;
+      if (range_pre.end_tiles > extent_start &&
+          !range_pre.IsOwnedBy(dest, host_depth_encoding_different)) {
         // Different render target overlapping the range - split the head.
-        ownership_ranges_.emplace(extent_start, it_pre->second);
-        it_pre->second.end_tiles = extent_start;
         // Let the next loop do the transfer and needed merging and splitting
         // starting from the added tail.
-        it = std::next(it_pre);
+        ownership_ranges_.emplace(ownership_ranges_.cbegin() + index,
+                                  extent_start, range_pre);
+        ownership_ranges_[index_pre].second.end_tiles = extent_start;
       }
     }
-    while (it != ownership_ranges_.end()) {
+    while (index < ownership_ranges_.size()) {
+      auto it = ownership_ranges_.begin() + index;
       if (it->first >= extent_end) {
         // Outside the touched extent already.
         break;
@@ -1581,14 +1582,16 @@ void RenderTargetCache::ChangeOwnership(
       if (it->second.IsOwnedBy(dest, host_depth_encoding_different)) {
         // Already owned by the needed render target - no need to transfer
         // anything.
-        ++it;
+        ++index;
         continue;
       }
       // Take over the current range. Handle the tail - may be outside the range
       // (split in this case) or within it.
       if (it->second.end_tiles > extent_end) {
         // Split the tail.
-        ownership_ranges_.emplace(extent_end, it->second);
+        OwnershipRange range_tail = it->second;
+        ownership_ranges_.emplace(std::next(it), extent_end, range_tail);
+        it = ownership_ranges_.begin() + index;
         it->second.end_tiles = extent_end;
       }
       if (transfers_append_out) {
@@ -1655,30 +1658,25 @@ void RenderTargetCache::ChangeOwnership(
         it->second.GetHostDepthRenderTarget(dest.GetDepthFormat()) = dest;
       }
       // Check if can merge with the next range after claiming.
-      std::map<uint32_t, OwnershipRange>::iterator it_next;
-      if (it != ownership_ranges_.end()) {
-        it_next = std::next(it);
-        if (it_next != ownership_ranges_.end() &&
-            it_next->second.AreOwnersSame(it->second)) {
-          // Merge with the next range.
-          it->second.end_tiles = it_next->second.end_tiles;
-          auto it_after = std::next(it_next);
-          ownership_ranges_.erase(it_next);
-          it_next = it_after;
-        }
-      } else {
-        it_next = ownership_ranges_.end();
+      size_t index_next = index + 1;
+      if (index_next < ownership_ranges_.size() &&
+          ownership_ranges_[index_next].second.AreOwnersSame(it->second)) {
+        // Merge with the next range.
+        it->second.end_tiles = ownership_ranges_[index_next].second.end_tiles;
+        ownership_ranges_.erase(std::next(it));
+        it = ownership_ranges_.begin() + index;
       }
       // Check if can merge with the previous range after claiming and merging
       // with the next (thus obtaining the correct end pointer).
-      if (it != ownership_ranges_.begin()) {
+      if (index) {
         auto it_prev = std::prev(it);
         if (it_prev->second.AreOwnersSame(it->second)) {
           it_prev->second.end_tiles = it->second.end_tiles;
           ownership_ranges_.erase(it);
+          --index_next;
         }
       }
-      it = it_next;
+      index = index_next;
     }
   };
   // start_tiles_base_relative may already be in the next 11 bits - wrap the
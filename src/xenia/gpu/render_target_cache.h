@@ -13,7 +13,6 @@
 #include <cmath>
 #include <cstdint>
 #include <functional>
-#include <map>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -616,14 +615,17 @@ class RenderTargetCache {
   // EDRAM memory are committed with a memory barrier.
   void PixelShaderInterlockFullEdramBarrierPlaced();
 
- private:
-  const RegisterFile& register_file_;
-  uint32_t draw_resolution_scale_x_;
-  uint32_t draw_resolution_scale_y_;
-
-  DrawExtentEstimator draw_extent_estimator_;
+  // EDRAM ownership tracking, accessible to subclasses primarily for testing.
 
-  // For host render targets.
+  // Tiles of the EDRAM covered by the rows [0, height) of a render target at
+  // 32bpp - twice as many for 64bpp.
+  static constexpr uint32_t GetLengthTilesAt32bpp(
+      uint32_t pitch_tiles_at_32bpp, uint32_t height,
+      xenos::MsaaSamples msaa_samples) {
+    return ((height << uint32_t(msaa_samples >= xenos::MsaaSamples::k2X)) +
+            (xenos::kEdramTileHeightSamples - 1)) /
+           xenos::kEdramTileHeightSamples * pitch_tiles_at_32bpp;
+  }
 
   struct OwnershipRange {
     uint32_t end_tiles;
@@ -697,17 +699,12 @@ class RenderTargetCache {
     }
   };
 
-  static constexpr xenos::ColorRenderTargetFormat GetColorResourceFormat(
-      xenos::ColorRenderTargetFormat format) {
-    // sRGB, if used on the host, is a view property or global state - linear
-    // and sRGB host render targets can share data directly without transfers.
-    if (format == xenos::ColorRenderTargetFormat::k_8_8_8_8_GAMMA) {
-      return xenos::ColorRenderTargetFormat::k_8_8_8_8;
-    }
-    return xenos::GetStorageColorFormat(format);
+  // Sorted by the start tile, with no gaps.
+  const std::vector<std::pair<uint32_t, OwnershipRange>>& ownership_ranges()
+      const {
+    return ownership_ranges_;
   }
-
-  RenderTarget* GetOrCreateRenderTarget(RenderTargetKey key);
+  void ResetOwnershipRanges(RenderTargetKey render_target);
 
   // Checks if changing ownership of the range to the specified render target
   // would require transferring data - primarily for barrier placement on the
@@ -725,18 +722,42 @@ class RenderTargetCache {
       uint32_t length_tiles, std::vector<Transfer>* transfers_append_out,
       const Transfer::Rectangle* resolve_clear_cutout = nullptr);
 
+ private:
+  const RegisterFile& register_file_;
+  uint32_t draw_resolution_scale_x_;
+  uint32_t draw_resolution_scale_y_;
+
+  DrawExtentEstimator draw_extent_estimator_;
+
+  // For host render targets.
+
+  static constexpr xenos::ColorRenderTargetFormat GetColorResourceFormat(
+      xenos::ColorRenderTargetFormat format) {
+    // sRGB, if used on the host, is a view property or global state - linear
+    // and sRGB host render targets can share data directly without transfers.
+    if (format == xenos::ColorRenderTargetFormat::k_8_8_8_8_GAMMA) {
+      return xenos::ColorRenderTargetFormat::k_8_8_8_8;
+    }
+    return xenos::GetStorageColorFormat(format);
+  }
+
+  RenderTarget* GetOrCreateRenderTarget(RenderTargetKey key);
+
+  // Index of the first range in ownership_ranges_ starting at or after the
+  // tile, or the number of the ranges if there's none.
+  size_t GetOwnershipRangeLowerBound(uint32_t tiles) const;
+
   // If failed to create, may contain nullptr to prevent attempting to create a
   // render target twice.
   std::unordered_map<RenderTargetKey, RenderTarget*, RenderTargetKey::Hasher>
       render_targets_;
 
-  // Map of host render targets currently containing the most up-to-date version
-  // of the tile. Has no gaps, unused parts are represented by empty render
-  // target keys.
-  // TODO(Triang3l): Pool allocator (or a custom red-black tree with one even),
-  // since standard containers use dynamic allocation for elements, though
-  // changes to this throughout a frame are pretty rare.
-  std::map<uint32_t, OwnershipRange> ownership_ranges_;
+  // Host render targets currently containing the most up-to-date version of
+  // the tile, as ranges sorted by the start tile. Has no gaps, unused parts are
+  // represented by empty render target keys. There are usually only a few
+  // dozen ranges, so a flat array is searched and modified faster than a tree,
+  // with no allocations for the ranges being split and merged.
+  std::vector<std::pair<uint32_t, OwnershipRange>> ownership_ranges_;
 
   // Render targets actually used by the draw call with the last successful
   // update. 0 is depth, color starting from 1, nullptr if not bound.
@@ -7,22 +7,33 @@
  ******************************************************************************
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstring>
+#include <map>
+#include <set>
 #include <sstream>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "third_party/glslang/SPIRV/disassemble.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/byte_order.h"
+#include "xenia/base/clock.h"
 #include "xenia/base/console_app_main.h"
 #include "xenia/base/cvar.h"
+#include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
 #include "xenia/base/string.h"
 #include "xenia/base/string_buffer.h"
+#include "xenia/base/threading.h"
+#include "xenia/base/xxhash.h"
 #include "xenia/gpu/dxbc_shader_translator.h"
+#include "xenia/gpu/shader_storage.h"
 #include "xenia/gpu/shader_translator.h"
 #include "xenia/gpu/spirv_shader_translator.h"
 #include "xenia/gpu/xenos.h"
@@ -59,11 +70,341 @@ DEFINE_bool(
     "Output host shader with a render backend implementation based on pixel "
     "shader interlock.",
     "GPU");
+DEFINE_path(
+    shader_storage_input, "",
+    "Guest shader storage file (.xsh) of a title to translate all shaders from "
+    "on all CPU cores instead of translating --shader_input. Requires "
+    "--shader_output_type to be spirv or dxbc.",
+    "GPU");
+DEFINE_path(
+    shader_storage_pipelines, "",
+    "Direct3D 12 pipeline storage file (.xpso) of the same title to take the "
+    "shader modifications to translate from for DXBC output. If not "
+    "specified, or for SPIR-V output, each shader is translated with the "
+    "default modification.",
+    "GPU");
+DEFINE_path(shader_storage_output, "",
+            "Directory to write the translated shaders from "
+            "--shader_storage_input to.",
+            "GPU");
+DEFINE_bool(shader_storage_validate, false,
+            "Validate the SPIR-V translated from --shader_storage_input with "
+            "SPIRV-Tools.",
+            "GPU");
+DEFINE_int32(shader_storage_threads, 0,
+             "Number of threads for translating --shader_storage_input, 0 to "
+             "use all logical CPU cores.",
+             "GPU");
 
 namespace xe {
 namespace gpu {
 
+namespace {
+
+// Reads the modifications of the shaders used by the pipelines in a Direct3D 12
+// pipeline storage file, keyed by the ucode data hash.
+bool ReadPipelineStorageModifications(
+    const std::filesystem::path& path, bool& edram_rov_used_out,
+    std::map<uint64_t, std::set<uint64_t>>& modifications_out) {
+  FILE* file = filesystem::OpenFile(path, "rb");
+  if (!file) {
+    XELOGE("Unable to open the pipeline storage file: {}",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  struct {
+    uint32_t magic;
+    uint32_t magic_api;
+    uint32_t version_swapped;
+  } file_header;
+  if (!fread(&file_header, sizeof(file_header), 1, file) ||
+      file_header.magic != kPipelineStorageMagic ||
+      (file_header.magic_api != kPipelineStorageMagicApiD3D12Rov &&
+       file_header.magic_api != kPipelineStorageMagicApiD3D12Rtv) ||
+      xe::byte_swap(file_header.version_swapped) !=
+          std::max(kD3D12PipelineDescriptionVersion,
+                   DxbcShaderTranslator::Modification::kVersion)) {
+    XELOGE(
+        "{} is not a Direct3D 12 pipeline storage file of the version "
+        "supported by this build",
+        xe::path_to_utf8(path));
+    fclose(file);
+    return false;
+  }
+  edram_rov_used_out =
+      file_header.magic_api == kPipelineStorageMagicApiD3D12Rov;
+  uint8_t description[kD3D12PipelineStoredDescriptionSize];
+  size_t description_count = 0;
+  while (fread(description, sizeof(description), 1, file)) {
+    PipelineStoredShaders shaders;
+    std::memcpy(&shaders, description, sizeof(shaders));
+    // Stop at the first corrupted description like the emulator does.
+    if (XXH3_64bits(description + sizeof(shaders.description_hash),
+                    sizeof(description) - sizeof(shaders.description_hash)) !=
+        shaders.description_hash) {
+      XELOGW("Pipeline storage is corrupted after {} descriptions",
+             description_count);
+      break;
+    }
+    modifications_out[shaders.vertex_shader_hash].insert(
+        shaders.vertex_shader_modification);
+    if (shaders.pixel_shader_hash) {
+      modifications_out[shaders.pixel_shader_hash].insert(
+          shaders.pixel_shader_modification);
+    }
+    ++description_count;
+  }
+  fclose(file);
+  XELOGI("Read {} pipeline descriptions from {}", description_count,
+         xe::path_to_utf8(path));
+  return true;
+}
+
+bool ReadShaderStorage(const std::filesystem::path& path,
+                       std::vector<std::unique_ptr<Shader>>& shaders_out) {
+  FILE* file = filesystem::OpenFile(path, "rb");
+  if (!file) {
+    XELOGE("Unable to open the shader storage file: {}",
+           xe::path_to_utf8(path));
+    return false;
+  }
+  struct {
+    uint32_t magic;
+    uint32_t version_swapped;
+  } file_header;
+  if (!fread(&file_header, sizeof(file_header), 1, file) ||
+      file_header.magic != kShaderStorageMagic ||
+      xe::byte_swap(file_header.version_swapped) !=
+          ShaderStoredHeader::kVersion) {
+    XELOGE(
+        "{} is not a shader storage file of the version supported by this "
+        "build",
+        xe::path_to_utf8(path));
+    fclose(file);
+    return false;
+  }
+  std::unordered_set<uint64_t> ucode_data_hashes;
+  ShaderStoredHeader shader_header;
+  std::vector<uint32_t> ucode_dwords;
+  ucode_dwords.reserve(0xFFFF);
+  while (fread(&shader_header, sizeof(shader_header), 1, file)) {
+    size_t ucode_byte_count =
+        shader_header.ucode_dword_count * sizeof(uint32_t);
+    ucode_dwords.resize(shader_header.ucode_dword_count);
+    if (shader_header.ucode_dword_count &&
+        !fread(ucode_dwords.data(), ucode_byte_count, 1, file)) {
+      break;
+    }
+    if (XXH3_64bits(ucode_dwords.data(), ucode_byte_count) !=
+        shader_header.ucode_data_hash) {
+      // Stop at the first corrupted shader like the emulator does.
+      XELOGW("Shader storage is corrupted after {} shaders",
+             shaders_out.size());
+      break;
+    }
+    if (!ucode_data_hashes.emplace(shader_header.ucode_data_hash).second) {
+      continue;
+    }
+    shaders_out.push_back(std::make_unique<Shader>(
+        shader_header.type, shader_header.ucode_data_hash, ucode_dwords.data(),
+        ucode_dwords.size()));
+  }
+  fclose(file);
+  return true;
+}
+
+// Translates every shader in --shader_storage_input with every modification
+// known for it, writing each translation to a separate file in
+// --shader_storage_output.
+int CompileShaderStorage() {
+  bool output_spirv = cvars::shader_output_type == "spirv";
+  if (!output_spirv && cvars::shader_output_type != "dxbc") {
+    XELOGE(
+        "--shader_storage_input requires --shader_output_type to be spirv or "
+        "dxbc");
+    return 1;
+  }
+
+  bool edram_rov_used = cvars::shader_output_pixel_shader_interlock;
+  std::map<uint64_t, std::set<uint64_t>> stored_modifications;
+  if (!output_spirv && !cvars::shader_storage_pipelines.empty() &&
+      !ReadPipelineStorageModifications(cvars::shader_storage_pipelines,
+                                        edram_rov_used,
+                                        stored_modifications)) {
+    return 1;
+  }
+
+  std::vector<std::unique_ptr<Shader>> shaders;
+  if (!ReadShaderStorage(cvars::shader_storage_input, shaders)) {
+    return 1;
+  }
+  XELOGI("Read {} shaders from {}", shaders.size(),
+         xe::path_to_utf8(cvars::shader_storage_input));
+
+  if (!cvars::shader_storage_output.empty() &&
+      !std::filesystem::exists(cvars::shader_storage_output) &&
+      !std::filesystem::create_directories(cvars::shader_storage_output)) {
+    XELOGE("Unable to create the output directory: {}",
+           xe::path_to_utf8(cvars::shader_storage_output));
+    return 1;
+  }
+
+  struct TranslationResult {
+    uint64_t ucode_data_hash;
+    uint64_t modification;
+    xenos::ShaderType type;
+    uint64_t translation_time_us;
+    bool valid;
+  };
+  std::vector<std::vector<TranslationResult>> shader_results(shaders.size());
+  std::atomic<size_t> next_shader_index = 0;
+  SpirvShaderTranslator::Features spirv_features(true);
+
+  auto thread_function = [&]() {
+    std::unique_ptr<ShaderTranslator> translator;
+    std::unique_ptr<ui::vulkan::SpirvToolsContext> spirv_tools_context;
+    if (output_spirv) {
+      translator = std::make_unique<SpirvShaderTranslator>(
+          spirv_features, true, true, edram_rov_used);
+      if (cvars::shader_storage_validate) {
+        spirv_tools_context =
+            std::make_unique<ui::vulkan::SpirvToolsContext>();
+        if (!spirv_tools_context->Initialize(spirv_features.spirv_version)) {
+          spirv_tools_context.reset();
+        }
+      }
+    } else {
+      translator = std::make_unique<DxbcShaderTranslator>(
+          ui::GraphicsProvider::GpuVendorID(0),
+          cvars::shader_output_bindless_resources, edram_rov_used);
+    }
+    StringBuffer ucode_disasm_buffer;
+    std::string spirv_validation_error;
+    uint64_t tick_frequency = xe::Clock::QueryHostTickFrequency();
+    for (;;) {
+      size_t shader_index = next_shader_index.fetch_add(1);
+      if (shader_index >= shaders.size()) {
+        break;
+      }
+      Shader& shader = *shaders[shader_index];
+      shader.AnalyzeUcode(ucode_disasm_buffer);
+      std::vector<uint64_t> modifications;
+      auto stored_modifications_it =
+          stored_modifications.find(shader.ucode_data_hash());
+      if (stored_modifications_it != stored_modifications.end()) {
+        modifications.assign(stored_modifications_it->second.cbegin(),
+                             stored_modifications_it->second.cend());
+      } else if (shader.type() == xenos::ShaderType::kVertex) {
+        modifications.push_back(translator->GetDefaultVertexShaderModification(
+            xenos::kMaxShaderTempRegisters,
+            Shader::HostVertexShaderType::kVertex));
+      } else {
+        modifications.push_back(translator->GetDefaultPixelShaderModification(
+            xenos::kMaxShaderTempRegisters));
+      }
+      for (uint64_t modification : modifications) {
+        Shader::Translation& translation =
+            *shader.GetOrCreateTranslation(modification);
+        uint64_t translation_start = xe::Clock::QueryHostTickCount();
+        bool valid = translator->TranslateAnalyzedShader(translation);
+        uint64_t translation_time_us =
+            (xe::Clock::QueryHostTickCount() - translation_start) * 1000000 /
+            tick_frequency;
+        const std::vector<uint8_t>& binary = translation.translated_binary();
+        if (valid && spirv_tools_context) {
+          spirv_validation_error.clear();
+          spirv_tools_context->Validate(
+              reinterpret_cast<const uint32_t*>(binary.data()),
+              binary.size() / sizeof(uint32_t), &spirv_validation_error);
+          if (!spirv_validation_error.empty()) {
+            XELOGE("Shader {:016X} modification {:016X} is invalid: {}",
+                   shader.ucode_data_hash(), modification,
+                   spirv_validation_error);
+            valid = false;
+          }
+        }
+        if (valid && !cvars::shader_storage_output.empty()) {
+          std::filesystem::path output_path =
+              cvars::shader_storage_output /
+              fmt::format(
+                  "{:016X}.{:016X}.{}.{}", shader.ucode_data_hash(),
+                  modification,
+                  shader.type() == xenos::ShaderType::kVertex ? "vs" : "ps",
+                  output_spirv ? "spv" : "dxbc");
+          FILE* output_file = filesystem::OpenFile(output_path, "wb");
+          if (output_file) {
+            fwrite(binary.data(), 1, binary.size(), output_file);
+            fclose(output_file);
+          } else {
+            XELOGE("Unable to open the output file: {}",
+                   xe::path_to_utf8(output_path));
+          }
+        }
+        shader_results[shader_index].push_back(
+            {shader.ucode_data_hash(), modification, shader.type(),
+             translation_time_us, valid});
+        // The translation is not needed anymore, don't keep all of them in
+        // memory.
+        shader.DestroyTranslation(modification);
+      }
+    }
+  };
+
+  uint32_t thread_count = xe::threading::logical_processor_count();
+  if (cvars::shader_storage_threads > 0) {
+    thread_count = uint32_t(cvars::shader_storage_threads);
+  }
+  thread_count = std::max(thread_count, uint32_t(1));
+  uint64_t start = xe::Clock::QueryHostTickCount();
+  std::vector<std::unique_ptr<xe::threading::Thread>> threads;
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    auto thread = xe::threading::Thread::Create({}, thread_function);
+    assert_not_null(thread);
+    thread->set_name("Shader Translation");
+    threads.push_back(std::move(thread));
+  }
+  for (auto& thread : threads) {
+    xe::threading::Wait(thread.get(), false);
+  }
+  uint64_t total_time_ms = (xe::Clock::QueryHostTickCount() - start) * 1000 /
+                           xe::Clock::QueryHostTickFrequency();
+
+  // Report the translation times, slowest first.
+  std::vector<TranslationResult> results;
+  for (const std::vector<TranslationResult>& results_of_shader :
+       shader_results) {
+    results.insert(results.cend(), results_of_shader.cbegin(),
+                   results_of_shader.cend());
+  }
+  std::sort(results.begin(), results.end(),
+            [](const TranslationResult& a, const TranslationResult& b) {
+              return a.translation_time_us > b.translation_time_us;
+            });
+  size_t failed_count = 0;
+  for (const TranslationResult& result : results) {
+    XELOGI("{} shader {:016X} modification {:016X}: {} us{}",
+           result.type == xenos::ShaderType::kVertex ? "Vertex" : "Pixel",
+           result.ucode_data_hash, result.modification,
+           result.translation_time_us, result.valid ? "" : ", failed");
+    if (!result.valid) {
+      ++failed_count;
+    }
+  }
+  XELOGI(
+      "Translated {} shader modifications of {} shaders on {} threads in {} "
+      "ms, {} failed",
+      results.size(), shaders.size(), thread_count, total_time_ms,
+      failed_count);
+  return failed_count ? 1 : 0;
+}
+
+}  // namespace
+
 int shader_compiler_main(const std::vector<std::string>& args) {
+  if (!cvars::shader_storage_input.empty()) {
+    return CompileShaderStorage();
+  }
+
   xenos::ShaderType shader_type;
   if (!cvars::shader_input_type.empty()) {
     if (cvars::shader_input_type == "vs") {
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_SHADER_STORAGE_H_
+#define XENIA_GPU_SHADER_STORAGE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "xenia/base/platform.h"
+#include "xenia/gpu/xenos.h"
+
+namespace xe {
+namespace gpu {
+
+// Layout of the persistent shader storage files, shared by the backends that
+// write them and the offline tools reading them.
+
+// The guest shader storage (.xsh) - the file header followed by the shaders,
+// each being a ShaderStoredHeader and the ucode in the guest endianness, with
+// the XXH3 hash of the ucode bytes as the ucode data hash.
+// 'XESH'.
+constexpr uint32_t kShaderStorageMagic = 0x48534558;
+
+XEPACKEDSTRUCT(ShaderStoredHeader, {
+  uint64_t ucode_data_hash;
+
+  uint32_t ucode_dword_count : 31;
+  xenos::ShaderType type : 1;
+
+  static constexpr uint32_t kVersion = 0x20201219;
+});
+
+// The pipeline description storage (.xpso) - the file header followed by the
+// descriptions of the host API. The version is the maximum of the version of
+// the description and of the shader modification of the host API.
+// 'XEPS'.
+constexpr uint32_t kPipelineStorageMagic = 0x53504558;
+// 'DXRO' - Direct3D 12 with rasterizer-ordered views.
+constexpr uint32_t kPipelineStorageMagicApiD3D12Rov = 0x4F525844;
+// 'DXRT' - Direct3D 12 with host render targets.
+constexpr uint32_t kPipelineStorageMagicApiD3D12Rtv = 0x54525844;
+
+// Every stored pipeline description begins with the hash of the description
+// and the shaders it uses.
+XEPACKEDSTRUCT(PipelineStoredShaders, {
+  uint64_t description_hash;
+  uint64_t vertex_shader_hash;
+  uint64_t vertex_shader_modification;
+  // 0 if drawing without a pixel shader.
+  uint64_t pixel_shader_hash;
+  uint64_t pixel_shader_modification;
+});
+
+// Version and size of the Direct3D 12 pipeline descriptions, checked in the
+// Direct3D 12 pipeline cache.
+constexpr uint32_t kD3D12PipelineDescriptionVersion = 0x20210425;
+constexpr size_t kD3D12PipelineStoredDescriptionSize = 72;
+
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_SHADER_STORAGE_H_
@@ -0,0 +1,176 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/gpu/shader_translation_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/string_buffer.h"
+
+DEFINE_int32(
+    gpu_shader_translation_threads, -1,
+    "Number of threads used for translating guest shaders in the background. "
+    "-1 to calculate automatically (25% of logical CPU cores), a positive "
+    "number to specify the number of threads explicitly (up to the number of "
+    "logical CPU cores), 0 to translate shaders only on the GPU command "
+    "processor thread when they're drawn.",
+    "GPU");
+
+namespace xe {
+namespace gpu {
+
+void ShaderTranslationPool::Initialize(WorkerFactory worker_factory) {
+  Shutdown();
+  if (!cvars::gpu_shader_translation_threads) {
+    return;
+  }
+  uint32_t logical_processor_count = xe::threading::logical_processor_count();
+  if (!logical_processor_count) {
+    // Pick some reasonable amount if couldn't determine the number of cores.
+    logical_processor_count = 6;
+  }
+  size_t thread_count;
+  if (cvars::gpu_shader_translation_threads < 0) {
+    thread_count = std::max(logical_processor_count / 4, uint32_t(1));
+  } else {
+    thread_count = std::min(uint32_t(cvars::gpu_shader_translation_threads),
+                            logical_processor_count);
+  }
+  worker_factory_ = std::move(worker_factory);
+  shutdown_ = false;
+  for (size_t i = 0; i < thread_count; ++i) {
+    std::unique_ptr<xe::threading::Thread> thread =
+        xe::threading::Thread::Create({}, [this]() { WorkerThread(); });
+    assert_not_null(thread);
+    thread->set_name("Shader Translation");
+    threads_.push_back(std::move(thread));
+  }
+}
+
+void ShaderTranslationPool::Shutdown() {
+  if (threads_.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    // Drop the work not started yet - only wait for the running requests.
+    for (const Request& request : requests_) {
+      shaders_in_use_.erase(request.shader);
+    }
+    requests_.clear();
+  }
+  request_cond_.notify_all();
+  for (auto& thread : threads_) {
+    xe::threading::Wait(thread.get(), false);
+  }
+  threads_.clear();
+  assert_true(shaders_in_use_.empty());
+  shaders_in_use_.clear();
+  worker_factory_ = nullptr;
+}
+
+void ShaderTranslationPool::Prefetch(Shader& shader,
+                                     std::optional<uint64_t> last_modification,
+                                     uint32_t program_cntl_num_reg) {
+  if (!is_active()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // If the shader is in use, it's already being prefetched - loaded by the
+    // guest multiple times before being drawn. Not accessing the analysis
+    // state in this case as a worker may be writing it.
+    if (shaders_in_use_.count(&shader) || shader.is_ucode_analyzed()) {
+      return;
+    }
+    Request& request = requests_.emplace_back();
+    request.shader = &shader;
+    request.translation = nullptr;
+    request.last_modification = last_modification;
+    request.program_cntl_num_reg = program_cntl_num_reg;
+    shaders_in_use_.insert(&shader);
+  }
+  request_cond_.notify_one();
+}
+
+void ShaderTranslationPool::Translate(Shader::Translation& translation) {
+  assert_true(is_active());
+  assert_true(translation.shader().is_ucode_analyzed());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    [[maybe_unused]] bool shader_inserted =
+        shaders_in_use_.insert(&translation.shader()).second;
+    assert_true(shader_inserted);
+    Request& request = requests_.emplace_back();
+    request.shader = &translation.shader();
+    request.translation = &translation;
+    request.program_cntl_num_reg = 0;
+  }
+  request_cond_.notify_one();
+}
+
+void ShaderTranslationPool::WaitForShader(const Shader& shader) {
+  if (!is_active()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  completion_cond_.wait(
+      lock, [this, &shader]() { return !shaders_in_use_.count(&shader); });
+}
+
+void ShaderTranslationPool::WaitForIdle() {
+  if (!is_active()) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  completion_cond_.wait(lock, [this]() { return shaders_in_use_.empty(); });
+}
+
+void ShaderTranslationPool::WorkerThread() {
+  std::unique_ptr<Worker> worker = worker_factory_();
+  StringBuffer ucode_disasm_buffer;
+  for (;;) {
+    Request request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      request_cond_.wait(
+          lock, [this]() { return shutdown_ || !requests_.empty(); });
+      if (shutdown_) {
+        break;
+      }
+      request = requests_.front();
+      requests_.pop_front();
+    }
+
+    Shader& shader = *request.shader;
+    if (!shader.is_ucode_analyzed()) {
+      shader.AnalyzeUcode(ucode_disasm_buffer);
+    }
+    Shader::Translation* translation = request.translation;
+    if (!translation && request.last_modification.has_value()) {
+      translation = shader.GetOrCreateTranslation(worker->PredictModification(
+          shader, *request.last_modification, request.program_cntl_num_reg));
+    }
+    if (translation && !translation->is_translated()) {
+      worker->Translate(*translation);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shaders_in_use_.erase(&shader);
+    }
+    completion_cond_.notify_all();
+  }
+}
+
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_SHADER_TRANSLATION_POOL_H_
+#define XENIA_GPU_SHADER_TRANSLATION_POOL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
+#include <vector>
+
+#include "xenia/base/cvar.h"
+#include "xenia/base/threading.h"
+#include "xenia/gpu/shader.h"
+
+DECLARE_int32(gpu_shader_translation_threads);
+
+namespace xe {
+namespace gpu {
+
+// Threads translating shaders in the background for a pipeline cache, each
+// with its own translator, so new shaders don't block the command processor
+// thread while it could be doing other work.
+//
+// Shaders loaded by the guest are analyzed and translated with a guessed
+// modification as soon as their microcode is received, and translations
+// requested by the command processor run alongside its own work. While a
+// shader has work queued or in progress, it's owned by the pool - the command
+// processor thread must call WaitForShader before accessing its analysis or
+// translations.
+class ShaderTranslationPool {
+ public:
+  // Shader state on the worker threads, created on the thread that uses it.
+  class Worker {
+   public:
+    virtual ~Worker() = default;
+    // Called for an analyzed shader, must mark the translation as invalid if
+    // failed.
+    virtual bool Translate(Shader::Translation& translation) = 0;
+    // Returns the modification the shader will likely be drawn with, from the
+    // modification of the previous draw's shader of the same type. Called
+    // after analysis.
+    virtual uint64_t PredictModification(const Shader& shader,
+                                         uint64_t last_modification,
+                                         uint32_t program_cntl_num_reg) = 0;
+  };
+  using WorkerFactory = std::function<std::unique_ptr<Worker>()>;
+
+  ~ShaderTranslationPool() { Shutdown(); }
+
+  // Creates the threads according to --gpu_shader_translation_threads. Doesn't
+  // create any if disabled, in which case the pool is inactive.
+  void Initialize(WorkerFactory worker_factory);
+  // Drops the work not started yet and waits for the threads to exit. Must be
+  // called before destroying any shader that may be used by the pool.
+  void Shutdown();
+
+  bool is_active() const { return !threads_.empty(); }
+
+  // Queues analysis and translation of a shader loaded by the guest if it
+  // hasn't been analyzed yet. last_modification is the modification of the
+  // previous draw's shader of the same type - if not known yet, the shader is
+  // only analyzed.
+  void Prefetch(Shader& shader, std::optional<uint64_t> last_modification,
+                uint32_t program_cntl_num_reg);
+  // Queues translation of an analyzed shader that has no other work in the
+  // pool.
+  void Translate(Shader::Translation& translation);
+  // Waits until the pool has no more work for the shader.
+  void WaitForShader(const Shader& shader);
+  // Waits until all the queued work is done.
+  void WaitForIdle();
+
+ private:
+  struct Request {
+    Shader* shader;
+    // If null, the translation is created after the analysis for the
+    // modification predicted from last_modification, if it's known.
+    Shader::Translation* translation;
+    std::optional<uint64_t> last_modification;
+    uint32_t program_cntl_num_reg;
+  };
+
+  void WorkerThread();
+
+  WorkerFactory worker_factory_;
+
+  std::mutex mutex_;
+  // Notified when a request is added or the threads need to exit.
+  std::condition_variable request_cond_;
+  // Notified when the work for a shader is done.
+  std::condition_variable completion_cond_;
+  // Protected with mutex_.
+  std::deque<Request> requests_;
+  // Shaders with a queued or running request (only one at a time), protected
+  // with mutex_.
+  std::unordered_set<const Shader*> shaders_in_use_;
+  bool shutdown_ = false;
+
+  std::vector<std::unique_ptr<xe::threading::Thread>> threads_;
+};
+
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_SHADER_TRANSLATION_POOL_H_
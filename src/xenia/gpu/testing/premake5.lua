@@ -0,0 +1,23 @@
+project_root = "../../../.."
+include(project_root.."/tools/build")
+
+test_suite("xenia-gpu-tests", project_root, ".", {
+  links = {
+    "capstone",
+    "dxbc",
+    "fmt",
+    "glslang-spirv",
+    "imgui",
+    "snappy",
+    "xenia-base",
+    "xenia-core",
+    "xenia-cpu",
+    "xenia-gpu",
+    "xenia-ui",
+    "xxhash",
+    "zstd",
+  },
+  includedirs = {
+    project_root.."/third_party/Vulkan-Headers/include",
+  },
+})
@@ -0,0 +1,523 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "xenia/base/platform.h"
+#include "xenia/gpu/primitive_processor.h"
+
+#include "third_party/catch/include/catch.hpp"
+#include "third_party/fmt/include/fmt/format.h"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+// Exposes the index processing functions of the primitive processor, never
+// instantiated.
+class PrimitiveProcessorKernels : public PrimitiveProcessor {
+ public:
+  using PrimitiveProcessor::Get16BitResetIndexUsage;
+  using PrimitiveProcessor::GetChunkSize;
+  using PrimitiveProcessor::IsResetUsed;
+  using PrimitiveProcessor::kChunkMinElements;
+  using PrimitiveProcessor::PassthroughIndexTransform;
+  using PrimitiveProcessor::QuadListToTriangleList;
+  using PrimitiveProcessor::ReplaceResetIndex16To16;
+  using PrimitiveProcessor::ReplaceResetIndex16To24;
+  using PrimitiveProcessor::ReplaceResetIndex32To24;
+  using PrimitiveProcessor::TriangleFanToList;
+  using PrimitiveProcessor::TriangleFanToListTriangles;
+#if XE_ARCH_AMD64
+  using PrimitiveProcessor::AreAVX2KernelsSupported;
+  using PrimitiveProcessor::AreAVX512KernelsSupported;
+  using PrimitiveProcessor::Get16BitResetIndexUsageAVX2;
+  using PrimitiveProcessor::IsResetUsedAVX2;
+  using PrimitiveProcessor::ReplaceResetIndex16To16AVX2;
+  using PrimitiveProcessor::ReplaceResetIndex16To16AVX512;
+  using PrimitiveProcessor::ReplaceResetIndex16To24AVX2;
+  using PrimitiveProcessor::ReplaceResetIndex16To24AVX512;
+  using PrimitiveProcessor::ReplaceResetIndex32To24AVX2;
+  using PrimitiveProcessor::ReplaceResetIndex32To24AVX512;
+#endif  // XE_ARCH_AMD64
+};
+
+using Kernels = PrimitiveProcessorKernels;
+
+// Non-SIMD reference implementations.
+
+static void ReferenceReplaceResetIndex16To16(uint16_t* dest,
+                                             const uint16_t* source,
+                                             uint32_t count,
+                                             uint16_t reset_index) {
+  for (uint32_t i = 0; i < count; ++i) {
+    dest[i] = source[i] != reset_index ? source[i] : UINT16_MAX;
+  }
+}
+
+static void ReferenceReplaceResetIndex16To24(uint32_t* dest,
+                                             const uint16_t* source,
+                                             uint32_t count,
+                                             uint16_t reset_index) {
+  for (uint32_t i = 0; i < count; ++i) {
+    dest[i] = source[i] != reset_index ? source[i] : UINT32_MAX;
+  }
+}
+
+static void ReferenceReplaceResetIndex32To24(uint32_t* dest,
+                                             const uint32_t* source,
+                                             uint32_t count,
+                                             uint32_t reset_index,
+                                             uint32_t low_bits_mask,
+                                             xenos::Endian host_swap) {
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t index = source[i] & low_bits_mask;
+    dest[i] = index != reset_index ? xenos::GpuSwapInline(index, host_swap)
+                                   : UINT32_MAX;
+  }
+}
+
+// Sentinel elements after the destination range to detect overruns.
+constexpr uint32_t kGuardElements = 64;
+constexpr uint16_t kGuard16 = 0xABCD;
+constexpr uint32_t kGuard32 = 0xABCDEF01;
+
+// Source data with enough reset indices and 0xFFFF to cover all the paths, with
+// extra elements in the end for testing different alignments.
+struct TestIndices {
+  TestIndices(std::mt19937& random, uint32_t count_max) {
+    indices_16.resize(count_max + 64);
+    indices_32.resize(count_max + 64);
+    for (uint16_t& index : indices_16) {
+      uint32_t kind = random() % 8;
+      index = kind == 0 ? kReset16 : (kind == 1 ? UINT16_MAX : random());
+    }
+    for (uint32_t& index : indices_32) {
+      // Upper 8 bits, ignored by the GPU, are random in the reset indices too.
+      uint32_t kind = random() % 8;
+      index = kind == 0 ? (kReset32 | (random() & 0xFF000000)) : random();
+    }
+  }
+  static constexpr uint16_t kReset16 = 0x1234;
+  static constexpr uint32_t kReset32 = 0x00ABCDEF;
+  std::vector<uint16_t> indices_16;
+  std::vector<uint32_t> indices_32;
+};
+
+template <typename Index>
+static void RequireEqual(const std::vector<Index>& result,
+                         const std::vector<Index>& reference, Index guard) {
+  REQUIRE(result.size() == reference.size() + kGuardElements);
+  for (size_t i = 0; i < reference.size(); ++i) {
+    if (result[i] != reference[i]) {
+      FAIL(fmt::format("Mismatch at {}: 0x{:X} instead of 0x{:X}", i,
+                       result[i], reference[i]));
+    }
+  }
+  for (size_t i = reference.size(); i < result.size(); ++i) {
+    if (result[i] != guard) {
+      FAIL(fmt::format("Overrun at {}", i));
+    }
+  }
+}
+
+// Counts up to 128 to cover the vector remainders, and large ones.
+static const uint32_t kTestCounts[] = {
+    0,  1,  2,  3,  4,   5,   7,    8,    9,    15,   16,   17,
+    31, 32, 33, 63, 64,  65,  127,  128,  1000, 1001, 4099, 65535};
+static const uint32_t kTestOffsets[] = {0, 1, 3, 8, 17, 32};
+
+TEST_CASE("Primitive processor reset index replacement",
+          "[primitive_processor]") {
+#if XE_ARCH_AMD64
+  amd64::InitFeatureFlags();
+#endif  // XE_ARCH_AMD64
+  std::mt19937 random(0x58454E41);
+  TestIndices test_indices(random, 65535);
+
+  for (uint32_t offset : kTestOffsets) {
+    for (uint32_t count : kTestCounts) {
+      INFO("Offset " << offset << ", count " << count);
+      const uint16_t* source_16 = test_indices.indices_16.data() + offset;
+      const uint32_t* source_32 = test_indices.indices_32.data() + offset;
+
+      bool reset_16_used_reference = false;
+      bool ffff_used_reference = false;
+      for (uint32_t i = 0; i < count; ++i) {
+        reset_16_used_reference |= source_16[i] == TestIndices::kReset16;
+        ffff_used_reference |= source_16[i] == UINT16_MAX;
+      }
+      bool reset_32_used_reference = false;
+      for (uint32_t i = 0; i < count; ++i) {
+        reset_32_used_reference |=
+            (source_32[i] & xenos::kVertexIndexMask) == TestIndices::kReset32;
+      }
+
+      std::vector<uint16_t> reference_16(count);
+      ReferenceReplaceResetIndex16To16(reference_16.data(), source_16, count,
+                                       TestIndices::kReset16);
+      std::vector<uint32_t> reference_16_to_24(count);
+      ReferenceReplaceResetIndex16To24(reference_16_to_24.data(), source_16,
+                                       count, TestIndices::kReset16);
+      std::vector<uint16_t> result_16;
+      std::vector<uint32_t> result_32;
+
+      // Whichever implementation is chosen for the host.
+      {
+        REQUIRE(Kernels::IsResetUsed(source_16, count, TestIndices::kReset16) ==
+                reset_16_used_reference);
+        REQUIRE(Kernels::IsResetUsed(source_32, count, TestIndices::kReset32,
+                                     xenos::kVertexIndexMask) ==
+                reset_32_used_reference);
+        bool reset_16_used, ffff_used;
+        Kernels::Get16BitResetIndexUsage(source_16, count,
+                                         TestIndices::kReset16, reset_16_used,
+                                         ffff_used);
+        REQUIRE(reset_16_used == reset_16_used_reference);
+        REQUIRE(ffff_used == ffff_used_reference);
+
+        result_16.assign(count + kGuardElements, kGuard16);
+        Kernels::ReplaceResetIndex16To16(result_16.data(), source_16, count,
+                                         TestIndices::kReset16);
+        RequireEqual(result_16, reference_16, kGuard16);
+        result_32.assign(count + kGuardElements, kGuard32);
+        Kernels::ReplaceResetIndex16To24(result_32.data(), source_16, count,
+                                         TestIndices::kReset16);
+        RequireEqual(result_32, reference_16_to_24, kGuard32);
+
+        std::vector<uint32_t> reference_32(count);
+        ReferenceReplaceResetIndex32To24(
+            reference_32.data(), source_32, count, TestIndices::kReset32,
+            xenos::kVertexIndexMask, xenos::Endian::kNone);
+        result_32.assign(count + kGuardElements, kGuard32);
+        Kernels::ReplaceResetIndex32To24<xenos::Endian::kNone>(
+            result_32.data(), source_32, count, TestIndices::kReset32,
+            xenos::kVertexIndexMask);
+        RequireEqual(result_32, reference_32, kGuard32);
+        ReferenceReplaceResetIndex32To24(
+            reference_32.data(), source_32, count, TestIndices::kReset32,
+            xenos::kVertexIndexMask, xenos::Endian::k8in32);
+        result_32.assign(count + kGuardElements, kGuard32);
+        Kernels::ReplaceResetIndex32To24<xenos::Endian::k8in32>(
+            result_32.data(), source_32, count, TestIndices::kReset32,
+            xenos::kVertexIndexMask);
+        RequireEqual(result_32, reference_32, kGuard32);
+      }
+
+#if XE_ARCH_AMD64
+      if (Kernels::AreAVX2KernelsSupported()) {
+        REQUIRE(Kernels::IsResetUsedAVX2(source_16, count,
+                                         TestIndices::kReset16) ==
+                reset_16_used_reference);
+        REQUIRE(Kernels::IsResetUsedAVX2(source_32, count,
+                                         TestIndices::kReset32,
+                                         xenos::kVertexIndexMask) ==
+                reset_32_used_reference);
+        bool reset_16_used, ffff_used;
+        Kernels::Get16BitResetIndexUsageAVX2(source_16, count,
+                                             TestIndices::kReset16,
+                                             reset_16_used, ffff_used);
+        REQUIRE(reset_16_used == reset_16_used_reference);
+        REQUIRE(ffff_used == ffff_used_reference);
+
+        result_16.assign(count + kGuardElements, kGuard16);
+        Kernels::ReplaceResetIndex16To16AVX2(result_16.data(), source_16,
+                                             count, TestIndices::kReset16);
+        RequireEqual(result_16, reference_16, kGuard16);
+        result_32.assign(count + kGuardElements, kGuard32);
+        Kernels::ReplaceResetIndex16To24AVX2(result_32.data(), source_16,
+                                             count, TestIndices::kReset16);
+        RequireEqual(result_32, reference_16_to_24, kGuard32);
+
+        for (xenos::Endian host_swap :
+             {xenos::Endian::kNone, xenos::Endian::k8in16,
+              xenos::Endian::k8in32, xenos::Endian::k16in32}) {
+          std::vector<uint32_t> reference_32(count);
+          ReferenceReplaceResetIndex32To24(
+              reference_32.data(), source_32, count, TestIndices::kReset32,
+              xenos::kVertexIndexMask, host_swap);
+          result_32.assign(count + kGuardElements, kGuard32);
+          Kernels::ReplaceResetIndex32To24AVX2(
+              result_32.data(), source_32, count, TestIndices::kReset32,
+              xenos::kVertexIndexMask, host_swap);
+          RequireEqual(result_32, reference_32, kGuard32);
+        }
+      }
+
+      if (Kernels::AreAVX512KernelsSupported()) {
+        result_16.assign(count + kGuardElements, kGuard16);
+        Kernels::ReplaceResetIndex16To16AVX512(result_16.data(), source_16,
+                                               count, TestIndices::kReset16);
+        RequireEqual(result_16, reference_16, kGuard16);
+        result_32.assign(count + kGuardElements, kGuard32);
+        Kernels::ReplaceResetIndex16To24AVX512(result_32.data(), source_16,
+                                               count, TestIndices::kReset16);
+        RequireEqual(result_32, reference_16_to_24, kGuard32);
+
+        for (xenos::Endian host_swap :
+             {xenos::Endian::kNone, xenos::Endian::k8in16,
+              xenos::Endian::k8in32, xenos::Endian::k16in32}) {
+          std::vector<uint32_t> reference_32(count);
+          ReferenceReplaceResetIndex32To24(
+              reference_32.data(), source_32, count, TestIndices::kReset32,
+              xenos::kVertexIndexMask, host_swap);
+          result_32.assign(count + kGuardElements, kGuard32);
+          Kernels::ReplaceResetIndex32To24AVX512(
+              result_32.data(), source_32, count, TestIndices::kReset32,
+              xenos::kVertexIndexMask, host_swap);
+          RequireEqual(result_32, reference_32, kGuard32);
+        }
+      }
+#endif  // XE_ARCH_AMD64
+    }
+  }
+}
+
+template <typename Index>
+static void TestPrimitiveConversions(const Index* source, uint32_t count,
+                                     Index guard) {
+  Kernels::PassthroughIndexTransform passthrough;
+
+  // The non-SIMD templates are the reference.
+  uint32_t fan_index_count = count > 2 ? (count - 2) * 3 : 0;
+  std::vector<Index> reference(fan_index_count);
+  Kernels::TriangleFanToList<Index, Kernels::PassthroughIndexTransform>(
+      reference.data(), source, count, passthrough);
+  std::vector<Index> result(fan_index_count + kGuardElements, guard);
+  Kernels::TriangleFanToList(result.data(), source, count, passthrough);
+  RequireEqual(result, reference, guard);
+
+  // Converting a fan in parts like when splitting between threads.
+  if (count > 2) {
+    uint32_t triangle_count = count - 2;
+    result.assign(fan_index_count + kGuardElements, guard);
+    for (uint32_t first = 0; first < triangle_count; first += 64) {
+      Kernels::TriangleFanToListTriangles(
+          result.data() + first * 3, source[0], source + 1 + first,
+          std::min(uint32_t(64), triangle_count - first));
+    }
+    RequireEqual(result, reference, guard);
+  }
+
+  uint32_t quad_index_count = count / 4 * 6;
+  reference.resize(quad_index_count);
+  Kernels::QuadListToTriangleList<Index, Kernels::PassthroughIndexTransform>(
+      reference.data(), source, count, passthrough);
+  result.assign(quad_index_count + kGuardElements, guard);
+  Kernels::QuadListToTriangleList(result.data(), source, count, passthrough);
+  RequireEqual(result, reference, guard);
+}
+
+TEST_CASE("Primitive processor primitive type conversion",
+          "[primitive_processor]") {
+  std::mt19937 random(0x58454E41);
+  TestIndices test_indices(random, 65535);
+  for (uint32_t offset : kTestOffsets) {
+    for (uint32_t count : kTestCounts) {
+      INFO("Offset " << offset << ", count " << count);
+      TestPrimitiveConversions(test_indices.indices_16.data() + offset, count,
+                               kGuard16);
+      TestPrimitiveConversions(test_indices.indices_32.data() + offset, count,
+                               kGuard32);
+    }
+  }
+}
+
+// Converts a single primitive in chunks like when splitting between threads,
+// with the primitive being larger than one chunk.
+template <typename Index>
+static void TestChunkedPrimitiveConversions(const Index* source,
+                                            uint32_t count,
+                                            uint32_t max_chunk_count,
+                                            Index guard) {
+  Kernels::PassthroughIndexTransform passthrough;
+
+  uint32_t triangle_count = count - 2;
+  std::vector<Index> reference(triangle_count * 3);
+  Kernels::TriangleFanToList<Index, Kernels::PassthroughIndexTransform>(
+      reference.data(), source, count, passthrough);
+  std::vector<Index> result(reference.size() + kGuardElements, guard);
+  uint32_t chunk_size = Kernels::GetChunkSize(triangle_count, max_chunk_count);
+  REQUIRE(chunk_size < triangle_count);
+  for (uint32_t offset = 0; offset < triangle_count; offset += chunk_size) {
+    Kernels::TriangleFanToListTriangles(
+        result.data() + offset * 3, source[0], source + 1 + offset,
+        std::min(chunk_size, triangle_count - offset));
+  }
+  RequireEqual(result, reference, guard);
+
+  reference.resize(count / 4 * 6);
+  Kernels::QuadListToTriangleList<Index, Kernels::PassthroughIndexTransform>(
+      reference.data(), source, count, passthrough);
+  result.assign(reference.size() + kGuardElements, guard);
+  chunk_size = Kernels::GetChunkSize(count, max_chunk_count);
+  REQUIRE(chunk_size < count);
+  // Chunks must be aligned to whole quads.
+  REQUIRE(chunk_size % 4 == 0);
+  for (uint32_t offset = 0; offset < count; offset += chunk_size) {
+    Kernels::QuadListToTriangleList(result.data() + offset / 4 * 6,
+                                    source + offset,
+                                    std::min(chunk_size, count - offset),
+                                    passthrough);
+  }
+  RequireEqual(result, reference, guard);
+}
+
+TEST_CASE("Primitive processor single primitive conversion in chunks",
+          "[primitive_processor]") {
+#if XE_ARCH_AMD64
+  amd64::InitFeatureFlags();
+#endif  // XE_ARCH_AMD64
+  std::mt19937 random(0x58454E41);
+  TestIndices test_indices(random, 65535);
+  // The smallest count is the smallest fan split between threads.
+  const uint32_t counts[] = {Kernels::kChunkMinElements * 2 + 2,
+                             Kernels::kChunkMinElements * 3 + 7, 65535};
+  for (uint32_t max_chunk_count : {2, 3, 5}) {
+    for (uint32_t offset : {0, 3}) {
+      for (uint32_t count : counts) {
+        INFO("Chunks " << max_chunk_count << ", offset " << offset
+                       << ", count " << count);
+        TestChunkedPrimitiveConversions(
+            test_indices.indices_16.data() + offset, count, max_chunk_count,
+            kGuard16);
+        TestChunkedPrimitiveConversions(
+            test_indices.indices_32.data() + offset, count, max_chunk_count,
+            kGuard32);
+      }
+    }
+  }
+}
+
+template <typename Function>
+static double MeasureGigabytesPerSecond(uint32_t source_bytes,
+                                        Function&& function) {
+  constexpr uint32_t kIterations = 2000;
+  // Warm up.
+  function();
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kIterations; ++i) {
+    function();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return double(source_bytes) * kIterations /
+         std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+TEST_CASE("Primitive processor index processing throughput",
+          "[.benchmark][primitive_processor]") {
+#if XE_ARCH_AMD64
+  amd64::InitFeatureFlags();
+#endif  // XE_ARCH_AMD64
+  // The largest guest index buffer.
+  constexpr uint32_t kCount = UINT16_MAX;
+  std::mt19937 random(0x58454E41);
+  TestIndices test_indices(random, kCount);
+  const uint16_t* source_16 = test_indices.indices_16.data();
+  const uint32_t* source_32 = test_indices.indices_32.data();
+  std::vector<uint16_t> dest_16(kCount * 3);
+  std::vector<uint32_t> dest_32(kCount * 3);
+  Kernels::PassthroughIndexTransform passthrough;
+
+  auto report = [](const char* name, double reference, double optimized) {
+    fmt::print("{:<32} {:8.2f} GB/s -> {:8.2f} GB/s ({:.2f}x)\n", name,
+               reference, optimized, optimized / reference);
+  };
+
+  report("ReplaceResetIndex16To16",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint16_t),
+             [&]() {
+               ReferenceReplaceResetIndex16To16(dest_16.data(), source_16,
+                                                kCount, TestIndices::kReset16);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint16_t), [&]() {
+           Kernels::ReplaceResetIndex16To16(dest_16.data(), source_16, kCount,
+                                            TestIndices::kReset16);
+         }));
+  report("ReplaceResetIndex16To24",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint16_t),
+             [&]() {
+               ReferenceReplaceResetIndex16To24(dest_32.data(), source_16,
+                                                kCount, TestIndices::kReset16);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint16_t), [&]() {
+           Kernels::ReplaceResetIndex16To24(dest_32.data(), source_16, kCount,
+                                            TestIndices::kReset16);
+         }));
+  report("ReplaceResetIndex32To24 8in32",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint32_t),
+             [&]() {
+               ReferenceReplaceResetIndex32To24(
+                   dest_32.data(), source_32, kCount, TestIndices::kReset32,
+                   xenos::kVertexIndexMask, xenos::Endian::k8in32);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint32_t), [&]() {
+           Kernels::ReplaceResetIndex32To24<xenos::Endian::k8in32>(
+               dest_32.data(), source_32, kCount, TestIndices::kReset32,
+               xenos::kVertexIndexMask);
+         }));
+  report("TriangleFanToList 16-bit",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint16_t),
+             [&]() {
+               Kernels::TriangleFanToList<uint16_t,
+                                          Kernels::PassthroughIndexTransform>(
+                   dest_16.data(), source_16, kCount, passthrough);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint16_t), [&]() {
+           Kernels::TriangleFanToList(dest_16.data(), source_16, kCount,
+                                      passthrough);
+         }));
+  report("TriangleFanToList 32-bit",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint32_t),
+             [&]() {
+               Kernels::TriangleFanToList<uint32_t,
+                                          Kernels::PassthroughIndexTransform>(
+                   dest_32.data(), source_32, kCount, passthrough);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint32_t), [&]() {
+           Kernels::TriangleFanToList(dest_32.data(), source_32, kCount,
+                                      passthrough);
+         }));
+  report("QuadListToTriangleList 16-bit",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint16_t),
+             [&]() {
+               Kernels::QuadListToTriangleList<
+                   uint16_t, Kernels::PassthroughIndexTransform>(
+                   dest_16.data(), source_16, kCount, passthrough);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint16_t), [&]() {
+           Kernels::QuadListToTriangleList(dest_16.data(), source_16, kCount,
+                                           passthrough);
+         }));
+  report("QuadListToTriangleList 32-bit",
+         MeasureGigabytesPerSecond(
+             kCount * sizeof(uint32_t),
+             [&]() {
+               Kernels::QuadListToTriangleList<
+                   uint32_t, Kernels::PassthroughIndexTransform>(
+                   dest_32.data(), source_32, kCount, passthrough);
+             }),
+         MeasureGigabytesPerSecond(kCount * sizeof(uint32_t), [&]() {
+           Kernels::QuadListToTriangleList(dest_32.data(), source_32, kCount,
+                                           passthrough);
+         }));
+}
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <memory>
+
+#include "xenia/gpu/draw_util.h"
+#include "xenia/gpu/register_file.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+TEST_CASE("Register writes mark their groups as dirty", "[register_file]") {
+  auto regs = std::make_unique<RegisterFile>();
+  REQUIRE(regs->ConsumeDirtyGroups() == RegisterFile::kAllGroupsMask);
+  REQUIRE(regs->dirty_groups() == 0);
+
+  regs->MarkDirty(XE_GPU_REG_VGT_DRAW_INITIATOR);
+  REQUIRE(regs->dirty_groups() == 0);
+
+  regs->MarkDirty(XE_GPU_REG_PA_CL_VPORT_XSCALE);
+  REQUIRE(regs->ConsumeDirtyGroups() ==
+          RegisterFile::GetGroupMask(RegisterGroup::kViewport));
+
+  regs->MarkDirty(XE_GPU_REG_RB_MODECONTROL);
+  REQUIRE(regs->ConsumeDirtyGroups() ==
+          (RegisterFile::GetGroupMask(RegisterGroup::kBlend) |
+           RegisterFile::GetGroupMask(RegisterGroup::kDepthStencil) |
+           RegisterFile::GetGroupMask(RegisterGroup::kSurfaceInfo)));
+
+  // Shader constants are not in any group.
+  regs->MarkRangeDirty(XE_GPU_REG_SHADER_CONSTANT_511_W, 2);
+  regs->MarkDirty(XE_GPU_REG_SHADER_CONSTANT_LOOP_31);
+  REQUIRE(regs->dirty_groups() == 0);
+}
+
+TEST_CASE("Draw state is derived only after register writes",
+          "[register_file]") {
+  auto regs = std::make_unique<RegisterFile>();
+  draw_util::DrawStateCache cache;
+
+  auto write = [&regs](uint32_t index, uint32_t value) {
+    regs->values[index] = value;
+    regs->MarkDirty(index);
+  };
+  reg::RB_MODECONTROL rb_modecontrol = {};
+  rb_modecontrol.edram_mode = xenos::ModeControl::kColorDepth;
+  write(XE_GPU_REG_RB_MODECONTROL, rb_modecontrol.value);
+  reg::RB_DEPTHCONTROL rb_depthcontrol = {};
+  rb_depthcontrol.z_enable = 1;
+  rb_depthcontrol.z_write_enable = 1;
+  rb_depthcontrol.zfunc = xenos::CompareFunction::kLess;
+  write(XE_GPU_REG_RB_DEPTHCONTROL, rb_depthcontrol.value);
+  write(XE_GPU_REG_PA_SC_WINDOW_SCISSOR_BR, (720 << 16) | 1280);
+  write(XE_GPU_REG_PA_SC_SCREEN_SCISSOR_BR, (720 << 16) | 1280);
+
+  cache.BeginDraw(*regs);
+  REQUIRE(cache.GetNormalizedDepthControl(*regs).z_enable);
+  draw_util::Scissor scissor;
+  cache.GetScissor(*regs, scissor, false);
+  REQUIRE(scissor.extent[0] == 1280);
+  REQUIRE(scissor.extent[1] == 720);
+  REQUIRE(cache.derivation_count() == 2);
+  REQUIRE(cache.reuse_count() == 0);
+
+  // Unrelated registers written.
+  write(XE_GPU_REG_VGT_DRAW_INITIATOR, 0);
+  write(XE_GPU_REG_SHADER_CONSTANT_000_X, 0);
+  cache.BeginDraw(*regs);
+  REQUIRE(cache.GetNormalizedDepthControl(*regs).z_enable);
+  cache.GetScissor(*regs, scissor, false);
+  REQUIRE(scissor.extent[0] == 1280);
+  REQUIRE(cache.derivation_count() == 2);
+  REQUIRE(cache.reuse_count() == 2);
+
+  // Only the state depending on the written registers is derived again.
+  write(XE_GPU_REG_PA_SC_WINDOW_SCISSOR_BR, (480 << 16) | 640);
+  cache.BeginDraw(*regs);
+  REQUIRE(cache.GetNormalizedDepthControl(*regs).z_enable);
+  cache.GetScissor(*regs, scissor, false);
+  REQUIRE(scissor.extent[0] == 640);
+  REQUIRE(scissor.extent[1] == 480);
+  REQUIRE(cache.derivation_count() == 3);
+  REQUIRE(cache.reuse_count() == 3);
+
+  // Writes are not lost if the state isn't requested for some draws.
+  rb_modecontrol.edram_mode = xenos::ModeControl::kIgnore;
+  write(XE_GPU_REG_RB_MODECONTROL, rb_modecontrol.value);
+  cache.BeginDraw(*regs);
+  cache.BeginDraw(*regs);
+  REQUIRE_FALSE(cache.GetNormalizedDepthControl(*regs).z_enable);
+}
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,395 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "xenia/gpu/register_file.h"
+#include "xenia/gpu/render_target_cache.h"
+#include "xenia/gpu/xenos.h"
+#include "xenia/memory.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+// Render target cache without host render targets, only tracking the EDRAM
+// ownership.
+class OwnershipTrackingRenderTargetCache : public RenderTargetCache {
+ public:
+  using RenderTargetCache::GetLengthTilesAt32bpp;
+  using RenderTargetCache::OwnershipRange;
+  using RenderTargetCache::RenderTargetKey;
+
+  using RenderTargetCache::ChangeOwnership;
+  using RenderTargetCache::ownership_ranges;
+  using RenderTargetCache::ResetOwnershipRanges;
+  using RenderTargetCache::WouldOwnershipChangeRequireTransfers;
+
+  OwnershipTrackingRenderTargetCache(const RegisterFile& register_file,
+                                     const Memory& memory,
+                                     bool host_depth_encoding_different)
+      : RenderTargetCache(register_file, memory, nullptr, 1, 1),
+        host_depth_encoding_different_(host_depth_encoding_different) {
+    InitializeCommon();
+  }
+
+  Path GetPath() const override { return Path::kHostRenderTargets; }
+
+ protected:
+  uint32_t GetMaxRenderTargetWidth() const override { return 8192; }
+  uint32_t GetMaxRenderTargetHeight() const override { return 8192; }
+
+  RenderTarget* CreateRenderTarget(RenderTargetKey key) override {
+    return nullptr;
+  }
+
+  bool IsHostDepthEncodingDifferent(
+      xenos::DepthRenderTargetFormat format) const override {
+    return host_depth_encoding_different_;
+  }
+
+ private:
+  bool host_depth_encoding_different_;
+};
+
+using Cache = OwnershipTrackingRenderTargetCache;
+using RenderTargetKey = Cache::RenderTargetKey;
+
+static RenderTargetKey MakeColorKey(uint32_t base_tiles,
+                                    uint32_t pitch_tiles_at_32bpp,
+                                    xenos::MsaaSamples msaa_samples,
+                                    xenos::ColorRenderTargetFormat format) {
+  RenderTargetKey key;
+  key.base_tiles = base_tiles;
+  key.pitch_tiles_at_32bpp = pitch_tiles_at_32bpp;
+  key.msaa_samples = msaa_samples;
+  key.resource_format = uint32_t(format);
+  return key;
+}
+
+static RenderTargetKey MakeDepthKey(uint32_t base_tiles,
+                                    uint32_t pitch_tiles_at_32bpp,
+                                    xenos::MsaaSamples msaa_samples,
+                                    xenos::DepthRenderTargetFormat format) {
+  RenderTargetKey key;
+  key.base_tiles = base_tiles;
+  key.pitch_tiles_at_32bpp = pitch_tiles_at_32bpp;
+  key.msaa_samples = msaa_samples;
+  key.is_depth = 1;
+  key.resource_format = uint32_t(format);
+  return key;
+}
+
+// Non-range reference implementation of the ownership tracking, storing the
+// owners of every tile.
+class ReferenceOwnership {
+ public:
+  explicit ReferenceOwnership(bool host_depth_encoding_different)
+      : host_depth_encoding_different_(host_depth_encoding_different) {}
+
+  bool WouldChangeRequireTransfers(RenderTargetKey dest,
+                                   uint32_t start_tiles_base_relative,
+                                   uint32_t length_tiles) const {
+    uint32_t start_tiles =
+        (dest.base_tiles + start_tiles_base_relative) % kTileCount;
+    for (uint32_t i = 0; i < length_tiles; ++i) {
+      const Tile& tile = tiles_[(start_tiles + i) % kTileCount];
+      if (!tile.render_target.IsEmpty() && tile.render_target != dest) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ChangeOwnership(RenderTargetKey dest, uint32_t start_tiles_base_relative,
+                       uint32_t length_tiles) {
+    bool host_depth_encoding_different =
+        dest.is_depth && host_depth_encoding_different_;
+    uint32_t start_tiles =
+        (dest.base_tiles + start_tiles_base_relative) % kTileCount;
+    for (uint32_t i = 0; i < length_tiles; ++i) {
+      Tile& tile = tiles_[(start_tiles + i) % kTileCount];
+      if (tile.render_target == dest) {
+        continue;
+      }
+      tile.render_target = dest;
+      if (host_depth_encoding_different) {
+        (dest.GetDepthFormat() == xenos::DepthRenderTargetFormat::kD24S8
+             ? tile.host_depth_render_target_unorm24
+             : tile.host_depth_render_target_float24) = dest;
+      }
+    }
+  }
+
+  void Reset() { tiles_.fill(Tile()); }
+
+  // Checks both the invariants of the ranges and their owners.
+  void Compare(const Cache& cache) const {
+    const auto& ranges = cache.ownership_ranges();
+    REQUIRE_FALSE(ranges.empty());
+    REQUIRE(ranges.front().first == 0);
+    REQUIRE(ranges.back().second.end_tiles == kTileCount);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+      const Cache::OwnershipRange& range = ranges[i].second;
+      REQUIRE(range.end_tiles > ranges[i].first);
+      if (i + 1 < ranges.size()) {
+        REQUIRE(ranges[i + 1].first == range.end_tiles);
+        // Adjacent ranges with the same owners must be merged.
+        REQUIRE_FALSE(range.AreOwnersSame(ranges[i + 1].second));
+      }
+      for (uint32_t j = ranges[i].first; j < range.end_tiles; ++j) {
+        const Tile& tile = tiles_[j];
+        REQUIRE(range.render_target == tile.render_target);
+        REQUIRE(range.host_depth_render_target_unorm24 ==
+                tile.host_depth_render_target_unorm24);
+        REQUIRE(range.host_depth_render_target_float24 ==
+                tile.host_depth_render_target_float24);
+      }
+    }
+  }
+
+ private:
+  static constexpr uint32_t kTileCount = xenos::kEdramTileCount;
+  struct Tile {
+    RenderTargetKey render_target;
+    RenderTargetKey host_depth_render_target_unorm24;
+    RenderTargetKey host_depth_render_target_float24;
+  };
+  bool host_depth_encoding_different_;
+  std::array<Tile, kTileCount> tiles_;
+};
+
+TEST_CASE("EDRAM length scales with MSAA and 64bpp", "[render_target_cache]") {
+  // 1280x720 at 1x: 45 rows of 16 tiles.
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 720, xenos::MsaaSamples::k1X) ==
+          720);
+  // 2x and 4x MSAA double the height in samples.
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 720, xenos::MsaaSamples::k2X) ==
+          1440);
+  REQUIRE(Cache::GetLengthTilesAt32bpp(32, 720, xenos::MsaaSamples::k4X) ==
+          2880);
+  // Partial rows of tiles are rounded up, after the MSAA scaling.
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 1, xenos::MsaaSamples::k1X) == 16);
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 17, xenos::MsaaSamples::k1X) == 32);
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 8, xenos::MsaaSamples::k2X) == 16);
+  REQUIRE(Cache::GetLengthTilesAt32bpp(16, 9, xenos::MsaaSamples::k2X) == 32);
+
+  // A 64bpp 2x MSAA render target covers twice as many tiles as a 32bpp one,
+  // so the depth buffer placed after the 32bpp one is overwritten.
+  auto register_file = std::make_unique<RegisterFile>();
+  auto memory = std::make_unique<Memory>();
+  Cache cache(*register_file, *memory, false);
+  RenderTargetKey color_32bpp =
+      MakeColorKey(0, 16, xenos::MsaaSamples::k2X,
+                   xenos::ColorRenderTargetFormat::k_8_8_8_8);
+  RenderTargetKey color_64bpp =
+      MakeColorKey(0, 16, xenos::MsaaSamples::k2X,
+                   xenos::ColorRenderTargetFormat::k_16_16_16_16);
+  REQUIRE(color_64bpp.Is64bpp());
+  uint32_t length_32bpp =
+      Cache::GetLengthTilesAt32bpp(16, 360, xenos::MsaaSamples::k2X);
+  REQUIRE(length_32bpp == 720);
+  RenderTargetKey depth =
+      MakeDepthKey(length_32bpp, 16, xenos::MsaaSamples::k2X,
+                   xenos::DepthRenderTargetFormat::kD24S8);
+  cache.ChangeOwnership(color_32bpp, 0, length_32bpp, nullptr);
+  REQUIRE_FALSE(
+      cache.WouldOwnershipChangeRequireTransfers(depth, 0, length_32bpp));
+  cache.ChangeOwnership(depth, 0, length_32bpp, nullptr);
+  REQUIRE(cache.ownership_ranges().size() == 3);
+  // The last tile of the 64bpp render target is in the depth buffer, the one
+  // after it is still unused.
+  REQUIRE(cache.WouldOwnershipChangeRequireTransfers(
+      color_64bpp, (length_32bpp << 1) - 1, 1));
+  REQUIRE_FALSE(cache.WouldOwnershipChangeRequireTransfers(
+      color_64bpp, length_32bpp << 1, 1));
+  cache.ChangeOwnership(color_64bpp, 0, length_32bpp << 1, nullptr);
+  REQUIRE(cache.WouldOwnershipChangeRequireTransfers(depth, 0, 1));
+  REQUIRE(cache.ownership_ranges().size() == 2);
+  REQUIRE(cache.ownership_ranges()[0].second.render_target == color_64bpp);
+  REQUIRE(cache.ownership_ranges()[0].second.end_tiles == length_32bpp << 1);
+}
+
+TEST_CASE("EDRAM ownership ranges are split and merged at edges",
+          "[render_target_cache]") {
+  auto register_file = std::make_unique<RegisterFile>();
+  auto memory = std::make_unique<Memory>();
+  Cache cache(*register_file, *memory, false);
+  ReferenceOwnership reference(false);
+  RenderTargetKey a = MakeColorKey(100, 10, xenos::MsaaSamples::k1X,
+                                   xenos::ColorRenderTargetFormat::k_8_8_8_8);
+  RenderTargetKey b = MakeColorKey(150, 10, xenos::MsaaSamples::k1X,
+                                   xenos::ColorRenderTargetFormat::k_8_8_8_8);
+  auto change = [&](RenderTargetKey dest, uint32_t start_tiles_base_relative,
+                    uint32_t length_tiles) {
+    REQUIRE(cache.WouldOwnershipChangeRequireTransfers(
+                dest, start_tiles_base_relative, length_tiles) ==
+            reference.WouldChangeRequireTransfers(
+                dest, start_tiles_base_relative, length_tiles));
+    cache.ChangeOwnership(dest, start_tiles_base_relative, length_tiles,
+                          nullptr);
+    reference.ChangeOwnership(dest, start_tiles_base_relative, length_tiles);
+    reference.Compare(cache);
+  };
+
+  // [100, 200) in the middle of the empty range - split on both sides.
+  change(a, 0, 100);
+  REQUIRE(cache.ownership_ranges().size() == 3);
+  // Tail of a range - split only the head.
+  change(b, 0, 50);
+  REQUIRE(cache.ownership_ranges().size() == 4);
+  // Taking the tail back - merged with the head.
+  change(a, 50, 50);
+  REQUIRE(cache.ownership_ranges().size() == 3);
+  // Right after the end - merged with the previous range.
+  change(a, 100, 100);
+  REQUIRE(cache.ownership_ranges().size() == 3);
+  REQUIRE(cache.ownership_ranges()[1].second.end_tiles == 300);
+  // Right before the start - not merged with the next range of another owner.
+  change(b, 2047 - 50, 1);
+  REQUIRE(cache.ownership_ranges().size() == 4);
+  // Filling a single-tile gap between two ranges of the same owner.
+  change(b, 150, 1);
+  REQUIRE(cache.ownership_ranges().size() == 5);
+  change(b, 0, 1);
+  REQUIRE(cache.ownership_ranges().size() == 7);
+  change(a, 50, 1);
+  REQUIRE(cache.ownership_ranges().size() == 5);
+  // Wrapping around the end of the EDRAM.
+  RenderTargetKey c = MakeColorKey(2040, 10, xenos::MsaaSamples::k1X,
+                                   xenos::ColorRenderTargetFormat::k_8_8_8_8);
+  change(c, 0, 20);
+  REQUIRE(cache.ownership_ranges().front().second.render_target == c);
+  REQUIRE(cache.ownership_ranges().back().second.render_target == c);
+  // Whole EDRAM.
+  change(a, 0, xenos::kEdramTileCount);
+  REQUIRE(cache.ownership_ranges().size() == 1);
+}
+
+static void TestRandomOwnershipChanges(bool host_depth_encoding_different) {
+  static constexpr uint32_t kTileCount = xenos::kEdramTileCount;
+  static constexpr uint32_t kChangeCount = 4096;
+  auto register_file = std::make_unique<RegisterFile>();
+  auto memory = std::make_unique<Memory>();
+  Cache cache(*register_file, *memory, host_depth_encoding_different);
+  ReferenceOwnership reference(host_depth_encoding_different);
+
+  std::mt19937 random(0x58454E41 + uint32_t(host_depth_encoding_different));
+  // A small set of render targets so they're reused and take back ownership of
+  // their own data.
+  static const xenos::MsaaSamples kMsaaSamples[] = {xenos::MsaaSamples::k1X,
+                                                    xenos::MsaaSamples::k2X,
+                                                    xenos::MsaaSamples::k4X};
+  std::vector<RenderTargetKey> keys;
+  for (uint32_t i = 0; i < 12; ++i) {
+    uint32_t base_tiles = random() % kTileCount;
+    uint32_t pitch_tiles_at_32bpp = 1 + random() % 40;
+    xenos::MsaaSamples msaa_samples = kMsaaSamples[random() % 3];
+    switch (i % 4) {
+      case 0:
+        keys.push_back(
+            MakeColorKey(base_tiles, pitch_tiles_at_32bpp, msaa_samples,
+                         xenos::ColorRenderTargetFormat::k_8_8_8_8));
+        break;
+      case 1:
+        keys.push_back(
+            MakeColorKey(base_tiles, pitch_tiles_at_32bpp, msaa_samples,
+                         xenos::ColorRenderTargetFormat::k_16_16_16_16));
+        break;
+      case 2:
+        keys.push_back(MakeDepthKey(base_tiles, pitch_tiles_at_32bpp,
+                                    msaa_samples,
+                                    xenos::DepthRenderTargetFormat::kD24S8));
+        break;
+      default:
+        keys.push_back(MakeDepthKey(base_tiles, pitch_tiles_at_32bpp,
+                                    msaa_samples,
+                                    xenos::DepthRenderTargetFormat::kD24FS8));
+        break;
+    }
+  }
+
+  // Picks a tile at or next to a boundary between the current ranges.
+  auto random_range_edge = [&]() -> uint32_t {
+    const auto& ranges = cache.ownership_ranges();
+    const auto& range = ranges[random() % ranges.size()];
+    uint32_t edge = (random() & 1) ? range.second.end_tiles : range.first;
+    return (edge + kTileCount - 1 + random() % 3) % kTileCount;
+  };
+
+  for (uint32_t i = 0; i < kChangeCount; ++i) {
+    if (i % 1024 == 0) {
+      cache.ResetOwnershipRanges(RenderTargetKey());
+      reference.Reset();
+    }
+    RenderTargetKey dest = keys[random() % keys.size()];
+    uint32_t start_tiles_base_relative;
+    switch (random() % 3) {
+      case 0:
+        start_tiles_base_relative = 0;
+        break;
+      case 1:
+        start_tiles_base_relative =
+            (random_range_edge() + kTileCount - dest.base_tiles) % kTileCount;
+        break;
+      default:
+        start_tiles_base_relative = random() % kTileCount;
+        break;
+    }
+    uint32_t length_tiles;
+    switch (random() % 3) {
+      case 0:
+        // Rows of the render target, like in Update.
+        length_tiles = std::min(
+            Cache::GetLengthTilesAt32bpp(dest.pitch_tiles_at_32bpp,
+                                         1 + random() % 720,
+                                         dest.msaa_samples)
+                << uint32_t(dest.Is64bpp()),
+            kTileCount);
+        break;
+      case 1:
+        // Up to and around a boundary between the current ranges.
+        length_tiles =
+            1 + (random_range_edge() + kTileCount - 1 -
+                 (dest.base_tiles + start_tiles_base_relative) % kTileCount) %
+                    kTileCount;
+        break;
+      default:
+        length_tiles = 1 + random() % kTileCount;
+        break;
+    }
+    REQUIRE(cache.WouldOwnershipChangeRequireTransfers(
+                dest, start_tiles_base_relative, length_tiles) ==
+            reference.WouldChangeRequireTransfers(
+                dest, start_tiles_base_relative, length_tiles));
+    cache.ChangeOwnership(dest, start_tiles_base_relative, length_tiles,
+                          nullptr);
+    reference.ChangeOwnership(dest, start_tiles_base_relative, length_tiles);
+    reference.Compare(cache);
+  }
+}
+
+TEST_CASE("Random EDRAM ownership changes match per-tile ownership",
+          "[render_target_cache]") {
+  SECTION("Same host depth encoding") { TestRandomOwnershipChanges(false); }
+  SECTION("Different host depth encoding") {
+    TestRandomOwnershipChanges(true);
+  }
+}
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "xenia/gpu/shader.h"
+#include "xenia/gpu/shader_translation_pool.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+class TestTranslationWorker : public ShaderTranslationPool::Worker {
+ public:
+  explicit TestTranslationWorker(std::atomic<uint32_t>& translation_count)
+      : translation_count_(translation_count) {}
+
+  bool Translate(Shader::Translation& translation) override {
+    REQUIRE(translation.shader().is_ucode_analyzed());
+    translation_count_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  uint64_t PredictModification(const Shader& shader,
+                               uint64_t last_modification,
+                               uint32_t program_cntl_num_reg) override {
+    return last_modification + program_cntl_num_reg;
+  }
+
+ private:
+  std::atomic<uint32_t>& translation_count_;
+};
+
+TEST_CASE("Shaders are analyzed and translated in the background",
+          "[shader_translation_pool]") {
+  int32_t thread_count = cvars::gpu_shader_translation_threads;
+  cvars::gpu_shader_translation_threads = 2;
+
+  std::atomic<uint32_t> translation_count = 0;
+  ShaderTranslationPool pool;
+  pool.Initialize([&translation_count]() {
+    return std::make_unique<TestTranslationWorker>(translation_count);
+  });
+  REQUIRE(pool.is_active());
+
+  // An empty shader (just an exec end).
+  const uint32_t ucode[] = {0x00000000, 0x00002000, 0x00000000};
+  std::vector<std::unique_ptr<Shader>> shaders;
+  for (uint64_t i = 0; i < 8; ++i) {
+    shaders.push_back(std::make_unique<Shader>(xenos::ShaderType::kPixel, i,
+                                               ucode, uint32_t(3)));
+  }
+
+  // Only analyzed if the modification can't be predicted.
+  pool.Prefetch(*shaders[0], std::nullopt, 0);
+  pool.WaitForShader(*shaders[0]);
+  REQUIRE(shaders[0]->is_ucode_analyzed());
+  REQUIRE(shaders[0]->translations().empty());
+  REQUIRE(translation_count == 0);
+
+  for (size_t i = 1; i < shaders.size(); ++i) {
+    pool.Prefetch(*shaders[i], uint64_t(0x10), 2);
+    // Loaded again before being drawn.
+    pool.Prefetch(*shaders[i], uint64_t(0x20), 2);
+  }
+  pool.WaitForIdle();
+  REQUIRE(translation_count == shaders.size() - 1);
+  for (size_t i = 1; i < shaders.size(); ++i) {
+    REQUIRE(shaders[i]->is_ucode_analyzed());
+    REQUIRE(shaders[i]->translations().size() == 1);
+    REQUIRE(shaders[i]->translations().count(0x12));
+  }
+
+  // Already analyzed shaders are not prefetched again.
+  pool.Prefetch(*shaders[0], uint64_t(0x10), 0);
+  pool.WaitForIdle();
+  REQUIRE(shaders[0]->translations().empty());
+
+  // Translations requested by the command processor.
+  pool.Translate(*shaders[0]->GetOrCreateTranslation(0x30));
+  pool.WaitForShader(*shaders[0]);
+  REQUIRE(translation_count == shaders.size());
+
+  pool.Shutdown();
+  REQUIRE_FALSE(pool.is_active());
+  cvars::gpu_shader_translation_threads = thread_count;
+}
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
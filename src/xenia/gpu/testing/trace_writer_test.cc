@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+#include "xenia/gpu/trace_protocol.h"
+#include "xenia/gpu/trace_reader.h"
+#include "xenia/gpu/trace_writer.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe {
+namespace gpu {
+namespace test {
+
+#if XE_ENABLE_TRACE_WRITER_INSTRUMENTATION == 1
+
+class TestTraceReader : public TraceReader {
+ public:
+  using TraceReader::DecompressMemory;
+
+  const uint8_t* trace_data() const { return trace_data_; }
+  size_t trace_size() const { return trace_size_; }
+};
+
+TEST_CASE("Trace writer memory reads", "[trace]") {
+  std::vector<uint8_t> membase(0x10000);
+  // Compressible data, the same at two addresses.
+  for (uint32_t i = 0; i < 0x1000; ++i) {
+    membase[i] = membase[0x2000 + i] = uint8_t(i / 16);
+  }
+  // Incompressible data.
+  std::mt19937 random_engine(0);
+  for (uint32_t i = 0x4000; i < 0x5000; ++i) {
+    membase[i] = uint8_t(random_engine());
+  }
+
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / "xenia-trace-writer-test.xtr";
+  {
+    TraceWriter writer(membase.data());
+    REQUIRE(writer.Open(path, 0));
+    writer.WriteMemoryRead(0x0, 0x1000);
+    writer.WriteMemoryRead(0x2000, 0x1000);
+    writer.WriteMemoryRead(0x4000, 0x1000);
+    writer.Flush();
+    writer.WriteMemoryRead(0x2000, 0x1000);
+    writer.WriteEvent(EventCommand::Type::kSwap);
+    writer.Close();
+  }
+
+  struct ExpectedRead {
+    uint32_t base_ptr;
+    MemoryEncodingFormat encoding_format;
+  };
+  const ExpectedRead expected_reads[] = {
+      {0x0, MemoryEncodingFormat::kZstd},
+      {0x2000, MemoryEncodingFormat::kReference},
+      {0x4000, MemoryEncodingFormat::kNone},
+      {0x2000, MemoryEncodingFormat::kReference},
+  };
+
+  {
+    TestTraceReader reader;
+    REQUIRE(reader.Open(path.string()));
+    const uint8_t* trace_ptr = reader.trace_data() + sizeof(TraceHeader);
+    const uint8_t* trace_end = reader.trace_data() + reader.trace_size();
+    std::vector<uint8_t> decoded(0x1000);
+    for (const ExpectedRead& expected_read : expected_reads) {
+      REQUIRE(trace_end - trace_ptr >= ptrdiff_t(sizeof(MemoryCommand)));
+      MemoryCommand cmd;
+      std::memcpy(&cmd, trace_ptr, sizeof(cmd));
+      trace_ptr += sizeof(cmd);
+      REQUIRE(cmd.type == TraceCommandType::kMemoryRead);
+      REQUIRE(cmd.base_ptr == expected_read.base_ptr);
+      REQUIRE(cmd.encoding_format == expected_read.encoding_format);
+      REQUIRE(cmd.decoded_length == decoded.size());
+      REQUIRE(reader.DecompressMemory(cmd.encoding_format, trace_ptr,
+                                      cmd.encoded_length, decoded.data(),
+                                      decoded.size()));
+      REQUIRE(std::memcmp(decoded.data(), membase.data() + cmd.base_ptr,
+                          decoded.size()) == 0);
+      trace_ptr += cmd.encoded_length;
+    }
+    EventCommand event_cmd;
+    REQUIRE(trace_end - trace_ptr == ptrdiff_t(sizeof(event_cmd)));
+    std::memcpy(&event_cmd, trace_ptr, sizeof(event_cmd));
+    REQUIRE(event_cmd.type == TraceCommandType::kEvent);
+    reader.Close();
+  }
+
+  std::filesystem::remove(path);
+}
+
+#endif  // XE_ENABLE_TRACE_WRITER_INSTRUMENTATION
+
+}  // namespace test
+}  // namespace gpu
+}  // namespace xe
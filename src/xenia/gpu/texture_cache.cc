@@ -11,6 +11,7 @@
 
 #include "xenia/base/clock.h"
 #include "xenia/base/cvar.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/profiling.h"
 #include "xenia/gpu/gpu_flags.h"
@@ -778,6 +779,7 @@ bool TextureCache::LoadTextureData(Texture& texture) {
   if (!base_outdated && !mips_outdated) {
     return true;
   }
+  frame_telemetry::AddToCounter(frame_telemetry::Counter::kTextureUploads);
 
   TextureKey texture_key = texture.key();
 
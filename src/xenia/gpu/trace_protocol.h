@@ -23,7 +23,7 @@ static const char kTraceExtension[] = "xtr";
 // Other changes besides the file format may require bumps, such as
 // anything that changes what is recorded into the files (new GPU
 // command processor commands, etc).
-constexpr uint32_t kTraceFormatVersion = 1;
+constexpr uint32_t kTraceFormatVersion = 2;
 
 // Trace file header identifying information about the trace.
 // This must be positioned at the start of the file and must only occur once.
@@ -95,6 +95,12 @@ enum class MemoryEncodingFormat {
   kNone,
   // Data is compressed with third_party/snappy.
   kSnappy,
+  // Data is compressed with third_party/zstd.
+  kZstd,
+  // Data is identical to that of an earlier memory command in the same trace.
+  // The encoded data is the uint64_t offset of that command from the start of
+  // the file. Only used for TraceCommandType::kMemoryRead.
+  kReference,
 };
 
 // Represents the GPU reading or writing data from or to memory.
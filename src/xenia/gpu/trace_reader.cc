@@ -10,8 +10,10 @@
 #include "xenia/gpu/trace_reader.h"
 
 #include <cinttypes>
+#include <cstring>
 
 #include "third_party/snappy/snappy.h"
+#include "third_party/zstd/lib/zstd.h"
 #include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/mapped_memory.h"
@@ -248,6 +250,31 @@ bool TraceReader::DecompressMemory(MemoryEncodingFormat encoding_format,
     case MemoryEncodingFormat::kSnappy:
       return snappy::RawUncompress(reinterpret_cast<const char*>(src), src_size,
                                    reinterpret_cast<char*>(dest));
+    case MemoryEncodingFormat::kZstd:
+      return ZSTD_decompress(dest, dest_size, src, src_size) == dest_size;
+    case MemoryEncodingFormat::kReference: {
+      uint64_t referenced_offset;
+      if (src_size != sizeof(referenced_offset)) {
+        return false;
+      }
+      std::memcpy(&referenced_offset, src, sizeof(referenced_offset));
+      if (referenced_offset > trace_size_ ||
+          trace_size_ - referenced_offset < sizeof(MemoryCommand)) {
+        return false;
+      }
+      auto referenced_cmd = reinterpret_cast<const MemoryCommand*>(
+          trace_data_ + referenced_offset);
+      // The writer only references commands containing the data itself.
+      if (referenced_cmd->encoding_format == MemoryEncodingFormat::kReference ||
+          referenced_cmd->decoded_length != dest_size ||
+          trace_size_ - referenced_offset - sizeof(MemoryCommand) <
+              referenced_cmd->encoded_length) {
+        return false;
+      }
+      return DecompressMemory(referenced_cmd->encoding_format,
+                              referenced_cmd + 1,
+                              referenced_cmd->encoded_length, dest, dest_size);
+    }
     default:
       assert_unhandled_case(encoding_format);
       return false;
@@ -9,27 +9,35 @@
 
 #include "xenia/gpu/trace_writer.h"
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
 
-#include "third_party/snappy/snappy-sinksource.h"
-#include "third_party/snappy/snappy.h"
+#include "third_party/zstd/lib/zstd.h"
 
 #include "build/version.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
 #include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
 #include "xenia/base/string.h"
+#include "xenia/base/xxhash.h"
 #include "xenia/gpu/registers.h"
 #include "xenia/gpu/xenos.h"
 
+DEFINE_int32(trace_gpu_compression_level, 3,
+             "Zstandard compression level for the data in GPU traces, from 1 "
+             "(fastest) to 19 (smallest), or 0 to store it uncompressed.",
+             "GPU");
+
 namespace xe {
 namespace gpu {
 #if XE_ENABLE_TRACE_WRITER_INSTRUMENTATION == 1
 TraceWriter::TraceWriter(uint8_t* membase)
     : membase_(membase), file_(nullptr) {}
 
-TraceWriter::~TraceWriter() = default;
+TraceWriter::~TraceWriter() { Close(); }
 
 bool TraceWriter::Open(const std::filesystem::path& path, uint32_t title_id) {
   Close();
@@ -52,25 +60,245 @@ bool TraceWriter::Open(const std::filesystem::path& path, uint32_t title_id) {
               sizeof(header.build_commit_sha));
   header.title_id = title_id;
   fwrite(&header, sizeof(header), 1, file_);
+  file_offset_ = sizeof(header);
+
+  compression_level_ =
+      std::min(std::max(cvars::trace_gpu_compression_level, 0),
+               ZSTD_maxCLevel());
+  if (compression_level_) {
+    compression_context_ = ZSTD_createCCtx();
+    if (!compression_context_) {
+      XELOGW("Failed to create the GPU trace compression context");
+      compression_level_ = 0;
+    }
+  }
+
+  buffer_pending_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  buffer_written_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  if (buffer_pending_event_ && buffer_written_event_) {
+    writer_shutting_down_.store(false, std::memory_order_relaxed);
+    writer_thread_ =
+        xe::threading::Thread::Create({}, [this]() { WriterThreadMain(); });
+  }
+  if (!writer_thread_) {
+    XELOGE("Failed to create the GPU trace writer thread");
+    Close();
+    return false;
+  }
+  writer_thread_->set_name("GPU Trace Writer");
 
   cached_memory_reads_.clear();
   return true;
 }
 
 void TraceWriter::Flush() {
-  if (file_) {
-    fflush(file_);
+  if (file_ && !buffer_.empty()) {
+    HandOffBuffer();
   }
 }
 
 void TraceWriter::Close() {
-  if (file_) {
-    cached_memory_reads_.clear();
+  if (!file_) {
+    return;
+  }
+
+  if (writer_thread_) {
+    if (!buffer_.empty()) {
+      HandOffBuffer();
+    }
+    AwaitWriterIdle();
+    writer_shutting_down_.store(true, std::memory_order_release);
+    buffer_pending_event_->Set();
+    xe::threading::Wait(writer_thread_.get(), false);
+    writer_thread_.reset();
+  }
+  buffer_written_event_.reset();
+  buffer_pending_event_.reset();
+  buffer_.clear();
+  pending_buffer_.clear();
+  output_buffer_.clear();
+
+  if (compression_context_) {
+    ZSTD_freeCCtx(compression_context_);
+    compression_context_ = nullptr;
+  }
+  written_memory_reads_.clear();
+  cached_memory_reads_.clear();
+
+  fflush(file_);
+  fclose(file_);
+  file_ = nullptr;
+}
+
+void TraceWriter::HandOffBuffer() {
+  // Double buffering - wait for the writer thread to be done with the previous
+  // buffer, if it's behind.
+  AwaitWriterIdle();
+  buffer_.swap(pending_buffer_);
+  buffer_.clear();
+  buffer_pending_.store(true, std::memory_order_release);
+  buffer_pending_event_->Set();
+}
+
+void TraceWriter::AwaitWriterIdle() {
+  SCOPE_profile_cpu_f("gpu");
+  while (buffer_pending_.load(std::memory_order_acquire)) {
+    xe::threading::Wait(buffer_written_event_.get(), false);
+  }
+}
+
+void TraceWriter::WriterThreadMain() {
+  while (true) {
+    if (buffer_pending_.load(std::memory_order_acquire)) {
+      EncodeBuffer(pending_buffer_);
+      fwrite(output_buffer_.data(), 1, output_buffer_.size(), file_);
+      fflush(file_);
+      file_offset_ += output_buffer_.size();
+      output_buffer_.clear();
+      buffer_pending_.store(false, std::memory_order_release);
+      buffer_written_event_->Set();
+      continue;
+    }
+    if (writer_shutting_down_.load(std::memory_order_acquire)) {
+      break;
+    }
+    xe::threading::Wait(buffer_pending_event_.get(), false);
+  }
+}
+
+template <typename Command>
+void TraceWriter::EncodeCommandWithData(Command& cmd, const void* data,
+                                        size_t data_length) {
+  size_t cmd_offset = output_buffer_.size();
+  output_buffer_.resize(cmd_offset + sizeof(cmd));
+  cmd.encoding_format = EncodePayload(data, data_length, cmd.encoded_length);
+  std::memcpy(output_buffer_.data() + cmd_offset, &cmd, sizeof(cmd));
+}
 
-    fflush(file_);
-    fclose(file_);
-    file_ = nullptr;
+void TraceWriter::EncodeBuffer(const std::vector<uint8_t>& buffer) {
+  SCOPE_profile_cpu_f("gpu");
+
+  // The recorded buffer is a trace stream with all data stored uncompressed,
+  // and the commands it contains are complete.
+  const uint8_t* buffer_ptr = buffer.data();
+  const uint8_t* buffer_end = buffer_ptr + buffer.size();
+  while (buffer_ptr < buffer_end) {
+    auto type = static_cast<TraceCommandType>(xe::load<uint32_t>(buffer_ptr));
+    const uint8_t* command_ptr = buffer_ptr;
+    size_t command_length;
+    switch (type) {
+      case TraceCommandType::kPrimaryBufferStart:
+        command_length = sizeof(PrimaryBufferStartCommand);
+        break;
+      case TraceCommandType::kPrimaryBufferEnd:
+        command_length = sizeof(PrimaryBufferEndCommand);
+        break;
+      case TraceCommandType::kIndirectBufferStart:
+        command_length = sizeof(IndirectBufferStartCommand);
+        break;
+      case TraceCommandType::kIndirectBufferEnd:
+        command_length = sizeof(IndirectBufferEndCommand);
+        break;
+      case TraceCommandType::kPacketStart: {
+        PacketStartCommand cmd;
+        std::memcpy(&cmd, buffer_ptr, sizeof(cmd));
+        command_length = sizeof(cmd) + sizeof(uint32_t) * cmd.count;
+      } break;
+      case TraceCommandType::kPacketEnd:
+        command_length = sizeof(PacketEndCommand);
+        break;
+      case TraceCommandType::kMemoryRead:
+      case TraceCommandType::kMemoryWrite: {
+        MemoryCommand cmd;
+        std::memcpy(&cmd, buffer_ptr, sizeof(cmd));
+        buffer_ptr += sizeof(cmd) + cmd.decoded_length;
+        const uint8_t* data = command_ptr + sizeof(cmd);
+        if (type == TraceCommandType::kMemoryRead &&
+            cmd.decoded_length >= kMinDeduplicatedLength) {
+          XXH128_hash_t hash = XXH3_128bits(data, cmd.decoded_length);
+          MemoryReadKey key;
+          key.hash_low = hash.low64;
+          key.hash_high = hash.high64;
+          key.length = cmd.decoded_length;
+          auto written_it = written_memory_reads_.find(key);
+          if (written_it != written_memory_reads_.end()) {
+            cmd.encoding_format = MemoryEncodingFormat::kReference;
+            cmd.encoded_length = uint32_t(sizeof(uint64_t));
+            size_t output_offset = output_buffer_.size();
+            output_buffer_.resize(output_offset + sizeof(cmd) +
+                                  sizeof(uint64_t));
+            std::memcpy(output_buffer_.data() + output_offset, &cmd,
+                        sizeof(cmd));
+            std::memcpy(output_buffer_.data() + output_offset + sizeof(cmd),
+                        &written_it->second, sizeof(uint64_t));
+            continue;
+          }
+          written_memory_reads_.emplace(
+              key, file_offset_ + output_buffer_.size());
+        }
+        EncodeCommandWithData(cmd, data, cmd.decoded_length);
+        continue;
+      }
+      case TraceCommandType::kEdramSnapshot: {
+        EdramSnapshotCommand cmd;
+        std::memcpy(&cmd, buffer_ptr, sizeof(cmd));
+        buffer_ptr += sizeof(cmd) + cmd.encoded_length;
+        EncodeCommandWithData(cmd, command_ptr + sizeof(cmd),
+                              cmd.encoded_length);
+        continue;
+      }
+      case TraceCommandType::kEvent:
+        command_length = sizeof(EventCommand);
+        break;
+      case TraceCommandType::kRegisters: {
+        RegistersCommand cmd;
+        std::memcpy(&cmd, buffer_ptr, sizeof(cmd));
+        buffer_ptr += sizeof(cmd) + cmd.encoded_length;
+        EncodeCommandWithData(cmd, command_ptr + sizeof(cmd),
+                              cmd.encoded_length);
+        continue;
+      }
+      case TraceCommandType::kGammaRamp: {
+        GammaRampCommand cmd;
+        std::memcpy(&cmd, buffer_ptr, sizeof(cmd));
+        buffer_ptr += sizeof(cmd) + cmd.encoded_length;
+        EncodeCommandWithData(cmd, command_ptr + sizeof(cmd),
+                              cmd.encoded_length);
+        continue;
+      }
+      default:
+        // Only the commands recorded by this class can be in the buffer.
+        assert_unhandled_case(type);
+        return;
+    }
+    // Commands without encoded data.
+    output_buffer_.insert(output_buffer_.end(), command_ptr,
+                          command_ptr + command_length);
+    buffer_ptr += command_length;
+  }
+}
+
+MemoryEncodingFormat TraceWriter::EncodePayload(const void* data,
+                                                size_t length,
+                                                uint32_t& encoded_length_out) {
+  size_t output_offset = output_buffer_.size();
+  if (compression_context_ && length > compression_threshold_) {
+    output_buffer_.resize(output_offset + ZSTD_compressBound(length));
+    size_t compressed_length = ZSTD_compressCCtx(
+        compression_context_, output_buffer_.data() + output_offset,
+        output_buffer_.size() - output_offset, data, length,
+        compression_level_);
+    if (!ZSTD_isError(compressed_length) && compressed_length < length) {
+      output_buffer_.resize(output_offset + compressed_length);
+      encoded_length_out = uint32_t(compressed_length);
+      return MemoryEncodingFormat::kZstd;
+    }
   }
+  // Not compressible - store as is.
+  output_buffer_.resize(output_offset + length);
+  std::memcpy(output_buffer_.data() + output_offset, data, length);
+  encoded_length_out = uint32_t(length);
+  return MemoryEncodingFormat::kNone;
 }
 
 void TraceWriter::WritePrimaryBufferStart(uint32_t base_ptr, uint32_t count) {
@@ -82,7 +310,7 @@ void TraceWriter::WritePrimaryBufferStart(uint32_t base_ptr, uint32_t count) {
       base_ptr,
       0,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WritePrimaryBufferEnd() {
@@ -92,7 +320,7 @@ void TraceWriter::WritePrimaryBufferEnd() {
   PrimaryBufferEndCommand cmd = {
       TraceCommandType::kPrimaryBufferEnd,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WriteIndirectBufferStart(uint32_t base_ptr, uint32_t count) {
@@ -104,7 +332,7 @@ void TraceWriter::WriteIndirectBufferStart(uint32_t base_ptr, uint32_t count) {
       base_ptr,
       0,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WriteIndirectBufferEnd() {
@@ -114,7 +342,7 @@ void TraceWriter::WriteIndirectBufferEnd() {
   IndirectBufferEndCommand cmd = {
       TraceCommandType::kIndirectBufferEnd,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WritePacketStart(uint32_t base_ptr, uint32_t count) {
@@ -126,8 +354,9 @@ void TraceWriter::WritePacketStart(uint32_t base_ptr, uint32_t count) {
       base_ptr,
       count,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
-  fwrite(membase_ + base_ptr, 4, count, file_);
+  Append(&cmd, sizeof(cmd));
+  Append(membase_ + base_ptr, sizeof(uint32_t) * count);
+  HandOffBufferIfFull();
 }
 
 void TraceWriter::WritePacketEnd() {
@@ -137,7 +366,7 @@ void TraceWriter::WritePacketEnd() {
   PacketEndCommand cmd = {
       TraceCommandType::kPacketEnd,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WriteMemoryRead(uint32_t base_ptr, size_t length,
@@ -182,18 +411,6 @@ void TraceWriter::WriteMemoryWrite(uint32_t base_ptr, size_t length,
                      host_ptr);
 }
 
-class SnappySink : public snappy::Sink {
- public:
-  SnappySink(FILE* file) : file_(file) {}
-
-  void Append(const char* bytes, size_t n) override {
-    fwrite(bytes, 1, n, file_);
-  }
-
- private:
-  FILE* file_ = nullptr;
-};
-
 void TraceWriter::WriteMemoryCommand(TraceCommandType type, uint32_t base_ptr,
                                      size_t length, const void* host_ptr) {
   MemoryCommand cmd = {};
@@ -206,62 +423,24 @@ void TraceWriter::WriteMemoryCommand(TraceCommandType type, uint32_t base_ptr,
     host_ptr = membase_ + cmd.base_ptr;
   }
 
-  bool compress = compress_output_ && length > compression_threshold_;
-  if (compress) {
-    // Write the header now so we reserve space in the buffer.
-    long header_position = std::ftell(file_);
-    cmd.encoding_format = MemoryEncodingFormat::kSnappy;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-
-    // Stream the content right to the buffer.
-    snappy::ByteArraySource snappy_source(
-        reinterpret_cast<const char*>(host_ptr), cmd.decoded_length);
-    SnappySink snappy_sink(file_);
-    cmd.encoded_length =
-        static_cast<uint32_t>(snappy::Compress(&snappy_source, &snappy_sink));
-
-    // Seek back and overwrite the header with our final size.
-    std::fseek(file_, header_position, SEEK_SET);
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    std::fseek(file_, header_position + sizeof(cmd) + cmd.encoded_length,
-               SEEK_SET);
-  } else {
-    // Uncompressed - write buffer directly to the file.
-    cmd.encoding_format = MemoryEncodingFormat::kNone;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    fwrite(host_ptr, 1, cmd.decoded_length, file_);
-  }
+  // Copy the data as the memory may be modified before it's written - it's
+  // compressed on the writer thread.
+  Append(&cmd, sizeof(cmd));
+  Append(host_ptr, cmd.decoded_length);
+  HandOffBufferIfFull();
 }
 
 void TraceWriter::WriteEdramSnapshot(const void* snapshot) {
+  if (!file_) {
+    return;
+  }
   EdramSnapshotCommand cmd = {};
   cmd.type = TraceCommandType::kEdramSnapshot;
-
-  if (compress_output_) {
-    // Write the header now so we reserve space in the buffer.
-    long header_position = std::ftell(file_);
-    cmd.encoding_format = MemoryEncodingFormat::kSnappy;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-
-    // Stream the content right to the buffer.
-    snappy::ByteArraySource snappy_source(
-        reinterpret_cast<const char*>(snapshot), xenos::kEdramSizeBytes);
-    SnappySink snappy_sink(file_);
-    cmd.encoded_length =
-        static_cast<uint32_t>(snappy::Compress(&snappy_source, &snappy_sink));
-
-    // Seek back and overwrite the header with our final size.
-    std::fseek(file_, header_position, SEEK_SET);
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    std::fseek(file_, header_position + sizeof(cmd) + cmd.encoded_length,
-               SEEK_SET);
-  } else {
-    // Uncompressed - write buffer directly to the file.
-    cmd.encoding_format = MemoryEncodingFormat::kNone;
-    cmd.encoded_length = xenos::kEdramSizeBytes;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    fwrite(snapshot, 1, xenos::kEdramSizeBytes, file_);
-  }
+  cmd.encoding_format = MemoryEncodingFormat::kNone;
+  cmd.encoded_length = xenos::kEdramSizeBytes;
+  Append(&cmd, sizeof(cmd));
+  Append(snapshot, xenos::kEdramSizeBytes);
+  HandOffBufferIfFull();
 }
 
 void TraceWriter::WriteEvent(EventCommand::Type event_type) {
@@ -272,51 +451,35 @@ void TraceWriter::WriteEvent(EventCommand::Type event_type) {
       TraceCommandType::kEvent,
       event_type,
   };
-  fwrite(&cmd, 1, sizeof(cmd), file_);
+  Append(&cmd, sizeof(cmd));
 }
 
 void TraceWriter::WriteRegisters(uint32_t first_register,
                                  const uint32_t* register_values,
                                  uint32_t register_count,
                                  bool execute_callbacks_on_play) {
+  if (!file_) {
+    return;
+  }
   RegistersCommand cmd = {};
   cmd.type = TraceCommandType::kRegisters;
   cmd.first_register = first_register;
   cmd.register_count = register_count;
   cmd.execute_callbacks = execute_callbacks_on_play;
-
-  uint32_t uncompressed_length = uint32_t(sizeof(uint32_t) * register_count);
-  if (compress_output_) {
-    // Write the header now so we reserve space in the buffer.
-    long header_position = std::ftell(file_);
-    cmd.encoding_format = MemoryEncodingFormat::kSnappy;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-
-    // Stream the content right to the buffer.
-    snappy::ByteArraySource snappy_source(
-        reinterpret_cast<const char*>(register_values), uncompressed_length);
-    SnappySink snappy_sink(file_);
-    cmd.encoded_length =
-        static_cast<uint32_t>(snappy::Compress(&snappy_source, &snappy_sink));
-
-    // Seek back and overwrite the header with our final size.
-    std::fseek(file_, header_position, SEEK_SET);
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    std::fseek(file_, header_position + sizeof(cmd) + cmd.encoded_length,
-               SEEK_SET);
-  } else {
-    // Uncompressed - write the values directly to the file.
-    cmd.encoding_format = MemoryEncodingFormat::kNone;
-    cmd.encoded_length = uncompressed_length;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    fwrite(register_values, 1, uncompressed_length, file_);
-  }
+  cmd.encoding_format = MemoryEncodingFormat::kNone;
+  cmd.encoded_length = uint32_t(sizeof(uint32_t) * register_count);
+  Append(&cmd, sizeof(cmd));
+  Append(register_values, cmd.encoded_length);
+  HandOffBufferIfFull();
 }
 
 void TraceWriter::WriteGammaRamp(
     const reg::DC_LUT_30_COLOR* gamma_ramp_256_entry_table,
     const reg::DC_LUT_PWL_DATA* gamma_ramp_pwl_rgb,
     uint32_t gamma_ramp_rw_component) {
+  if (!file_) {
+    return;
+  }
   GammaRampCommand cmd = {};
   cmd.type = TraceCommandType::kGammaRamp;
   cmd.rw_component = uint8_t(gamma_ramp_rw_component);
@@ -325,42 +488,13 @@ void TraceWriter::WriteGammaRamp(
       sizeof(reg::DC_LUT_30_COLOR) * 256;
   constexpr uint32_t kPWLUncompressedLength =
       sizeof(reg::DC_LUT_PWL_DATA) * 3 * 128;
-  constexpr uint32_t kUncompressedLength =
+  cmd.encoding_format = MemoryEncodingFormat::kNone;
+  cmd.encoded_length =
       k256EntryTableUncompressedLength + kPWLUncompressedLength;
-  if (compress_output_) {
-    // Write the header now so we reserve space in the buffer.
-    long header_position = std::ftell(file_);
-    cmd.encoding_format = MemoryEncodingFormat::kSnappy;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-
-    // Stream the content right to the buffer.
-    {
-      std::unique_ptr<char[]> gamma_ramps(new char[kUncompressedLength]);
-      std::memcpy(gamma_ramps.get(), gamma_ramp_256_entry_table,
-                  k256EntryTableUncompressedLength);
-      std::memcpy(gamma_ramps.get() + k256EntryTableUncompressedLength,
-                  gamma_ramp_pwl_rgb, kPWLUncompressedLength);
-      snappy::ByteArraySource snappy_source(gamma_ramps.get(),
-                                            kUncompressedLength);
-      SnappySink snappy_sink(file_);
-      cmd.encoded_length =
-          static_cast<uint32_t>(snappy::Compress(&snappy_source, &snappy_sink));
-    }
-
-    // Seek back and overwrite the header with our final size.
-    std::fseek(file_, header_position, SEEK_SET);
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    std::fseek(file_, header_position + sizeof(cmd) + cmd.encoded_length,
-               SEEK_SET);
-  } else {
-    // Uncompressed - write the values directly to the file.
-    cmd.encoding_format = MemoryEncodingFormat::kNone;
-    cmd.encoded_length = kUncompressedLength;
-    fwrite(&cmd, 1, sizeof(cmd), file_);
-    fwrite(gamma_ramp_256_entry_table, 1, k256EntryTableUncompressedLength,
-           file_);
-    fwrite(gamma_ramp_pwl_rgb, 1, kPWLUncompressedLength, file_);
-  }
+  Append(&cmd, sizeof(cmd));
+  Append(gamma_ramp_256_entry_table, k256EntryTableUncompressedLength);
+  Append(gamma_ramp_pwl_rgb, kPWLUncompressedLength);
+  HandOffBufferIfFull();
 }
 #endif
 }  //  namespace gpu
@@ -10,10 +10,16 @@
 #ifndef XENIA_GPU_TRACE_WRITER_H_
 #define XENIA_GPU_TRACE_WRITER_H_
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "xenia/base/threading.h"
 #include "xenia/gpu/registers.h"
 #include "xenia/gpu/trace_protocol.h"
 
@@ -27,9 +33,19 @@
 #define XE_ENABLE_TRACE_WRITER_INSTRUMENTATION 1
 #endif
 
+#if XE_ENABLE_TRACE_WRITER_INSTRUMENTATION == 1
+typedef struct ZSTD_CCtx_s ZSTD_CCtx;
+#endif
+
 namespace xe {
 namespace gpu {
 
+// Commands are recorded, with the memory they reference copied, to an
+// in-memory buffer on the calling thread. Full buffers are handed off to a
+// background thread which compresses the payloads, replaces repeated memory
+// reads with references to the earlier copies, and writes the result to the
+// file, so tracing doesn't stall the command processor on compression and
+// disk I/O.
 class TraceWriter {
  public:
 #if XE_ENABLE_TRACE_WRITER_INSTRUMENTATION == 1
@@ -39,7 +55,10 @@ class TraceWriter {
   bool is_open() const { return file_ != nullptr; }
 
   bool Open(const std::filesystem::path& path, uint32_t title_id);
+  // Hands off everything recorded so far to the writer thread without waiting
+  // for it to be written.
   void Flush();
+  // Writes everything recorded so far and closes the file.
   void Close();
 
   void WritePrimaryBufferStart(uint32_t base_ptr, uint32_t count);
@@ -63,15 +82,77 @@ class TraceWriter {
                       uint32_t gamma_ramp_rw_component);
 
  private:
+  // Recorded data is handed off to the writer thread when the buffer reaches
+  // this size.
+  static constexpr size_t kBufferHandOffSize = 4 * 1024 * 1024;
+  // Memory reads smaller than this are always written, not referenced.
+  static constexpr size_t kMinDeduplicatedLength = 64;
+
   void WriteMemoryCommand(TraceCommandType type, uint32_t base_ptr,
                           size_t length, const void* host_ptr = nullptr);
+  void Append(const void* data, size_t length) {
+    const uint8_t* data_bytes = reinterpret_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), data_bytes, data_bytes + length);
+  }
+  void HandOffBufferIfFull() {
+    if (buffer_.size() >= kBufferHandOffSize) {
+      HandOffBuffer();
+    }
+  }
+  void HandOffBuffer();
+  void AwaitWriterIdle();
+
+  // Writer thread.
+  void WriterThreadMain();
+  void EncodeBuffer(const std::vector<uint8_t>& buffer);
+  // Appends the payload to output_buffer_, compressed if beneficial, returning
+  // the encoding format and setting the encoded length.
+  MemoryEncodingFormat EncodePayload(const void* data, size_t length,
+                                     uint32_t& encoded_length_out);
+  template <typename Command>
+  void EncodeCommandWithData(Command& cmd, const void* data,
+                             size_t data_length);
 
   std::set<uint64_t> cached_memory_reads_;
   uint8_t* membase_;
   FILE* file_;
 
-  bool compress_output_ = true;
+  // Recorded on the calling thread.
+  std::vector<uint8_t> buffer_;
+  // Owned by the writer thread while buffer_pending_ is true.
+  std::vector<uint8_t> pending_buffer_;
+  std::atomic<bool> buffer_pending_{false};
+  std::atomic<bool> writer_shutting_down_{false};
+  std::unique_ptr<xe::threading::Event> buffer_pending_event_;
+  std::unique_ptr<xe::threading::Event> buffer_written_event_;
+  std::unique_ptr<xe::threading::Thread> writer_thread_;
+
+  // Writer thread state.
+  ZSTD_CCtx* compression_context_ = nullptr;
+  int compression_level_ = 0;
   size_t compression_threshold_ = 1024;  // Min. number of bytes to compress.
+  std::vector<uint8_t> output_buffer_;
+  uint64_t file_offset_ = 0;
+  // Memory read content hash and length -> offset of the command containing
+  // the data in the file. The data itself is not kept for comparison, so the
+  // hash is 128-bit to make a collision between different data practically
+  // impossible.
+  struct MemoryReadKey {
+    uint64_t hash_low;
+    uint64_t hash_high;
+    uint32_t length;
+    bool operator==(const MemoryReadKey& other) const {
+      return hash_low == other.hash_low && hash_high == other.hash_high &&
+             length == other.length;
+    }
+  };
+  struct MemoryReadKeyHasher {
+    size_t operator()(const MemoryReadKey& key) const {
+      return size_t(key.hash_low);
+    }
+  };
+  std::unordered_map<MemoryReadKey, uint64_t, MemoryReadKeyHasher>
+      written_memory_reads_;
 
 #else
   // this could be annoying to maintain if new methods are added or the
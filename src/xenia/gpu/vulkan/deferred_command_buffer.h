@@ -32,6 +32,16 @@ class DeferredCommandBuffer {
   void Reset();
   void Execute(VkCommandBuffer command_buffer);
 
+  bool empty() const { return command_stream_.empty(); }
+  size_t size_bytes() const {
+    return command_stream_.size() * sizeof(uintmax_t);
+  }
+  // Exchanges the recorded commands with another deferred command buffer,
+  // keeping the allocated storage of both.
+  void Swap(DeferredCommandBuffer& other) {
+    command_stream_.swap(other.command_stream_);
+  }
+
   // render_pass_begin->pNext of all barriers must be null.
   void CmdVkBeginRenderPass(const VkRenderPassBeginInfo* render_pass_begin,
                             VkSubpassContents contents) {
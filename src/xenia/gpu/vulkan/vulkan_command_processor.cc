@@ -39,6 +39,14 @@
 #include "xenia/ui/vulkan/vulkan_provider.h"
 #include "xenia/ui/vulkan/vulkan_util.h"
 
+DEFINE_bool(
+    vulkan_submission_thread, false,
+    "Replay the recorded host commands into Vulkan command buffers and submit "
+    "them on a separate thread, overlapping that with PM4 processing and draw "
+    "setup on the GPU command processor thread. May improve performance in "
+    "draw-heavy games when the command processor thread is the bottleneck.",
+    "Vulkan");
+
 DECLARE_bool(clear_memory_page_state);
 
 namespace xe {
@@ -1036,12 +1044,24 @@ bool VulkanCommandProcessor::SetupContext() {
   // Just not to expose uninitialized memory.
   std::memset(&system_constants_, 0, sizeof(system_constants_));
 
+  if (cvars::vulkan_submission_thread) {
+    submission_thread_ = std::make_unique<VulkanSubmissionThread>(*this);
+    if (!submission_thread_->Initialize()) {
+      XELOGW(
+          "Failed to create the Vulkan submission thread, submitting on the "
+          "command processor thread");
+      submission_thread_.reset();
+    }
+  }
+
   return true;
 }
 
 void VulkanCommandProcessor::ShutdownContext() {
   AwaitAllQueueOperationsCompletion();
 
+  submission_thread_.reset();
+
   const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
@@ -1143,6 +1163,11 @@ void VulkanCommandProcessor::ShutdownContext() {
     dfn.vkDestroyCommandPool(device, command_buffer.pool, nullptr);
   }
   command_buffers_writable_.clear();
+  if (submission_thread_command_buffer_begun_) {
+    dfn.vkDestroyCommandPool(device, submission_thread_command_buffer_.pool,
+                             nullptr);
+    submission_thread_command_buffer_begun_ = false;
+  }
 
   for (const auto& destroy_pair : destroy_framebuffers_) {
     dfn.vkDestroyFramebuffer(device, destroy_pair.second, nullptr);
@@ -1592,6 +1617,7 @@ void VulkanCommandProcessor::IssueSwap(uint32_t frontbuffer_ptr,
         // presenter so it can submit its own commands for displaying it to the
         // queue, and also need to submit the release barrier.
         EndSubmission(true);
+        AwaitSubmissionThread();
         return true;
       });
 
@@ -2172,6 +2198,7 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
   SCOPE_profile_cpu_f("gpu");
 #endif  // XE_UI_VULKAN_FINE_GRAINED_DRAW_SCOPES
 
+  draw_state_cache_.BeginDraw(*register_file_);
   const RegisterFile& regs = *register_file_;
 
   xenos::ModeControl edram_mode = regs.Get<reg::RB_MODECONTROL>().edram_mode;
@@ -2371,9 +2398,9 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
 
   // Set up the render targets - this may perform dispatches and draws.
   reg::RB_DEPTHCONTROL normalized_depth_control =
-      draw_util::GetNormalizedDepthControl(regs);
+      draw_state_cache_.GetNormalizedDepthControl(regs);
   uint32_t normalized_color_mask =
-      pixel_shader ? draw_util::GetNormalizedColorMask(
+      pixel_shader ? draw_state_cache_.GetNormalizedColorMask(
                          regs, pixel_shader->writes_color_targets())
                    : 0;
   if (!render_target_cache_->Update(is_rasterization_done,
@@ -2474,9 +2501,7 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
                 device_info.maxViewportDimensions[1], true,
                 normalized_depth_control, false, host_render_targets_used,
                 pixel_shader && pixel_shader->writes_depth());
-  gviargs.SetupRegisterValues(regs);
-
-  draw_util::GetHostViewportInfo(&gviargs, viewport_info);
+  draw_state_cache_.GetHostViewportInfo(regs, gviargs, viewport_info);
 
   // Update dynamic graphics pipeline state.
   UpdateDynamicState(viewport_info, primitive_polygonal,
@@ -2635,6 +2660,13 @@ bool VulkanCommandProcessor::IssueDraw(xenos::PrimitiveType prim_type,
                                       memexport_range.size_bytes, false);
   }
 
+  if (submission_thread_ &&
+      (!memexport_ranges_.empty() ||
+       deferred_command_buffer_.size_bytes() >=
+           kSubmissionThreadHandOffThreshold)) {
+    HandOffDeferredCommands();
+  }
+
   return true;
 }
 
@@ -2655,9 +2687,21 @@ bool VulkanCommandProcessor::IssueCopy() {
 
   // TODO(Triang3l): CPU readback.
 
+  // Resolves are usually followed by draws using the result, get the copying
+  // to the GPU early.
+  HandOffDeferredCommands();
+
   return true;
 }
 
+void VulkanCommandProcessor::PrepareForWait() {
+  CommandProcessor::PrepareForWait();
+  // WAIT_REG_MEM - the guest is likely waiting for the GPU to reach some
+  // point, let the submission thread record what has been done so far while
+  // the command processor thread is sleeping.
+  HandOffDeferredCommands();
+}
+
 void VulkanCommandProcessor::InitializeTrace() {
   CommandProcessor::InitializeTrace();
 
@@ -2692,6 +2736,16 @@ void VulkanCommandProcessor::CheckSubmissionFenceAndDeviceLoss(
     await_submission = GetCurrentSubmission() - 1;
   }
 
+  // The fences can be awaited in a blocking way only after the submissions
+  // have actually reached the queue.
+  if (submission_thread_ && (await_submission > submission_completed_ ||
+                             submission_thread_->has_failed())) {
+    AwaitSubmissionThread();
+    if (device_lost_) {
+      return;
+    }
+  }
+
   const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
@@ -2989,34 +3043,9 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
       }
       semaphores_free_.push_back(semaphore);
     }
-    if (command_buffers_writable_.empty()) {
-      CommandBuffer command_buffer;
-      VkCommandPoolCreateInfo command_pool_create_info;
-      command_pool_create_info.sType =
-          VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-      command_pool_create_info.pNext = nullptr;
-      command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
-      command_pool_create_info.queueFamilyIndex =
-          provider.queue_family_graphics_compute();
-      if (dfn.vkCreateCommandPool(device, &command_pool_create_info, nullptr,
-                                  &command_buffer.pool) != VK_SUCCESS) {
-        XELOGE("Failed to create a Vulkan command pool");
-        return false;
-      }
-      VkCommandBufferAllocateInfo command_buffer_allocate_info;
-      command_buffer_allocate_info.sType =
-          VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-      command_buffer_allocate_info.pNext = nullptr;
-      command_buffer_allocate_info.commandPool = command_buffer.pool;
-      command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-      command_buffer_allocate_info.commandBufferCount = 1;
-      if (dfn.vkAllocateCommandBuffers(device, &command_buffer_allocate_info,
-                                       &command_buffer.buffer) != VK_SUCCESS) {
-        XELOGE("Failed to allocate a Vulkan command buffer");
-        dfn.vkDestroyCommandPool(device, command_buffer.pool, nullptr);
-        return false;
-      }
-      command_buffers_writable_.push_back(command_buffer);
+    if (!submission_thread_command_buffer_begun_ &&
+        !EnsureWritableCommandBuffer()) {
+      return false;
     }
   }
 
@@ -3093,68 +3122,88 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
 
     SubmitBarriers(true);
 
-    assert_false(command_buffers_writable_.empty());
-    CommandBuffer command_buffer = command_buffers_writable_.back();
-    if (dfn.vkResetCommandPool(device, command_buffer.pool, 0) != VK_SUCCESS) {
-      XELOGE("Failed to reset a Vulkan command pool");
-      return false;
-    }
-    VkCommandBufferBeginInfo command_buffer_begin_info;
-    command_buffer_begin_info.sType =
-        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    command_buffer_begin_info.pNext = nullptr;
-    command_buffer_begin_info.flags =
-        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    command_buffer_begin_info.pInheritanceInfo = nullptr;
-    if (dfn.vkBeginCommandBuffer(command_buffer.buffer,
-                                 &command_buffer_begin_info) != VK_SUCCESS) {
-      XELOGE("Failed to begin a Vulkan command buffer");
-      return false;
-    }
-    deferred_command_buffer_.Execute(command_buffer.buffer);
-    if (dfn.vkEndCommandBuffer(command_buffer.buffer) != VK_SUCCESS) {
-      XELOGE("Failed to end a Vulkan command buffer");
-      return false;
-    }
-
-    VkSubmitInfo submit_info;
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.pNext = nullptr;
-    if (!current_submission_wait_semaphores_.empty()) {
-      submit_info.waitSemaphoreCount =
-          uint32_t(current_submission_wait_semaphores_.size());
-      submit_info.pWaitSemaphores = current_submission_wait_semaphores_.data();
-      submit_info.pWaitDstStageMask =
-          current_submission_wait_stage_masks_.data();
+    CommandBuffer command_buffer;
+    if (submission_thread_command_buffer_begun_) {
+      command_buffer = submission_thread_command_buffer_;
     } else {
-      submit_info.waitSemaphoreCount = 0;
-      submit_info.pWaitSemaphores = nullptr;
-      submit_info.pWaitDstStageMask = nullptr;
+      assert_false(command_buffers_writable_.empty());
+      command_buffer = command_buffers_writable_.back();
     }
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &command_buffer.buffer;
-    submit_info.signalSemaphoreCount = 0;
-    submit_info.pSignalSemaphores = nullptr;
     assert_false(fences_free_.empty());
     VkFence fence = fences_free_.back();
-    if (dfn.vkResetFences(device, 1, &fence) != VK_SUCCESS) {
-      XELOGE("Failed to reset a Vulkan submission fence");
-      return false;
-    }
-    VkResult submit_result;
-    {
-      ui::vulkan::VulkanProvider::QueueAcquisition queue_acquisition(
-          provider.AcquireQueue(provider.queue_family_graphics_compute(), 0));
-      submit_result =
-          dfn.vkQueueSubmit(queue_acquisition.queue, 1, &submit_info, fence);
-    }
-    if (submit_result != VK_SUCCESS) {
-      XELOGE("Failed to submit a Vulkan command buffer");
-      if (submit_result == VK_ERROR_DEVICE_LOST && !device_lost_) {
-        device_lost_ = true;
-        graphics_system_->OnHostGpuLossFromAnyThread(true);
+    if (submission_thread_) {
+      if (dfn.vkResetFences(device, 1, &fence) != VK_SUCCESS) {
+        XELOGE("Failed to reset a Vulkan submission fence");
+        return false;
+      }
+      submission_thread_->Execute(command_buffer.pool, command_buffer.buffer,
+                                  !submission_thread_command_buffer_begun_,
+                                  deferred_command_buffer_);
+      submission_thread_->Submit(command_buffer.buffer,
+                                 current_submission_wait_semaphores_,
+                                 current_submission_wait_stage_masks_, fence);
+    } else {
+      if (dfn.vkResetCommandPool(device, command_buffer.pool, 0) !=
+          VK_SUCCESS) {
+        XELOGE("Failed to reset a Vulkan command pool");
+        return false;
+      }
+      VkCommandBufferBeginInfo command_buffer_begin_info;
+      command_buffer_begin_info.sType =
+          VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+      command_buffer_begin_info.pNext = nullptr;
+      command_buffer_begin_info.flags =
+          VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+      command_buffer_begin_info.pInheritanceInfo = nullptr;
+      if (dfn.vkBeginCommandBuffer(command_buffer.buffer,
+                                   &command_buffer_begin_info) != VK_SUCCESS) {
+        XELOGE("Failed to begin a Vulkan command buffer");
+        return false;
+      }
+      deferred_command_buffer_.Execute(command_buffer.buffer);
+      if (dfn.vkEndCommandBuffer(command_buffer.buffer) != VK_SUCCESS) {
+        XELOGE("Failed to end a Vulkan command buffer");
+        return false;
+      }
+
+      VkSubmitInfo submit_info;
+      submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+      submit_info.pNext = nullptr;
+      if (!current_submission_wait_semaphores_.empty()) {
+        submit_info.waitSemaphoreCount =
+            uint32_t(current_submission_wait_semaphores_.size());
+        submit_info.pWaitSemaphores =
+            current_submission_wait_semaphores_.data();
+        submit_info.pWaitDstStageMask =
+            current_submission_wait_stage_masks_.data();
+      } else {
+        submit_info.waitSemaphoreCount = 0;
+        submit_info.pWaitSemaphores = nullptr;
+        submit_info.pWaitDstStageMask = nullptr;
+      }
+      submit_info.commandBufferCount = 1;
+      submit_info.pCommandBuffers = &command_buffer.buffer;
+      submit_info.signalSemaphoreCount = 0;
+      submit_info.pSignalSemaphores = nullptr;
+      if (dfn.vkResetFences(device, 1, &fence) != VK_SUCCESS) {
+        XELOGE("Failed to reset a Vulkan submission fence");
+        return false;
+      }
+      VkResult submit_result;
+      {
+        ui::vulkan::VulkanProvider::QueueAcquisition queue_acquisition(
+            provider.AcquireQueue(provider.queue_family_graphics_compute(), 0));
+        submit_result =
+            dfn.vkQueueSubmit(queue_acquisition.queue, 1, &submit_info, fence);
+      }
+      if (submit_result != VK_SUCCESS) {
+        XELOGE("Failed to submit a Vulkan command buffer");
+        if (submit_result == VK_ERROR_DEVICE_LOST && !device_lost_) {
+          device_lost_ = true;
+          graphics_system_->OnHostGpuLossFromAnyThread(true);
+        }
+        return false;
       }
-      return false;
     }
     uint64_t submission_current = GetCurrentSubmission();
     current_submission_wait_stage_masks_.clear();
@@ -3164,7 +3213,11 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
     }
     current_submission_wait_semaphores_.clear();
     command_buffers_submitted_.emplace_back(submission_current, command_buffer);
-    command_buffers_writable_.pop_back();
+    if (submission_thread_command_buffer_begun_) {
+      submission_thread_command_buffer_begun_ = false;
+    } else {
+      command_buffers_writable_.pop_back();
+    }
     // Increments the current submission number, going to the next submission.
     submissions_in_flight_fences_.push_back(fence);
     fences_free_.pop_back();
@@ -3218,6 +3271,76 @@ bool VulkanCommandProcessor::EndSubmission(bool is_swap) {
   return true;
 }
 
+bool VulkanCommandProcessor::EnsureWritableCommandBuffer() {
+  if (!command_buffers_writable_.empty()) {
+    return true;
+  }
+  const ui::vulkan::VulkanProvider& provider = GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+  CommandBuffer command_buffer;
+  VkCommandPoolCreateInfo command_pool_create_info;
+  command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  command_pool_create_info.pNext = nullptr;
+  command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  command_pool_create_info.queueFamilyIndex =
+      provider.queue_family_graphics_compute();
+  if (dfn.vkCreateCommandPool(device, &command_pool_create_info, nullptr,
+                              &command_buffer.pool) != VK_SUCCESS) {
+    XELOGE("Failed to create a Vulkan command pool");
+    return false;
+  }
+  VkCommandBufferAllocateInfo command_buffer_allocate_info;
+  command_buffer_allocate_info.sType =
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  command_buffer_allocate_info.pNext = nullptr;
+  command_buffer_allocate_info.commandPool = command_buffer.pool;
+  command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+  command_buffer_allocate_info.commandBufferCount = 1;
+  if (dfn.vkAllocateCommandBuffers(device, &command_buffer_allocate_info,
+                                   &command_buffer.buffer) != VK_SUCCESS) {
+    XELOGE("Failed to allocate a Vulkan command buffer");
+    dfn.vkDestroyCommandPool(device, command_buffer.pool, nullptr);
+    return false;
+  }
+  command_buffers_writable_.push_back(command_buffer);
+  return true;
+}
+
+void VulkanCommandProcessor::HandOffDeferredCommands() {
+  if (!submission_thread_ || !submission_open_ ||
+      deferred_command_buffer_.empty()) {
+    return;
+  }
+  if (!submission_thread_command_buffer_begun_) {
+    if (!EnsureWritableCommandBuffer()) {
+      // Everything will be handed off in the end of the submission anyway.
+      return;
+    }
+    // Take it out of the writable list right away so it's not affected by
+    // command buffers being reclaimed during the submission.
+    submission_thread_command_buffer_ = command_buffers_writable_.back();
+    command_buffers_writable_.pop_back();
+  }
+  submission_thread_->Execute(submission_thread_command_buffer_.pool,
+                              submission_thread_command_buffer_.buffer,
+                              !submission_thread_command_buffer_begun_,
+                              deferred_command_buffer_);
+  submission_thread_command_buffer_begun_ = true;
+}
+
+void VulkanCommandProcessor::AwaitSubmissionThread() {
+  if (!submission_thread_) {
+    return;
+  }
+  submission_thread_->AwaitIdle();
+  if (submission_thread_->has_failed() && !device_lost_) {
+    device_lost_ = true;
+    graphics_system_->OnHostGpuLossFromAnyThread(
+        submission_thread_->is_device_lost());
+  }
+}
+
 void VulkanCommandProcessor::ClearTransientDescriptorPools() {
   texture_transient_descriptor_sets_free_.clear();
   texture_transient_descriptor_sets_used_.clear();
@@ -3310,7 +3433,7 @@ void VulkanCommandProcessor::UpdateDynamicState(
 
   // Scissor.
   draw_util::Scissor scissor;
-  draw_util::GetScissor(regs, scissor);
+  draw_state_cache_.GetScissor(regs, scissor);
   VkRect2D scissor_rect;
   scissor_rect.offset.x = int32_t(scissor.offset[0]);
   scissor_rect.offset.y = int32_t(scissor.offset[1]);
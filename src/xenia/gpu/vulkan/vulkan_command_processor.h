@@ -34,6 +34,7 @@
 #include "xenia/gpu/vulkan/vulkan_render_target_cache.h"
 #include "xenia/gpu/vulkan/vulkan_shader.h"
 #include "xenia/gpu/vulkan/vulkan_shared_memory.h"
+#include "xenia/gpu/vulkan/vulkan_submission_thread.h"
 #include "xenia/gpu/vulkan/vulkan_texture_cache.h"
 #include "xenia/gpu/xenos.h"
 #include "xenia/kernel/kernel_state.h"
@@ -290,6 +291,8 @@ class VulkanCommandProcessor final : public CommandProcessor {
 
   void InitializeTrace() override;
 
+  void PrepareForWait() override;
+
  private:
   struct CommandBuffer {
     VkCommandPool pool;
@@ -430,6 +433,18 @@ class VulkanCommandProcessor final : public CommandProcessor {
   // clearing and stopping capturing. Returns whether the submission was done
   // successfully, if it has failed, leaves it open.
   bool EndSubmission(bool is_swap);
+  // Creates a command buffer for the next submission if none are available.
+  bool EnsureWritableCommandBuffer();
+  // If the submission thread is used, hands off the commands recorded in the
+  // deferred command buffer so far, so they are replayed into the host command
+  // buffer while the command processor thread continues processing. Done at
+  // resolves, memory export and once enough commands have been recorded.
+  void HandOffDeferredCommands();
+  // Synchronization point with the submission thread - waits until everything
+  // handed off to it has reached the queue, and handles its failure as a
+  // device loss since the fences of the failed submissions will never be
+  // signaled.
+  void AwaitSubmissionThread();
   bool AwaitAllQueueOperationsCompletion() {
     CheckSubmissionFenceAndDeviceLoss(GetCurrentSubmission());
     return !submission_open_ && submissions_in_flight_fences_.empty();
@@ -508,6 +523,16 @@ class VulkanCommandProcessor final : public CommandProcessor {
   std::deque<std::pair<uint64_t, CommandBuffer>> command_buffers_submitted_;
   DeferredCommandBuffer deferred_command_buffer_;
 
+  // Replays the deferred command buffer and submits on another thread if
+  // pipelined submission is enabled.
+  static constexpr size_t kSubmissionThreadHandOffThreshold = 256 * 1024;
+  std::unique_ptr<VulkanSubmissionThread> submission_thread_;
+  // The command buffer of the open submission, taken out of
+  // command_buffers_writable_ when the first commands are handed off to the
+  // submission thread.
+  CommandBuffer submission_thread_command_buffer_ = {};
+  bool submission_thread_command_buffer_begun_ = false;
+
   std::vector<VkSparseMemoryBind> sparse_memory_binds_;
   std::vector<SparseBufferBind> sparse_buffer_binds_;
   // SparseBufferBind converted to VkSparseBufferMemoryBindInfo to this buffer
@@ -19,6 +19,7 @@
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
 #include "xenia/base/profiling.h"
@@ -38,6 +39,52 @@ namespace xe {
 namespace gpu {
 namespace vulkan {
 
+class VulkanPipelineCache::TranslationWorker
+    : public ShaderTranslationPool::Worker {
+ public:
+  explicit TranslationWorker(VulkanPipelineCache& pipeline_cache)
+      : pipeline_cache_(pipeline_cache),
+        translator_(
+            SpirvShaderTranslator::Features(
+                pipeline_cache.command_processor_.GetVulkanProvider()
+                    .device_info()),
+            pipeline_cache.render_target_cache_
+                .msaa_2x_attachments_supported(),
+            pipeline_cache.render_target_cache_
+                .msaa_2x_no_attachments_supported(),
+            pipeline_cache.render_target_cache_.GetPath() ==
+                RenderTargetCache::Path::kPixelShaderInterlock) {}
+
+  bool Translate(Shader::Translation& translation) override {
+    return pipeline_cache_.TranslateAnalyzedShader(
+        translator_,
+        static_cast<VulkanShader::VulkanTranslation&>(translation));
+  }
+
+  uint64_t PredictModification(const Shader& shader,
+                               uint64_t last_modification,
+                               uint32_t program_cntl_num_reg) override {
+    // Keep the state-dependent parts, but take what depends on the shader
+    // itself from the new shader.
+    SpirvShaderTranslator::Modification modification(last_modification);
+    uint32_t dynamic_addressable_register_count =
+        shader.GetDynamicAddressableRegisterCount(program_cntl_num_reg);
+    if (shader.type() == xenos::ShaderType::kVertex) {
+      modification.vertex.dynamic_addressable_register_count =
+          dynamic_addressable_register_count;
+      modification.vertex.interpolator_mask &= shader.writes_interpolators();
+    } else {
+      modification.pixel.dynamic_addressable_register_count =
+          dynamic_addressable_register_count;
+    }
+    return modification.value;
+  }
+
+ private:
+  VulkanPipelineCache& pipeline_cache_;
+  SpirvShaderTranslator translator_;
+};
+
 VulkanPipelineCache::VulkanPipelineCache(
     VulkanCommandProcessor& command_processor,
     const RegisterFile& register_file,
@@ -81,6 +128,11 @@ bool VulkanPipelineCache::Initialize() {
     }
   }
 
+  last_vertex_shader_modification_.reset();
+  last_pixel_shader_modification_.reset();
+  translation_pool_.Initialize(
+      [this]() { return std::make_unique<TranslationWorker>(*this); });
+
   return true;
 }
 
@@ -90,6 +142,9 @@ void VulkanPipelineCache::Shutdown() {
   const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
   VkDevice device = provider.device();
 
+  // Stop background shader translation before destroying the shaders.
+  translation_pool_.Shutdown();
+
   // Destroy all pipelines.
   last_pipeline_ = nullptr;
   for (const auto& pipeline_pair : pipelines_) {
@@ -139,6 +194,15 @@ VulkanShader* VulkanPipelineCache::LoadShader(xenos::ShaderType shader_type,
       new VulkanShader(command_processor_.GetVulkanProvider(), shader_type,
                        data_hash, host_address, dword_count);
   shaders_.emplace(data_hash, shader);
+  // Start analyzing and translating it ahead of the draws.
+  auto sq_program_cntl = register_file_.Get<reg::SQ_PROGRAM_CNTL>();
+  if (shader_type == xenos::ShaderType::kVertex) {
+    translation_pool_.Prefetch(*shader, last_vertex_shader_modification_,
+                               sq_program_cntl.vs_num_reg);
+  } else {
+    translation_pool_.Prefetch(*shader, last_pixel_shader_modification_,
+                               sq_program_cntl.ps_num_reg);
+  }
   return shader;
 }
 
@@ -232,6 +296,12 @@ bool VulkanPipelineCache::EnsureShadersTranslated(
               register_file_.Get<reg::SQ_PROGRAM_CNTL>().vs_export_mode !=
                   xenos::VertexShaderExportMode::kPosition2VectorsEdgeKill);
   assert_false(register_file_.Get<reg::SQ_PROGRAM_CNTL>().gen_index_vtx);
+  // If both shaders are new, translate the fragment shader in the background
+  // while translating the vertex shader.
+  if (pixel_shader != nullptr && !pixel_shader->is_translated() &&
+      !vertex_shader->is_translated() && translation_pool_.is_active()) {
+    translation_pool_.Translate(*pixel_shader);
+  }
   if (!vertex_shader->is_translated()) {
     vertex_shader->shader().AnalyzeUcode(ucode_disasm_buffer_);
     if (!TranslateAnalyzedShader(*shader_translator_, *vertex_shader)) {
@@ -243,7 +313,9 @@ bool VulkanPipelineCache::EnsureShadersTranslated(
     // Translation attempted previously, but not valid.
     return false;
   }
+  last_vertex_shader_modification_ = vertex_shader->modification();
   if (pixel_shader != nullptr) {
+    translation_pool_.WaitForShader(pixel_shader->shader());
     if (!pixel_shader->is_translated()) {
       pixel_shader->shader().AnalyzeUcode(ucode_disasm_buffer_);
       if (!TranslateAnalyzedShader(*shader_translator_, *pixel_shader)) {
@@ -255,6 +327,7 @@ bool VulkanPipelineCache::EnsureShadersTranslated(
       // Translation attempted previously, but not valid.
       return false;
     }
+    last_pixel_shader_modification_ = pixel_shader->modification();
   }
   return true;
 }
@@ -385,6 +458,7 @@ bool VulkanPipelineCache::TranslateAnalyzedShader(
         shader.GetTextureBindingsAfterTranslation();
     size_t texture_binding_count = texture_bindings.size();
     if (texture_binding_count) {
+      std::lock_guard<std::mutex> layouts_lock(layouts_mutex_);
       size_t texture_binding_layout_bytes =
           texture_binding_count * sizeof(*texture_bindings.data());
       uint64_t texture_binding_layout_hash =
@@ -1869,6 +1943,7 @@ bool VulkanPipelineCache::EnsurePipelineCreated(
   if (creation_arguments.pipeline->second.pipeline != VK_NULL_HANDLE) {
     return true;
   }
+  frame_telemetry::AddToCounter(frame_telemetry::Counter::kPipelineCreations);
 
   // This function preferably should validate the description to prevent
   // unsupported behavior that may be dangerous/crashing because pipelines can
@@ -14,6 +14,7 @@
 #include <cstring>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <utility>
 
@@ -23,6 +24,7 @@
 #include "xenia/gpu/primitive_processor.h"
 #include "xenia/gpu/register_file.h"
 #include "xenia/gpu/registers.h"
+#include "xenia/gpu/shader_translation_pool.h"
 #include "xenia/gpu/spirv_shader_translator.h"
 #include "xenia/gpu/vulkan/vulkan_render_target_cache.h"
 #include "xenia/gpu/vulkan/vulkan_shader.h"
@@ -59,10 +61,14 @@ class VulkanPipelineCache {
   bool Initialize();
   void Shutdown();
 
+  // Loads a shader from the guest, and starts its translation in the
+  // background if it's new.
   VulkanShader* LoadShader(xenos::ShaderType shader_type,
                            const uint32_t* host_address, uint32_t dword_count);
-  // Analyze shader microcode on the translator thread.
+  // Analyze shader microcode on the translator thread, or wait for the
+  // background analysis.
   void AnalyzeShaderUcode(Shader& shader) {
+    translation_pool_.WaitForShader(shader);
     shader.AnalyzeUcode(ucode_disasm_buffer_);
   }
 
@@ -250,6 +256,9 @@ class VulkanPipelineCache {
   bool TranslateAnalyzedShader(SpirvShaderTranslator& translator,
                                VulkanShader::VulkanTranslation& translation);
 
+  // Translates shaders on the background translation threads.
+  class TranslationWorker;
+
   void WritePipelineRenderTargetDescription(
       reg::RB_BLENDCONTROL blend_control, uint32_t write_mask,
       PipelineRenderTarget& render_target_out) const;
@@ -288,6 +297,12 @@ class VulkanPipelineCache {
   // Reusable shader translator on the command processor thread.
   std::unique_ptr<SpirvShaderTranslator> shader_translator_;
 
+  ShaderTranslationPool translation_pool_;
+  // Modifications of the shaders used by the last draw, for guessing the
+  // modifications of new shaders to translate them before they're drawn.
+  std::optional<uint64_t> last_vertex_shader_modification_;
+  std::optional<uint64_t> last_pixel_shader_modification_;
+
   struct LayoutUID {
     size_t uid;
     size_t vector_span_offset;
@@ -0,0 +1,222 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/gpu/vulkan/vulkan_submission_thread.h"
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+#include "xenia/base/profiling.h"
+#include "xenia/gpu/vulkan/vulkan_command_processor.h"
+
+namespace xe {
+namespace gpu {
+namespace vulkan {
+
+VulkanSubmissionThread::VulkanSubmissionThread(
+    const VulkanCommandProcessor& command_processor)
+    : command_processor_(command_processor) {
+  static_assert(!(kQueueSize & (kQueueSize - 1)),
+                "The submission queue size must be a power of two");
+}
+
+VulkanSubmissionThread::~VulkanSubmissionThread() { Shutdown(); }
+
+bool VulkanSubmissionThread::Initialize() {
+  for (Job& job : jobs_) {
+    job.commands = std::make_unique<DeferredCommandBuffer>(command_processor_);
+  }
+  job_available_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  job_completed_event_ = xe::threading::Event::CreateAutoResetEvent(false);
+  if (!job_available_event_ || !job_completed_event_) {
+    XELOGE("Failed to create the Vulkan submission thread events");
+    Shutdown();
+    return false;
+  }
+  shutting_down_.store(false, std::memory_order_relaxed);
+  failed_.store(false, std::memory_order_relaxed);
+  device_lost_.store(false, std::memory_order_relaxed);
+  thread_ = xe::threading::Thread::Create({}, [this]() { ThreadMain(); });
+  if (!thread_) {
+    XELOGE("Failed to create the Vulkan submission thread");
+    Shutdown();
+    return false;
+  }
+  thread_->set_name("Vulkan Submission");
+  return true;
+}
+
+void VulkanSubmissionThread::Shutdown() {
+  if (thread_) {
+    // Let it finish everything handed off so far so the fences get signaled.
+    AwaitIdle();
+    shutting_down_.store(true, std::memory_order_release);
+    job_available_event_->Set();
+    xe::threading::Wait(thread_.get(), false);
+    thread_.reset();
+  }
+  job_completed_event_.reset();
+  job_available_event_.reset();
+  for (Job& job : jobs_) {
+    job.commands.reset();
+  }
+}
+
+void VulkanSubmissionThread::Execute(VkCommandPool command_pool,
+                                     VkCommandBuffer command_buffer,
+                                     bool begin,
+                                     DeferredCommandBuffer& commands) {
+  if (!begin && commands.empty()) {
+    return;
+  }
+  Job& job = AcquireJob();
+  job.command_pool = command_pool;
+  job.command_buffer = command_buffer;
+  job.begin = begin;
+  job.submit = false;
+  job.commands->Swap(commands);
+  ReleaseJob();
+}
+
+void VulkanSubmissionThread::Submit(
+    VkCommandBuffer command_buffer,
+    const std::vector<VkSemaphore>& wait_semaphores,
+    const std::vector<VkPipelineStageFlags>& wait_stage_masks,
+    VkFence fence) {
+  assert_true(wait_semaphores.size() == wait_stage_masks.size());
+  Job& job = AcquireJob();
+  job.command_pool = VK_NULL_HANDLE;
+  job.command_buffer = command_buffer;
+  job.begin = false;
+  job.submit = true;
+  job.wait_semaphores = wait_semaphores;
+  job.wait_stage_masks = wait_stage_masks;
+  job.fence = fence;
+  ReleaseJob();
+}
+
+void VulkanSubmissionThread::AwaitIdle() {
+  if (!thread_) {
+    return;
+  }
+  SCOPE_profile_cpu_f("gpu");
+  while (!is_idle()) {
+    xe::threading::Wait(job_completed_event_.get(), false);
+  }
+}
+
+VulkanSubmissionThread::Job& VulkanSubmissionThread::AcquireJob() {
+  uint32_t write_index = write_index_.load(std::memory_order_relaxed);
+  // Wait for a free slot if the submission thread is behind by the whole
+  // queue.
+  while (write_index - read_index_.load(std::memory_order_acquire) >=
+         kQueueSize) {
+    xe::threading::Wait(job_completed_event_.get(), false);
+  }
+  return jobs_[write_index & (kQueueSize - 1)];
+}
+
+void VulkanSubmissionThread::ReleaseJob() {
+  write_index_.store(write_index_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+  job_available_event_->Set();
+}
+
+void VulkanSubmissionThread::ThreadMain() {
+  uint32_t read_index = read_index_.load(std::memory_order_relaxed);
+  while (true) {
+    if (read_index == write_index_.load(std::memory_order_acquire)) {
+      if (shutting_down_.load(std::memory_order_acquire)) {
+        break;
+      }
+      xe::threading::Wait(job_available_event_.get(), false);
+      continue;
+    }
+    Job& job = jobs_[read_index & (kQueueSize - 1)];
+    // After a failure, still consume the jobs so the command processor thread
+    // doesn't wait forever, but don't touch the command buffers anymore.
+    if (!failed_.load(std::memory_order_relaxed) && !RunJob(job)) {
+      failed_.store(true, std::memory_order_release);
+    }
+    job.commands->Reset();
+    read_index_.store(++read_index, std::memory_order_release);
+    job_completed_event_->Set();
+  }
+}
+
+bool VulkanSubmissionThread::RunJob(Job& job) {
+  SCOPE_profile_cpu_f("gpu");
+
+  ui::vulkan::VulkanProvider& provider = command_processor_.GetVulkanProvider();
+  const ui::vulkan::VulkanProvider::DeviceFunctions& dfn = provider.dfn();
+  VkDevice device = provider.device();
+
+  if (job.begin) {
+    if (dfn.vkResetCommandPool(device, job.command_pool, 0) != VK_SUCCESS) {
+      XELOGE("Failed to reset a Vulkan command pool");
+      return false;
+    }
+    VkCommandBufferBeginInfo command_buffer_begin_info;
+    command_buffer_begin_info.sType =
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    command_buffer_begin_info.pNext = nullptr;
+    command_buffer_begin_info.flags =
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    command_buffer_begin_info.pInheritanceInfo = nullptr;
+    if (dfn.vkBeginCommandBuffer(job.command_buffer,
+                                 &command_buffer_begin_info) != VK_SUCCESS) {
+      XELOGE("Failed to begin a Vulkan command buffer");
+      return false;
+    }
+  }
+
+  job.commands->Execute(job.command_buffer);
+
+  if (job.submit) {
+    if (dfn.vkEndCommandBuffer(job.command_buffer) != VK_SUCCESS) {
+      XELOGE("Failed to end a Vulkan command buffer");
+      return false;
+    }
+    VkSubmitInfo submit_info;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = nullptr;
+    if (!job.wait_semaphores.empty()) {
+      submit_info.waitSemaphoreCount = uint32_t(job.wait_semaphores.size());
+      submit_info.pWaitSemaphores = job.wait_semaphores.data();
+      submit_info.pWaitDstStageMask = job.wait_stage_masks.data();
+    } else {
+      submit_info.waitSemaphoreCount = 0;
+      submit_info.pWaitSemaphores = nullptr;
+      submit_info.pWaitDstStageMask = nullptr;
+    }
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &job.command_buffer;
+    submit_info.signalSemaphoreCount = 0;
+    submit_info.pSignalSemaphores = nullptr;
+    VkResult submit_result;
+    {
+      ui::vulkan::VulkanProvider::QueueAcquisition queue_acquisition(
+          provider.AcquireQueue(provider.queue_family_graphics_compute(), 0));
+      submit_result = dfn.vkQueueSubmit(queue_acquisition.queue, 1,
+                                        &submit_info, job.fence);
+    }
+    if (submit_result != VK_SUCCESS) {
+      XELOGE("Failed to submit a Vulkan command buffer");
+      if (submit_result == VK_ERROR_DEVICE_LOST) {
+        device_lost_.store(true, std::memory_order_release);
+      }
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace vulkan
+}  // namespace gpu
+}  // namespace xe
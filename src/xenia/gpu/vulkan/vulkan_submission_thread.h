@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_GPU_VULKAN_VULKAN_SUBMISSION_THREAD_H_
+#define XENIA_GPU_VULKAN_VULKAN_SUBMISSION_THREAD_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "xenia/base/threading.h"
+#include "xenia/gpu/vulkan/deferred_command_buffer.h"
+#include "xenia/ui/vulkan/vulkan_provider.h"
+
+namespace xe {
+namespace gpu {
+namespace vulkan {
+
+class VulkanCommandProcessor;
+
+// Second stage of the Vulkan command processor pipeline. The command processor
+// thread decodes PM4, processes primitives, looks up the caches and writes
+// host commands to the DeferredCommandBuffer; chunks of that are handed off
+// through a bounded single-producer, single-consumer lock-free queue to this
+// thread, which replays them into the real Vulkan command buffer and submits
+// it to the queue.
+//
+// All methods except for the constructor and the destructor must be called
+// from the command processor thread only.
+class VulkanSubmissionThread {
+ public:
+  // Must be a power of two.
+  static constexpr uint32_t kQueueSize = 16;
+
+  explicit VulkanSubmissionThread(
+      const VulkanCommandProcessor& command_processor);
+  ~VulkanSubmissionThread();
+
+  bool Initialize();
+  void Shutdown();
+
+  // Hands off the commands recorded so far, leaving `commands` empty. If
+  // `begin` is true, the command pool is reset and the command buffer is begun
+  // before the commands are executed.
+  void Execute(VkCommandPool command_pool, VkCommandBuffer command_buffer,
+               bool begin, DeferredCommandBuffer& commands);
+  // Ends the command buffer and submits it, signaling the fence, which must be
+  // unsignaled already.
+  void Submit(VkCommandBuffer command_buffer,
+              const std::vector<VkSemaphore>& wait_semaphores,
+              const std::vector<VkPipelineStageFlags>& wait_stage_masks,
+              VkFence fence);
+
+  // Synchronization point - waits until everything handed off has been
+  // submitted to the queue (or has failed to be).
+  void AwaitIdle();
+  bool is_idle() const {
+    return read_index_.load(std::memory_order_acquire) ==
+           write_index_.load(std::memory_order_relaxed);
+  }
+
+  // If the submission thread has failed to record or to submit a command
+  // buffer, the fence of the submission will never be signaled, so this must be
+  // checked before awaiting fences, with everything treated as lost.
+  bool has_failed() const { return failed_.load(std::memory_order_acquire); }
+  bool is_device_lost() const {
+    return device_lost_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Job {
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    bool begin = false;
+    bool submit = false;
+    std::unique_ptr<DeferredCommandBuffer> commands;
+    std::vector<VkSemaphore> wait_semaphores;
+    std::vector<VkPipelineStageFlags> wait_stage_masks;
+    VkFence fence = VK_NULL_HANDLE;
+  };
+
+  Job& AcquireJob();
+  void ReleaseJob();
+  void ThreadMain();
+  bool RunJob(Job& job);
+
+  const VulkanCommandProcessor& command_processor_;
+
+  Job jobs_[kQueueSize];
+  // write_index_ is only modified by the command processor thread, read_index_
+  // only by the submission thread.
+  std::atomic<uint32_t> write_index_{0};
+  std::atomic<uint32_t> read_index_{0};
+  std::unique_ptr<xe::threading::Event> job_available_event_;
+  std::unique_ptr<xe::threading::Event> job_completed_event_;
+
+  std::atomic<bool> shutting_down_{false};
+  std::atomic<bool> failed_{false};
+  std::atomic<bool> device_lost_{false};
+
+  std::unique_ptr<xe::threading::Thread> thread_;
+};
+
+}  // namespace vulkan
+}  // namespace gpu
+}  // namespace xe
+
+#endif  // XENIA_GPU_VULKAN_VULKAN_SUBMISSION_THREAD_H_
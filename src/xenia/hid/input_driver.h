@@ -14,6 +14,7 @@
 #include <functional>
 
 #include "xenia/hid/input.h"
+#include "xenia/hid/input_latency.h"
 #include "xenia/ui/window.h"
 #include "xenia/xbox.h"
 
@@ -42,6 +43,10 @@ class InputDriver {
   virtual X_RESULT GetKeystroke(uint32_t user_index, uint32_t flags,
                                 X_INPUT_KEYSTROKE* out_keystroke) = 0;
 
+  // Latency of the mouse input passed to the game, or nullptr if the driver
+  // doesn't handle mouse input.
+  virtual InputLatencyHistogram* mouse_latency_histogram() { return nullptr; }
+
   void set_is_active_callback(std::function<bool()> is_active_callback) {
     is_active_callback_ = is_active_callback;
   }
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_HID_INPUT_LATENCY_H_
+#define XENIA_HID_INPUT_LATENCY_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace xe {
+namespace hid {
+
+// Host time from input events arriving to their effect being written to guest
+// memory, counted in power-of-two microsecond buckets. Recorded by the thread
+// polling the input, read by the UI thread.
+class InputLatencyHistogram {
+ public:
+  // Bucket 0 is [0, 2) us, bucket i is [2^i, 2^(i+1)) us, and the last one
+  // also includes everything above (over ~1 second).
+  static constexpr uint32_t kBucketCount = 21;
+
+  using Counts = std::array<uint64_t, kBucketCount>;
+
+  static uint32_t GetBucket(uint64_t latency_us) {
+    uint32_t bucket = 0;
+    while (latency_us > 1 && bucket + 1 < kBucketCount) {
+      latency_us >>= 1;
+      ++bucket;
+    }
+    return bucket;
+  }
+  // Lower bound of the latencies in the bucket.
+  static uint64_t GetBucketMinUs(uint32_t bucket) {
+    return bucket ? uint64_t(1) << bucket : 0;
+  }
+
+  void Record(uint64_t latency_us) {
+    counts_[GetBucket(latency_us)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Counts GetCounts() const {
+    Counts counts;
+    for (uint32_t i = 0; i < kBucketCount; ++i) {
+      counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+  }
+
+  void Reset() {
+    for (std::atomic<uint64_t>& count : counts_) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketCount> counts_ = {};
+};
+
+}  // namespace hid
+}  // namespace xe
+
+#endif  // XENIA_HID_INPUT_LATENCY_H_
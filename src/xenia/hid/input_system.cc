@@ -245,6 +245,16 @@ void InputSystem::UpdateTitleId(uint32_t title_id) {
   }
 }
 
+InputLatencyHistogram* InputSystem::GetMouseLatencyHistogram() {
+  for (auto& driver : drivers_) {
+    InputLatencyHistogram* histogram = driver->mouse_latency_histogram();
+    if (histogram) {
+      return histogram;
+    }
+  }
+  return nullptr;
+}
+
 std::unique_lock<xe_unlikely_mutex> InputSystem::lock() {
   return std::unique_lock<xe_unlikely_mutex>{lock_};
 }
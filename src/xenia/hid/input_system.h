@@ -57,6 +57,9 @@ class InputSystem {
 
   void UpdateTitleId(uint32_t title_id);
 
+  // nullptr if none of the drivers handle mouse input.
+  InputLatencyHistogram* GetMouseLatencyHistogram();
+
   std::unique_lock<xe_unlikely_mutex> lock();
 
  private:
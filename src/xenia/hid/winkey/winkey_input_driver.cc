@@ -9,6 +9,7 @@
 
 #include "xenia/hid/winkey/winkey_input_driver.h"
 
+#include "xenia/base/clock.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform_win.h"
 #include "xenia/base/system.h"
@@ -502,20 +503,10 @@ X_RESULT WinKeyInputDriver::GetState(uint32_t user_index,
   X_RESULT result = X_ERROR_SUCCESS;
 
   RawInputState state;
+  uint64_t mouse_first_event_time = 0;
 
   if (window()->HasFocus() && is_active()) {
-    {
-      while (!mouse_events_.empty()) {
-        MouseEvent* mouse = &mouse_events_.front();
-
-        if (mouse != nullptr) {
-          state.mouse.x_delta += mouse->x_delta;
-          state.mouse.y_delta += mouse->y_delta;
-          state.mouse.wheel_delta += mouse->wheel_delta;
-          mouse_events_.pop();
-        }
-      }
-    }
+    state.mouse = TakeMouseInput(mouse_first_event_time);
 
     for (int i = 0; i < sizeof(key_states_); i++) {
       if (key_states_[i]) {
@@ -601,7 +592,13 @@ X_RESULT WinKeyInputDriver::GetState(uint32_t user_index,
   if (title_id) {
     for (auto& game : hookable_games_) {
       if (game->IsGameSupported()) {
-        game->DoHooks(user_index, state, out_state);
+        if (game->DoHooks(user_index, state, out_state) &&
+            mouse_first_event_time) {
+          // The hooks have written the mouse input to guest memory.
+          mouse_latency_histogram_.Record(
+              (Clock::QueryHostTickCount() - mouse_first_event_time) *
+              1000000 / Clock::QueryHostTickFrequency());
+        }
         if (modifier_pressed) {
           game_modifier_handled =
               game->ModifierKeyHandler(user_index, state, out_state);
@@ -749,7 +746,15 @@ void WinKeyInputDriver::OnRawMouse(ui::MouseEvent& evt) {
   mouse.y_delta = evt.y();
   mouse.buttons = evt.scroll_x();
   mouse.wheel_delta = evt.scroll_y();
-  mouse_events_.push(mouse);
+  mouse_x_delta_.fetch_add(mouse.x_delta, std::memory_order_relaxed);
+  mouse_y_delta_.fetch_add(mouse.y_delta, std::memory_order_relaxed);
+  mouse_wheel_delta_.fetch_add(mouse.wheel_delta, std::memory_order_relaxed);
+  mouse_buttons_.fetch_or(mouse.buttons, std::memory_order_relaxed);
+  // After the deltas, so the reader sees them if it sees the time.
+  uint64_t no_event_time = 0;
+  mouse_first_event_time_.compare_exchange_strong(
+      no_event_time, Clock::QueryHostTickCount(), std::memory_order_release,
+      std::memory_order_relaxed);
 
   {
     if (mouse.buttons & RI_MOUSE_LEFT_BUTTON_DOWN) {
@@ -804,6 +809,25 @@ void WinKeyInputDriver::OnRawMouse(ui::MouseEvent& evt) {
   }
 }
 
+MouseEvent WinKeyInputDriver::TakeMouseInput(uint64_t& first_event_time) {
+  // An event arriving while the values are being taken may be split between
+  // two calls, only slightly skewing the latency measured for it.
+  first_event_time =
+      mouse_first_event_time_.exchange(0, std::memory_order_acquire);
+  MouseEvent mouse;
+  mouse.x_delta = mouse_x_delta_.exchange(0, std::memory_order_relaxed);
+  mouse.y_delta = mouse_y_delta_.exchange(0, std::memory_order_relaxed);
+  mouse.wheel_delta =
+      mouse_wheel_delta_.exchange(0, std::memory_order_relaxed);
+  mouse.buttons = mouse_buttons_.exchange(0, std::memory_order_relaxed);
+  if (!mouse.x_delta && !mouse.y_delta && !mouse.wheel_delta &&
+      !mouse.buttons) {
+    // Only the time of an event already taken by the previous call.
+    first_event_time = 0;
+  }
+  return mouse;
+}
+
 }  // namespace winkey
 }  // namespace hid
 }  // namespace xe
@@ -10,11 +10,13 @@
 #ifndef XENIA_HID_WINKEY_WINKEY_INPUT_DRIVER_H_
 #define XENIA_HID_WINKEY_WINKEY_INPUT_DRIVER_H_
 
+#include <atomic>
 #include <queue>
 
 #include "xenia/base/mutex.h"
 #include "xenia/hid/input.h"
 #include "xenia/hid/input_driver.h"
+#include "xenia/hid/input_latency.h"
 #include "xenia/hid/winkey/hookables/hookable_game.h"
 #include "xenia/ui/virtual_key.h"
 
@@ -75,6 +77,10 @@ class WinKeyInputDriver final : public InputDriver {
   X_RESULT GetKeystroke(uint32_t user_index, uint32_t flags,
                         X_INPUT_KEYSTROKE* out_keystroke) override;
 
+  InputLatencyHistogram* mouse_latency_histogram() override {
+    return &mouse_latency_histogram_;
+  }
+
  protected:
   struct KeyEvent {
     ui::VirtualKey virtual_key = ui::VirtualKey::kNone;
@@ -118,13 +124,26 @@ class WinKeyInputDriver final : public InputDriver {
 
   void OnRawMouse(ui::MouseEvent& e);
 
+  // Takes the mouse input accumulated since the previous call. first_event_time
+  // is the host tick count of the oldest event taken, or 0 if there were none.
+  MouseEvent TakeMouseInput(uint64_t& first_event_time);
+
   WinKeyWindowInputListener window_input_listener_;
 
   xe::global_critical_region global_critical_region_;
   std::queue<KeyEvent> key_events_;
   std::vector<KeyBinding> key_bindings_;
 
-  std::queue<MouseEvent> mouse_events_;
+  // Raw mouse input not taken by GetState yet, summed on the UI thread, with
+  // up to thousands of events per frame for high polling rate mice.
+  std::atomic<int32_t> mouse_x_delta_ = 0;
+  std::atomic<int32_t> mouse_y_delta_ = 0;
+  std::atomic<int32_t> mouse_wheel_delta_ = 0;
+  // RI_MOUSE_* button transition flags of all the events.
+  std::atomic<int32_t> mouse_buttons_ = 0;
+  // Host tick count of the oldest event, 0 if there are none.
+  std::atomic<uint64_t> mouse_first_event_time_ = 0;
+  InputLatencyHistogram mouse_latency_histogram_;
 
   uint8_t key_states_[256] = {};
   std::map<uint32_t, std::map<std::string, std::map<ui::VirtualKey, uint32_t>>>
@@ -13,6 +13,7 @@
 
 #include "third_party/fmt/include/fmt/format.h"
 #include "xenia/base/assert.h"
+#include "xenia/base/boot_trace.h"
 #include "xenia/base/byte_stream.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/string.h"
@@ -91,6 +92,7 @@ KernelState::~KernelState() {
   }
 
   executable_module_.reset();
+  title_xdbf_ = util::XdbfGameData(nullptr, 0);
   user_modules_.clear();
   kernel_modules_.clear();
 
@@ -134,9 +136,7 @@ bool KernelState::is_title_system_type(uint32_t title_id) {
   return (title_id >> 16) == 0xFFFE;
 }
 
-util::XdbfGameData KernelState::title_xdbf() const {
-  return module_xdbf(executable_module_);
-}
+util::XdbfGameData KernelState::title_xdbf() const { return title_xdbf_; }
 
 util::XdbfGameData KernelState::module_xdbf(
     object_ref<UserModule> exec_module) const {
@@ -327,8 +327,12 @@ void KernelState::SetExecutableModule(object_ref<UserModule> module) {
   }
   executable_module_ = std::move(module);
   if (!executable_module_) {
+    title_xdbf_ = util::XdbfGameData(nullptr, 0);
     return;
   }
+  // Indexed once rather than every time the title's achievements, properties
+  // or contexts are looked up.
+  title_xdbf_ = module_xdbf(executable_module_);
 
   auto title_process =
       memory_->TranslateVirtual<X_KPROCESS*>(GetTitleProcess());
@@ -519,8 +523,11 @@ X_RESULT KernelState::FinishLoadingUserModule(
     return result;
   }
   module->Dump();
-  emulator_->patcher()->ApplyPatchesForTitle(memory_, module->title_id(),
-                                             module->hash());
+  {
+    boot_trace::ScopedPhase phase("Apply title patches");
+    emulator_->patcher()->ApplyPatchesForTitle(memory_, module->title_id(),
+                                               module->hash());
+  }
   emulator_->on_patch_apply();
   if (module->xex_module()) {
     module->xex_module()->Precompile();
@@ -776,6 +783,7 @@ void KernelState::TerminateTitle() {
 
   // Unset the executable module.
   executable_module_ = nullptr;
+  title_xdbf_ = util::XdbfGameData(nullptr, 0);
 
   if (XThread::IsInThread()) {
     threads_by_id_.erase(XThread::GetCurrentThread()->thread_id());
@@ -358,6 +358,8 @@ class KernelState {
   bool has_notified_startup_ = false;
 
   object_ref<UserModule> executable_module_;
+  // The XDBF of executable_module_.
+  util::XdbfGameData title_xdbf_{nullptr, 0};
   std::vector<object_ref<KernelModule>> kernel_modules_;
   std::vector<object_ref<UserModule>> user_modules_;
   std::vector<TerminateNotification> terminate_notifications_;
@@ -85,8 +85,8 @@ std::string GameInfoDatabase::GetLocalizedString(const uint32_t id,
     return "";
   }
 
-  return xdbf_gamedata_->GetStringTableEntry(
-      xdbf_gamedata_->GetExistingLanguage(language), id);
+  return std::string(xdbf_gamedata_->GetStringTableEntry(
+      xdbf_gamedata_->GetExistingLanguage(language), id));
 }
 
 GameInfoDatabase::Context GameInfoDatabase::GetContext(
@@ -551,6 +551,9 @@ struct ExportRegistrerHelper {
         "R must be void or derive from shim::Result");
     static_assert((std::is_base_of_v<shim::Param, Ps> && ...),
                   "Ps must derive from shim::Param");
+    static_assert(!(tags & xe::cpu::ExportTag::kLeaf) ||
+                      !(tags & xe::cpu::ExportTag::kBlocking),
+                  "Blocking exports cannot use the leaf thunk");
     constexpr auto TAGS =
         tags | xe::cpu::ExportTag::kImplemented | xe::cpu::ExportTag::kLog;
 
@@ -8,7 +8,12 @@
  */
 
 #include "xenia/kernel/util/xdbf_utils.h"
+
 #include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "xenia/base/logging.h"
 
 namespace xe {
 namespace kernel {
@@ -33,146 +38,208 @@ constexpr uint64_t kXdbfIdXvc2 = 0x58564332;
 constexpr uint64_t kXdbfIdXmat = 0x584D4154;
 constexpr uint64_t kXdbfIdXsrc = 0x58535243;
 
-XdbfWrapper::XdbfWrapper(const uint8_t* data, size_t data_size)
-    : data_(data), data_size_(data_size) {
-  if (!data || data_size <= sizeof(XbdfHeader)) {
-    data_ = nullptr;
-    return;
-  }
+namespace {
 
-  const uint8_t* ptr = data_;
+using XdbfEntryKey = std::pair<uint16_t, uint64_t>;
 
-  header_ = reinterpret_cast<const XbdfHeader*>(ptr);
-  ptr += sizeof(XbdfHeader);
-  if (header_->magic != kXdbfSignatureXdbf) {
-    data_ = nullptr;
-    return;
+struct XdbfEntryKeyHash {
+  size_t operator()(const XdbfEntryKey& key) const {
+    return std::hash<uint64_t>()(key.second ^ (uint64_t(key.first) << 48));
+  }
+};
+
+// Gets the entries of a metadata table, which are preceded by the section
+// header and the entry count of type CountType.
+template <typename T, typename CountType>
+XdbfTable<T> GetTable(XdbfBlock block, fourcc_t signature) {
+  if (!block ||
+      block.size < sizeof(XdbfSectionHeader) + sizeof(CountType)) {
+    return {};
   }
 
-  entries_ = reinterpret_cast<const XbdfEntry*>(ptr);
-  ptr += sizeof(XbdfEntry) * header_->entry_count;
+  auto head = reinterpret_cast<const XdbfSectionHeader*>(block.buffer);
+  assert_true(head->magic == signature);
+  assert_true(head->version == 1);
 
-  files_ = reinterpret_cast<const XbdfFileLoc*>(ptr);
-  ptr += sizeof(XbdfFileLoc) * header_->free_count;
+  const uint8_t* ptr = block.buffer + sizeof(XdbfSectionHeader);
+  size_t count = xe::load_and_swap<CountType>(ptr);
+  ptr += sizeof(CountType);
 
-  content_offset_ = ptr;
+  size_t max_count =
+      (block.size - sizeof(XdbfSectionHeader) - sizeof(CountType)) / sizeof(T);
+  if (count > max_count) {
+    XELOGW("XDBF: Table {:08X} has {} entries, but only {} fit in it",
+           signature, count, max_count);
+    count = max_count;
+  }
+  return {reinterpret_cast<const T*>(ptr), count};
 }
 
-XdbfBlock XdbfWrapper::GetEntry(XdbfSection section, uint64_t id) const {
-  for (uint32_t i = 0; i < header_->entry_used; ++i) {
-    auto& entry = entries_[i];
-    if (entry.section == static_cast<uint16_t>(section) && entry.id == id) {
-      XdbfBlock block;
-      block.buffer = content_offset_ + entry.offset;
-      block.size = entry.size;
-      return block;
-    }
+// ID -> index in the table. The first entry with an ID is used, like with a
+// linear search.
+template <typename T>
+std::unordered_map<uint32_t, uint32_t> IndexTable(const XdbfTable<T>& table) {
+  std::unordered_map<uint32_t, uint32_t> indices;
+  indices.reserve(table.size());
+  for (size_t i = 0; i < table.size(); ++i) {
+    indices.emplace(uint32_t(table[i].id), uint32_t(i));
   }
-  return {0};
+  return indices;
 }
 
-std::string XdbfWrapper::GetStringTableEntry(XLanguage language,
-                                             uint16_t string_id) const {
-  auto language_block =
-      GetEntry(XdbfSection::kStringTable, static_cast<uint64_t>(language));
-  if (!language_block) {
-    return "";
+std::unordered_map<uint16_t, std::string_view> IndexStringTable(
+    XdbfBlock block) {
+  std::unordered_map<uint16_t, std::string_view> strings;
+  if (block.size < sizeof(XdbfSectionHeader) + sizeof(uint16_t)) {
+    return strings;
   }
 
-  auto xstr_head =
-      reinterpret_cast<const XdbfSectionHeader*>(language_block.buffer);
+  auto xstr_head = reinterpret_cast<const XdbfSectionHeader*>(block.buffer);
   assert_true(xstr_head->magic == kXdbfSignatureXstr);
   assert_true(xstr_head->version == 1);
 
-  const uint8_t* ptr = language_block.buffer + sizeof(XdbfSectionHeader);
-  const uint16_t string_count = xe::byte_swap<uint16_t>(*(uint16_t*)ptr);
+  const uint8_t* ptr = block.buffer + sizeof(XdbfSectionHeader);
+  const uint8_t* end = block.buffer + block.size;
+  const uint16_t string_count = xe::load_and_swap<uint16_t>(ptr);
   ptr += sizeof(uint16_t);
 
+  strings.reserve(string_count);
   for (uint16_t i = 0; i < string_count; ++i) {
+    if (size_t(end - ptr) < sizeof(XdbfStringTableEntry)) {
+      break;
+    }
     auto entry = reinterpret_cast<const XdbfStringTableEntry*>(ptr);
     ptr += sizeof(XdbfStringTableEntry);
-    if (entry->id == string_id) {
-      return std::string(reinterpret_cast<const char*>(ptr),
-                         entry->string_length);
+    if (size_t(end - ptr) < entry->string_length) {
+      break;
     }
+    strings.emplace(
+        entry->id,
+        std::string_view(reinterpret_cast<const char*>(ptr),
+                         entry->string_length));
     ptr += entry->string_length;
   }
-  return "";
+  return strings;
 }
 
-std::vector<XdbfAchievementTableEntry> XdbfWrapper::GetAchievements() const {
-  std::vector<XdbfAchievementTableEntry> achievements;
-
-  auto achievement_table = GetEntry(XdbfSection::kMetadata, kXdbfIdXach);
-  if (!achievement_table) {
-    return achievements;
-  }
+}  // namespace
 
-  auto xach_head =
-      reinterpret_cast<const XdbfSectionHeader*>(achievement_table.buffer);
-  assert_true(xach_head->magic == kXdbfSignatureXach);
-  assert_true(xach_head->version == 1);
+struct XdbfWrapper::Index {
+  std::unordered_map<XdbfEntryKey, XdbfBlock, XdbfEntryKeyHash> entries;
+  // Language -> string ID -> string.
+  std::unordered_map<uint64_t, std::unordered_map<uint16_t, std::string_view>>
+      string_tables;
 
-  const uint8_t* ptr = achievement_table.buffer + sizeof(XdbfSectionHeader);
-  const uint16_t achievement_count = xe::byte_swap<uint16_t>(*(uint16_t*)ptr);
-  ptr += sizeof(uint16_t);
+  XdbfTable<XdbfAchievementTableEntry> achievements;
+  XdbfTable<XdbfPropertyTableEntry> properties;
+  XdbfTable<XdbfContextTableEntry> contexts;
+  std::unordered_map<uint32_t, uint32_t> achievement_indices;
+  std::unordered_map<uint32_t, uint32_t> property_indices;
+  std::unordered_map<uint32_t, uint32_t> context_indices;
+};
 
-  for (uint16_t i = 0; i < achievement_count; ++i) {
-    auto entry = reinterpret_cast<const XdbfAchievementTableEntry*>(ptr);
-    ptr += sizeof(XdbfAchievementTableEntry);
-    achievements.push_back(*entry);
+XdbfWrapper::XdbfWrapper(const uint8_t* data, size_t data_size)
+    : data_(data), data_size_(data_size) {
+  if (!data || data_size <= sizeof(XbdfHeader)) {
+    data_ = nullptr;
+    return;
   }
-  return achievements;
-}
 
-std::vector<XdbfPropertyTableEntry> XdbfWrapper::GetProperties() const {
-  std::vector<XdbfPropertyTableEntry> properties;
+  const uint8_t* ptr = data_;
+  const uint8_t* data_end = data_ + data_size_;
 
-  auto property_table = GetEntry(XdbfSection::kMetadata, kXdbfIdXprp);
-  if (!property_table) {
-    return properties;
+  auto header = reinterpret_cast<const XbdfHeader*>(ptr);
+  ptr += sizeof(XbdfHeader);
+  if (header->magic != kXdbfSignatureXdbf ||
+      header->entry_used > header->entry_count) {
+    data_ = nullptr;
+    return;
   }
 
-  auto xprp_head =
-      reinterpret_cast<const XdbfSectionHeader*>(property_table.buffer);
-  assert_true(xprp_head->magic == kXdbfSignatureXprp);
-  assert_true(xprp_head->version == 1);
+  auto entries = reinterpret_cast<const XbdfEntry*>(ptr);
+  ptr += sizeof(XbdfEntry) * header->entry_count;
 
-  const uint8_t* ptr = property_table.buffer + sizeof(XdbfSectionHeader);
-  const uint16_t properties_count = xe::byte_swap<uint16_t>(*(uint16_t*)ptr);
-  ptr += sizeof(uint16_t);
+  ptr += sizeof(XbdfFileLoc) * header->free_count;
 
-  for (uint16_t i = 0; i < properties_count; i++) {
-    auto entry = reinterpret_cast<const XdbfPropertyTableEntry*>(ptr);
-    ptr += sizeof(XdbfPropertyTableEntry);
-    properties.push_back(*entry);
+  const uint8_t* content_offset = ptr;
+  if (content_offset > data_end) {
+    data_ = nullptr;
+    return;
+  }
+
+  auto index = std::make_shared<Index>();
+  index->entries.reserve(header->entry_used);
+  for (uint32_t i = 0; i < header->entry_used; ++i) {
+    const XbdfEntry& entry = entries[i];
+    if (entry.offset > size_t(data_end - content_offset) ||
+        entry.size > size_t(data_end - content_offset) - entry.offset) {
+      XELOGW("XDBF: Entry {:016X} in section {} is out of bounds",
+             uint64_t(entry.id), uint16_t(entry.section));
+      continue;
+    }
+    // The first entry is used, like with a linear search.
+    index->entries.emplace(XdbfEntryKey(entry.section, entry.id),
+                           XdbfBlock{content_offset + entry.offset,
+                                     entry.size});
+    if (entry.section == static_cast<uint16_t>(XdbfSection::kStringTable)) {
+      index->string_tables.emplace(
+          entry.id, IndexStringTable({content_offset + entry.offset,
+                                      entry.size}));
+    }
   }
-  return properties;
+  // GetEntry can be used from now on.
+  index_ = index;
+
+  index->achievements = GetTable<XdbfAchievementTableEntry, uint16_t>(
+      GetEntry(XdbfSection::kMetadata, kXdbfIdXach), kXdbfSignatureXach);
+  index->achievement_indices = IndexTable(index->achievements);
+  index->properties = GetTable<XdbfPropertyTableEntry, uint16_t>(
+      GetEntry(XdbfSection::kMetadata, kXdbfIdXprp), kXdbfSignatureXprp);
+  index->property_indices = IndexTable(index->properties);
+  index->contexts = GetTable<XdbfContextTableEntry, uint32_t>(
+      GetEntry(XdbfSection::kMetadata, kXdbfIdXctx), kXdbfSignatureXcxt);
+  index->context_indices = IndexTable(index->contexts);
 }
 
-std::vector<XdbfContextTableEntry> XdbfWrapper::GetContexts() const {
-  std::vector<XdbfContextTableEntry> contexts;
+XdbfBlock XdbfWrapper::GetEntry(XdbfSection section, uint64_t id) const {
+  if (!index_) {
+    return {0};
+  }
+  auto it = index_->entries.find(
+      XdbfEntryKey(static_cast<uint16_t>(section), id));
+  if (it == index_->entries.end()) {
+    return {0};
+  }
+  return it->second;
+}
 
-  auto contexts_table = GetEntry(XdbfSection::kMetadata, kXdbfIdXctx);
-  if (!contexts_table) {
-    return contexts;
+std::string_view XdbfWrapper::GetStringTableEntry(XLanguage language,
+                                                  uint16_t string_id) const {
+  if (!index_) {
+    return {};
+  }
+  auto table_it =
+      index_->string_tables.find(static_cast<uint64_t>(language));
+  if (table_it == index_->string_tables.end()) {
+    return {};
   }
+  auto string_it = table_it->second.find(string_id);
+  if (string_it == table_it->second.end()) {
+    return {};
+  }
+  return string_it->second;
+}
 
-  auto xcxt_head =
-      reinterpret_cast<const XdbfSectionHeader*>(contexts_table.buffer);
-  assert_true(xcxt_head->magic == kXdbfSignatureXcxt);
-  assert_true(xcxt_head->version == 1);
+XdbfTable<XdbfAchievementTableEntry> XdbfWrapper::GetAchievements() const {
+  return index_ ? index_->achievements : XdbfTable<XdbfAchievementTableEntry>();
+}
 
-  const uint8_t* ptr = contexts_table.buffer + sizeof(XdbfSectionHeader);
-  const uint32_t contexts_count = xe::byte_swap<uint32_t>(*(uint32_t*)ptr);
-  ptr += sizeof(uint32_t);
+XdbfTable<XdbfPropertyTableEntry> XdbfWrapper::GetProperties() const {
+  return index_ ? index_->properties : XdbfTable<XdbfPropertyTableEntry>();
+}
 
-  for (uint32_t i = 0; i < contexts_count; i++) {
-    auto entry = reinterpret_cast<const XdbfContextTableEntry*>(ptr);
-    ptr += sizeof(XdbfContextTableEntry);
-    contexts.push_back(*entry);
-  }
-  return contexts;
+XdbfTable<XdbfContextTableEntry> XdbfWrapper::GetContexts() const {
+  return index_ ? index_->contexts : XdbfTable<XdbfContextTableEntry>();
 }
 
 std::vector<XdbfViewTable> XdbfWrapper::GetStatsView() const {
@@ -242,39 +309,36 @@ const uint8_t* XdbfWrapper::ReadXLast(uint32_t& compressed_size,
 }
 
 XdbfAchievementTableEntry XdbfWrapper::GetAchievement(const uint32_t id) const {
-  const auto achievements = GetAchievements();
-
-  for (const auto& entry : achievements) {
-    if (entry.id != id) {
-      continue;
-    }
-    return entry;
+  if (!index_) {
+    return {};
   }
-  return {};
+  auto it = index_->achievement_indices.find(id);
+  if (it == index_->achievement_indices.end()) {
+    return {};
+  }
+  return index_->achievements[it->second];
 }
 
 XdbfPropertyTableEntry XdbfWrapper::GetProperty(const uint32_t id) const {
-  const auto properties = GetProperties();
-
-  for (const auto& entry : properties) {
-    if (entry.id != id) {
-      continue;
-    }
-    return entry;
+  if (!index_) {
+    return {};
   }
-  return {};
+  auto it = index_->property_indices.find(id);
+  if (it == index_->property_indices.end()) {
+    return {};
+  }
+  return index_->properties[it->second];
 }
 
 XdbfContextTableEntry XdbfWrapper::GetContext(const uint32_t id) const {
-  const auto contexts = GetContexts();
-
-  for (const auto& entry : contexts) {
-    if (entry.id != id) {
-      continue;
-    }
-    return entry;
+  if (!index_) {
+    return {};
+  }
+  auto it = index_->context_indices.find(id);
+  if (it == index_->context_indices.end()) {
+    return {};
   }
-  return {};
+  return index_->contexts[it->second];
 }
 
 XdbfSharedView XdbfWrapper::GetSharedView(const uint8_t* ptr,
@@ -369,8 +433,9 @@ XdbfPropertyBag XdbfWrapper::GetMatchCollection() const {
 XLanguage XdbfGameData::GetExistingLanguage(XLanguage language_to_check) const {
   // A bit of a hack. Check if title in specific language exist.
   // If it doesn't then for sure language is not supported.
-  return title(language_to_check).empty() ? default_language()
-                                          : language_to_check;
+  return GetStringTableEntry(language_to_check, kXdbfIdTitle).empty()
+             ? default_language()
+             : language_to_check;
 }
 
 XdbfBlock XdbfGameData::icon() const {
@@ -388,11 +453,11 @@ XLanguage XdbfGameData::default_language() const {
 }
 
 std::string XdbfGameData::title() const {
-  return GetStringTableEntry(default_language(), kXdbfIdTitle);
+  return std::string(GetStringTableEntry(default_language(), kXdbfIdTitle));
 }
 
 std::string XdbfGameData::title(XLanguage language) const {
-  return GetStringTableEntry(language, kXdbfIdTitle);
+  return std::string(GetStringTableEntry(language, kXdbfIdTitle));
 }
 
 }  // namespace util
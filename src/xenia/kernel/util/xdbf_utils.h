@@ -10,7 +10,9 @@
 #ifndef XENIA_KERNEL_UTIL_XDBF_UTILS_H_
 #define XENIA_KERNEL_UTIL_XDBF_UTILS_H_
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "xenia/base/memory.h"
@@ -163,8 +165,25 @@ struct XdbfBlock {
   operator bool() const { return buffer != nullptr; }
 };
 
+// A table of entries in the XDBF data, not copied from it.
+template <typename T>
+struct XdbfTable {
+  const T* entries = nullptr;
+  size_t count = 0;
+
+  const T* begin() const { return entries; }
+  const T* end() const { return entries + count; }
+  size_t size() const { return count; }
+  bool empty() const { return !count; }
+  const T& operator[](size_t index) const { return entries[index]; }
+};
+
 // Wraps an XBDF (XboxDataBaseFormat) in-memory database.
 // https://free60project.github.io/wiki/XDBF.html
+//
+// The entries, the achievement, property and context tables and the string
+// tables are indexed once when the database is wrapped. The index is shared
+// between copies of the wrapper, and the data must outlive all of them.
 class XdbfWrapper {
  public:
   XdbfWrapper(const uint8_t* data, size_t data_size);
@@ -176,13 +195,16 @@ class XdbfWrapper {
   // If the entry is not found the returned block will be nullptr.
   XdbfBlock GetEntry(XdbfSection section, uint64_t id) const;
 
-  // Gets a string from the string table in the given language.
+  // Gets a string from the string table in the given language, pointing to
+  // the XDBF data.
   // Returns the empty string if the entry is not found.
-  std::string GetStringTableEntry(XLanguage language, uint16_t string_id) const;
-  std::vector<XdbfAchievementTableEntry> GetAchievements() const;
-  std::vector<XdbfPropertyTableEntry> GetProperties() const;
-  std::vector<XdbfContextTableEntry> GetContexts() const;
+  std::string_view GetStringTableEntry(XLanguage language,
+                                       uint16_t string_id) const;
+  XdbfTable<XdbfAchievementTableEntry> GetAchievements() const;
+  XdbfTable<XdbfPropertyTableEntry> GetProperties() const;
+  XdbfTable<XdbfContextTableEntry> GetContexts() const;
 
+  // Return zero-initialized entries if not found.
   XdbfAchievementTableEntry GetAchievement(const uint32_t id) const;
   XdbfPropertyTableEntry GetProperty(const uint32_t id) const;
   XdbfContextTableEntry GetContext(const uint32_t id) const;
@@ -199,13 +221,13 @@ class XdbfWrapper {
                            uint32_t& decompressed_size) const;
 
  private:
+  struct Index;
+
   const uint8_t* data_ = nullptr;
   size_t data_size_ = 0;
-  const uint8_t* content_offset_ = nullptr;
 
-  const XbdfHeader* header_ = nullptr;
-  const XbdfEntry* entries_ = nullptr;
-  const XbdfFileLoc* files_ = nullptr;
+  // Null if the data is not valid.
+  std::shared_ptr<const Index> index_;
 };
 
 class XdbfGameData : public XdbfWrapper {
@@ -47,9 +47,9 @@ void AchievementManager::EarnAchievement(uint64_t xuid, uint32_t title_id,
   const XLanguage title_language = title_xdbf.GetExistingLanguage(
       static_cast<XLanguage>(cvars::user_language));
 
-  const std::string label =
+  const std::string_view label =
       title_xdbf.GetStringTableEntry(title_language, achievement.label_id);
-  const std::string desc = title_xdbf.GetStringTableEntry(
+  const std::string_view desc = title_xdbf.GetStringTableEntry(
       title_language, achievement.description_id);
 
   XELOGI("Achievement unlocked: {}", label);
@@ -49,7 +49,7 @@ X_HRESULT XgiApp::DispatchMessageSync(uint32_t message, uint32_t buffer_ptr,
         const auto context = title_xdbf.GetContext(context_id);
         const XLanguage title_language = title_xdbf.GetExistingLanguage(
             static_cast<XLanguage>(XLanguage::kEnglish));
-        const std::string desc =
+        const std::string_view desc =
             title_xdbf.GetStringTableEntry(title_language, context.string_id);
         XELOGD("XGIUserSetContextEx: {} - Set to value: {}", desc,
                context_value);
@@ -75,7 +75,7 @@ X_HRESULT XgiApp::DispatchMessageSync(uint32_t message, uint32_t buffer_ptr,
         const auto property_xdbf = title_xdbf.GetProperty(property_id);
         const XLanguage title_language = title_xdbf.GetExistingLanguage(
             static_cast<XLanguage>(XLanguage::kEnglish));
-        const std::string desc = title_xdbf.GetStringTableEntry(
+        const std::string_view desc = title_xdbf.GetStringTableEntry(
             title_language, property_xdbf.string_id);
 
         Property property =
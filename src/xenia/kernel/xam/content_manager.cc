@@ -33,6 +33,16 @@ static const char* kGameContentHeaderDirName = "Headers";
 
 static int content_device_id_ = 0;
 
+// The time of the last modification of the directory, or the minimum if it
+// doesn't exist.
+static std::filesystem::file_time_type GetDirectoryWriteTime(
+    const std::filesystem::path& path) {
+  std::error_code ec;
+  std::filesystem::file_time_type write_time =
+      std::filesystem::last_write_time(path, ec);
+  return ec ? std::filesystem::file_time_type::min() : write_time;
+}
+
 ContentPackage::ContentPackage(KernelState* kernel_state,
                                const std::string_view root_name,
                                const XCONTENT_AGGREGATE_DATA& data,
@@ -134,9 +144,8 @@ std::filesystem::path ContentManager::ResolvePackagePath(
   return get_package_path(data.title_id);
 }
 
-std::filesystem::path ContentManager::ResolvePackageHeaderPath(
-    const std::string_view file_name, uint64_t xuid, uint32_t title_id,
-    const XContentType content_type) const {
+std::filesystem::path ContentManager::ResolvePackageHeaderRoot(
+    uint64_t xuid, uint32_t title_id, const XContentType content_type) const {
   if (title_id == kCurrentlyRunningTitleId) {
     title_id = kernel_state_->title_id();
   }
@@ -148,13 +157,19 @@ std::filesystem::path ContentManager::ResolvePackageHeaderPath(
   auto xuid_str = fmt::format("{:016X}", xuid);
   auto title_id_str = fmt::format("{:08X}", title_id);
   auto content_type_str = fmt::format("{:08X}", uint32_t(content_type));
-  std::string final_name =
-      xe::string_util::trim(std::string(file_name)) + ".header";
 
   // Header root path:
   // content_root/xuid/title_id/Headers/content_type/
   return root_path_ / xuid_str / title_id_str / kGameContentHeaderDirName /
-         content_type_str / final_name;
+         content_type_str;
+}
+
+std::filesystem::path ContentManager::ResolvePackageHeaderPath(
+    const std::string_view file_name, uint64_t xuid, uint32_t title_id,
+    const XContentType content_type) const {
+  std::string final_name =
+      xe::string_util::trim(std::string(file_name)) + ".header";
+  return ResolvePackageHeaderRoot(xuid, title_id, content_type) / final_name;
 }
 
 std::unordered_set<uint32_t> ContentManager::FindPublisherTitleIds(
@@ -203,37 +218,81 @@ std::vector<XCONTENT_AGGREGATE_DATA> ContentManager::ListContent(
     title_ids = FindPublisherTitleIds(xuid, title_id);
   }
 
+  std::lock_guard<xe_mutex> lock(content_lists_lock_);
   for (const uint32_t& title_id : title_ids) {
-    // Search path:
-    // content_root/xuid/title_id/type_name/*
-    auto package_root = ResolvePackageRoot(xuid, title_id, content_type);
-    auto file_infos = xe::filesystem::ListFiles(package_root);
-
-    for (const auto& file_info : file_infos) {
-      if (file_info.type != xe::filesystem::FileInfo::Type::kDirectory) {
-        // Directories only.
-        continue;
-      }
-
-      XCONTENT_AGGREGATE_DATA content_data;
-      if (XSUCCEEDED(ReadContentHeaderFile(xe::path_to_utf8(file_info.name),
-                                           xuid, title_id, content_type,
-                                           content_data))) {
-        result.emplace_back(std::move(content_data));
-      } else {
-        content_data.device_id = device_id;
-        content_data.content_type = content_type;
-        content_data.set_display_name(xe::path_to_utf16(file_info.name));
-        content_data.set_file_name(xe::path_to_utf8(file_info.name));
-        content_data.title_id = title_id;
-        content_data.xuid = xuid;
-        result.emplace_back(std::move(content_data));
+    const ContentList& content_list =
+        GetContentList(xuid, title_id, content_type);
+    for (const ContentList::Content& content : content_list.contents) {
+      result.push_back(content.data);
+      if (!content.has_header) {
+        result.back().device_id = device_id;
+        result.back().title_id = title_id;
       }
     }
   }
   return result;
 }
 
+const ContentManager::ContentList& ContentManager::GetContentList(
+    const uint64_t xuid, const uint32_t title_id,
+    const XContentType content_type) const {
+  ContentListKey key;
+  key.xuid = xuid;
+  key.title_id =
+      title_id == kCurrentlyRunningTitleId ? kernel_state_->title_id()
+                                           : title_id;
+  key.content_type = content_type;
+
+  // Search path:
+  // content_root/xuid/title_id/type_name/*
+  auto package_root = ResolvePackageRoot(xuid, key.title_id, content_type);
+  std::filesystem::file_time_type package_root_write_time =
+      GetDirectoryWriteTime(package_root);
+  std::filesystem::file_time_type header_root_write_time =
+      GetDirectoryWriteTime(
+          ResolvePackageHeaderRoot(xuid, key.title_id, content_type));
+
+  auto content_list_it = content_lists_.find(key);
+  if (content_list_it != content_lists_.end() &&
+      content_list_it->second.package_root_write_time ==
+          package_root_write_time &&
+      content_list_it->second.header_root_write_time ==
+          header_root_write_time) {
+    return content_list_it->second;
+  }
+
+  ContentList& content_list = content_lists_[key];
+  content_list.package_root_write_time = package_root_write_time;
+  content_list.header_root_write_time = header_root_write_time;
+  content_list.contents.clear();
+
+  auto file_infos = xe::filesystem::ListFiles(package_root);
+  for (const auto& file_info : file_infos) {
+    if (file_info.type != xe::filesystem::FileInfo::Type::kDirectory) {
+      // Directories only.
+      continue;
+    }
+
+    ContentList::Content& content = content_list.contents.emplace_back();
+    content.has_header =
+        XSUCCEEDED(ReadContentHeaderFile(xe::path_to_utf8(file_info.name),
+                                         xuid, key.title_id, content_type,
+                                         content.data));
+    if (!content.has_header) {
+      content.data.content_type = content_type;
+      content.data.set_display_name(xe::path_to_utf16(file_info.name));
+      content.data.set_file_name(xe::path_to_utf8(file_info.name));
+      content.data.xuid = xuid;
+    }
+  }
+  return content_list;
+}
+
+void ContentManager::InvalidateContentLists() {
+  std::lock_guard<xe_mutex> lock(content_lists_lock_);
+  content_lists_.clear();
+}
+
 std::unique_ptr<ContentPackage> ContentManager::ResolvePackage(
     const std::string_view root_name, const uint64_t xuid,
     const XCONTENT_AGGREGATE_DATA& data, const uint32_t disc_number) {
@@ -275,6 +334,7 @@ X_RESULT ContentManager::WriteContentHeaderFile(const uint64_t xuid,
   }
 
   xe::filesystem::CreateEmptyFile(header_path);
+  InvalidateContentLists();
 
   if (std::filesystem::exists(header_path)) {
     auto file = xe::filesystem::OpenFile(header_path, "wb");
@@ -337,6 +397,8 @@ X_RESULT ContentManager::CreateContent(const std::string_view root_name,
     return X_ERROR_ACCESS_DENIED;
   }
 
+  InvalidateContentLists();
+
   auto package = ResolvePackage(root_name, xuid, data);
   assert_not_null(package);
 
@@ -418,6 +480,7 @@ X_RESULT ContentManager::SetContentThumbnail(
   auto global_lock = global_critical_region_.Acquire();
   auto package_path = ResolvePackagePath(xuid, data);
   std::filesystem::create_directories(package_path);
+  InvalidateContentLists();
   if (std::filesystem::exists(package_path)) {
     auto thumb_path = package_path / kThumbnailFileName;
     auto file = xe::filesystem::OpenFile(thumb_path, "wb");
@@ -439,7 +502,9 @@ X_RESULT ContentManager::DeleteContent(const uint64_t xuid,
   }
 
   auto package_path = ResolvePackagePath(xuid, data);
-  if (std::filesystem::remove_all(package_path) > 0) {
+  std::uintmax_t removed_count = std::filesystem::remove_all(package_path);
+  InvalidateContentLists();
+  if (removed_count > 0) {
     return X_ERROR_SUCCESS;
   } else {
     return X_ERROR_FILE_NOT_FOUND;
@@ -10,6 +10,7 @@
 #ifndef XENIA_KERNEL_XAM_CONTENT_MANAGER_H_
 #define XENIA_KERNEL_XAM_CONTENT_MANAGER_H_
 
+#include <filesystem>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -180,14 +181,54 @@ class ContentManager {
   std::filesystem::path ResolveGameUserContentPath(const uint64_t xuid);
   bool IsContentOpen(const XCONTENT_AGGREGATE_DATA& data) const;
   void CloseOpenedFilesFromContent(const std::string_view root_name);
+  // Must be called after modifying packages or their header files, as that
+  // doesn't always change the write time of the directories containing them.
+  void InvalidateContentLists();
 
  private:
+  struct ContentListKey {
+    uint64_t xuid;
+    uint32_t title_id;
+    XContentType content_type;
+
+    bool operator==(const ContentListKey& other) const {
+      return xuid == other.xuid && title_id == other.title_id &&
+             content_type == other.content_type;
+    }
+  };
+  struct ContentListKeyHash {
+    size_t operator()(const ContentListKey& key) const {
+      return std::hash<uint64_t>()(key.xuid ^
+                                   (uint64_t(key.title_id) << 32) ^
+                                   uint32_t(key.content_type));
+    }
+  };
+  // The packages in a package root, kept until the package root or the
+  // header directory is modified.
+  struct ContentList {
+    struct Content {
+      XCONTENT_AGGREGATE_DATA data;
+      // If false, the data is made from the package directory name, and the
+      // device and the title IDs need to be filled when listing.
+      bool has_header;
+    };
+    std::filesystem::file_time_type package_root_write_time;
+    std::filesystem::file_time_type header_root_write_time;
+    std::vector<Content> contents;
+  };
+
+  // Must be called with content_lists_lock_ held.
+  const ContentList& GetContentList(const uint64_t xuid,
+                                    const uint32_t title_id,
+                                    const XContentType content_type) const;
   std::filesystem::path ResolvePackageRoot(
       const uint64_t xuid, const uint32_t title_id,
       const XContentType content_type) const;
   std::filesystem::path ResolvePackagePath(const uint64_t xuid,
                                            const XCONTENT_AGGREGATE_DATA& data,
                                            const uint32_t disc_number = -1);
+  std::filesystem::path ResolvePackageHeaderRoot(
+      uint64_t xuid, uint32_t title_id, const XContentType content_type) const;
   std::filesystem::path ResolvePackageHeaderPath(
       const std::string_view file_name, uint64_t xuid, uint32_t title_id,
       const XContentType content_type) const;
@@ -202,6 +243,12 @@ class ContentManager {
   // TODO(benvanik): remove use of global lock, it's bad here!
   xe::global_critical_region global_critical_region_;
   std::unordered_map<string_key, ContentPackage*> open_packages_;
+
+  // Titles may enumerate their content repeatedly, so the package roots are
+  // listed and the headers are read only after they're modified.
+  mutable xe_mutex content_lists_lock_;
+  mutable std::unordered_map<ContentListKey, ContentList, ContentListKeyHash>
+      content_lists_;
 };
 
 }  // namespace xam
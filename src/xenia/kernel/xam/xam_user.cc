@@ -592,7 +592,7 @@ dword_result_t XamUserCreateAchievementEnumerator_entry(
   if (db.is_valid()) {
     const XLanguage language =
         db.GetExistingLanguage(static_cast<XLanguage>(cvars::user_language));
-    const std::vector<util::XdbfAchievementTableEntry> achievement_list =
+    const util::XdbfTable<util::XdbfAchievementTableEntry> achievement_list =
         db.GetAchievements();
 
     for (const util::XdbfAchievementTableEntry& entry : achievement_list) {
@@ -313,8 +313,8 @@ dword_result_t XMAIsOutputBufferValid_entry(lpvoid_t context_ptr) {
   XMA_CONTEXT_DATA context(context_ptr);
   return context.output_buffer_valid;
 }
-DECLARE_XBOXKRNL_EXPORT2(XMAIsOutputBufferValid, kAudio, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(XMAIsOutputBufferValid, kAudio, kImplemented,
+                         kHighFrequency, kLeaf);
 
 dword_result_t XMASetOutputBufferValid_entry(lpvoid_t context_ptr) {
   XMA_CONTEXT_DATA context(context_ptr);
@@ -330,8 +330,8 @@ dword_result_t XMAGetOutputBufferReadOffset_entry(lpvoid_t context_ptr) {
   XMA_CONTEXT_DATA context(context_ptr);
   return context.output_buffer_read_offset;
 }
-DECLARE_XBOXKRNL_EXPORT2(XMAGetOutputBufferReadOffset, kAudio, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(XMAGetOutputBufferReadOffset, kAudio, kImplemented,
+                         kHighFrequency, kLeaf);
 
 dword_result_t XMASetOutputBufferReadOffset_entry(lpvoid_t context_ptr,
                                                   dword_t value) {
@@ -348,8 +348,8 @@ dword_result_t XMAGetOutputBufferWriteOffset_entry(lpvoid_t context_ptr) {
   XMA_CONTEXT_DATA context(context_ptr);
   return context.output_buffer_write_offset;
 }
-DECLARE_XBOXKRNL_EXPORT2(XMAGetOutputBufferWriteOffset, kAudio, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(XMAGetOutputBufferWriteOffset, kAudio, kImplemented,
+                         kHighFrequency, kLeaf);
 
 dword_result_t XMAGetPacketMetadata_entry(lpvoid_t context_ptr) {
   XMA_CONTEXT_DATA context(context_ptr);
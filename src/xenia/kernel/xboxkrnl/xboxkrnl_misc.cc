@@ -127,7 +127,7 @@ static qword_result_t KeQueryInterruptTime_entry(const ppc_context_t& ctx) {
 
   return xe::load_and_swap<uint64_t>(&bundle->interrupt_time);
 }
-DECLARE_XBOXKRNL_EXPORT1(KeQueryInterruptTime, kNone, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(KeQueryInterruptTime, kNone, kImplemented, kLeaf);
 }  // namespace xboxkrnl
 }  // namespace kernel
 }  // namespace xe
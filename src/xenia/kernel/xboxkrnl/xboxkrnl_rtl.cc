@@ -52,7 +52,7 @@ dword_result_t RtlCompareMemory_entry(lpvoid_t source1, lpvoid_t source2,
 
   return c;
 }
-DECLARE_XBOXKRNL_EXPORT1(RtlCompareMemory, kMemory, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(RtlCompareMemory, kMemory, kImplemented, kLeaf);
 
 // https://msdn.microsoft.com/en-us/library/ff552123
 dword_result_t RtlCompareMemoryUlong_entry(lpvoid_t source, dword_t length,
@@ -72,7 +72,7 @@ dword_result_t RtlCompareMemoryUlong_entry(lpvoid_t source, dword_t length,
   }
   return num_compared_bytes;
 }
-DECLARE_XBOXKRNL_EXPORT1(RtlCompareMemoryUlong, kMemory, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(RtlCompareMemoryUlong, kMemory, kImplemented, kLeaf);
 
 // https://msdn.microsoft.com/en-us/library/ff552263
 void RtlFillMemoryUlong_entry(lpvoid_t destination, dword_t length,
@@ -86,7 +86,7 @@ void RtlFillMemoryUlong_entry(lpvoid_t destination, dword_t length,
     *p = swapped_pattern;
   }
 }
-DECLARE_XBOXKRNL_EXPORT1(RtlFillMemoryUlong, kMemory, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(RtlFillMemoryUlong, kMemory, kImplemented, kLeaf);
 
 static constexpr const unsigned char rtl_lower_table[256] = {
     0x0,  0x1,  0x2,  0x3,  0x4,  0x5,  0x6,  0x7,  0x8,  0x9,  0xA,  0xB,
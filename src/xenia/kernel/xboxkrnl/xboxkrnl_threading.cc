@@ -387,20 +387,21 @@ void xeKeSetCurrentProcessType(uint32_t type, cpu::ppc::PPCContext* context) {
 dword_result_t KeGetCurrentProcessType_entry(const ppc_context_t& context) {
   return xeKeGetCurrentProcessType(context);
 }
-DECLARE_XBOXKRNL_EXPORT2(KeGetCurrentProcessType, kThreading, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KeGetCurrentProcessType, kThreading, kImplemented,
+                         kHighFrequency, kLeaf);
 
 void KeSetCurrentProcessType_entry(dword_t type, const ppc_context_t& context) {
   xeKeSetCurrentProcessType(type, context);
 }
-DECLARE_XBOXKRNL_EXPORT1(KeSetCurrentProcessType, kThreading, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(KeSetCurrentProcessType, kThreading, kImplemented,
+                         kLeaf);
 
 dword_result_t KeQueryPerformanceFrequency_entry() {
   uint64_t result = Clock::guest_tick_frequency();
   return static_cast<uint32_t>(result);
 }
-DECLARE_XBOXKRNL_EXPORT2(KeQueryPerformanceFrequency, kThreading, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KeQueryPerformanceFrequency, kThreading, kImplemented,
+                         kHighFrequency, kLeaf);
 
 uint32_t KeDelayExecutionThread(uint32_t processor_mode, uint32_t alertable,
                                 uint64_t* interval_ptr,
@@ -456,7 +457,7 @@ void KeQuerySystemTime_entry(lpqword_t time_ptr, const ppc_context_t& ctx) {
     *time_ptr = time;
   }
 }
-DECLARE_XBOXKRNL_EXPORT1(KeQuerySystemTime, kThreading, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(KeQuerySystemTime, kThreading, kImplemented, kLeaf);
 
 // https://msdn.microsoft.com/en-us/library/ms686801
 dword_result_t KeTlsAlloc_entry() {
@@ -489,8 +490,8 @@ dword_result_t KeTlsGetValue_entry(dword_t tls_index) {
 
   return 0;
 }
-DECLARE_XBOXKRNL_EXPORT2(KeTlsGetValue, kThreading, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KeTlsGetValue, kThreading, kImplemented,
+                         kHighFrequency, kLeaf);
 
 // https://msdn.microsoft.com/en-us/library/ms686818
 dword_result_t KeTlsSetValue_entry(dword_t tls_index, dword_t tls_value) {
@@ -502,7 +503,7 @@ dword_result_t KeTlsSetValue_entry(dword_t tls_index, dword_t tls_value) {
 
   return 0;
 }
-DECLARE_XBOXKRNL_EXPORT1(KeTlsSetValue, kThreading, kImplemented);
+DECLARE_XBOXKRNL_EXPORT2(KeTlsSetValue, kThreading, kImplemented, kLeaf);
 
 void KeInitializeEvent_entry(pointer_t<X_KEVENT> event_ptr, dword_t event_type,
                              dword_t initial_state) {
@@ -1209,8 +1210,8 @@ dword_result_t KeRaiseIrqlToDpcLevel_entry(const ppc_context_t& ctx) {
 
   return old_irql;
 }
-DECLARE_XBOXKRNL_EXPORT2(KeRaiseIrqlToDpcLevel, kThreading, kImplemented,
-                         kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KeRaiseIrqlToDpcLevel, kThreading, kImplemented,
+                         kHighFrequency, kLeaf);
 void xeKfLowerIrql(PPCContext* ctx, unsigned char new_irql) {
   X_KPCR* kpcr = ctx->TranslateVirtualGPR<X_KPCR*>(ctx->r[13]);
 
@@ -1227,7 +1228,8 @@ void xeKfLowerIrql(PPCContext* ctx, unsigned char new_irql) {
 void KfLowerIrql_entry(dword_t new_irql, const ppc_context_t& ctx) {
   xeKfLowerIrql(ctx, static_cast<unsigned char>(new_irql));
 }
-DECLARE_XBOXKRNL_EXPORT2(KfLowerIrql, kThreading, kImplemented, kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KfLowerIrql, kThreading, kImplemented, kHighFrequency,
+                         kLeaf);
 
 unsigned char xeKfRaiseIrql(PPCContext* ctx, unsigned char new_irql) {
   X_KPCR* v1 = ctx->TranslateVirtualGPR<X_KPCR*>(ctx->r[13]);
@@ -1248,7 +1250,8 @@ dword_result_t KfRaiseIrql_entry(dword_t new_irql, const ppc_context_t& ctx) {
   return xeKfRaiseIrql(ctx, new_irql);
 }
 
-DECLARE_XBOXKRNL_EXPORT2(KfRaiseIrql, kThreading, kImplemented, kHighFrequency);
+DECLARE_XBOXKRNL_EXPORT3(KfRaiseIrql, kThreading, kImplemented, kHighFrequency,
+                         kLeaf);
 
 uint32_t xeNtQueueApcThread(uint32_t thread_handle, uint32_t apc_routine,
                             uint32_t apc_routine_context, uint32_t arg1,
@@ -6,7 +6,10 @@
  * Released under the BSD license - see LICENSE in the root for more details. *
  ******************************************************************************
  */
-#include <regex>
+#include <cctype>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
 
 #include "xenia/base/cvar.h"
 #include "xenia/base/filesystem.h"
@@ -22,13 +25,36 @@ DEFINE_bool(apply_patches, true, "Enables custom patching functionality",
 namespace xe {
 namespace patcher {
 
-PatchDB::PatchDB(const std::filesystem::path patches_root) {
+PatchDB::PatchDB(const std::filesystem::path patches_root,
+                 const std::filesystem::path cache_root) {
   patches_root_ = patches_root;
+  cache_root_ = cache_root;
   LoadPatches();
 }
 
 PatchDB::~PatchDB() {}
 
+std::optional<uint32_t> PatchDB::GetPatchFileTitleId(
+    const std::filesystem::path& file_name) {
+  const std::string name = path_to_utf8(file_name);
+  static const std::string_view kExtension = ".patch.toml";
+  if (name.size() < 8 + kExtension.size() ||
+      name.compare(name.size() - kExtension.size(), kExtension.size(),
+                   kExtension)) {
+    return std::nullopt;
+  }
+  uint32_t title_id = 0;
+  for (size_t i = 0; i < 8; ++i) {
+    const char c = name[i];
+    if (!std::isxdigit(static_cast<unsigned char>(c))) {
+      return std::nullopt;
+    }
+    title_id = (title_id << 4) |
+               uint32_t(c <= '9' ? c - '0' : (std::tolower(c) - 'a' + 10));
+  }
+  return title_id;
+}
+
 void PatchDB::LoadPatches() {
   if (!cvars::apply_patches) {
     return;
@@ -38,23 +64,268 @@ void PatchDB::LoadPatches() {
   const std::vector<xe::filesystem::FileInfo> patch_files =
       filesystem::ListFiles(patches_directory);
 
+  // Only index the files by the title ID in the name - parsing all of them is
+  // expensive with hundreds of titles, and only one title is played.
+  size_t indexed_file_count = 0;
   for (const xe::filesystem::FileInfo& patch_file : patch_files) {
     // Skip files that doesn't have only title_id as name and .patch as
     // extension
-    if (!std::regex_match(path_to_utf8(patch_file.name),
-                          patch_filename_regex_)) {
+    const std::optional<uint32_t> title_id =
+        GetPatchFileTitleId(patch_file.name);
+    if (!title_id) {
       XELOGE("PatchDB: Skipped loading file {} due to incorrect filename",
              path_to_utf8(patch_file.name));
       continue;
     }
+    patch_file_index_[*title_id].push_back(patch_file);
+    ++indexed_file_count;
+  }
+  XELOGI("PatchDB: Found {} patch files for {} titles", indexed_file_count,
+         patch_file_index_.size());
+}
 
-    const PatchFileEntry loaded_title_patches =
-        ReadPatchFile(patch_file.path / patch_file.name);
+void PatchDB::LoadTitlePatches(const uint32_t title_id) {
+  auto index_it = patch_file_index_.find(title_id);
+  if (index_it == patch_file_index_.end()) {
+    return;
+  }
+  for (const xe::filesystem::FileInfo& patch_file : index_it->second) {
+    PatchFileEntry loaded_title_patches = LoadPatchFile(patch_file);
     if (loaded_title_patches.title_id != -1) {
-      loaded_patches_.push_back(loaded_title_patches);
+      loaded_patches_.push_back(std::move(loaded_title_patches));
+    }
+  }
+  patch_file_index_.erase(index_it);
+}
+
+PatchFileEntry PatchDB::LoadPatchFile(
+    const xe::filesystem::FileInfo& patch_file) {
+  PatchFileEntry patch_entry;
+  if (ReadCachedPatchFile(patch_file, patch_entry)) {
+    return patch_entry;
+  }
+  patch_entry = ReadPatchFile(patch_file.path / patch_file.name);
+  if (patch_entry.title_id != -1) {
+    WriteCachedPatchFile(patch_file, patch_entry);
+  }
+  return patch_entry;
+}
+
+namespace {
+
+// Appends plain values and length-prefixed arrays to a byte vector.
+class CacheWriter {
+ public:
+  template <typename T>
+  void Write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    Write(&value, sizeof(value));
+  }
+  void Write(const void* data, size_t length) {
+    const uint8_t* data_bytes = reinterpret_cast<const uint8_t*>(data);
+    data_.insert(data_.end(), data_bytes, data_bytes + length);
+  }
+  void WriteBytes(const void* data, size_t length) {
+    Write(uint32_t(length));
+    Write(data, length);
+  }
+  void WriteString(const std::string& value) {
+    WriteBytes(value.data(), value.size());
+  }
+
+  const std::vector<uint8_t>& data() const { return data_; }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+// Reads the data written by CacheWriter, failing instead of reading past the
+// end if the file is truncated or corrupt.
+class CacheReader {
+ public:
+  explicit CacheReader(const std::vector<uint8_t>& data) : data_(data) {}
+
+  template <typename T>
+  bool Read(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return Read(&value, sizeof(value));
+  }
+  bool Read(void* data, size_t length) {
+    if (data_.size() - offset_ < length) {
+      return false;
+    }
+    std::memcpy(data, data_.data() + offset_, length);
+    offset_ += length;
+    return true;
+  }
+  bool ReadBytes(std::vector<uint8_t>& value) {
+    uint32_t length;
+    if (!Read(length) || data_.size() - offset_ < length) {
+      return false;
+    }
+    value.assign(data_.data() + offset_, data_.data() + offset_ + length);
+    offset_ += length;
+    return true;
+  }
+  bool ReadString(std::string& value) {
+    uint32_t length;
+    if (!Read(length) || data_.size() - offset_ < length) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data_.data() + offset_),
+                 length);
+    offset_ += length;
+    return true;
+  }
+  bool is_at_end() const { return offset_ == data_.size(); }
+
+ private:
+  const std::vector<uint8_t>& data_;
+  size_t offset_ = 0;
+};
+
+constexpr fourcc_t kCacheMagic = make_fourcc("XPDB");
+
+}  // namespace
+
+std::filesystem::path PatchDB::GetCachePath(
+    const xe::filesystem::FileInfo& patch_file) const {
+  std::filesystem::path cache_file_name = patch_file.name;
+  cache_file_name += ".bin";
+  return cache_root_ / "patches" / cache_file_name;
+}
+
+bool PatchDB::ReadCachedPatchFile(const xe::filesystem::FileInfo& patch_file,
+                                  PatchFileEntry& patch_entry) const {
+  if (cache_root_.empty()) {
+    return false;
+  }
+
+  std::vector<uint8_t> cache_data;
+  {
+    FILE* cache_file = xe::filesystem::OpenFile(GetCachePath(patch_file), "rb");
+    if (!cache_file) {
+      return false;
+    }
+    uint8_t read_buffer[4096];
+    size_t read_length;
+    while ((read_length = std::fread(read_buffer, 1, sizeof(read_buffer),
+                                     cache_file)) != 0) {
+      cache_data.insert(cache_data.end(), read_buffer,
+                        read_buffer + read_length);
+    }
+    std::fclose(cache_file);
+  }
+
+  CacheReader reader(cache_data);
+  uint32_t magic, version;
+  uint64_t source_size, source_write_timestamp;
+  if (!reader.Read(magic) || magic != kCacheMagic || !reader.Read(version) ||
+      version != kCacheVersion || !reader.Read(source_size) ||
+      source_size != patch_file.total_size ||
+      !reader.Read(source_write_timestamp) ||
+      source_write_timestamp != patch_file.write_timestamp) {
+    return false;
+  }
+
+  PatchFileEntry cached_entry;
+  uint32_t hash_count;
+  if (!reader.Read(cached_entry.title_id) ||
+      !reader.ReadString(cached_entry.title_name) ||
+      !reader.Read(hash_count) ||
+      cached_entry.title_id == -1) {
+    return false;
+  }
+  for (uint32_t i = 0; i < hash_count; ++i) {
+    uint64_t hash;
+    if (!reader.Read(hash)) {
+      return false;
+    }
+    cached_entry.hashes.push_back(hash);
+  }
+  uint32_t patch_count;
+  if (!reader.Read(patch_count)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < patch_count; ++i) {
+    PatchInfoEntry patch_info = PatchInfoEntry();
+    uint32_t data_count;
+    if (!reader.Read(patch_info.id) ||
+        !reader.ReadString(patch_info.patch_name) ||
+        !reader.ReadString(patch_info.patch_desc) ||
+        !reader.ReadString(patch_info.patch_author) ||
+        !reader.Read(patch_info.is_enabled) || !reader.Read(data_count)) {
+      return false;
     }
+    for (uint32_t j = 0; j < data_count; ++j) {
+      uint32_t address;
+      std::vector<uint8_t> data;
+      if (!reader.Read(address) || !reader.ReadBytes(data)) {
+        return false;
+      }
+      patch_info.patch_data.push_back({address, PatchDataValue(data)});
+    }
+    cached_entry.patch_info.push_back(std::move(patch_info));
+  }
+  if (!reader.is_at_end()) {
+    return false;
+  }
+
+  patch_entry = std::move(cached_entry);
+  return true;
+}
+
+void PatchDB::WriteCachedPatchFile(const xe::filesystem::FileInfo& patch_file,
+                                   const PatchFileEntry& patch_entry) const {
+  if (cache_root_.empty()) {
+    return;
+  }
+
+  CacheWriter writer;
+  writer.Write(kCacheMagic);
+  writer.Write(kCacheVersion);
+  writer.Write(uint64_t(patch_file.total_size));
+  writer.Write(patch_file.write_timestamp);
+  writer.Write(patch_entry.title_id);
+  writer.WriteString(patch_entry.title_name);
+  writer.Write(uint32_t(patch_entry.hashes.size()));
+  for (uint64_t hash : patch_entry.hashes) {
+    writer.Write(hash);
+  }
+  writer.Write(uint32_t(patch_entry.patch_info.size()));
+  for (const PatchInfoEntry& patch_info : patch_entry.patch_info) {
+    writer.Write(patch_info.id);
+    writer.WriteString(patch_info.patch_name);
+    writer.WriteString(patch_info.patch_desc);
+    writer.WriteString(patch_info.patch_author);
+    writer.Write(patch_info.is_enabled);
+    writer.Write(uint32_t(patch_info.patch_data.size()));
+    for (const PatchDataEntry& patch_data : patch_info.patch_data) {
+      writer.Write(patch_data.address);
+      writer.WriteBytes(patch_data.data.patch_data.data(),
+                        patch_data.data.patch_data.size());
+    }
+  }
+
+  const std::filesystem::path cache_path = GetCachePath(patch_file);
+  if (!xe::filesystem::CreateParentFolder(cache_path)) {
+    return;
+  }
+  FILE* cache_file = xe::filesystem::OpenFile(cache_path, "wb");
+  if (!cache_file) {
+    XELOGW("PatchDB: Cannot write patch cache file {}",
+           path_to_utf8(cache_path));
+    return;
+  }
+  const std::vector<uint8_t>& cache_data = writer.data();
+  bool written = std::fwrite(cache_data.data(), 1, cache_data.size(),
+                             cache_file) == cache_data.size();
+  std::fclose(cache_file);
+  if (!written) {
+    // Don't leave a truncated cache file, though it would be rejected anyway.
+    std::error_code error_code;
+    std::filesystem::remove(cache_path, error_code);
   }
-  XELOGI("PatchDB: Loaded patches for {} titles", loaded_patches_.size());
 }
 
 PatchFileEntry PatchDB::ReadPatchFile(
@@ -212,6 +483,8 @@ bool PatchDB::ReadPatchData(std::vector<PatchDataEntry>& patch_data,
 
 std::vector<PatchFileEntry> PatchDB::GetTitlePatches(
     const uint32_t title_id, const std::optional<uint64_t> hash) {
+  LoadTitlePatches(title_id);
+
   std::vector<PatchFileEntry> title_patches;
 
   std::copy_if(
@@ -226,6 +499,13 @@ std::vector<PatchFileEntry> PatchDB::GetTitlePatches(
   return title_patches;
 }
 
+std::vector<PatchFileEntry>& PatchDB::GetAllPatches() {
+  while (!patch_file_index_.empty()) {
+    LoadTitlePatches(patch_file_index_.begin()->first);
+  }
+  return loaded_patches_;
+}
+
 void PatchDB::ReadHashes(PatchFileEntry& patch_entry,
                          const toml::node* hashes_node) const {
   auto add_hash = [&patch_entry](const toml::node* hash_node) {
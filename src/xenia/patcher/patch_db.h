@@ -11,11 +11,13 @@
 #define XENIA_PATCH_DB_H_
 
 #include <cstring>
+#include <filesystem>
 #include <map>
 #include <optional>
-#include <regex>
+#include <unordered_map>
 
 #include "third_party/tomlplusplus/toml.hpp"
+#include "xenia/base/filesystem.h"
 
 namespace xe {
 namespace patcher {
@@ -89,9 +91,15 @@ struct PatchData {
   PatchData(uint8_t size_, PatchDataType type_) : size(size_), type(type_) {};
 };
 
+// Patch files are indexed by the title ID prefix of their names when the
+// database is created, and only parsed when patches for the title are
+// requested. Parsed files are stored in a binary cache, if a cache root is
+// provided, that is used while the size and the modification time of the patch
+// file are unchanged.
 class PatchDB {
  public:
-  PatchDB(const std::filesystem::path patches_root);
+  PatchDB(const std::filesystem::path patches_root,
+          const std::filesystem::path cache_root = {});
   ~PatchDB();
 
   void LoadPatches();
@@ -100,9 +108,27 @@ class PatchDB {
 
   std::vector<PatchFileEntry> GetTitlePatches(
       const uint32_t title_id, const std::optional<uint64_t> hash);
-  std::vector<PatchFileEntry>& GetAllPatches() { return loaded_patches_; }
+  std::vector<PatchFileEntry>& GetAllPatches();
 
  private:
+  // Cache file format version, to be bumped when the layout of the entries
+  // changes.
+  static constexpr uint32_t kCacheVersion = 1;
+
+  // Returns the title ID from the name of a patch file, which must be the
+  // title ID followed by anything and the .patch.toml extension.
+  static std::optional<uint32_t> GetPatchFileTitleId(
+      const std::filesystem::path& file_name);
+
+  void LoadTitlePatches(const uint32_t title_id);
+  PatchFileEntry LoadPatchFile(const xe::filesystem::FileInfo& patch_file);
+  std::filesystem::path GetCachePath(
+      const xe::filesystem::FileInfo& patch_file) const;
+  bool ReadCachedPatchFile(const xe::filesystem::FileInfo& patch_file,
+                           PatchFileEntry& patch_entry) const;
+  void WriteCachedPatchFile(const xe::filesystem::FileInfo& patch_file,
+                            const PatchFileEntry& patch_entry) const;
+
   void ReadHashes(PatchFileEntry& patch_entry,
                   const toml::node* patch_toml_fields) const;
   void ReadPatchHeader(PatchInfoEntry& patch_info,
@@ -111,9 +137,6 @@ class PatchDB {
                      const std::pair<std::string, PatchData> data_type,
                      const toml::table* patch_fields) const;
 
-  inline static const std::regex patch_filename_regex_ =
-      std::regex("^[A-Fa-f0-9]{8}.*\\.patch\\.toml$");
-
   const std::map<std::string, PatchData> patch_data_types_size_ = {
       {"string", PatchData(0, PatchDataType::kString)},
       {"u16string", PatchData(0, PatchDataType::kU16String)},
@@ -125,8 +148,12 @@ class PatchDB {
       {"be16", PatchData(sizeof(uint16_t), PatchDataType::kBE16)},
       {"be8", PatchData(sizeof(uint8_t), PatchDataType::kBE8)}};
 
+  // Title ID from the file name -> patch files not parsed yet.
+  std::unordered_map<uint32_t, std::vector<xe::filesystem::FileInfo>>
+      patch_file_index_;
   std::vector<PatchFileEntry> loaded_patches_;
   std::filesystem::path patches_root_;
+  std::filesystem::path cache_root_;
 };
 }  // namespace patcher
 }  // namespace xe
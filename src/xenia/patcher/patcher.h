@@ -18,7 +18,8 @@ namespace patcher {
 
 class Patcher {
  public:
-  Patcher(const std::filesystem::path patches_root);
+  Patcher(const std::filesystem::path patches_root,
+          const std::filesystem::path cache_root = {});
 
   void ApplyPatch(Memory* memory, const PatchInfoEntry* patch);
   void ApplyPatchesForTitle(Memory* memory, const uint32_t title_id,
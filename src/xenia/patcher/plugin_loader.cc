@@ -6,6 +6,8 @@
  * Released under the BSD license - see LICENSE in the root for more details. *
  ******************************************************************************
  */
+#include <algorithm>
+#include <cctype>
 #include <string>
 
 #include "xenia/base/logging.h"
@@ -40,21 +42,31 @@ PluginLoader::PluginLoader(kernel::KernelState* kernel_state,
 }
 
 void PluginLoader::LoadConfigs() {
-  // Iterate through directory and check if .toml file exists
+  // Only gather the titles which have plugins - the configurations are parsed
+  // when a title is launched.
   std::vector<xe::filesystem::FileInfo> dir_files =
       xe::filesystem::ListDirectories(plugins_root_);
 
-  dir_files =
-      xe::filesystem::FilterByName(dir_files, std::regex("[A-Fa-f0-9]{8}"));
-
   for (const auto& entry : dir_files) {
-    const uint32_t title_id =
-        std::stoi(entry.name.filename().string(), nullptr, 16);
+    const std::string name = path_to_utf8(entry.name.filename());
+    if (name.size() != 8 ||
+        !std::all_of(name.cbegin(), name.cend(), [](char c) {
+          return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        })) {
+      continue;
+    }
+    unloaded_title_configs_.insert(
+        xe::string_util::from_string<uint32_t>(name, true));
+  }
 
+  XELOGI("Plugins: Found plugins for {} titles",
+         unloaded_title_configs_.size());
+}
+
+void PluginLoader::EnsureTitleConfigLoaded(const uint32_t title_id) {
+  if (unloaded_title_configs_.erase(title_id)) {
     LoadTitleConfig(title_id);
   }
-
-  XELOGI("Plugins: Loaded plugins for {} titles", dir_files.size());
 }
 
 void PluginLoader::LoadTitleConfig(const uint32_t title_id) {
@@ -162,8 +174,10 @@ std::vector<uint64_t> PluginLoader::GetHashes(
   return hashes;
 }
 
-bool PluginLoader::IsAnyPluginForTitleAvailable(
-    const uint32_t title_id, const uint64_t module_hash) const {
+bool PluginLoader::IsAnyPluginForTitleAvailable(const uint32_t title_id,
+                                                const uint64_t module_hash) {
+  EnsureTitleConfigLoaded(title_id);
+
   const auto result = std::find_if(
       plugin_configs_.cbegin(), plugin_configs_.cend(),
       [title_id, module_hash](const PluginInfoEntry& entry) {
@@ -178,6 +192,8 @@ bool PluginLoader::IsAnyPluginForTitleAvailable(
 }
 
 void PluginLoader::LoadTitlePlugins(const uint32_t title_id) {
+  EnsureTitleConfigLoaded(title_id);
+
   std::vector<PluginInfoEntry> title_plugins;
 
   std::copy_if(plugin_configs_.cbegin(), plugin_configs_.cend(),
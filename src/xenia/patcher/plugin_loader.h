@@ -10,6 +10,8 @@
 #ifndef XENIA_PLUGIN_LOADER_H_
 #define XENIA_PLUGIN_LOADER_H_
 
+#include <unordered_set>
+
 #include "third_party/tomlplusplus/toml.hpp"
 #include "xenia/kernel/kernel_state.h"
 #include "xenia/memory.h"
@@ -26,6 +28,9 @@ struct PluginInfoEntry {
   bool is_enabled;
 };
 
+// Only the directories of the titles having plugins are listed when the loader
+// is created, the plugin configuration of a title is parsed when the title is
+// launched.
 class PluginLoader {
  public:
   PluginLoader(kernel::KernelState* kernel_state,
@@ -33,11 +38,12 @@ class PluginLoader {
 
   void LoadTitlePlugins(const uint32_t title_id);
   bool IsAnyPluginForTitleAvailable(const uint32_t title_id,
-                                    const uint64_t module_hash) const;
+                                    const uint64_t module_hash);
   bool IsAnyPluginLoaded() { return is_any_plugin_loaded_; }
 
  private:
   void LoadConfigs();
+  void EnsureTitleConfigLoaded(const uint32_t title_id);
   void LoadTitleConfig(const uint32_t title_id);
   void CreatePluginDevice(const uint32_t title_id);
   void LoadTitlePlugin(const PluginInfoEntry& entry);
@@ -47,6 +53,9 @@ class PluginLoader {
   kernel::KernelState* kernel_state_;
   std::filesystem::path plugins_root_;
 
+  // Titles with a plugin directory whose configuration hasn't been loaded
+  // yet.
+  std::unordered_set<uint32_t> unloaded_title_configs_;
   std::vector<PluginInfoEntry> plugin_configs_;
 
   bool is_any_plugin_loaded_;
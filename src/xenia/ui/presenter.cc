@@ -14,6 +14,7 @@
 
 #include "xenia/base/assert.h"
 #include "xenia/base/cvar.h"
+#include "xenia/base/frame_telemetry.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/platform.h"
 #include "xenia/ui/window.h"
@@ -1278,7 +1279,14 @@ Presenter::PaintResult Presenter::PaintAndPresent(bool execute_ui_drawers) {
   assert_false(execute_ui_drawers && !is_in_ui_thread_paint_);
   assert_true(surface_paint_connection_state_ ==
               SurfacePaintConnectionState::kConnectedPaintable);
+  uint64_t paint_start_us =
+      frame_telemetry::is_enabled() ? frame_telemetry::GetTimeUs() : 0;
   PaintResult result = PaintAndPresentImpl(execute_ui_drawers);
+  if (paint_start_us && (result == PaintResult::kPresented ||
+                         result == PaintResult::kPresentedSuboptimal)) {
+    frame_telemetry::AddHostPresent(frame_telemetry::GetTimeUs() -
+                                    paint_start_us);
+  }
   switch (result) {
     case PaintResult::kPresented:
       surface_paint_connection_was_optimal_at_successful_paint_ = true;
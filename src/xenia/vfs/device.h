@@ -10,6 +10,7 @@
 #ifndef XENIA_VFS_DEVICE_H_
 #define XENIA_VFS_DEVICE_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -42,9 +43,21 @@ class Device {
   virtual uint32_t sectors_per_allocation_unit() const = 0;
   virtual uint32_t bytes_per_sector() const = 0;
 
+  // Changed whenever entries are created, deleted or renamed after the device
+  // has been initialized, for validating cached path resolution results.
+  uint32_t entry_revision() const {
+    return entry_revision_.load(std::memory_order_acquire);
+  }
+  void MarkEntriesModified() {
+    entry_revision_.fetch_add(1, std::memory_order_acq_rel);
+  }
+
  protected:
   xe::global_critical_region global_critical_region_;
   std::string mount_path_;
+
+ private:
+  std::atomic<uint32_t> entry_revision_{0};
 };
 
 }  // namespace vfs
@@ -0,0 +1,237 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include "xenia/vfs/devices/disc_zarchive_block_cache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "xenia/base/assert.h"
+#include "xenia/base/logging.h"
+
+#include "third_party/zarchive/include/zarchive/zarchivereader.h"
+
+namespace xe {
+namespace vfs {
+
+DiscZarchiveBlockCache::DiscZarchiveBlockCache(ZArchiveReader& reader,
+                                               size_t max_block_count,
+                                               uint32_t read_ahead_block_count,
+                                               uint32_t read_ahead_thread_count)
+    : reader_(reader),
+      max_block_count_(std::max(max_block_count, size_t(1))),
+      // Don't let the read-ahead evict the blocks it has decompressed itself
+      // before they're read.
+      read_ahead_block_count_(std::min(read_ahead_block_count,
+                                       uint32_t(max_block_count_ / 2))) {
+  if (!read_ahead_block_count_) {
+    return;
+  }
+  for (uint32_t i = 0; i < read_ahead_thread_count; ++i) {
+    std::unique_ptr<xe::threading::Thread> read_ahead_thread =
+        xe::threading::Thread::Create({}, [this]() { ReadAheadThread(); });
+    if (!read_ahead_thread) {
+      XELOGE("Failed to create a ZArchive read-ahead thread");
+      break;
+    }
+    read_ahead_thread->set_name("ZArchive Read-Ahead");
+    read_ahead_threads_.push_back(std::move(read_ahead_thread));
+  }
+}
+
+DiscZarchiveBlockCache::~DiscZarchiveBlockCache() {
+  if (!read_ahead_threads_.empty()) {
+    {
+      std::lock_guard<xe_mutex> lock(lock_);
+      read_ahead_shutdown_ = true;
+    }
+    read_ahead_cond_.notify_all();
+    for (auto& read_ahead_thread : read_ahead_threads_) {
+      xe::threading::Wait(read_ahead_thread.get(), false);
+    }
+  }
+}
+
+size_t DiscZarchiveBlockCache::Read(uint32_t file_handle, uint64_t file_size,
+                                    uint64_t offset, size_t length,
+                                    void* buffer) {
+  if (offset >= file_size) {
+    return 0;
+  }
+  length = size_t(std::min(uint64_t(length), file_size - offset));
+  if (!length) {
+    return 0;
+  }
+  uint32_t first_block_index = uint32_t(offset >> kBlockSizeLog2);
+  uint32_t last_block_index = uint32_t((offset + length - 1) >> kBlockSizeLog2);
+
+  auto buffer_bytes = static_cast<uint8_t*>(buffer);
+  size_t bytes_read = 0;
+  for (uint32_t block_index = first_block_index;
+       block_index <= last_block_index; ++block_index) {
+    std::shared_ptr<Block> block =
+        AcquireBlock(file_handle, block_index, file_size);
+    if (!block) {
+      break;
+    }
+    size_t block_offset = size_t(offset + bytes_read -
+                                 (uint64_t(block_index) << kBlockSizeLog2));
+    size_t block_bytes_read =
+        std::min(length - bytes_read, size_t(block->length) - block_offset);
+    std::memcpy(buffer_bytes + bytes_read, block->data.data() + block_offset,
+                block_bytes_read);
+    bytes_read += block_bytes_read;
+  }
+
+  // After acquiring the blocks being read, so the read-ahead doesn't evict
+  // them.
+  if (!read_ahead_threads_.empty()) {
+    std::lock_guard<xe_mutex> lock(lock_);
+    auto read_end_it = read_ends_.find(file_handle);
+    if (read_end_it != read_ends_.end()) {
+      if (read_end_it->second == offset) {
+        QueueReadAhead(file_handle, last_block_index + 1, file_size);
+      }
+      read_end_it->second = offset + length;
+    } else {
+      read_ends_.emplace(file_handle, offset + length);
+    }
+  }
+
+  return bytes_read;
+}
+
+std::shared_ptr<DiscZarchiveBlockCache::Block>
+DiscZarchiveBlockCache::AcquireBlock(uint32_t file_handle,
+                                     uint32_t block_index,
+                                     uint64_t file_size) {
+  std::unique_lock<xe_mutex> lock(lock_);
+  std::shared_ptr<Block> block;
+  auto block_it = blocks_.find(GetBlockKey(file_handle, block_index));
+  if (block_it != blocks_.end()) {
+    block = *block_it->second;
+    lru_.splice(lru_.begin(), lru_, block_it->second);
+  } else {
+    block = InsertBlock(file_handle, block_index, file_size);
+  }
+  if (block->state == Block::State::kQueued) {
+    // Not requested yet, or still in the read-ahead queue - don't wait for the
+    // read-ahead threads to reach it.
+    block->state = Block::State::kDecompressing;
+    lock.unlock();
+    DecompressBlock(*block);
+  } else {
+    block_decompressed_cond_.wait(lock, [&block]() {
+      return block->state != Block::State::kDecompressing;
+    });
+  }
+  // Not modified after decompression anymore.
+  return block->state == Block::State::kReady ? block : nullptr;
+}
+
+std::shared_ptr<DiscZarchiveBlockCache::Block>
+DiscZarchiveBlockCache::InsertBlock(uint32_t file_handle, uint32_t block_index,
+                                    uint64_t file_size) {
+  while (blocks_.size() >= max_block_count_) {
+    // Still referenced by the threads using it if there are any.
+    const Block& evicted_block = *lru_.back();
+    blocks_.erase(GetBlockKey(evicted_block.file_handle, evicted_block.index));
+    lru_.pop_back();
+  }
+  auto block = std::make_shared<Block>();
+  block->file_handle = file_handle;
+  block->index = block_index;
+  block->length =
+      uint32_t(std::min(uint64_t(kBlockSize),
+                        file_size - (uint64_t(block_index) << kBlockSizeLog2)));
+  lru_.push_front(block);
+  blocks_.emplace(GetBlockKey(file_handle, block_index), lru_.begin());
+  return block;
+}
+
+void DiscZarchiveBlockCache::DecompressBlock(Block& block) {
+  assert_true(block.state == Block::State::kDecompressing);
+  block.data.resize(block.length);
+  uint64_t bytes_read = reader_.ReadFromFile(
+      block.file_handle, uint64_t(block.index) << kBlockSizeLog2, block.length,
+      block.data.data());
+  decompressed_block_count_.fetch_add(1, std::memory_order_relaxed);
+  {
+    std::lock_guard<xe_mutex> lock(lock_);
+    if (bytes_read == block.length) {
+      block.state = Block::State::kReady;
+    } else {
+      XELOGE("Failed to read block {} of ZArchive file {}", block.index,
+             block.file_handle);
+      block.state = Block::State::kFailed;
+      block.data.clear();
+      // Let the next request try again.
+      auto block_it =
+          blocks_.find(GetBlockKey(block.file_handle, block.index));
+      if (block_it != blocks_.end() && block_it->second->get() == &block) {
+        lru_.erase(block_it->second);
+        blocks_.erase(block_it);
+      }
+    }
+  }
+  block_decompressed_cond_.notify_all();
+}
+
+void DiscZarchiveBlockCache::QueueReadAhead(uint32_t file_handle,
+                                            uint32_t first_block_index,
+                                            uint64_t file_size) {
+  uint64_t block_count = (file_size + kBlockSize - 1) >> kBlockSizeLog2;
+  uint32_t end_block_index = uint32_t(std::min(
+      uint64_t(first_block_index) + read_ahead_block_count_, block_count));
+  bool queued = false;
+  for (uint32_t block_index = first_block_index;
+       block_index < end_block_index; ++block_index) {
+    if (blocks_.find(GetBlockKey(file_handle, block_index)) != blocks_.end()) {
+      continue;
+    }
+    read_ahead_queue_.push_back(
+        InsertBlock(file_handle, block_index, file_size));
+    queued = true;
+  }
+  if (queued) {
+    read_ahead_cond_.notify_all();
+  }
+}
+
+void DiscZarchiveBlockCache::ReadAheadThread() {
+  while (true) {
+    std::shared_ptr<Block> block;
+    {
+      std::unique_lock<xe_mutex> lock(lock_);
+      read_ahead_cond_.wait(lock, [this]() {
+        return read_ahead_shutdown_ || !read_ahead_queue_.empty();
+      });
+      if (read_ahead_shutdown_) {
+        return;
+      }
+      block = std::move(read_ahead_queue_.front());
+      read_ahead_queue_.pop_front();
+      // Skip if a reader has already claimed it, or if it has already been
+      // evicted, in which case decompressing it would be a waste.
+      if (block->state != Block::State::kQueued) {
+        continue;
+      }
+      auto block_it =
+          blocks_.find(GetBlockKey(block->file_handle, block->index));
+      if (block_it == blocks_.end() || *block_it->second != block) {
+        continue;
+      }
+      block->state = Block::State::kDecompressing;
+    }
+    DecompressBlock(*block);
+  }
+}
+
+}  // namespace vfs
+}  // namespace xe
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#ifndef XENIA_VFS_DEVICES_DISC_ZARCHIVE_BLOCK_CACHE_H_
+#define XENIA_VFS_DEVICES_DISC_ZARCHIVE_BLOCK_CACHE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "xenia/base/mutex.h"
+#include "xenia/base/threading.h"
+
+class ZArchiveReader;
+
+namespace xe {
+namespace vfs {
+
+// Decompressed file data of a ZArchive, in blocks of the ZArchive compression
+// block size, shared by all readers of the device, with the least recently
+// used blocks dropped when the cache is full.
+//
+// If a file is read sequentially, the blocks after the read range are
+// decompressed ahead of time by background threads. Each block is
+// decompressed only once even if multiple threads request it at the same
+// time - the rest wait for the one doing the decompression.
+class DiscZarchiveBlockCache {
+ public:
+  static constexpr uint32_t kBlockSizeLog2 = 16;
+  static constexpr uint32_t kBlockSize = uint32_t(1) << kBlockSizeLog2;
+
+  // If read_ahead_thread_count is 0, read-ahead is disabled.
+  DiscZarchiveBlockCache(ZArchiveReader& reader, size_t max_block_count,
+                         uint32_t read_ahead_block_count,
+                         uint32_t read_ahead_thread_count);
+  ~DiscZarchiveBlockCache();
+
+  // Returns the number of bytes read, which is less than length only if the
+  // range crosses the end of the file or if it can't be read.
+  size_t Read(uint32_t file_handle, uint64_t file_size, uint64_t offset,
+              size_t length, void* buffer);
+
+  // Number of blocks decompressed since the creation of the cache, including
+  // the ones decompressed again after eviction.
+  uint64_t decompressed_block_count() const {
+    return decompressed_block_count_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Block {
+    enum class State {
+      // Waiting in the read-ahead queue.
+      kQueued,
+      kDecompressing,
+      kReady,
+      kFailed,
+    };
+
+    uint32_t file_handle;
+    uint32_t index;
+    uint32_t length;
+    State state = State::kQueued;
+    std::vector<uint8_t> data;
+  };
+  using BlockList = std::list<std::shared_ptr<Block>>;
+
+  static uint64_t GetBlockKey(uint32_t file_handle, uint32_t block_index) {
+    return (uint64_t(file_handle) << 32) | block_index;
+  }
+
+  // Returns nullptr if the block couldn't be decompressed.
+  std::shared_ptr<Block> AcquireBlock(uint32_t file_handle,
+                                      uint32_t block_index,
+                                      uint64_t file_size);
+  // Must be called with the lock held. The block must not be in the cache
+  // yet.
+  std::shared_ptr<Block> InsertBlock(uint32_t file_handle,
+                                     uint32_t block_index,
+                                     uint64_t file_size);
+  // Must be called with the lock not held, with the state of the block
+  // changed to kDecompressing by the caller.
+  void DecompressBlock(Block& block);
+  // Must be called with the lock held.
+  void QueueReadAhead(uint32_t file_handle, uint32_t first_block_index,
+                      uint64_t file_size);
+  void ReadAheadThread();
+
+  ZArchiveReader& reader_;
+  size_t max_block_count_;
+  uint32_t read_ahead_block_count_;
+
+  xe_mutex lock_;
+  // Notified when blocks leave the kDecompressing state.
+  std::condition_variable_any block_decompressed_cond_;
+  // Most recently used first.
+  BlockList lru_;
+  std::unordered_map<uint64_t, BlockList::iterator> blocks_;
+  // File handle -> where the last read from it has ended, for detecting
+  // sequential access.
+  std::unordered_map<uint32_t, uint64_t> read_ends_;
+
+  std::atomic<uint64_t> decompressed_block_count_{0};
+
+  std::condition_variable_any read_ahead_cond_;
+  std::deque<std::shared_ptr<Block>> read_ahead_queue_;
+  bool read_ahead_shutdown_ = false;
+  std::vector<std::unique_ptr<xe::threading::Thread>> read_ahead_threads_;
+};
+
+}  // namespace vfs
+}  // namespace xe
+
+#endif  // XENIA_VFS_DEVICES_DISC_ZARCHIVE_BLOCK_CACHE_H_
@@ -9,6 +9,9 @@
 
 #include "xenia/vfs/devices/disc_zarchive_device.h"
 
+#include <algorithm>
+
+#include "xenia/base/cvar.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/math.h"
@@ -16,9 +19,21 @@
 
 #include "third_party/zarchive/include/zarchive/zarchivereader.h"
 
+DEFINE_int32(zarchive_block_cache_size, 64,
+             "Size of the cache of decompressed data of ZArchive disc images, "
+             "in megabytes. 0 to disable the cache.",
+             "Storage");
+DEFINE_int32(zarchive_read_ahead_blocks, 16,
+             "Number of 64 KB blocks after the read data to decompress in "
+             "background when a file on a ZArchive disc image is read "
+             "sequentially. 0 to disable reading ahead.",
+             "Storage");
+
 namespace xe {
 namespace vfs {
 
+using namespace xe::literals;
+
 DiscZarchiveDevice::DiscZarchiveDevice(const std::string_view mount_path,
                                        const std::filesystem::path& host_path)
     : Device(mount_path), name_("GDFX"), host_path_(host_path), reader_() {}
@@ -34,6 +49,17 @@ bool DiscZarchiveDevice::Initialize() {
     return false;
   }
 
+  if (cvars::zarchive_block_cache_size > 0) {
+    // Reading ahead is mostly useful to move decompression off the thread
+    // doing the reads, and the reader serializes most of the work internally,
+    // so only a couple of threads are needed.
+    block_cache_ = std::make_unique<DiscZarchiveBlockCache>(
+        *reader_,
+        size_t(cvars::zarchive_block_cache_size) * 1_MiB /
+            DiscZarchiveBlockCache::kBlockSize,
+        uint32_t(std::max(cvars::zarchive_read_ahead_blocks, 0)), 2);
+  }
+
   const std::string root_path = std::string("/");
   const ZArchiveNodeHandle handle = reader_->LookUp(root_path);
   auto root_entry = new DiscZarchiveEntry(this, nullptr, root_path, "");
@@ -84,7 +110,7 @@ bool DiscZarchiveDevice::ReadAllEntries(const std::string& path,
     entry->attributes_ = kFileAttributeReadOnly;
     entry->handle_ = static_cast<uint32_t>(handle);
     entry->parent_ = parent;
-    entry->children_.push_back(std::unique_ptr<Entry>(entry));
+    entry->AddChild(std::unique_ptr<Entry>(entry));
     return true;
   }
 
@@ -119,7 +145,7 @@ bool DiscZarchiveDevice::ReadAllEntries(const std::string& path,
         entry->data_size_ = 0;
         entry->size_ = dirEntry.size;
         entry->attributes_ = kFileAttributeDirectory | kFileAttributeReadOnly;
-        node->children_.push_back(std::unique_ptr<Entry>(entry));
+        node->AddChild(std::unique_ptr<Entry>(entry));
         if (!ReadAllEntries(full_path + "\\", entry, node)) {
           return false;
         }
@@ -128,7 +154,7 @@ bool DiscZarchiveDevice::ReadAllEntries(const std::string& path,
         entry->attributes_ = kFileAttributeReadOnly;
         entry->allocation_size_ =
             xe::round_up(entry->size_, bytes_per_sector());
-        node->children_.push_back(std::unique_ptr<Entry>(entry));
+        node->AddChild(std::unique_ptr<Entry>(entry));
       }
     }
     return true;
@@ -15,6 +15,7 @@
 
 #include "xenia/base/mapped_memory.h"
 #include "xenia/vfs/device.h"
+#include "xenia/vfs/devices/disc_zarchive_block_cache.h"
 
 #include "third_party/zarchive/include/zarchive/zarchivereader.h"
 
@@ -48,6 +49,8 @@ class DiscZarchiveDevice : public Device {
   uint32_t bytes_per_sector() const override { return 0x200; }
 
   ZArchiveReader* reader() const { return reader_.get(); }
+  // nullptr if disabled.
+  DiscZarchiveBlockCache* block_cache() const { return block_cache_.get(); }
 
  private:
   bool ReadAllEntries(const std::string& path, DiscZarchiveEntry* node,
@@ -57,6 +60,8 @@ class DiscZarchiveDevice : public Device {
   std::filesystem::path host_path_;
   std::unique_ptr<Entry> root_entry_;
   std::unique_ptr<ZArchiveReader> reader_;
+  // Must be destroyed before the reader.
+  std::unique_ptr<DiscZarchiveBlockCache> block_cache_;
 };
 
 }  // namespace vfs
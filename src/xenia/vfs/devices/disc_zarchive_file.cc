@@ -31,10 +31,16 @@ X_STATUS DiscZarchiveFile::ReadSync(void* buffer, size_t buffer_length,
   if (byte_offset >= entry_->size()) {
     return X_STATUS_END_OF_FILE;
   }
-  const uint64_t bytes_read =
-      ((DiscZarchiveDevice*)entry_->device_)
-          ->reader()
-          ->ReadFromFile(entry_->handle_, byte_offset, buffer_length, buffer);
+  auto device = (DiscZarchiveDevice*)entry_->device_;
+  DiscZarchiveBlockCache* block_cache = device->block_cache();
+  if (block_cache) {
+    *out_bytes_read =
+        block_cache->Read(entry_->handle_, entry_->data_size(), byte_offset,
+                          buffer_length, buffer);
+    return X_STATUS_SUCCESS;
+  }
+  const uint64_t bytes_read = device->reader()->ReadFromFile(
+      entry_->handle_, byte_offset, buffer_length, buffer);
   const size_t real_length =
       std::min(buffer_length, entry_->data_size() - byte_offset);
   *out_bytes_read = real_length;
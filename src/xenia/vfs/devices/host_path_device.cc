@@ -41,8 +41,10 @@ bool HostPathDevice::Initialize() {
 
   auto root_entry = new HostPathEntry(this, nullptr, "", "", host_path_);
   root_entry->attributes_ = kFileAttributeDirectory;
+  // Directories are listed lazily when they're accessed for the first time,
+  // so mounting a large tree doesn't stat every file in it.
+  root_entry->children_populated_ = false;
   root_entry_ = std::unique_ptr<Entry>(root_entry);
-  PopulateEntry(root_entry);
 
   return true;
 }
@@ -60,19 +62,5 @@ Entry* HostPathDevice::ResolvePath(const std::string_view path) {
   return root_entry_->ResolvePath(path);
 }
 
-void HostPathDevice::PopulateEntry(HostPathEntry* parent_entry) {
-  auto child_infos = xe::filesystem::ListFiles(parent_entry->host_path());
-  for (auto& child_info : child_infos) {
-    auto child = HostPathEntry::Create(
-        this, parent_entry, parent_entry->host_path() / child_info.name,
-        child_info);
-    parent_entry->children_.push_back(std::unique_ptr<Entry>(child));
-
-    if (child_info.type == xe::filesystem::FileInfo::Type::kDirectory) {
-      PopulateEntry(child);
-    }
-  }
-}
-
 }  // namespace vfs
 }  // namespace xe
@@ -42,6 +42,8 @@ HostPathEntry* HostPathEntry::Create(Device* device, Entry* parent,
   entry->write_timestamp_ = file_info.write_timestamp;
   if (file_info.type == xe::filesystem::FileInfo::Type::kDirectory) {
     entry->attributes_ = kFileAttributeDirectory;
+    // Listed from the host when accessed for the first time.
+    entry->children_populated_ = false;
   } else {
     entry->attributes_ = kFileAttributeNormal;
     if (device->is_read_only()) {
@@ -76,6 +78,13 @@ std::unique_ptr<MappedMemory> HostPathEntry::OpenMapped(MappedMemory::Mode mode,
   return MappedMemory::Open(host_path_, mode, offset, length);
 }
 
+void HostPathEntry::PopulateChildren() {
+  for (auto& child_info : xe::filesystem::ListFiles(host_path_)) {
+    AddChild(std::unique_ptr<Entry>(
+        Create(device_, this, host_path_ / child_info.name, child_info)));
+  }
+}
+
 std::unique_ptr<Entry> HostPathEntry::CreateEntryInternal(
     const std::string_view name, uint32_t attributes) {
   auto full_path = host_path_ / xe::to_path(name);
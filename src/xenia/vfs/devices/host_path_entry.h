@@ -49,6 +49,7 @@ class HostPathEntry : public Entry {
  private:
   friend class HostPathDevice;
 
+  void PopulateChildren() override;
   std::unique_ptr<Entry> CreateEntryInternal(const std::string_view name,
                                              uint32_t attributes) override;
   bool DeleteEntryInternal(Entry* entry) override;
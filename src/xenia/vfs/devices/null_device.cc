@@ -32,7 +32,7 @@ bool NullDevice::Initialize() {
 
   for (auto path : null_paths_) {
     auto child = NullEntry::Create(this, root_entry, path);
-    root_entry->children_.push_back(std::unique_ptr<Entry>(child));
+    root_entry->AddChild(std::unique_ptr<Entry>(child));
   }
   return true;
 }
@@ -12,9 +12,11 @@
 
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <string_view>
 
 #include "xenia/base/math.h"
+#include "xenia/base/mutex.h"
 #include "xenia/kernel/util/xex2_info.h"
 #include "xenia/kernel/xam/content_manager.h"
 #include "xenia/vfs/device.h"
@@ -23,6 +25,8 @@
 namespace xe {
 namespace vfs {
 
+class XContentContainerEntry;
+
 constexpr fourcc_t kLIVESignature = make_fourcc("LIVE");
 constexpr fourcc_t kCONSignature = make_fourcc("CON ");
 constexpr fourcc_t kPIRSSignature = make_fourcc("PIRS");
@@ -68,6 +72,29 @@ class XContentContainerDevice : public Device {
     return header_->content_header.licenses[0].license_bits;
   }
 
+  // Checks the data of a file against the hashes stored in the container
+  // while it's being read sequentially, so it doesn't have to be read again.
+  class EntryVerifier {
+   public:
+    virtual ~EntryVerifier() = default;
+    // Takes the next part of the data of the file, of any length. Returns
+    // false if a block doesn't match its hash.
+    virtual bool Update(const void* data, size_t length) = 0;
+    // Checks the last block if it's incomplete, after all the data has been
+    // passed to Update.
+    virtual bool Finish() = 0;
+  };
+  // Returns nullptr if the container has no hashes to check. Verifiers of
+  // different entries may be used on different threads.
+  virtual std::unique_ptr<EntryVerifier> CreateEntryVerifier(
+      const XContentContainerEntry& entry) {
+    return nullptr;
+  }
+
+  // The host files are shared by all the entries and accessed by seeking, so
+  // reading must be done with this held.
+  xe_mutex& files_lock() { return files_lock_; }
+
  protected:
   XContentContainerDevice(const std::string_view mount_path,
                           const std::filesystem::path& host_path);
@@ -107,6 +134,7 @@ class XContentContainerDevice : public Device {
   std::string name_;
   std::filesystem::path host_path_;
 
+  xe_mutex files_lock_;
   std::map<size_t, FILE*> files_;
   size_t files_total_size_;
   std::unique_ptr<Entry> root_entry_;
@@ -11,6 +11,7 @@
 #include <cmath>
 
 #include "xenia/base/math.h"
+#include "xenia/vfs/devices/xcontent_container_device.h"
 #include "xenia/vfs/devices/xcontent_container_entry.h"
 #include "xenia/vfs/devices/xcontent_container_file.h"
 
@@ -37,6 +38,8 @@ X_STATUS XContentContainerFile::ReadSync(void* buffer, size_t buffer_length,
   size_t remaining_length =
       std::min(buffer_length, entry_->size() - byte_offset);
 
+  std::lock_guard<xe_mutex> lock(
+      static_cast<XContentContainerDevice*>(entry_->device())->files_lock());
   *out_bytes_read = 0;
   for (size_t i = 0; i < entry_->block_list().size(); i++) {
     auto& record = entry_->block_list()[i];
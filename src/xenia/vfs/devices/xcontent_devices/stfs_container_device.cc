@@ -8,6 +8,7 @@
  */
 
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "xenia/base/logging.h"
@@ -15,6 +16,8 @@
 #include "xenia/vfs/devices/xcontent_container_entry.h"
 #include "xenia/vfs/devices/xcontent_devices/stfs_container_device.h"
 
+#include "third_party/crypto/TinySHA1.hpp"
+
 namespace xe {
 namespace vfs {
 
@@ -91,7 +94,7 @@ StfsContainerDevice::Result StfsContainerDevice::Read() {
       std::unique_ptr<XContentContainerEntry> entry =
           ReadEntry(parent_entry, &files_, &dir_entry);
       all_entries.push_back(entry.get());
-      parent_entry->children_.emplace_back(std::move(entry));
+      parent_entry->AddChild(std::move(entry));
     }
 
     const StfsHashEntry* block_hash = GetBlockHash(table_block_index);
@@ -126,6 +129,7 @@ std::unique_ptr<XContentContainerEntry> StfsContainerDevice::ReadEntry(
     entry->attributes_ = kFileAttributeNormal | kFileAttributeReadOnly;
     entry->data_offset_ = BlockToOffset(dir_entry->start_block_number());
     entry->data_size_ = dir_entry->length;
+    entry->block_ = dir_entry->start_block_number();
   }
   entry->size_ = dir_entry->length;
   entry->allocation_size_ = xe::round_up(dir_entry->length, kBlockSize);
@@ -178,6 +182,97 @@ std::unique_ptr<XContentContainerEntry> StfsContainerDevice::ReadEntry(
   return entry;
 }
 
+class StfsContainerDevice::StfsEntryVerifier
+    : public XContentContainerDevice::EntryVerifier {
+ public:
+  StfsEntryVerifier(StfsContainerDevice& device,
+                    const XContentContainerEntry& entry)
+      : device_(device),
+        entry_(entry),
+        block_index_(uint32_t(entry.block())) {}
+
+  bool Update(const void* data, size_t length) override {
+    auto data_bytes = static_cast<const uint8_t*>(data);
+    while (length) {
+      size_t block_part_length =
+          std::min(length, size_t(kBlockSize - block_bytes_hashed_));
+      sha_.processBytes(data_bytes, block_part_length);
+      block_bytes_hashed_ += uint32_t(block_part_length);
+      data_bytes += block_part_length;
+      length -= block_part_length;
+      if (block_bytes_hashed_ == kBlockSize && !FinishBlock()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Finish() override {
+    if (!block_bytes_hashed_) {
+      return true;
+    }
+    if (block_number_ >= entry_.block_list().size()) {
+      XELOGE("STFS file {} has more data than blocks", entry_.path());
+      return false;
+    }
+    // The hash covers the whole block, including the padding after the end of
+    // the file, which has to be read from the container.
+    uint8_t padding[kBlockSize];
+    uint32_t padding_length = kBlockSize - block_bytes_hashed_;
+    const XContentContainerEntry::BlockRecord& record =
+        entry_.block_list()[block_number_];
+    {
+      std::lock_guard<xe_mutex> lock(device_.files_lock_);
+      auto& file = device_.files_.at(record.file);
+      xe::filesystem::Seek(file, record.offset + block_bytes_hashed_,
+                           SEEK_SET);
+      size_t padding_bytes_read = fread(padding, 1, padding_length, file);
+      std::memset(padding + padding_bytes_read, 0,
+                  padding_length - padding_bytes_read);
+    }
+    sha_.processBytes(padding, padding_length);
+    return FinishBlock();
+  }
+
+ private:
+  bool FinishBlock() {
+    uint8_t expected_hash[sizeof(StfsHashEntry::sha1)];
+    {
+      std::lock_guard<xe_mutex> lock(device_.files_lock_);
+      const StfsHashEntry* block_hash = device_.GetBlockHash(block_index_);
+      std::memcpy(expected_hash, block_hash->sha1, sizeof(expected_hash));
+      block_index_ = block_hash->level0_next_block();
+    }
+    uint8_t hash[sizeof(StfsHashEntry::sha1)];
+    sha_.finalize(hash);
+    sha_.reset();
+    block_bytes_hashed_ = 0;
+    if (std::memcmp(hash, expected_hash, sizeof(hash))) {
+      XELOGE("STFS block {} of {} doesn't match its hash", block_number_,
+             entry_.path());
+      return false;
+    }
+    ++block_number_;
+    return true;
+  }
+
+  StfsContainerDevice& device_;
+  const XContentContainerEntry& entry_;
+  // Blocks of a file are chained through their level-0 hash entries.
+  uint32_t block_index_;
+  size_t block_number_ = 0;
+  uint32_t block_bytes_hashed_ = 0;
+  sha1::SHA1 sha_;
+};
+
+std::unique_ptr<XContentContainerDevice::EntryVerifier>
+StfsContainerDevice::CreateEntryVerifier(const XContentContainerEntry& entry) {
+  if (entry.attributes() & kFileAttributeDirectory) {
+    return nullptr;
+  }
+  return std::make_unique<StfsEntryVerifier>(*this, entry);
+}
+
 size_t StfsContainerDevice::BlockToOffset(uint64_t block_index) const {
   // For every level there is a hash table
   // Level 0: hash table of next 170 blocks
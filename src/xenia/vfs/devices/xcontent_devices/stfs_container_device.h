@@ -52,7 +52,12 @@ class StfsContainerDevice : public XContentContainerDevice {
     return 0;
   }
 
+  std::unique_ptr<EntryVerifier> CreateEntryVerifier(
+      const XContentContainerEntry& entry) override;
+
  private:
+  class StfsEntryVerifier;
+
   static const uint8_t kBlocksHashLevelAmount = 3;
   const uint32_t kBlocksPerHashLevel[kBlocksHashLevelAmount] = {170, 28900,
                                                                 4913000};
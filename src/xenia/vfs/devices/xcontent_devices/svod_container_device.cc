@@ -233,7 +233,7 @@ SvodContainerDevice::Result SvodContainerDevice::ReadEntry(
     }
   }
 
-  parent->children_.emplace_back(std::move(entry));
+  parent->AddChild(std::move(entry));
 
   // Read the right node.
   if (dir_entry.node_r) {
@@ -41,7 +41,7 @@ void Entry::Dump(xe::StringBuffer* string_buffer, int indent) {
   }
   string_buffer->Append(name());
   string_buffer->Append('\n');
-  for (auto& child : children_) {
+  for (auto& child : children()) {
     child->Dump(string_buffer, indent + 2);
   }
 }
@@ -50,14 +50,12 @@ bool Entry::is_read_only() const { return device_->is_read_only(); }
 
 Entry* Entry::GetChild(const std::string_view name) {
   auto global_lock = global_critical_region_.Acquire();
-  auto it = std::find_if(children_.cbegin(), children_.cend(),
-                         [&](const auto& child) {
-                           return xe::utf8::equal_case(child->name(), name);
-                         });
-  if (it == children_.cend()) {
+  EnsureChildrenPopulated();
+  auto it = children_by_name_.find(name);
+  if (it == children_by_name_.cend()) {
     return nullptr;
   }
-  return (*it).get();
+  return it->second;
 }
 
 Entry* Entry::ResolvePath(const std::string_view path) {
@@ -76,6 +74,7 @@ Entry* Entry::ResolvePath(const std::string_view path) {
 Entry* Entry::IterateChildren(const xe::filesystem::WildcardEngine& engine,
                               size_t* current_index) {
   auto global_lock = global_critical_region_.Acquire();
+  EnsureChildrenPopulated();
   while (*current_index < children_.size()) {
     auto& child = children_[*current_index];
     *current_index = *current_index + 1;
@@ -99,10 +98,11 @@ Entry* Entry::CreateEntry(const std::string_view name, uint32_t attributes) {
   if (!entry) {
     return nullptr;
   }
-  children_.push_back(std::move(entry));
+  Entry* added_entry = AddChild(std::move(entry));
+  device_->MarkEntriesModified();
   // TODO(benvanik): resort? would break iteration?
   Touch();
-  return children_.back().get();
+  return added_entry;
 }
 
 bool Entry::Delete(Entry* entry) {
@@ -116,12 +116,14 @@ bool Entry::Delete(Entry* entry) {
   if (!DeleteEntryInternal(entry)) {
     return false;
   }
+  UnindexChild(entry);
   for (auto it = children_.begin(); it != children_.end(); ++it) {
     if (it->get() == entry) {
       children_.erase(it);
       break;
     }
   }
+  device_->MarkEntriesModified();
   Touch();
   return true;
 }
@@ -146,10 +148,58 @@ void Entry::Rename(const std::filesystem::path file_path) {
 
   RenameEntryInternal(guest_path_without_root);
 
+  // The name index of the parent references the name.
+  if (parent_) {
+    parent_->UnindexChild(this);
+  }
   absolute_path_ = xe::utf8::join_guest_paths(device_->mount_path(),
                                               guest_path_without_root);
   path_ = guest_path_without_root;
   name_ = xe::path_to_utf8(file_path.filename());
+  if (parent_) {
+    parent_->IndexChild(this);
+  }
+  device_->MarkEntriesModified();
+}
+
+Entry* Entry::AddChild(std::unique_ptr<Entry> child) {
+  Entry* child_ptr = child.get();
+  children_.push_back(std::move(child));
+  IndexChild(child_ptr);
+  return child_ptr;
+}
+
+void Entry::EnsureChildrenPopulated() {
+  if (children_populated_.load(std::memory_order_acquire)) {
+    return;
+  }
+  auto global_lock = global_critical_region_.Acquire();
+  if (!children_populated_.load(std::memory_order_relaxed)) {
+    PopulateChildren();
+    children_populated_.store(true, std::memory_order_release);
+  }
+}
+
+void Entry::IndexChild(Entry* child) {
+  // With case-sensitive host file systems, names may differ only in case -
+  // keep the first child found, like a linear search would.
+  children_by_name_.emplace(child->name(), child);
+}
+
+void Entry::UnindexChild(Entry* child) {
+  auto it = children_by_name_.find(child->name());
+  if (it == children_by_name_.end() || it->second != child) {
+    return;
+  }
+  children_by_name_.erase(it);
+  // Expose the next child with the same name, if there's any.
+  for (const auto& other_child : children_) {
+    if (other_child.get() != child &&
+        xe::utf8::equal_case(other_child->name(), child->name())) {
+      children_by_name_.emplace(other_child->name(), other_child.get());
+      break;
+    }
+  }
 }
 
 }  // namespace vfs
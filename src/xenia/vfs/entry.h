@@ -10,8 +10,10 @@
 #ifndef XENIA_VFS_ENTRY_H_
 #define XENIA_VFS_ENTRY_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "xenia/base/filesystem.h"
@@ -19,6 +21,7 @@
 #include "xenia/base/mapped_memory.h"
 #include "xenia/base/mutex.h"
 #include "xenia/base/string_buffer.h"
+#include "xenia/base/utf8.h"
 #include "xenia/xbox.h"
 
 namespace xe {
@@ -108,10 +111,14 @@ class Entry {
   Entry* GetChild(const std::string_view name);
   Entry* ResolvePath(const std::string_view path);
 
-  const std::vector<std::unique_ptr<Entry>>& children() const {
+  const std::vector<std::unique_ptr<Entry>>& children() {
+    EnsureChildrenPopulated();
     return children_;
   }
-  size_t child_count() const { return children_.size(); }
+  size_t child_count() {
+    EnsureChildrenPopulated();
+    return children_.size();
+  }
   Entry* IterateChildren(const xe::filesystem::WildcardEngine& engine,
                          size_t* current_index);
 
@@ -144,6 +151,17 @@ class Entry {
   virtual bool DeleteEntryInternal(Entry* entry) { return false; }
   virtual void RenameEntryInternal(const std::filesystem::path file_path) {}
 
+  // Appends a child, which devices must do instead of modifying children_
+  // directly to keep the name lookup index up to date.
+  Entry* AddChild(std::unique_ptr<Entry> child);
+
+  // For devices where listing the children is expensive, they can be added
+  // when they are accessed for the first time rather than when the device is
+  // mounted - if children_populated_ is false, PopulateChildren is called
+  // (with the global lock held) before the first access.
+  virtual void PopulateChildren() {}
+  void EnsureChildrenPopulated();
+
   xe::global_critical_region global_critical_region_;
   Device* device_;
   Entry* parent_;
@@ -157,7 +175,30 @@ class Entry {
   uint64_t access_timestamp_;
   uint64_t write_timestamp_;
   bool delete_on_close_;
+  // Set only after PopulateChildren returns, checked without the lock.
+  std::atomic<bool> children_populated_ = true;
   std::vector<std::unique_ptr<Entry>> children_;
+
+ private:
+  struct ChildNameHash {
+    size_t operator()(const std::string_view name) const {
+      return xe::utf8::hash_fnv1a_case(name);
+    }
+  };
+  struct ChildNameEqual {
+    bool operator()(const std::string_view left,
+                    const std::string_view right) const {
+      return xe::utf8::equal_case(left, right);
+    }
+  };
+
+  void IndexChild(Entry* child);
+  void UnindexChild(Entry* child);
+
+  // Case-insensitive name -> the first child with it. The keys reference the
+  // names of the children.
+  std::unordered_map<std::string_view, Entry*, ChildNameHash, ChildNameEqual>
+      children_by_name_;
 };
 
 }  // namespace vfs
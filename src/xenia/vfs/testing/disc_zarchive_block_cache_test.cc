@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/vfs/devices/disc_zarchive_block_cache.h"
+
+#include "third_party/catch/include/catch.hpp"
+#include "third_party/zarchive/include/zarchive/zarchivereader.h"
+#include "third_party/zarchive/include/zarchive/zarchivewriter.h"
+
+namespace xe::vfs::test {
+
+namespace {
+
+constexpr uint32_t kBlockSize = DiscZarchiveBlockCache::kBlockSize;
+
+// A ZArchive with a single file, Data.bin, of 3.5 cache blocks, with every
+// block containing different data.
+class TemporaryZArchive {
+ public:
+  static constexpr uint64_t kFileSize = kBlockSize * 3 + kBlockSize / 2;
+
+  explicit TemporaryZArchive(const std::string_view name)
+      : path_(std::filesystem::temp_directory_path() / name) {
+    data_.resize(size_t(kFileSize));
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = uint8_t(i * 7 + (i / kBlockSize) * 31);
+    }
+    FILE* file = xe::filesystem::OpenFile(path_, "wb");
+    if (!file) {
+      return;
+    }
+    {
+      ZArchiveWriter writer(
+          [](int32_t part_index, void* ctx) {},
+          [](const void* data, size_t length, void* ctx) {
+            fwrite(data, 1, length, static_cast<FILE*>(ctx));
+          },
+          file);
+      writer.StartNewFile("Data.bin");
+      writer.AppendData(data_.data(), data_.size());
+      writer.Finalize();
+    }
+    fclose(file);
+  }
+  ~TemporaryZArchive() { std::filesystem::remove(path_); }
+
+  const std::filesystem::path& path() const { return path_; }
+  const uint8_t* data() const { return data_.data(); }
+
+ private:
+  std::filesystem::path path_;
+  std::vector<uint8_t> data_;
+};
+
+}  // namespace
+
+TEST_CASE("ZArchive block cache reuses and evicts blocks",
+          "[zarchive_block_cache]") {
+  TemporaryZArchive archive("xenia-vfs-zarchive-block-cache-test.zar");
+  std::unique_ptr<ZArchiveReader> reader(
+      ZArchiveReader::OpenFromFile(archive.path()));
+  REQUIRE(reader);
+  ZArchiveNodeHandle handle = reader->LookUp("Data.bin", true, false);
+  REQUIRE(handle != ZARCHIVE_INVALID_NODE);
+  uint64_t file_size = reader->GetFileSize(handle);
+  REQUIRE(file_size == TemporaryZArchive::kFileSize);
+
+  // Two blocks, without read-ahead so only the reads decompress blocks.
+  DiscZarchiveBlockCache cache(*reader, 2, 0, 0);
+  uint8_t buffer[64];
+  auto read = [&](uint64_t offset, size_t length) -> size_t {
+    std::memset(buffer, 0, sizeof(buffer));
+    size_t bytes_read = cache.Read(handle, file_size, offset, length, buffer);
+    REQUIRE(std::memcmp(buffer, archive.data() + offset, bytes_read) == 0);
+    return bytes_read;
+  };
+
+  // Miss.
+  REQUIRE(read(100, 16) == 16);
+  REQUIRE(cache.decompressed_block_count() == 1);
+  // Hit in the same block.
+  REQUIRE(read(kBlockSize - 32, 32) == 32);
+  REQUIRE(cache.decompressed_block_count() == 1);
+
+  // Crossing the boundary between blocks 0 and 1 - only block 1 is new.
+  REQUIRE(read(kBlockSize - 8, 16) == 16);
+  REQUIRE(cache.decompressed_block_count() == 2);
+
+  // Block 2 evicts block 0, the least recently used one.
+  REQUIRE(read(kBlockSize * 2 + 5, 8) == 8);
+  REQUIRE(cache.decompressed_block_count() == 3);
+  REQUIRE(read(kBlockSize + 5, 8) == 8);
+  REQUIRE(cache.decompressed_block_count() == 3);
+  REQUIRE(read(5, 8) == 8);
+  REQUIRE(cache.decompressed_block_count() == 4);
+  // Block 0 has evicted block 2, not the more recently used block 1.
+  REQUIRE(read(kBlockSize + 13, 8) == 8);
+  REQUIRE(cache.decompressed_block_count() == 4);
+  REQUIRE(read(kBlockSize * 2 + 13, 8) == 8);
+  REQUIRE(cache.decompressed_block_count() == 5);
+
+  // Reads are clamped to the end of the file, which is in the middle of the
+  // last block.
+  REQUIRE(read(file_size - 10, 64) == 10);
+  REQUIRE(read(file_size, 64) == 0);
+  REQUIRE(cache.decompressed_block_count() == 6);
+}
+
+TEST_CASE("ZArchive block cache reads ahead sequential reads",
+          "[zarchive_block_cache]") {
+  TemporaryZArchive archive("xenia-vfs-zarchive-read-ahead-test.zar");
+  std::unique_ptr<ZArchiveReader> reader(
+      ZArchiveReader::OpenFromFile(archive.path()));
+  REQUIRE(reader);
+  ZArchiveNodeHandle handle = reader->LookUp("Data.bin", true, false);
+  REQUIRE(handle != ZARCHIVE_INVALID_NODE);
+  uint64_t file_size = reader->GetFileSize(handle);
+
+  // Reading the whole file in chunks crossing the block boundaries, with the
+  // blocks after them being decompressed in the background.
+  DiscZarchiveBlockCache cache(*reader, 4, 2, 2);
+  std::vector<uint8_t> buffer(static_cast<size_t>(file_size));
+  const size_t kChunkSize = kBlockSize / 3;
+  for (uint64_t offset = 0; offset < file_size; offset += kChunkSize) {
+    REQUIRE(cache.Read(handle, file_size, offset, kChunkSize,
+                       buffer.data() + offset) ==
+            size_t(std::min(uint64_t(kChunkSize), file_size - offset)));
+  }
+  REQUIRE(std::memcmp(buffer.data(), archive.data(), buffer.size()) == 0);
+  // Each block is decompressed once, either by a read or by the read-ahead.
+  REQUIRE(cache.decompressed_block_count() == 4);
+}
+
+}  // namespace xe::vfs::test
@@ -0,0 +1,126 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "xenia/base/filesystem.h"
+#include "xenia/vfs/devices/host_path_device.h"
+
+#include "third_party/catch/include/catch.hpp"
+#include "third_party/fmt/include/fmt/format.h"
+
+namespace xe::vfs::test {
+
+namespace {
+
+// A directory tree of `directory_count` nested levels, each containing
+// `file_count` empty files.
+class TemporaryTree {
+ public:
+  TemporaryTree(const std::string_view name, uint32_t directory_count,
+                uint32_t file_count)
+      : root_(std::filesystem::temp_directory_path() / name) {
+    std::filesystem::remove_all(root_);
+    std::filesystem::path directory = root_;
+    for (uint32_t i = 0; i < directory_count; ++i) {
+      directory /= fmt::format("Dir{}", i);
+      std::filesystem::create_directories(directory);
+      for (uint32_t j = 0; j < file_count; ++j) {
+        FILE* file = xe::filesystem::OpenFile(
+            directory / fmt::format("File{}.bin", j), "wb");
+        if (file) {
+          fclose(file);
+        }
+      }
+    }
+  }
+  ~TemporaryTree() { std::filesystem::remove_all(root_); }
+
+  const std::filesystem::path& root() const { return root_; }
+
+ private:
+  std::filesystem::path root_;
+};
+
+std::string MakeGuestPath(uint32_t directory_count, uint32_t file_index) {
+  std::string path;
+  for (uint32_t i = 0; i < directory_count; ++i) {
+    path += fmt::format("Dir{}\\", i);
+  }
+  path += fmt::format("File{}.bin", file_index);
+  return path;
+}
+
+}  // namespace
+
+TEST_CASE("HostPathDevice resolves paths", "[host_path_device]") {
+  TemporaryTree tree("xenia-vfs-host-path-test", 3, 4);
+  HostPathDevice device("\\Device\\Test", tree.root(), true);
+  REQUIRE(device.Initialize());
+
+  Entry* file = device.ResolvePath(MakeGuestPath(3, 2));
+  REQUIRE(file != nullptr);
+  REQUIRE(file->name() == "File2.bin");
+  REQUIRE(file->parent()->name() == "Dir2");
+
+  // Guest paths are case-insensitive.
+  REQUIRE(device.ResolvePath("dir0\\DIR1\\dIr2\\FILE2.BIN") == file);
+
+  REQUIRE(device.ResolvePath("Dir0\\Dir1\\File4.bin") == nullptr);
+  REQUIRE(device.ResolvePath("Dir0\\Missing\\File0.bin") == nullptr);
+
+  Entry* directory = device.ResolvePath("Dir0");
+  REQUIRE(directory != nullptr);
+  // Dir1 and the files.
+  REQUIRE(directory->child_count() == 5);
+}
+
+TEST_CASE("HostPathDevice mount and resolve",
+          "[.benchmark][host_path_device]") {
+  constexpr uint32_t kDirectoryCount = 8;
+  constexpr uint32_t kFileCount = 512;
+  constexpr uint32_t kResolveCount = 100000;
+
+  TemporaryTree tree("xenia-vfs-host-path-benchmark", kDirectoryCount,
+                     kFileCount);
+  std::vector<std::string> guest_paths;
+  for (uint32_t i = 0; i < kFileCount; ++i) {
+    guest_paths.push_back(MakeGuestPath(kDirectoryCount, i));
+  }
+
+  auto mount_start = std::chrono::steady_clock::now();
+  HostPathDevice device("\\Device\\Benchmark", tree.root(), true);
+  REQUIRE(device.Initialize());
+  auto mount_end = std::chrono::steady_clock::now();
+
+  // The first resolution lists the directories on the way.
+  REQUIRE(device.ResolvePath(guest_paths[0]) != nullptr);
+  auto first_resolve_end = std::chrono::steady_clock::now();
+
+  for (uint32_t i = 0; i < kResolveCount; ++i) {
+    REQUIRE(device.ResolvePath(guest_paths[i % kFileCount]) != nullptr);
+  }
+  auto resolve_end = std::chrono::steady_clock::now();
+
+  fmt::print(
+      "mount: {:.3f} ms, first resolve: {:.3f} ms, resolve: {:.1f} ns/path\n",
+      std::chrono::duration<double, std::milli>(mount_end - mount_start)
+          .count(),
+      std::chrono::duration<double, std::milli>(first_resolve_end - mount_end)
+          .count(),
+      std::chrono::duration<double, std::nano>(resolve_end - first_resolve_end)
+              .count() /
+          double(kResolveCount));
+}
+
+}  // namespace xe::vfs::test
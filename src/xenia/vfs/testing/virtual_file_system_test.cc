@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ * Xenia : Xbox 360 Emulator Research Project                                 *
+ ******************************************************************************
+ * Copyright 2024 Xenia Canary. All rights reserved.                          *
+ * Released under the BSD license - see LICENSE in the root for more details. *
+ ******************************************************************************
+ */
+
+#include <filesystem>
+#include <memory>
+
+#include "xenia/vfs/devices/host_path_device.h"
+#include "xenia/vfs/virtual_file_system.h"
+
+#include "third_party/catch/include/catch.hpp"
+
+namespace xe::vfs::test {
+
+namespace {
+
+std::unique_ptr<Device> CreateHostPathDevice(
+    const std::string_view mount_path, const std::filesystem::path& host_path) {
+  auto device = std::make_unique<HostPathDevice>(mount_path, host_path, false);
+  if (!device->Initialize()) {
+    return nullptr;
+  }
+  return device;
+}
+
+}  // namespace
+
+TEST_CASE("VirtualFileSystem resolves and caches paths", "[vfs]") {
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() / "xenia-vfs-resolve-test";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root / "a" / "Sub");
+  std::filesystem::create_directories(root / "b");
+
+  VirtualFileSystem vfs;
+  REQUIRE(vfs.RegisterDevice(
+      CreateHostPathDevice("\\Device\\A", root / "a")));
+  REQUIRE(vfs.RegisterDevice(
+      CreateHostPathDevice("\\Device\\B", root / "b")));
+  REQUIRE(vfs.RegisterSymbolicLink("game:", "\\Device\\A"));
+  REQUIRE(vfs.RegisterSymbolicLink("b:", "\\Device\\B"));
+
+  Entry* sub = vfs.ResolvePath("\\Device\\A\\Sub");
+  REQUIRE(sub != nullptr);
+  REQUIRE(sub->name() == "Sub");
+  // Cached, and through the symbolic link.
+  REQUIRE(vfs.ResolvePath("\\Device\\A\\Sub") == sub);
+  REQUIRE(vfs.ResolvePath("game:\\sub") == sub);
+  REQUIRE(vfs.ResolvePath("\\Device\\C\\Sub") == nullptr);
+
+  SECTION("Creation and deletion") {
+    REQUIRE(vfs.ResolvePath("\\Device\\B\\File.bin") == nullptr);
+    Entry* file = vfs.CreatePath("b:\\File.bin", kFileAttributeNormal);
+    REQUIRE(file != nullptr);
+    REQUIRE(vfs.ResolvePath("\\Device\\B\\File.bin") == file);
+    REQUIRE(vfs.DeletePath("b:\\File.bin"));
+    REQUIRE(vfs.ResolvePath("\\Device\\B\\File.bin") == nullptr);
+
+    file = vfs.CreatePath("b:\\File.bin", kFileAttributeNormal);
+    REQUIRE(file != nullptr);
+    REQUIRE(vfs.ResolvePath("\\Device\\B\\File.bin") == file);
+    // Deletion not through the file system.
+    REQUIRE(file->Delete());
+    REQUIRE(vfs.ResolvePath("\\Device\\B\\File.bin") == nullptr);
+  }
+
+  SECTION("Devices at overlapping mount paths") {
+    // The device registered first is used, like with a linear search.
+    REQUIRE(vfs.RegisterDevice(
+        CreateHostPathDevice("\\Device\\A\\Sub", root / "b")));
+    REQUIRE(vfs.ResolvePath("\\Device\\A\\Sub") == sub);
+    REQUIRE(vfs.UnregisterDevice("\\Device\\A"));
+    Entry* b_root = vfs.ResolvePath("\\Device\\A\\Sub");
+    REQUIRE(b_root != nullptr);
+    REQUIRE(b_root != sub);
+    REQUIRE(vfs.ResolvePath("game:\\Sub") == b_root);
+  }
+
+  vfs.Clear();
+  std::filesystem::remove_all(root);
+}
+
+}  // namespace xe::vfs::test
@@ -30,6 +30,11 @@ DEFINE_transient_path(source, "", "Specifies the file to dump from.",
 DEFINE_transient_path(dump_path, "",
                       "Specifies the directory to dump files to.", "General");
 
+DEFINE_transient_bool(verify, false,
+                      "Verifies the dumped files against the block hashes of "
+                      "STFS packages.",
+                      "General");
+
 int vfs_dump_main(const std::vector<std::string>& args) {
   if (cvars::source.empty() || cvars::dump_path.empty()) {
     XELOGE("Usage: {} [source] [dump_path]", xe::path_to_utf8(args[0]));
@@ -44,7 +49,8 @@ int vfs_dump_main(const std::vector<std::string>& args) {
     XELOGE("Failed to initialize device");
     return 1;
   }
-  return VirtualFileSystem::ExtractContentFiles(device.get(), base_path);
+  return VirtualFileSystem::ExtractContentFiles(device.get(), base_path,
+                                                cvars::verify);
 }
 
 }  // namespace vfs
@@ -11,18 +11,32 @@
 #include "xenia/kernel/xam/content_manager.h"
 #include "xenia/vfs/devices/xcontent_container_device.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
 #include "devices/host_path_entry.h"
 #include "xenia/base/literals.h"
 #include "xenia/base/logging.h"
 #include "xenia/base/string.h"
+#include "xenia/base/threading.h"
 #include "xenia/kernel/xfile.h"
+#include "xenia/vfs/devices/xcontent_container_entry.h"
 
 namespace xe {
 namespace vfs {
 
 using namespace xe::literals;
 
-VirtualFileSystem::VirtualFileSystem() {}
+namespace {
+// Files that can't be mapped are copied through a buffer of this size per
+// thread.
+constexpr size_t kExtractionChunkSize = 4_MiB;
+constexpr size_t kMaxExtractionThreadCount = 8;
+}  // namespace
+
+VirtualFileSystem::VirtualFileSystem() { RebuildMountPoints(); }
 
 VirtualFileSystem::~VirtualFileSystem() {
   // Delete all devices.
@@ -31,22 +45,26 @@ VirtualFileSystem::~VirtualFileSystem() {
 }
 
 void VirtualFileSystem::Clear() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   devices_.clear();
   symlinks_.clear();
+  OnStateModified();
 }
 
 bool VirtualFileSystem::RegisterDevice(std::unique_ptr<Device> device) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   devices_.emplace_back(std::move(device));
+  OnStateModified();
   return true;
 }
 
 bool VirtualFileSystem::UnregisterDevice(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   for (auto it = devices_.begin(); it != devices_.end(); ++it) {
     if ((*it)->mount_path() == path) {
       XELOGD("Unregistered device: {}", (*it)->mount_path());
       devices_.erase(it);
+      OnStateModified();
       return true;
     }
   }
@@ -55,15 +73,16 @@ bool VirtualFileSystem::UnregisterDevice(const std::string_view path) {
 
 bool VirtualFileSystem::RegisterSymbolicLink(const std::string_view path,
                                              const std::string_view target) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   symlinks_.insert({std::string(path), std::string(target)});
+  OnStateModified();
   XELOGD("Registered symbolic link: {} => {}", path, target);
 
   return true;
 }
 
 bool VirtualFileSystem::UnregisterSymbolicLink(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  std::unique_lock<std::shared_mutex> lock(mutex_);
   auto it = std::find_if(
       symlinks_.cbegin(), symlinks_.cend(),
       [&](const auto& s) { return xe::utf8::equal_case(path, s.first); });
@@ -73,11 +92,13 @@ bool VirtualFileSystem::UnregisterSymbolicLink(const std::string_view path) {
   XELOGD("Unregistered symbolic link: {} => {}", it->first, it->second);
 
   symlinks_.erase(it);
+  OnStateModified();
   return true;
 }
 
 bool VirtualFileSystem::FindSymbolicLink(const std::string_view path,
                                          std::string& target) {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
   auto it = std::find_if(
       symlinks_.cbegin(), symlinks_.cend(),
       [&](const auto& s) { return xe::utf8::starts_with_case(path, s.first); });
@@ -88,6 +109,59 @@ bool VirtualFileSystem::FindSymbolicLink(const std::string_view path,
   return true;
 }
 
+void VirtualFileSystem::OnStateModified() {
+  ++state_revision_;
+  resolve_cache_.clear();
+  RebuildMountPoints();
+}
+
+void VirtualFileSystem::RebuildMountPoints() {
+  mount_points_.clear();
+  mount_points_.emplace_back();
+  for (uint32_t i = 0; i < uint32_t(devices_.size()); ++i) {
+    uint32_t node_index = 0;
+    for (char c : devices_[i]->mount_path()) {
+      auto& children = mount_points_[node_index].children;
+      auto it = std::find_if(
+          children.cbegin(), children.cend(),
+          [c](const auto& child) { return child.first == c; });
+      if (it != children.cend()) {
+        node_index = it->second;
+        continue;
+      }
+      uint32_t child_index = uint32_t(mount_points_.size());
+      children.emplace_back(c, child_index);
+      mount_points_.emplace_back();
+      node_index = child_index;
+    }
+    MountPointNode& node = mount_points_[node_index];
+    // Like with a linear search, the first registered device wins if multiple
+    // are mounted at the same path.
+    if (node.device_index == UINT32_MAX) {
+      node.device_index = i;
+    }
+  }
+}
+
+Device* VirtualFileSystem::FindDevice(const std::string_view path) const {
+  // Of all the devices mounted at a prefix of the path, take the first
+  // registered one, like a linear search with starts_with would.
+  uint32_t device_index = mount_points_[0].device_index;
+  uint32_t node_index = 0;
+  for (char c : path) {
+    const auto& children = mount_points_[node_index].children;
+    auto it = std::find_if(children.cbegin(), children.cend(),
+                           [c](const auto& child) { return child.first == c; });
+    if (it == children.cend()) {
+      break;
+    }
+    node_index = it->second;
+    device_index =
+        std::min(device_index, mount_points_[node_index].device_index);
+  }
+  return device_index != UINT32_MAX ? devices_[device_index].get() : nullptr;
+}
+
 bool VirtualFileSystem::ResolveSymbolicLink(const std::string_view path,
                                             std::string& result) {
   result = path;
@@ -110,34 +184,68 @@ bool VirtualFileSystem::ResolveSymbolicLink(const std::string_view path,
 }
 
 Entry* VirtualFileSystem::ResolvePath(const std::string_view path) {
-  auto global_lock = global_critical_region_.Acquire();
+  size_t path_hash = std::hash<std::string_view>()(path);
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto cache_it = resolve_cache_.find(path_hash);
+    if (cache_it != resolve_cache_.cend() && cache_it->second.path == path &&
+        cache_it->second.entry_revision ==
+            cache_it->second.device->entry_revision()) {
+      return cache_it->second.entry;
+    }
+  }
 
   // Resolve relative paths
   auto normalized_path(xe::utf8::canonicalize_guest_path(path));
 
-  // Resolve symlinks.
-  std::string resolved_path;
-  if (ResolveSymbolicLink(normalized_path, resolved_path)) {
-    normalized_path = resolved_path;
-  }
-
-  // Find the device.
-  auto it =
-      std::find_if(devices_.cbegin(), devices_.cend(), [&](const auto& d) {
-        return xe::utf8::starts_with(normalized_path, d->mount_path());
-      });
-  if (it == devices_.cend()) {
-    // Supress logging the error for ShaderDumpxe:\CompareBackEnds as this is
-    // not an actual problem nor something we care about.
-    if (path != "ShaderDumpxe:\\CompareBackEnds") {
-      XELOGE("ResolvePath({}) failed - device not found", path);
+  // The device takes the global critical region, which must be taken before
+  // mutex_ (see the lock order in the header). mutex_ is then held while
+  // calling into the device so it can't be unregistered meanwhile.
+  auto global_lock = global_critical_region_.Acquire();
+  CachedResolution resolution;
+  uint64_t state_revision;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    // Resolve symlinks.
+    std::string resolved_path;
+    if (ResolveSymbolicLink(normalized_path, resolved_path)) {
+      normalized_path = resolved_path;
     }
-    return nullptr;
-  }
 
-  const auto& device = *it;
-  auto relative_path = normalized_path.substr(device->mount_path().size());
-  return device->ResolvePath(relative_path);
+    // Find the device.
+    Device* device = FindDevice(normalized_path);
+    if (!device) {
+      // Supress logging the error for ShaderDumpxe:\CompareBackEnds as this
+      // is not an actual problem nor something we care about.
+      if (path != "ShaderDumpxe:\\CompareBackEnds") {
+        XELOGE("ResolvePath({}) failed - device not found", path);
+      }
+      return nullptr;
+    }
+
+    // Take the revision before resolving so a concurrent modification makes
+    // the cached result stale rather than the result missing it.
+    resolution.device = device;
+    resolution.entry_revision = device->entry_revision();
+    auto relative_path = normalized_path.substr(device->mount_path().size());
+    resolution.entry = device->ResolvePath(relative_path);
+    state_revision = state_revision_;
+  }
+  Entry* entry = resolution.entry;
+
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // The device may have been unregistered while the lock was released.
+    if (state_revision == state_revision_) {
+      if (resolve_cache_.size() >= kResolveCacheMaxSize) {
+        resolve_cache_.clear();
+      }
+      resolution.path = path;
+      resolve_cache_.insert_or_assign(path_hash, std::move(resolution));
+    }
+  }
+  return entry;
 }
 
 Entry* VirtualFileSystem::CreatePath(const std::string_view path,
@@ -336,10 +444,13 @@ X_STATUS VirtualFileSystem::OpenFile(Entry* root_entry,
 X_STATUS VirtualFileSystem::ExtractContentFile(Entry* entry,
                                                std::filesystem::path base_path,
                                                bool extract_to_root) {
-  // Allocate a buffer when needed.
-  size_t buffer_size = 0;
-  uint8_t* buffer = nullptr;
+  std::vector<uint8_t> buffer;
+  return ExtractContentFile(entry, base_path, extract_to_root, buffer);
+}
 
+X_STATUS VirtualFileSystem::ExtractContentFile(
+    Entry* entry, std::filesystem::path base_path, bool extract_to_root,
+    std::vector<uint8_t>& buffer, XContentContainerDevice* verified_device) {
   XELOGI("Extracting file: {}", entry->path());
 
   auto dest_name = base_path / xe::to_path(entry->path());
@@ -369,40 +480,66 @@ X_STATUS VirtualFileSystem::ExtractContentFile(Entry* entry,
     return 1;
   }
 
+  std::unique_ptr<XContentContainerDevice::EntryVerifier> verifier;
+  if (verified_device) {
+    verifier = verified_device->CreateEntryVerifier(
+        *static_cast<XContentContainerEntry*>(entry));
+  }
+
   if (entry->can_map()) {
     auto map = entry->OpenMapped(xe::MappedMemory::Mode::kRead);
     fwrite(map->data(), map->size(), 1, file);
+    if (verifier && !verifier->Update(map->data(), map->size())) {
+      result = X_STATUS_UNSUCCESSFUL;
+    }
     map->Close();
   } else {
-    // Can't map the file into memory. Read it into a temporary buffer.
-    if (!buffer || entry->size() > buffer_size) {
-      // Resize the buffer.
-      if (buffer) {
-        delete[] buffer;
+    // Can't map the file into memory. Copy it in chunks through the buffer,
+    // which the caller may reuse for multiple files.
+    size_t buffer_size = std::min(entry->size(), kExtractionChunkSize);
+    if (buffer.size() < buffer_size) {
+      buffer.resize(buffer_size);
+    }
+    size_t offset = 0;
+    while (offset < entry->size()) {
+      size_t bytes_read = 0;
+      in_file->ReadSync(buffer.data(),
+                        std::min(buffer_size, entry->size() - offset), offset,
+                        &bytes_read);
+      if (!bytes_read) {
+        XELOGE("Failed to read {} at offset {}", entry->path(), offset);
+        result = X_STATUS_UNSUCCESSFUL;
+        break;
       }
-
-      // Allocate a buffer rounded up to the nearest 512MB.
-      buffer_size = xe::round_up(entry->size(), 512_MiB);
-      buffer = new uint8_t[buffer_size];
+      if (verifier && !verifier->Update(buffer.data(), bytes_read)) {
+        result = X_STATUS_UNSUCCESSFUL;
+        break;
+      }
+      if (fwrite(buffer.data(), 1, bytes_read, file) != bytes_read) {
+        XELOGE("Failed to write {}", xe::path_to_utf8(dest_name));
+        result = X_STATUS_UNSUCCESSFUL;
+        break;
+      }
+      offset += bytes_read;
     }
-
-    size_t bytes_read = 0;
-    in_file->ReadSync(buffer, entry->size(), 0, &bytes_read);
-    fwrite(buffer, bytes_read, 1, file);
+  }
+  if (result == X_STATUS_SUCCESS && verifier && !verifier->Finish()) {
+    result = X_STATUS_UNSUCCESSFUL;
   }
 
   fclose(file);
   in_file->Destroy();
-
-  if (buffer) {
-    delete[] buffer;
-  }
-  return 0;
+  return result;
 }
 
-X_STATUS VirtualFileSystem::ExtractContentFiles(
-    Device* device, std::filesystem::path base_path) {
-  // Run through all the files, breadth-first style.
+X_STATUS VirtualFileSystem::ExtractContentFiles(Device* device,
+                                                std::filesystem::path base_path,
+                                                bool verify) {
+  auto start_time = std::chrono::steady_clock::now();
+
+  // Run through all the entries, breadth-first style, creating the
+  // directories right away so the files can then be extracted in any order.
+  std::vector<Entry*> files;
   std::queue<vfs::Entry*> queue;
   auto root = device->ResolvePath("/");
   queue.push(root);
@@ -414,9 +551,77 @@ X_STATUS VirtualFileSystem::ExtractContentFiles(
       queue.push(entry.get());
     }
 
-    ExtractContentFile(entry, base_path);
+    if (entry->attributes() & kFileAttributeDirectory) {
+      X_STATUS result = ExtractContentFile(entry, base_path);
+      if (result != X_STATUS_SUCCESS) {
+        XELOGE("Failed to create directory {}", entry->path());
+        return result;
+      }
+    } else {
+      files.push_back(entry);
+    }
   }
-  return X_STATUS_SUCCESS;
+
+  // Largest files first, for better balancing between the threads.
+  std::sort(files.begin(), files.end(), [](Entry* a, Entry* b) {
+    return a->size() > b->size();
+  });
+
+  XContentContainerDevice* verified_device =
+      verify ? dynamic_cast<XContentContainerDevice*>(device) : nullptr;
+
+  std::atomic<size_t> next_file_index{0};
+  std::atomic<uint64_t> bytes_extracted{0};
+  std::atomic<X_STATUS> first_error{X_STATUS_SUCCESS};
+  auto extract_files = [&]() {
+    // Each thread has its own buffer, so the memory usage is bounded by the
+    // thread count regardless of the file sizes.
+    std::vector<uint8_t> buffer;
+    while (true) {
+      size_t file_index = next_file_index.fetch_add(1);
+      if (file_index >= files.size()) {
+        break;
+      }
+      Entry* entry = files[file_index];
+      X_STATUS result = ExtractContentFile(entry, base_path, false, buffer,
+                                           verified_device);
+      if (result != X_STATUS_SUCCESS) {
+        XELOGE("Failed to extract {}: {:08X}", entry->path(), result);
+        X_STATUS no_error = X_STATUS_SUCCESS;
+        first_error.compare_exchange_strong(no_error, result);
+        continue;
+      }
+      bytes_extracted += entry->size();
+    }
+  };
+
+  size_t thread_count =
+      std::min(std::min(size_t(xe::threading::logical_processor_count()),
+                        kMaxExtractionThreadCount),
+               files.size());
+  std::vector<std::unique_ptr<xe::threading::Thread>> threads;
+  for (size_t i = 1; i < thread_count; ++i) {
+    auto thread = xe::threading::Thread::Create({}, extract_files);
+    if (!thread) {
+      break;
+    }
+    thread->set_name("Content Extraction");
+    threads.push_back(std::move(thread));
+  }
+  extract_files();
+  for (auto& thread : threads) {
+    xe::threading::Wait(thread.get(), false);
+  }
+
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+  double megabytes = double(bytes_extracted) / double(1_MiB);
+  XELOGI("Extracted {} files, {:.1f} MB in {:.2f} s ({:.1f} MB/s){}",
+         files.size(), megabytes, seconds,
+         seconds > 0.0 ? megabytes / seconds : 0.0,
+         verified_device ? ", verified" : "");
+  return first_error;
 }
 
 void VirtualFileSystem::ExtractContentHeader(Device* device,
@@ -10,9 +10,12 @@
 #ifndef XENIA_VFS_VIRTUAL_FILE_SYSTEM_H_
 #define XENIA_VFS_VIRTUAL_FILE_SYSTEM_H_
 
+#include <cstdint>
 #include <memory>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "xenia/base/mutex.h"
@@ -23,6 +26,8 @@
 namespace xe {
 namespace vfs {
 
+class XContentContainerDevice;
+
 class VirtualFileSystem {
  public:
   VirtualFileSystem();
@@ -52,17 +57,67 @@ class VirtualFileSystem {
   static X_STATUS ExtractContentFile(Entry* entry,
                                      std::filesystem::path base_path,
                                      bool extract_to_root = false);
+  // Extracts the files with multiple threads. If verify is true, the files
+  // are also checked against the hashes in the container if it has them.
   static X_STATUS ExtractContentFiles(Device* device,
-                                      std::filesystem::path base_path);
+                                      std::filesystem::path base_path,
+                                      bool verify = false);
   static void ExtractContentHeader(Device* device,
                                    std::filesystem::path base_path);
 
  private:
+  // If verified_device is not null, the data is checked against its hashes
+  // while it's being read.
+  static X_STATUS ExtractContentFile(
+      Entry* entry, std::filesystem::path base_path, bool extract_to_root,
+      std::vector<uint8_t>& buffer,
+      XContentContainerDevice* verified_device = nullptr);
+
+  // Character trie of the mount paths, since a device is found by a prefix of
+  // the path.
+  struct MountPointNode {
+    std::vector<std::pair<char, uint32_t>> children;
+    // Index in devices_ of the device mounted at the path of this node, or
+    // UINT32_MAX.
+    uint32_t device_index = UINT32_MAX;
+  };
+
+  struct CachedResolution {
+    // Compared on lookup since the cache is keyed by the hash of the path, so
+    // a lookup doesn't need to allocate a key string.
+    std::string path;
+    Device* device;
+    // nullptr if the device has been found, but the entry hasn't.
+    Entry* entry;
+    uint32_t entry_revision;
+  };
+  // Dropped entirely when it grows this large.
+  static constexpr size_t kResolveCacheMaxSize = 16384;
+
+  // All state modifications must be done with an exclusive lock, and they
+  // must increment state_revision_ and clear the resolve cache.
+  void OnStateModified();
+  void RebuildMountPoints();
+  Device* FindDevice(const std::string_view path) const;
+  bool ResolveSymbolicLink(const std::string_view path, std::string& result);
+
+  // Path resolution, which games may do a lot during loading from many
+  // threads, only needs a shared lock.
+  //
+  // Lock order: the global critical region, then mutex_. Devices and entries
+  // take the global critical region, and the kernel calls into the file
+  // system while holding it, so nothing may wait for the global critical
+  // region while holding mutex_ - ResolvePath takes it before mutex_ when it
+  // needs to call into a device.
   xe::global_critical_region global_critical_region_;
+  std::shared_mutex mutex_;
   std::vector<std::unique_ptr<Device>> devices_;
+  std::vector<MountPointNode> mount_points_;
   std::unordered_map<std::string, std::string> symlinks_;
-
-  bool ResolveSymbolicLink(const std::string_view path, std::string& result);
+  // Hash of the guest path as passed to ResolvePath -> the resolved entry.
+  // Entries from a device are valid while its entry revision stays the same.
+  std::unordered_map<size_t, CachedResolution> resolve_cache_;
+  uint64_t state_revision_ = 0;
 };
 
 }  // namespace vfs